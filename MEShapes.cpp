@@ -11,30 +11,44 @@
 #include <me/render/Geometry.h>
 #include <me/game/Game.h>
 
-#include <shapes/BeveledBox.h>
-#include <shapes/Circle.h>
-#include <shapes/Cone.h>
-#include <shapes/Box.h>
-#include <shapes/Cylinder.h>
-#include <shapes/DashRing.h>
-#include <shapes/Plane.h>
-#include <shapes/PointField.h>
-#include <shapes/PointRing.h>
-#include <shapes/Pyramid.h>
-#include <shapes/Sphere.h>
-#include <shapes/Tube.h>
+#include <shapes/ShapeCreators.h>
+#include <shapes/BufferPool.h>
 
 using namespace shapes;
 using namespace me;
 using namespace render;
 
-void Deleter( me::sculpter::IShapeCreator * creator )
+namespace
 {
-	delete creator;
+	// Held until MEShapesUnload logs them, while the game's log is certainly still alive.
+	ShapeStats::ptr g_stats;
+
+	BufferPool g_pool;
+	std::unique_ptr< BufferPool::Scope > g_poolScope;
 }
 
 extern "C" __declspec(dllexport) bool MELoader( me::game::IGame * gameInstance, const qxml::Element * element );
 
+/// <summary>
+/// Writes the per shape type counters to the game's log and releases them. Call before the game shuts down its
+/// debug log; the creators may outlive it.
+/// </summary>
+extern "C" __declspec(dllexport) void MEShapesUnload( me::game::IGame * gameInstance );
+
+/// <summary>
+/// Fills entries with a snapshot of the per shape type counters. Returns false if MELoader has not run, or
+/// MEShapesUnload has since.
+/// </summary>
+extern "C" __declspec(dllexport) bool MEShapesGetStats( std::vector< shapes::ShapeStatsEntry > * entries );
+
+/// <summary>
+/// Shapes created on the calling thread between these share pooled vertex and index buffers, see BufferPool.
+/// They are not drawable until MEShapesCommitPool, which must be called from the same thread. Calling
+/// MEShapesBeginPool again before the commit keeps pooling into the same pool.
+/// </summary>
+extern "C" __declspec(dllexport) void MEShapesBeginPool();
+extern "C" __declspec(dllexport) void MEShapesCommitPool( me::render::IRenderer * renderer );
+
 __declspec(dllexport) bool MELoader( me::game::IGame * gameBase, const qxml::Element * element )
 {
 	using namespace me;
@@ -44,21 +58,53 @@ __declspec(dllexport) bool MELoader( me::game::IGame * gameBase, const qxml::Ele
 	// Add sculpter creators.
 	auto geometryManager = unify::polymorphic_downcast< rm::ResourceManager< me::render::Geometry > * >( gameInstance->GetManager< Geometry >( ) );
 	auto shapeFactory = dynamic_cast< me::sculpter::SculpterFactory *>( geometryManager->GetFactory( "me_shape" ) );
-	shapeFactory->AddShapeCreator( "box", me::sculpter::IShapeCreator::ptr( new shapes::Box(), Deleter ) );
-	shapeFactory->AddShapeCreator( "beveledbox", me::sculpter::IShapeCreator::ptr( new shapes::BeveledBox(), Deleter ) );
-	shapeFactory->AddShapeCreator( "Circle", me::sculpter::IShapeCreator::ptr( new shapes::Circle(), Deleter ) );
-	shapeFactory->AddShapeCreator( "Cone", me::sculpter::IShapeCreator::ptr( new shapes::Cone(), Deleter ) );
-	shapeFactory->AddShapeCreator( "Cylinder", me::sculpter::IShapeCreator::ptr( new shapes::Cylinder(), Deleter ) );
-	shapeFactory->AddShapeCreator( "DashRing", me::sculpter::IShapeCreator::ptr( new shapes::DashRing(), Deleter ) );
-	shapeFactory->AddShapeCreator( "Plane", me::sculpter::IShapeCreator::ptr( new shapes::Plane(), Deleter ) );
-	shapeFactory->AddShapeCreator( "PointField", me::sculpter::IShapeCreator::ptr( new shapes::PointField(), Deleter ) );
-	shapeFactory->AddShapeCreator( "PointRing", me::sculpter::IShapeCreator::ptr( new shapes::PointRing(), Deleter ) );
-	shapeFactory->AddShapeCreator( "Pyramid", me::sculpter::IShapeCreator::ptr( new shapes::Pyramid(), Deleter ) );
-	shapeFactory->AddShapeCreator( "Sphere", me::sculpter::IShapeCreator::ptr( new shapes::Sphere(), Deleter ) );
-	shapeFactory->AddShapeCreator( "Tube", me::sculpter::IShapeCreator::ptr( new shapes::Tube(), Deleter ) );
+
+	// Optional pack of shapes baked offline by MEShapesBake, for example <extension source="MEShapes.dll" pack="shapes.me_pack"/>.
+	ShapePack::ptr pack;
+	if( element && element->HasAttributes( "pack" ) )
+	{
+		pack.reset( new ShapePack( unify::Path( element->GetAttribute< std::string >( "pack" ) ) ) );
+	}
+
+	g_stats.reset( new ShapeStats() );
+
+	AddShapeCreators( *shapeFactory, pack, g_stats );
 
 	//gameInstance->GetManager< Geometry >()->AddFactory( "me_shape", GeometryFactory::ptr( factory ) );
 
 	return true;
 }
 
+__declspec(dllexport) void MEShapesUnload( me::game::IGame * gameInstance )
+{
+	if( g_stats )
+	{
+		g_stats->Log( dynamic_cast< game::Game * >( gameInstance )->Debug() );
+		g_stats.reset();
+	}
+}
+
+__declspec(dllexport) bool MEShapesGetStats( std::vector< shapes::ShapeStatsEntry > * entries )
+{
+	if( !g_stats )
+	{
+		return false;
+	}
+
+	*entries = g_stats->GetEntries();
+	return true;
+}
+
+__declspec(dllexport) void MEShapesBeginPool()
+{
+	// End any scope still open first; constructing the new one before the old is destroyed would leave the
+	// old destructor restoring no pool at all.
+	g_poolScope.reset();
+	g_poolScope.reset( new BufferPool::Scope( g_pool ) );
+}
+
+__declspec(dllexport) void MEShapesCommitPool( me::render::IRenderer * renderer )
+{
+	g_poolScope.reset();
+	g_pool.Commit( renderer );
+}
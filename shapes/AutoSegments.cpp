@@ -0,0 +1,73 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/AutoSegments.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace shapes;
+
+AutoSegments::AutoSegments()
+	: enabled{ false }
+	, chordError{ 0.01f }
+	, pixelError{ 0.0f }
+	, referenceDistance{ 10.0f }
+	, fovDegrees{ 45.0f }
+	, screenHeight{ 1080.0f }
+	, minSegments{ 3 }
+	, maxSegments{ 256 }
+{
+}
+
+AutoSegments::AutoSegments( const unify::Parameters & parameters )
+	: enabled{ parameters.Get( "autosegments", false ) }
+	, chordError{ parameters.Get( "chorderror", 0.01f ) }
+	, pixelError{ parameters.Get( "pixelerror", 0.0f ) }
+	, referenceDistance{ parameters.Get( "referencedistance", 10.0f ) }
+	, fovDegrees{ parameters.Get( "fov", 45.0f ) }
+	, screenHeight{ parameters.Get( "screenheight", 1080.0f ) }
+	, minSegments{ parameters.Get< unsigned int >( "minsegments", 3 ) }
+	, maxSegments{ parameters.Get< unsigned int >( "maxsegments", 256 ) }
+{
+}
+
+float AutoSegments::GetWorldError() const
+{
+	if( pixelError <= 0.0f )
+	{
+		return chordError;
+	}
+
+	// The height of the view at the reference distance, spread over the screen's pixels.
+	const float fovRadians = fovDegrees * 3.14159265358979f / 180.0f;
+	float worldPerPixel = 2.0f * referenceDistance * tanf( fovRadians * 0.5f ) / screenHeight;
+	return pixelError * worldPerPixel;
+}
+
+unsigned int AutoSegments::Resolve( float radius, unsigned int segments, float arc ) const
+{
+	if( !enabled )
+	{
+		return segments;
+	}
+
+	const unsigned int most = std::max( minSegments, maxSegments );
+	float error = GetWorldError();
+	if( radius <= 0.0f || error <= 0.0f || error >= radius )
+	{
+		return minSegments;
+	}
+
+	// A chord spanning theta radians strays r * (1 - cos(theta / 2)) from its arc. An error too small for a
+	// float to tell from the arc needs as many segments as allowed.
+	float theta = 2.0f * acosf( 1.0f - error / radius );
+	if( !( theta > 1e-6f ) )
+	{
+		return most;
+	}
+
+	// Clamped while still a float, as the count can be far beyond what an unsigned int holds.
+	float resolved = ceilf( fabsf( arc ) / theta );
+	resolved = std::min( std::max( resolved, (float)minSegments ), (float)most );
+	return (unsigned int)resolved;
+}
@@ -0,0 +1,39 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <unify/Parameters.h>
+
+namespace shapes
+{
+	/// <summary>
+	/// Picks the fewest segments that keep a round shape's chords within an error tolerance. The tolerance is
+	/// either a chord error in world units, or a pixel error at a reference distance, which is converted to
+	/// world units through the vertical field of view and screen height.
+	/// </summary>
+	struct AutoSegments
+	{
+		AutoSegments();
+		AutoSegments( const unify::Parameters & parameters );
+
+		bool enabled;
+		float chordError;
+		float pixelError;
+		float referenceDistance;
+		float fovDegrees;
+		float screenHeight;
+		unsigned int minSegments;
+		unsigned int maxSegments;
+
+		/// <summary>
+		/// The world space error allowed between a chord and its arc.
+		/// </summary>
+		float GetWorldError() const;
+
+		/// <summary>
+		/// Returns the segments to use over "arc" radians of a circle of "radius". When not enabled this is
+		/// just "segments".
+		/// </summary>
+		unsigned int Resolve( float radius, unsigned int segments, float arc = 6.28318530717959f ) const;
+	};
+}
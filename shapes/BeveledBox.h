@@ -3,9 +3,24 @@
 #pragma once
 
 #include <me/sculpter/IShapeCreator.h>
+#include <shapes/ShapeDesc.h>
+#include <shapes/ShapeQuery.h>
+#include <me/render/TextureMode.h>
+#include <vector>
 
 namespace shapes
 {
+	struct BeveledBoxDesc : public ShapeDesc
+	{
+		BeveledBoxDesc();
+		BeveledBoxDesc( const unify::Parameters & parameters );
+
+		unify::V3< float > inf;
+		unify::V3< float > sup;
+		me::render::TextureMode::TYPE textureMode;
+		std::vector< unify::Color > diffuses;
+	};
+
 	class BeveledBox : public me::sculpter::IShapeCreator
 	{
 	public:
@@ -13,5 +28,11 @@ namespace shapes
 		~BeveledBox() override;
 
 		void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+		void Create( me::render::PrimitiveList & primitiveList, const BeveledBoxDesc & desc ) const;
+
+		/// <summary>
+		/// The exact shape desc describes, for picking and containment without its triangles.
+		/// </summary>
+		IShapeQuery::ptr CreateQuery( const BeveledBoxDesc & desc ) const;
 	};
 }
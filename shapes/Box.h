@@ -3,9 +3,27 @@
 #pragma once
 
 #include <me/sculpter/IShapeCreator.h>
+#include <shapes/ShapeDesc.h>
+#include <shapes/ShapeQuery.h>
+#include <shapes/Occlusion.h>
+#include <me/render/TextureMode.h>
+#include <unify/TexArea.h>
+#include <vector>
 
 namespace shapes
 {
+	struct BoxDesc : public ShapeDesc
+	{
+		BoxDesc();
+		BoxDesc( const unify::Parameters & parameters );
+
+		unify::V3< float > inf;
+		unify::V3< float > sup;
+		me::render::TextureMode::TYPE textureMode;
+		std::vector< unify::Color > diffuses;
+		std::vector< unify::TexArea > faceUV;
+	};
+
 	class Box : public me::sculpter::IShapeCreator
 	{
 	public:
@@ -13,5 +31,16 @@ namespace shapes
 		~Box() override;
 
 		void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+		void Create( me::render::PrimitiveList & primitiveList, const BoxDesc & desc ) const;
+
+		/// <summary>
+		/// The exact shape desc describes, for picking and containment without its triangles.
+		/// </summary>
+		IShapeQuery::ptr CreateQuery( const BoxDesc & desc ) const;
+
+		/// <summary>
+		/// A low detail stand in for occlusion culling, inside the shape desc describes.
+		/// </summary>
+		OccluderMesh CreateOccluder( const BoxDesc & desc ) const;
 	};
 }
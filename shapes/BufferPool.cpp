@@ -0,0 +1,171 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/BufferPool.h>
+#include <me/exception/FailedToCreate.h>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+BufferPool::Pool::Pool()
+	: vertexStride{ 0 }
+{
+}
+
+BufferPool::Pending::Pending()
+	: set{ nullptr }
+	, pool{ nullptr }
+	, baseVertex{ 0 }
+	, startIndex{ 0 }
+	, indexed{ false }
+{
+}
+
+BufferPool::BufferPool( BufferUsage::TYPE usage )
+	: m_usage{ usage }
+{
+}
+
+bool BufferPool::AddVertexBuffer( BufferSet & set, const VertexBufferParameters & parameters )
+{
+	// Per-instance slots are sized by instance, not by vertex, so only single slot buffers are pooled.
+	if( parameters.usage != m_usage || parameters.countAndSource.size() != 1 )
+	{
+		return false;
+	}
+
+	Pending & pending = Get( set );
+	if( pending.pool )
+	{
+		throw me::exception::FailedToCreate( "BufferPool only supports a single vertex buffer per BufferSet!" );
+	}
+
+	Pool & pool = m_pools[parameters.vertexDeclaration.get()];
+	pool.vertexDeclaration = parameters.vertexDeclaration;
+	pool.vertexStride = parameters.vertexDeclaration->GetSizeInBytes( 0 );
+
+	const auto & source = parameters.countAndSource[0];
+	const unsigned char * bytes = (const unsigned char *)source.source;
+	pending.pool = &pool;
+	pending.baseVertex = (unsigned int)( pool.vertices.size() / pool.vertexStride );
+	pool.vertices.insert( pool.vertices.end(), bytes, bytes + source.count * pool.vertexStride );
+	pool.bbox += parameters.bbox;
+	return true;
+}
+
+bool BufferPool::AddIndexBuffer( BufferSet & set, const IndexBufferParameters & parameters )
+{
+	// Indices are only pooled along with the vertices they index, and with the pool's usage. Indices left out
+	// go to their BufferSet, and still index the pooled vertices through the base vertex of their methods.
+	auto itr = m_index.find( &set );
+	if( parameters.usage != m_usage || itr == m_index.end() || m_pending[itr->second].pool == nullptr )
+	{
+		return false;
+	}
+
+	Pending & pending = m_pending[itr->second];
+	Pool & pool = *pending.pool;
+
+	const auto & source = parameters.countAndSource[0];
+	const Index32 * indices = (const Index32 *)source.source;
+	pending.indexed = true;
+	pending.startIndex = (unsigned int)pool.indices.size();
+	pool.indices.insert( pool.indices.end(), indices, indices + source.count );
+	return true;
+}
+
+bool BufferPool::AddMethod( BufferSet & set, const RenderMethod & method )
+{
+	// Creators add their methods before their buffers, so every method waits for Commit, when it is known
+	// whether its BufferSet was pooled.
+	Get( set ).methods.push_back( method );
+	return true;
+}
+
+size_t BufferPool::GetVertexCount() const
+{
+	size_t count = 0;
+	for( const auto & pool : m_pools )
+	{
+		count += pool.second.vertices.size() / pool.second.vertexStride;
+	}
+	return count;
+}
+
+size_t BufferPool::GetIndexCount() const
+{
+	size_t count = 0;
+	for( const auto & pool : m_pools )
+	{
+		count += pool.second.indices.size();
+	}
+	return count;
+}
+
+void BufferPool::Commit( IRenderer * renderer )
+{
+	std::map< const Pool *, IVertexBuffer::ptr > vertexBuffers;
+	std::map< const Pool *, IIndexBuffer::ptr > indexBuffers;
+	for( const auto & itr : m_pools )
+	{
+		const Pool & pool = itr.second;
+
+		size_t vertexCount = pool.vertices.size() / pool.vertexStride;
+		VertexBufferParameters vbParameters{ pool.vertexDeclaration, { { vertexCount, pool.vertices.data() } }, m_usage };
+		vbParameters.bbox = pool.bbox;
+		vertexBuffers[&pool] = renderer->ProduceVB( vbParameters );
+
+		if( !pool.indices.empty() )
+		{
+			indexBuffers[&pool] = renderer->ProduceIB( { { { pool.indices.size(), pool.indices.data() } }, m_usage } );
+		}
+	}
+
+	for( auto & pending : m_pending )
+	{
+		if( pending.pool )
+		{
+			pending.set->AddVertexBuffer( vertexBuffers[pending.pool] );
+			if( pending.indexed )
+			{
+				pending.set->AddIndexBuffer( indexBuffers[pending.pool] );
+			}
+		}
+
+		for( RenderMethod method : pending.methods )
+		{
+			if( pending.pool )
+			{
+				// Non-indexed methods start at their base vertex, indexed methods are offset by it.
+				method.baseVertexIndex += pending.baseVertex;
+				if( method.useIB )
+				{
+					method.startIndex += pending.startIndex;
+				}
+			}
+			pending.set->AddMethod( method );
+		}
+	}
+
+	m_pools.clear();
+	m_pending.clear();
+	m_index.clear();
+}
+
+BufferPool * BufferPool::Current()
+{
+	return CurrentScope< BufferPool >::Get();
+}
+
+BufferPool::Pending & BufferPool::Get( BufferSet & set )
+{
+	auto itr = m_index.find( &set );
+	if( itr == m_index.end() )
+	{
+		itr = m_index.insert( { &set, m_pending.size() } ).first;
+		m_pending.push_back( Pending() );
+		m_pending.back().set = &set;
+	}
+	return m_pending[itr->second];
+}
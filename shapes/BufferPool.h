@@ -0,0 +1,84 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <shapes/CurrentScope.h>
+#include <me/render/IRenderer.h>
+#include <me/render/BufferSet.h>
+#include <me/render/RenderMethod.h>
+#include <unify/BBox.h>
+#include <vector>
+#include <map>
+
+namespace shapes
+{
+	/// <summary>
+	/// Gathers the vertices and indices of every shape created while it is current into one vertex buffer and one
+	/// index buffer per vertex declaration. Each shape's render methods are offset into the shared buffers through
+	/// their base vertex and start index, so many shapes share a handful of buffer objects.
+	///
+	/// Nothing is drawable until Commit, and every BufferSet added to must still exist at that point. Only buffers
+	/// with the pool's usage are pooled, others are handed to their BufferSet as usual. The pooled vertex buffer's
+	/// bounds are those of every shape in it; sets that need bounds of their own, such as point chunks, add
+	/// their vertices through AddBoundedVertexBuffer, which skips the pool.
+	/// </summary>
+	class BufferPool
+	{
+	public:
+		typedef CurrentScope< BufferPool > Scope;
+
+		BufferPool( me::render::BufferUsage::TYPE usage = me::render::BufferUsage::Default );
+
+		/// <summary>
+		/// Each returns false when the pool does not take it, in which case it goes straight to the BufferSet.
+		/// </summary>
+		bool AddVertexBuffer( me::render::BufferSet & set, const me::render::VertexBufferParameters & parameters );
+		bool AddIndexBuffer( me::render::BufferSet & set, const me::render::IndexBufferParameters & parameters );
+		bool AddMethod( me::render::BufferSet & set, const me::render::RenderMethod & method );
+
+		size_t GetVertexCount() const;
+		size_t GetIndexCount() const;
+
+		/// <summary>
+		/// Creates the shared buffers, hands them to every pooled BufferSet along with its offset methods, then
+		/// empties the pool so it can be reused.
+		/// </summary>
+		void Commit( me::render::IRenderer * renderer );
+
+		/// <summary>
+		/// Returns the pool current for the calling thread, or nullptr.
+		/// </summary>
+		static BufferPool * Current();
+
+	private:
+		struct Pool
+		{
+			Pool();
+
+			me::render::VertexDeclaration::ptr vertexDeclaration;
+			size_t vertexStride;
+			std::vector< unsigned char > vertices;
+			std::vector< me::render::Index32 > indices;
+			unify::BBox< float > bbox;
+		};
+
+		struct Pending
+		{
+			Pending();
+
+			me::render::BufferSet * set;
+			Pool * pool;
+			unsigned int baseVertex;
+			unsigned int startIndex;
+			bool indexed;
+			std::vector< me::render::RenderMethod > methods;
+		};
+
+		Pending & Get( me::render::BufferSet & set );
+
+		me::render::BufferUsage::TYPE m_usage;
+		std::map< const me::render::VertexDeclaration *, Pool > m_pools;
+		std::vector< Pending > m_pending;
+		std::map< const me::render::BufferSet *, size_t > m_index;
+	};
+}
@@ -2,6 +2,9 @@
 // All Rights Reserved
 
 #include <shapes/Circle.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapeTransform.h>
+#include <shapes/ShapeKernels.h>
 #include <me/render/VertexUtil.h>
 #include <me/exception/NotImplemented.h>
 #include <me/exception/FailedToCreate.h>
@@ -9,6 +12,7 @@
 #include <unify/Size3.h>
 #include <unify/TexArea.h>
 #include <unify/Angle.h>
+#include <algorithm>
 
 using namespace me;
 using namespace render;
@@ -16,7 +20,20 @@ using namespace shapes;
 
 const float PI = 3.14159265358979f;
 const float PI2 = 6.28318530717959f;
-const std::string DefaultBufferUsage = "Default";
+
+CircleDesc::CircleDesc()
+	: radius{ 1.0f }
+	, segments{ 12 }
+{
+}
+
+CircleDesc::CircleDesc( const unify::Parameters & parameters )
+	: ShapeDesc( parameters )
+	, radius{ parameters.Get( "radius", 1.0f ) }
+	, segments{ parameters.Get< unsigned int >( "segments", 12 ) }
+	, autoSegments{ parameters }
+{
+}
 
 Circle::Circle()
 {
@@ -28,100 +45,116 @@ Circle::~Circle()
 
 // 2D circle in 3d space (filled)
 void Circle::Create( PrimitiveList & primitiveList, const unify::Parameters & parameters ) const
+{
+	try
+	{
+		Create( primitiveList, CircleDesc( parameters ) );
+	}
+	catch( std::exception & ex )
+	{
+		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+	}
+}
+
+void Circle::Create( PrimitiveList & primitiveList, const CircleDesc & desc ) const
 {
 	using namespace unify;
 
-	try
+	if( desc.canonical )
 	{
-		unsigned int segments = parameters.Get< unsigned int >( "segments", 12 );
-		unify::Color diffuse = parameters.Get( "diffuse", unify::ColorWhite() );
-		unify::Color specular = parameters.Get( "specular", unify::ColorWhite() );
-		float radius = parameters.Get( "radius", 1.0f );
-		unify::V3< float > center = parameters.Get( "center", unify::V3< float >( 0, 0, 0 ) );
-		Effect::ptr effect = parameters.Get< Effect::ptr >( "effect" );
-		VertexDeclaration::ptr vd = effect->GetVertexShader()->GetVertexDeclaration();
-		BufferUsage::TYPE bufferUsage = BufferUsage::FromString( parameters.Get( "bufferusage", DefaultBufferUsage ) );
+		CircleDesc unit = desc;
+		unit.canonical = false;
+		unit.center = V3< float >( 0, 0, 0 );
+		unit.radius = 1.0f;
+		unit.segments = desc.autoSegments.Resolve( desc.radius, desc.segments );
+		unit.autoSegments.enabled = false;
+		ShapeTransform::Report( V3< float >( desc.radius, desc.radius, desc.radius ), desc.center );
+		Create( primitiveList, unit );
+		return;
+	}
 
-		if( segments < 3 ) segments = 3;
+	unsigned int segments = desc.autoSegments.Resolve( desc.radius, desc.segments );
+	unify::Color diffuse = desc.diffuse;
+	unify::Color specular = desc.specular;
+	float radius = desc.radius;
+	unify::V3< float > center = desc.center;
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
 
-		size_t vertexCount = segments + 1;
-		size_t indexCount = segments * 3;
+	if( segments < 3 ) segments = 3;
 
-		BufferSet & set = primitiveList.AddBufferSet();
-		set.SetEffect( effect );
+	size_t vertexCount = segments + 1;
+	size_t indexCount = segments * 3;
 
-		// Method 1 - Fan
-		set.AddMethod( RenderMethod::CreateTriangleListIndexed( vertexCount, (unsigned int)indexCount, 0, 0 ) );
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
 
-		std::shared_ptr< unsigned char > vertices( new unsigned char[vertexCount * vd->GetSizeInBytes( 0 )] );
-		unify::DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, unify::DataLockAccess::ReadWrite, 0 );
+	// Method 1 - Fan
+	AddMethod( set, RenderMethod::CreateTriangleListIndexed( vertexCount, (unsigned int)indexCount, 0, 0 ) );
 
-		VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
+	std::shared_ptr< unsigned char > vertices( new unsigned char[vertexCount * vd->GetSizeInBytes( 0 )] );
+	unify::DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, unify::DataLockAccess::ReadWrite, 0 );
 
-		unsigned short stream = 0;
+	VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
 
-		VertexElement positionE = CommonVertexElement::Position( stream );
-		VertexElement normalE = CommonVertexElement::Normal( stream );
-		VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
-		VertexElement specularE = CommonVertexElement::Specular( stream );
-		VertexElement texE = CommonVertexElement::TexCoords( stream );
+	unsigned short stream = 0;
 
-		class V
-		{
-		public:
-			unify::V3< float > pos;
-			unify::V3< float > normal;
-			unify::Color diffuse;
-			unify::Color specular;
-			unify::TexCoords coords;
-		};
-		qjson::Object jsonFormat;
-		jsonFormat.Add( { "Position", "Float3" } );
-		jsonFormat.Add( { "Normal", "Float3" } );
-		jsonFormat.Add( { "Diffuse", "Color" } );
-		jsonFormat.Add( { "Specular", "Color" } );
-		jsonFormat.Add( { "TexCoord", "TexCoord" } );
-		VertexDeclaration::ptr vFormat( new VertexDeclaration( jsonFormat ) );
-
-		// Set the center
-		WriteVertex( *vd, lock, 0, positionE, center );
-		WriteVertex( *vd, lock, 0, normalE, unify::V3< float >( 0, 1, 0 ) );
-		WriteVertex( *vd, lock, 0, texE, unify::TexCoords( 0.5f, 0.5f ) );
-		WriteVertex( *vd, lock, 0, diffuseE, diffuse );
-		WriteVertex( *vd, lock, 0, specularE, specular );
-		vbParameters.bbox += center;
-
-		double dRad = 0;
-		double dRadChange = PI2 / segments;
-		for( unsigned int v = 1; v <= segments; v++ )
-		{
+	VertexElement positionE = CommonVertexElement::Position( stream );
+	VertexElement normalE = CommonVertexElement::Normal( stream );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+	VertexElement specularE = CommonVertexElement::Specular( stream );
+	VertexElement texE = CommonVertexElement::TexCoords( stream );
 
-			unify::V3< float > pos( (float)sin( dRad ) * radius, 0, (float)cos( dRad ) * radius );
-			pos += center;
+	std::vector< float > sines( segments );
+	std::vector< float > cosines( segments );
+	kernels::SinCos( 0.0f, PI2 / segments, segments, sines.data(), cosines.data() );
 
-			WriteVertex( *vd, lock, v, positionE, pos );
-			WriteVertex( *vd, lock, v, normalE, unify::V3< float >( 0, 1, 0 ) );
-			WriteVertex( *vd, lock, v, texE, unify::TexCoords( 0.5f + (float)(sin( dRad ) * 0.5), 0.5f + (float)(cos( dRad ) * -0.5) ) );
-			WriteVertex( *vd, lock, v, diffuseE, diffuse );
-			WriteVertex( *vd, lock, v, specularE, specular );
-			vbParameters.bbox += pos;
-			dRad += dRadChange;
-		}
+	// The center, then the rim.
+	std::vector< unify::V3< float > > positions( vertexCount );
+	positions[0] = unify::V3< float >( 0, 0, 0 );
+	for( unsigned int v = 1; v <= segments; v++ )
+	{
+		positions[v] = unify::V3< float >( sines[v - 1] * radius, 0, cosines[v - 1] * radius );
+	}
+	kernels::Transform( kernels::Affine::Translation( center ), positions.data(), positions.data(), vertexCount );
+	kernels::Bounds( positions.data(), vertexCount, vbParameters.bbox );
 
-		set.AddVertexBuffer( vbParameters );
+	for( unsigned int v = 0; v <= segments; v++ )
+	{
+		unify::TexCoords coords = v == 0 ? unify::TexCoords( 0.5f, 0.5f ) : unify::TexCoords( 0.5f + sines[v - 1] * 0.5f, 0.5f + cosines[v - 1] * -0.5f );
+		WriteVertex( *vd, lock, v, positionE, positions[v] );
+		WriteVertex( *vd, lock, v, normalE, unify::V3< float >( 0, 1, 0 ) );
+		WriteVertex( *vd, lock, v, texE, coords );
+		WriteVertex( *vd, lock, v, diffuseE, diffuse );
+		WriteVertex( *vd, lock, v, specularE, specular );
+	}
 
-		std::vector< Index32 > indices( indexCount );
+	AddVertexBuffer( set, vbParameters );
 
+	// One triangle per segment, in order around the rim, so GetArcIndexCount can draw part of it.
+	AddSharedIndexBuffer( set, { "Circle", { segments } }, BufferUsage::Default, [&]( std::vector< Index32 > & indices )
+	{
+		indices.resize( indexCount );
 		for( size_t s = 0; s < segments; s++ )
 		{
 			indices[(s * 3) + 0] = 0;
 			indices[(s * 3) + 1] = (me::render::Index32)s + 1;
 			indices[(s * 3) + 2] = (me::render::Index32)((s < (segments - 1)) ? s + 2 : 1);
 		}
+	} );
+}
 
-		set.AddIndexBuffer( { { { indexCount, &indices[0] } } } );
-	} catch( std::exception & ex )
-	{
-		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
-	}
+IShapeQuery::ptr Circle::CreateQuery( const CircleDesc & desc ) const
+{
+	return RevolvedQuery::CreateDisc( desc.center, desc.radius );
+}
+
+unsigned int Circle::GetArcIndexCount( const CircleDesc & desc, float fraction )
+{
+	unsigned int segments = desc.autoSegments.Resolve( desc.radius, desc.segments );
+	if( segments < 3 ) segments = 3;
+
+	fraction = std::min( std::max( fraction, 0.0f ), 1.0f );
+	return (unsigned int)( fraction * segments + 0.5f ) * 3;
 }
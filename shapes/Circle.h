@@ -3,9 +3,22 @@
 #pragma once
 
 #include <me/sculpter/IShapeCreator.h>
+#include <shapes/ShapeDesc.h>
+#include <shapes/ShapeQuery.h>
+#include <shapes/AutoSegments.h>
 
 namespace shapes
 {
+	struct CircleDesc : public ShapeDesc
+	{
+		CircleDesc();
+		CircleDesc( const unify::Parameters & parameters );
+
+		float radius;
+		unsigned int segments;
+		AutoSegments autoSegments;
+	};
+
 	class Circle : public me::sculpter::IShapeCreator
 	{
 	public:
@@ -13,5 +26,18 @@ namespace shapes
 		~Circle() override;
 		
 		void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+		void Create( me::render::PrimitiveList & primitiveList, const CircleDesc & desc ) const;
+
+		/// <summary>
+		/// The exact shape desc describes, for picking and containment without its triangles.
+		/// </summary>
+		IShapeQuery::ptr CreateQuery( const CircleDesc & desc ) const;
+
+		/// <summary>
+		/// The index count that draws fraction, 0 to 1, of the circle desc describes, from +z toward +x, to the
+		/// nearest segment. The triangles are in that order, so a partial arc is the shape's method with only
+		/// its index count changed.
+		/// </summary>
+		static unsigned int GetArcIndexCount( const CircleDesc & desc, float fraction );
 	};
 }
@@ -0,0 +1,192 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/CollisionProxy.h>
+#include <shapes/VectorMath.h>
+#include <me/exception/FailedToCreate.h>
+#include <algorithm>
+
+using namespace shapes;
+using vectormath::Dot;
+using vectormath::Cross;
+
+CollisionProxy::CollisionProxy()
+	: type{ Type::Sphere }
+	, center{ 0, 0, 0 }
+	, halfExtents{ 0, 0, 0 }
+	, radius{ 0 }
+	, height{ 0 }
+	, firstVertex{ 0 }
+	, vertexCount{ 0 }
+	, firstIndex{ 0 }
+	, indexCount{ 0 }
+{
+}
+
+CollisionProxy CollisionProxy::MakeSphere( const unify::V3< float > & center, float radius )
+{
+	CollisionProxy proxy;
+	proxy.type = Type::Sphere;
+	proxy.center = center;
+	proxy.radius = radius;
+	return proxy;
+}
+
+CollisionProxy CollisionProxy::MakeBox( const unify::V3< float > & center, const unify::V3< float > & halfExtents )
+{
+	CollisionProxy proxy;
+	proxy.type = Type::Box;
+	proxy.center = center;
+	proxy.halfExtents = halfExtents;
+	return proxy;
+}
+
+CollisionProxy CollisionProxy::MakeCylinder( const unify::V3< float > & center, float radius, float height )
+{
+	CollisionProxy proxy;
+	proxy.type = Type::Cylinder;
+	proxy.center = center;
+	proxy.radius = radius;
+	proxy.height = height;
+	return proxy;
+}
+
+CollisionProxy CollisionProxy::MakeCone( const unify::V3< float > & center, float radius, float height )
+{
+	CollisionProxy proxy;
+	proxy.type = Type::Cone;
+	proxy.center = center;
+	proxy.radius = radius;
+	proxy.height = height;
+	return proxy;
+}
+
+void CollisionTable::Add( const CollisionProxy & proxy )
+{
+	m_proxies.push_back( proxy );
+}
+
+void CollisionTable::AddHull( const unify::V3< float > * vertices, size_t vertexCount, const uint16_t * indices, size_t indexCount )
+{
+	if( vertexCount > 0xffff )
+	{
+		throw me::exception::FailedToCreate( "Collision hulls are limited to 65535 vertices!" );
+	}
+
+	CollisionProxy proxy;
+	proxy.type = CollisionProxy::Type::Hull;
+	proxy.firstVertex = (uint32_t)m_hullVertices.size();
+	proxy.vertexCount = (uint32_t)vertexCount;
+	proxy.firstIndex = (uint32_t)m_hullIndices.size();
+	proxy.indexCount = (uint32_t)( indexCount - indexCount % 3 );
+
+	unify::V3< float > center( 0, 0, 0 );
+	for( size_t v = 0; v < vertexCount; ++v )
+	{
+		center += vertices[v];
+		m_hullVertices.push_back( vertices[v] );
+	}
+	if( vertexCount )
+	{
+		center /= (float)vertexCount;
+	}
+	proxy.center = center;
+
+	for( size_t i = 0; i < proxy.indexCount; i += 3 )
+	{
+		uint16_t a = indices[i];
+		uint16_t b = indices[i + 1];
+		uint16_t c = indices[i + 2];
+		if( Dot( Cross( vertices[b] - vertices[a], vertices[c] - vertices[a] ), vertices[a] - center ) < 0.0f )
+		{
+			std::swap( b, c );
+		}
+		m_hullIndices.push_back( a );
+		m_hullIndices.push_back( b );
+		m_hullIndices.push_back( c );
+	}
+
+	m_proxies.push_back( proxy );
+}
+
+const std::vector< CollisionProxy > & CollisionTable::GetProxies() const
+{
+	return m_proxies;
+}
+
+const std::vector< unify::V3< float > > & CollisionTable::GetHullVertices() const
+{
+	return m_hullVertices;
+}
+
+const std::vector< uint16_t > & CollisionTable::GetHullIndices() const
+{
+	return m_hullIndices;
+}
+
+void CollisionTable::Clear()
+{
+	m_proxies.clear();
+	m_hullVertices.clear();
+	m_hullIndices.clear();
+}
+
+CollisionTable * CollisionTable::Current()
+{
+	return CurrentScope< CollisionTable >::Get();
+}
+
+void shapes::AddCollisionProxy( const CollisionProxy & proxy )
+{
+	if( CollisionTable * table = CollisionTable::Current() )
+	{
+		table->Add( proxy );
+	}
+}
+
+void shapes::AddCollisionHull( const unify::V3< float > * vertices, size_t vertexCount, const uint16_t * indices, size_t indexCount )
+{
+	if( CollisionTable * table = CollisionTable::Current() )
+	{
+		table->AddHull( vertices, vertexCount, indices, indexCount );
+	}
+}
+
+void shapes::AddCollisionPrism( const unify::V3< float > * polygon, size_t count, float low, float high )
+{
+	if( !CollisionTable::Current() || count < 3 )
+	{
+		return;
+	}
+
+	// Both rings are indexed with 16 bits.
+	if( count * 2 > 0xffff )
+	{
+		throw me::exception::FailedToCreate( "Collision prisms are limited to 32767 sides!" );
+	}
+
+	// The bottom ring, then the top ring.
+	std::vector< unify::V3< float > > vertices( count * 2 );
+	for( size_t i = 0; i < count; ++i )
+	{
+		vertices[i] = unify::V3< float >( polygon[i].x, low, polygon[i].z );
+		vertices[count + i] = unify::V3< float >( polygon[i].x, high, polygon[i].z );
+	}
+
+	const size_t top = count;
+	std::vector< uint16_t > indices;
+	indices.reserve( ( count - 2 ) * 6 + count * 6 );
+	for( size_t i = 1; i + 1 < count; ++i )
+	{
+		indices.insert( indices.end(), { 0, (uint16_t)i, (uint16_t)( i + 1 ) } );
+		indices.insert( indices.end(), { (uint16_t)top, (uint16_t)( top + i + 1 ), (uint16_t)( top + i ) } );
+	}
+	for( size_t i = 0; i < count; ++i )
+	{
+		size_t next = ( i + 1 ) % count;
+		indices.insert( indices.end(), { (uint16_t)i, (uint16_t)next, (uint16_t)( top + next ) } );
+		indices.insert( indices.end(), { (uint16_t)i, (uint16_t)( top + next ), (uint16_t)( top + i ) } );
+	}
+
+	AddCollisionHull( vertices.data(), vertices.size(), indices.data(), indices.size() );
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <shapes/CurrentScope.h>
+#include <unify/V3.h>
+#include <cstdint>
+#include <vector>
+
+namespace shapes
+{
+	/// <summary>
+	/// A simplified stand in for a shape's render geometry, for physics. Primitives are described by a few
+	/// numbers; hulls are convex, with their vertices and triangles held in the CollisionTable's shared arrays.
+	/// Proxies are in the same space as the shape's vertices, so a canonical shape's proxy is unit sized too.
+	/// </summary>
+	struct CollisionProxy
+	{
+		enum class Type
+		{
+			Sphere,		// radius about center.
+			Box,		// halfExtents about center.
+			Cylinder,	// radius, and height centered on center, along y.
+			Cone,		// radius of the base, height above the apex at center, along y.
+			Hull
+		};
+
+		CollisionProxy();
+
+		static CollisionProxy MakeSphere( const unify::V3< float > & center, float radius );
+		static CollisionProxy MakeBox( const unify::V3< float > & center, const unify::V3< float > & halfExtents );
+		static CollisionProxy MakeCylinder( const unify::V3< float > & center, float radius, float height );
+		static CollisionProxy MakeCone( const unify::V3< float > & center, float radius, float height );
+
+		Type type;
+		unify::V3< float > center;
+		unify::V3< float > halfExtents;
+		float radius;
+		float height;
+
+		// A hull's range in the table's hull vertices and hull indices.
+		uint32_t firstVertex;
+		uint32_t vertexCount;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+	};
+
+	/// <summary>
+	/// The proxies written by creators while it is current, in the order they were written. Every hull's
+	/// vertices are packed into one array, and its triangles into one array of 16 bit indices, relative to the
+	/// hull's first vertex.
+	/// </summary>
+	class CollisionTable
+	{
+	public:
+		typedef CurrentScope< CollisionTable > Scope;
+
+		void Add( const CollisionProxy & proxy );
+
+		/// <summary>
+		/// Adds a convex hull. The triangles are rewound where needed so each normal, ( b - a ) x ( c - a ),
+		/// points away from the hull's center.
+		/// </summary>
+		void AddHull( const unify::V3< float > * vertices, size_t vertexCount, const uint16_t * indices, size_t indexCount );
+
+		const std::vector< CollisionProxy > & GetProxies() const;
+		const std::vector< unify::V3< float > > & GetHullVertices() const;
+		const std::vector< uint16_t > & GetHullIndices() const;
+
+		void Clear();
+
+		/// <summary>
+		/// Returns the table current for the calling thread, or nullptr.
+		/// </summary>
+		static CollisionTable * Current();
+
+	private:
+		std::vector< CollisionProxy > m_proxies;
+		std::vector< unify::V3< float > > m_hullVertices;
+		std::vector< uint16_t > m_hullIndices;
+	};
+
+	/// <summary>
+	/// Adds a primitive proxy to the current CollisionTable, if there is one.
+	/// </summary>
+	void AddCollisionProxy( const CollisionProxy & proxy );
+
+	/// <summary>
+	/// Adds a convex hull to the current CollisionTable, if there is one.
+	/// </summary>
+	void AddCollisionHull( const unify::V3< float > * vertices, size_t vertexCount, const uint16_t * indices, size_t indexCount );
+
+	/// <summary>
+	/// Adds the hull of a convex polygon in xz, given in order around its edge, extruded from y = low to y = high.
+	/// </summary>
+	void AddCollisionPrism( const unify::V3< float > * polygon, size_t count, float low, float high );
+}
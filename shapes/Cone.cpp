@@ -2,6 +2,10 @@
 // All Rights Reserved
 
 #include <shapes/Cone.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapeTransform.h>
+#include <shapes/CollisionProxy.h>
+#include <shapes/ShapeKernels.h>
 #include <me/render/VertexUtil.h>
 #include <me/exception/NotImplemented.h>
 #include <me/exception/FailedToCreate.h>
@@ -16,7 +20,32 @@ using namespace shapes;
 
 const float PI = 3.14159265358979f;
 const float PI2 = 6.28318530717959f;
-const std::string DefaultBufferUsage = "Default";
+
+ConeDesc::ConeDesc()
+	: radius{ 1.0f }
+	, height{ 1.0f }
+	, segments{ 12 }
+	, textureMode{ TextureMode::Correct }
+	, texArea{ unify::TexCoords( 0, 0 ), unify::TexCoords( 1, 1 ) }
+	, caps{ true }
+	, merged{ false }
+	, indexed{ false }
+{
+}
+
+ConeDesc::ConeDesc( const unify::Parameters & parameters )
+	: ShapeDesc( parameters )
+	, radius{ parameters.Get( "radius", 1.0f ) }
+	, height{ parameters.Get( "height", 1.0f ) }
+	, segments{ parameters.Get< unsigned int >( "segments", 12 ) }
+	, textureMode{ parameters.Get( "texturemode", TextureMode::Correct ) }
+	, texArea{ parameters.Get< unify::TexArea >( "texarea", unify::TexArea( unify::TexCoords( 0, 0 ), unify::TexCoords( 1, 1 ) ) ) }
+	, caps{ parameters.Get( "caps", true ) }
+	, merged{ parameters.Get( "merged", false ) }
+	, indexed{ parameters.Get( "indexed", false ) }
+	, autoSegments{ parameters }
+{
+}
 
 Cone::Cone()
 {
@@ -27,157 +56,287 @@ Cone::~Cone()
 }
 
 void Cone::Create(PrimitiveList & primitiveList, const unify::Parameters & parameters ) const
+{
+	try
+	{
+		Create( primitiveList, ConeDesc( parameters ) );
+	}
+	catch( std::exception & ex )
+	{
+		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+	}
+}
+
+void Cone::Create(PrimitiveList & primitiveList, const ConeDesc & desc ) const
 {
 	using namespace unify;
 
-	try
+	if( desc.canonical )
+	{
+		ConeDesc unit = desc;
+		unit.canonical = false;
+		unit.center = V3< float >( 0, 0, 0 );
+		unit.radius = 1.0f;
+		unit.height = 1.0f;
+		unit.segments = desc.autoSegments.Resolve( desc.radius, desc.segments );
+		unit.autoSegments.enabled = false;
+		ShapeTransform::Report( V3< float >( desc.radius, desc.height, desc.radius ), desc.center );
+		Create( primitiveList, unit );
+		return;
+	}
+
+	// The base is drawn at half the height above the apex.
+	if( desc.collision )
+	{
+		AddCollisionProxy( CollisionProxy::MakeCone( desc.center, desc.radius, desc.height * 0.5f ) );
+	}
+
+	if( desc.indexed )
 	{
-		unsigned int segments = parameters.Get< unsigned int >( "segments", 12 );
-		Color diffuse = parameters.Get( "diffuse", ColorWhite() );
-		Color specular = parameters.Get( "specular", ColorWhite() );
-		float radius = parameters.Get( "radius", 1.0f );
-		float height = parameters.Get( "height", 1.0f );
-		V3< float > center = parameters.Get( "center", V3< float >( 0, 0, 0 ) );
-		int textureMode = parameters.Get( "texturemode", TextureMode::Correct );
-		Effect::ptr effect = parameters.Get< Effect::ptr >( "effect" );
-		BufferUsage::TYPE bufferUsage = BufferUsage::FromString( parameters.Get( "bufferusage", DefaultBufferUsage ) );
-		// TODO: support top and bottom texArea.
-		unify::TexArea texArea = parameters.Get< unify::TexArea >( "texarea", TexArea( TexCoords( 0, 0 ), TexCoords( 1, 1 ) ) );
-		bool caps = parameters.Get( "caps", true );
+		CreateIndexed( primitiveList, desc );
+		return;
+	}
 
-		VertexDeclaration::ptr vd = effect->GetVertexShader()->GetVertexDeclaration();
+	unsigned int segments = desc.autoSegments.Resolve( desc.radius, desc.segments );
+	Color diffuse = desc.diffuse;
+	Color specular = desc.specular;
+	float radius = desc.radius;
+	float height = desc.height;
+	V3< float > center = desc.center;
+	int textureMode = desc.textureMode;
+	Effect::ptr effect = desc.effect;
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
+	unify::TexArea texArea = desc.texArea;
+	bool caps = desc.caps;
+	bool merged = desc.merged;
 
-		if( segments < 3 ) segments = 3;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
 
-		height *= 0.5f;
+	if( segments < 3 ) segments = 3;
 
-		size_t vertexCount = (segments + 1) * 2;
-		size_t indexCount = 0;
-		if( caps )
-		{
-			vertexCount += (segments + 2) * 2;
-			indexCount = segments * 3 * 1;
-		}
+	height *= 0.5f;
 
-		BufferSet & set = primitiveList.AddBufferSet();
-		set.SetEffect( effect );
+	size_t vertexCount = (segments + 1) * 2;
+	size_t indexCount = 0;
+	if( caps )
+	{
+		vertexCount += (segments + 2) * 2;
+		indexCount = segments * 3 * 1;
+	}
+
+	// Merged, the side strip is converted to a list ahead of the cap.
+	size_t capStart = merged ? segments * 2 * 3 : 0;
+	indexCount += capStart;
 
-		std::shared_ptr< unsigned char > vertices( new unsigned char[vd->GetSizeInBytes( 0 ) * vertexCount] );
-		DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
 
-		VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
+	std::shared_ptr< unsigned char > vertices( new unsigned char[vd->GetSizeInBytes( 0 ) * vertexCount] );
+	DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
 
-		std::vector< Index32 > indices( indexCount );
+	VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
 
+	std::vector< Index32 > indices;
+	if( merged )
+	{
+		AppendTriangleStrip( indices, 0, segments * 2 );
+		AddMethod( set, RenderMethod::CreateTriangleListIndexed( (unsigned int)vertexCount, (unsigned int)indexCount, 0, 0 ) );
+	}
+	else
+	{
 		// Method 1 - Triangle Strip (sides)
-		set.AddMethod( RenderMethod::CreateTriangleStrip( 0, segments * 2 ) );
+		AddMethod( set, RenderMethod::CreateTriangleStrip( 0, segments * 2 ) );
 
 		if( caps )
 		{
-			set.AddMethod( RenderMethod::CreateTriangleListIndexed( segments + 1, segments * 3, 0, 0 ) );
+			AddMethod( set, RenderMethod::CreateTriangleListIndexed( segments + 1, segments * 3, 0, 0 ) );
 		}
+	}
+	indices.resize( indexCount );
 
-		unsigned short stream = 0;
+	unsigned short stream = 0;
 
-		VertexElement positionE = CommonVertexElement::Position( stream );
-		VertexElement normalE = CommonVertexElement::Normal( stream );
-		VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
-		VertexElement specularE = CommonVertexElement::Specular( stream );
-		VertexElement texE = CommonVertexElement::TexCoords( stream );
+	VertexElement positionE = CommonVertexElement::Position( stream );
+	VertexElement normalE = CommonVertexElement::Normal( stream );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+	VertexElement specularE = CommonVertexElement::Specular( stream );
+	VertexElement texE = CommonVertexElement::TexCoords( stream );
 
-		struct V
-		{
-			V3< float > pos;
-			V3< float > normal;
-			Color diffuse;
-			Color specular;
-			TexCoords coords;
-		};
-		qjson::Object jsonFormat;
-		jsonFormat.Add( { "Position", "Float3" } );
-		jsonFormat.Add( { "Normal", "Float3" } );
-		jsonFormat.Add( { "Diffuse", "Color" } );
-		jsonFormat.Add( { "Specular", "Color" } );
-		jsonFormat.Add( { "TexCoord", "TexCoord" } );
-		VertexDeclaration::ptr vFormat( new VertexDeclaration( jsonFormat ) );
-
-		unify::V3< float > pos;
-		unify::V3< float > norm;
-		float rad = 0;
-		float radChange = PI2 / segments;
-		unify::TexCoords cChange;
-		cChange.u = (texArea.dr.u - texArea.ul.u) / segments;
-
-		// Sides...
-		double dRad = 0;
-		double dRadChange = PI2 / segments;
-		for( unsigned int s = 0; s <= segments; s++ )
+	// Positions are built around the origin, then normalized, moved to center and bounded in bulk. The apex
+	// vertices all sit at the origin, so their normals come from a separate direction per side.
+	std::vector< float > sines( segments + 1 );
+	std::vector< float > cosines( segments + 1 );
+	kernels::SinCos( 0.0f, PI2 / segments, segments + 1, sines.data(), cosines.data() );
+
+	std::vector< V3< float > > positions( vertexCount );
+	std::vector< V3< float > > directions( vertexCount );
+	std::vector< TexCoords > coords( vertexCount );
+	float uChange = (texArea.dr.u - texArea.ul.u) / segments;
+
+	const unsigned int capRim = segments * 2 + 2;
+	const unsigned int capCenter = capRim + segments + 1;
+
+	// Sides...
+	for( unsigned int s = 0; s <= segments; s++ )
+	{
+		float sine = sines[s];
+		float cosine = cosines[s];
+
+		positions[(s * 2) + 0] = V3< float >( 0, 0, 0 );
+		directions[(s * 2) + 0] = V3< float >( sine * radius, -height, cosine * radius );
+		coords[(s * 2) + 0] = TexCoords( uChange * s, texArea.dr.v );
+
+		positions[(s * 2) + 1] = V3< float >( sine * radius, height, cosine * radius );
+		directions[(s * 2) + 1] = positions[(s * 2) + 1];
+		coords[(s * 2) + 1] = TexCoords( uChange * s, texArea.ul.v );
+
+		if( caps )
 		{
-			pos = V3< float >( sin( rad ) * radius, -height, cos( rad ) * radius );
-			norm = pos;
-			norm.Normalize();
-			WriteVertex( *vd, lock, (s * 2) + 0, positionE, center );
-			WriteVertex( *vd, lock, (s * 2) + 0, normalE, norm );
-			WriteVertex( *vd, lock, (s * 2) + 0, texE, TexCoords( cChange.u * s, texArea.dr.v ) );
-			WriteVertex( *vd, lock, (s * 2) + 0, diffuseE, diffuse );
-			WriteVertex( *vd, lock, (s * 2) + 0, specularE, specular );
-			vbParameters.bbox += center;
-
-
-			pos = V3< float >( sin( rad ) * radius, height, cos( rad ) * radius );
-			norm = pos;
-			norm.Normalize();
-			WriteVertex( *vd, lock, (s * 2) + 1, positionE, pos + center );
-			WriteVertex( *vd, lock, (s * 2) + 1, normalE, norm );
-			WriteVertex( *vd, lock, (s * 2) + 1, texE, TexCoords( cChange.u * s, texArea.ul.v ) );
-			WriteVertex( *vd, lock, (s * 2) + 1, diffuseE, diffuse );
-			WriteVertex( *vd, lock, (s * 2) + 1, specularE, specular );
-			vbParameters.bbox += pos + center;
-
-			if( caps )
-			{
-				pos = V3< float >( sin( rad ) * radius, height, cos( rad ) * radius );
-				norm = pos;
-				norm.Normalize();
-				WriteVertex( *vd, lock, (segments * 2 + 2) + s, positionE, pos + center );
-				WriteVertex( *vd, lock, (segments * 2 + 2) + s, normalE, norm );
-				WriteVertex( *vd, lock, (segments * 2 + 2) + s, texE, unify::TexCoords( 0.5f + (float)(sin( rad ) * 0.5f), 0.5f + (float)(cos( rad ) * -0.5f) ) );
-				WriteVertex( *vd, lock, (segments * 2 + 2) + s, diffuseE, diffuse );
-				WriteVertex( *vd, lock, (segments * 2 + 2) + s, specularE, specular );
-				vbParameters.bbox += pos + center;
-			}
-			rad += radChange;
+			positions[capRim + s] = V3< float >( sine * radius, height, cosine * radius );
+			directions[capRim + s] = positions[capRim + s];
+			coords[capRim + s] = TexCoords( 0.5f + sine * 0.5f, 0.5f + cosine * -0.5f );
 		}
+	}
 
-		if( caps )
+	if( caps )
+	{
+		for( unsigned int s = 0; s < segments; ++s )
 		{
-			for( unsigned int s = 0; s < segments; ++s )
-			{
-				indices[0 + s * 3] = (segments * 2) + 2 + (s);
-				indices[1 + s * 3] = (segments * 2) + 2 + (s)+1;
-				indices[2 + s * 3] = (segments * 2) + 2 + segments + 1;
-			}
-
-			pos = unify::V3< float >( 0, height, 0 );
-			norm = pos;
-			norm.Normalize();
-			WriteVertex( *vd, lock, segments * 2 + 2 + segments + 1, positionE, pos + center );
-			WriteVertex( *vd, lock, segments * 2 + 2 + segments + 1, normalE, norm );
-			WriteVertex( *vd, lock, segments * 2 + 2 + segments + 1, texE, TexCoords( 0.5f, 0.5f ) );
-			WriteVertex( *vd, lock, segments * 2 + 2 + segments + 1, diffuseE, diffuse );
-			WriteVertex( *vd, lock, segments * 2 + 2 + segments + 1, specularE, specular );
-			vbParameters.bbox += pos + center;
+			indices[capStart + 0 + s * 3] = capRim + (s);
+			indices[capStart + 1 + s * 3] = capRim + (s)+1;
+			indices[capStart + 2 + s * 3] = capCenter;
 		}
 
-		set.AddVertexBuffer( vbParameters );
+		positions[capCenter] = V3< float >( 0, height, 0 );
+		directions[capCenter] = positions[capCenter];
+		coords[capCenter] = TexCoords( 0.5f, 0.5f );
+	}
+
+	std::vector< V3< float > > normals( vertexCount );
+	kernels::Normalize( directions.data(), normals.data(), vertexCount );
+	kernels::Transform( kernels::Affine::Translation( center ), positions.data(), positions.data(), vertexCount );
+	kernels::Bounds( positions.data(), vertexCount, vbParameters.bbox );
+
+	for( size_t v = 0; v < vertexCount; ++v )
+	{
+		WriteVertex( *vd, lock, v, positionE, positions[v] );
+		WriteVertex( *vd, lock, v, normalE, normals[v] );
+		WriteVertex( *vd, lock, v, texE, coords[v] );
+		WriteVertex( *vd, lock, v, diffuseE, diffuse );
+		WriteVertex( *vd, lock, v, specularE, specular );
+	}
+
+	AddVertexBuffer( set, vbParameters );
+
+	if( indexCount > 0 )
+	{
+		AddIndexBuffer( set, { { { indexCount, &indices[0] } }, bufferUsage } );
+	}
+}
+
+void Cone::CreateIndexed( PrimitiveList & primitiveList, const ConeDesc & desc ) const
+{
+	using namespace unify;
+
+	unsigned int segments = desc.autoSegments.Resolve( desc.radius, desc.segments );
+	float radius = desc.radius;
+	float height = desc.height;
+	V3< float > center = desc.center;
+	Effect::ptr effect = desc.effect;
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
+	unify::TexArea texArea = desc.texArea;
+	bool caps = desc.caps;
+
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+
+	if( segments < 3 ) segments = 3;
+
+	height *= 0.5f;
+
+	// The rim carries the same normals the cap used, so the cap is fanned from the rim around a single center
+	// vertex. The cap takes the side's texture coordinates.
+	const unsigned int ringVertices = (segments + 1) * 2;
+	const unsigned int capCenter = ringVertices;
+	size_t vertexCount = ringVertices + (caps ? 1 : 0);
+
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
+
+	std::vector< unsigned char > vertices( vd->GetSizeInBytes( 0 ) * vertexCount );
+	DataLock lock( vertices.data(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
 
-		if( indexCount > 0 )
+	VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.data() } }, bufferUsage };
+
+	unsigned short stream = 0;
+
+	VertexElement positionE = CommonVertexElement::Position( stream );
+	VertexElement normalE = CommonVertexElement::Normal( stream );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+	VertexElement specularE = CommonVertexElement::Specular( stream );
+	VertexElement texE = CommonVertexElement::TexCoords( stream );
+
+	// The apex keeps one vertex per segment, each with the normal of its own side. Vertices are staged around
+	// the origin with unnormalized directions, then normalized, moved to center and bounded in bulk.
+	std::vector< V3< float > > positions( vertexCount );
+	std::vector< V3< float > > directions( vertexCount );
+	std::vector< TexCoords > coords( vertexCount );
+	auto place = [&]( size_t index, V3< float > pos, V3< float > direction, TexCoords texCoords )
+	{
+		positions[index] = pos;
+		directions[index] = direction;
+		coords[index] = texCoords;
+	};
+
+	std::vector< float > sines( segments + 1 );
+	std::vector< float > cosines( segments + 1 );
+	kernels::SinCos( 0.0f, PI2 / segments, segments + 1, sines.data(), cosines.data() );
+
+	float uChange = (texArea.dr.u - texArea.ul.u) / segments;
+	for( unsigned int s = 0; s <= segments; s++ )
+	{
+		place( (s * 2) + 0, V3< float >( 0, 0, 0 ), V3< float >( sines[s] * radius, -height, cosines[s] * radius ), TexCoords( uChange * s, texArea.dr.v ) );
+
+		V3< float > rim( sines[s] * radius, height, cosines[s] * radius );
+		place( (s * 2) + 1, rim, rim, TexCoords( uChange * s, texArea.ul.v ) );
+	}
+
+	std::vector< Index32 > indices;
+	AppendTriangleStrip( indices, 0, segments * 2 );
+
+	if( caps )
+	{
+		V3< float > pos( 0, height, 0 );
+		place( capCenter, pos, pos, TexCoords( 0.5f, 0.5f ) );
+
+		for( unsigned int s = 0; s < segments; ++s )
 		{
-			set.AddIndexBuffer( { { { indexCount, &indices[0] } }, bufferUsage } );
+			indices.push_back( (s * 2) + 1 );
+			indices.push_back( ((s + 1) * 2) + 1 );
+			indices.push_back( capCenter );
 		}
 	}
-	catch( std::exception & ex )
+
+	std::vector< V3< float > > normals( vertexCount );
+	kernels::Normalize( directions.data(), normals.data(), vertexCount );
+	kernels::Transform( kernels::Affine::Translation( center ), positions.data(), positions.data(), vertexCount );
+	kernels::Bounds( positions.data(), vertexCount, vbParameters.bbox );
+
+	for( size_t v = 0; v < vertexCount; ++v )
 	{
-		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+		WriteVertex( *vd, lock, v, positionE, positions[v] );
+		WriteVertex( *vd, lock, v, normalE, normals[v] );
+		WriteVertex( *vd, lock, v, texE, coords[v] );
+		WriteVertex( *vd, lock, v, diffuseE, desc.diffuse );
+		WriteVertex( *vd, lock, v, specularE, desc.specular );
 	}
+
+	AddMethod( set, RenderMethod::CreateTriangleListIndexed( (unsigned int)vertexCount, (unsigned int)indices.size(), 0, 0 ) );
+	AddVertexBuffer( set, vbParameters );
+	AddIndexBuffer( set, { { { indices.size(), &indices[0] } }, bufferUsage } );
+}
+
+IShapeQuery::ptr Cone::CreateQuery( const ConeDesc & desc ) const
+{
+	// The base is drawn at half the height above the apex.
+	return RevolvedQuery::CreateCone( desc.center, desc.radius, desc.height * 0.5f, desc.caps );
 }
@@ -3,9 +3,34 @@
 #pragma once
 
 #include <me/sculpter/IShapeCreator.h>
+#include <shapes/ShapeDesc.h>
+#include <shapes/ShapeQuery.h>
+#include <shapes/AutoSegments.h>
+#include <me/render/TextureMode.h>
+#include <unify/TexArea.h>
 
 namespace shapes
 {
+	struct ConeDesc : public ShapeDesc
+	{
+		ConeDesc();
+		ConeDesc( const unify::Parameters & parameters );
+
+		float radius;
+		float height;
+		unsigned int segments;
+		me::render::TextureMode::TYPE textureMode;
+		unify::TexArea texArea;
+		bool caps;
+
+		// Every part shares one index buffer and draws as a single indexed triangle list.
+		bool merged;
+
+		// Each ring position is written once per distinct normal and the caps reuse the rim. Implies merged.
+		bool indexed;
+		AutoSegments autoSegments;
+	};
+
 	class Cone : public me::sculpter::IShapeCreator
 	{
 	public:
@@ -13,5 +38,14 @@ namespace shapes
 		~Cone() override;
 
 		void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+		void Create( me::render::PrimitiveList & primitiveList, const ConeDesc & desc ) const;
+
+		/// <summary>
+		/// The exact shape desc describes, for picking and containment without its triangles.
+		/// </summary>
+		IShapeQuery::ptr CreateQuery( const ConeDesc & desc ) const;
+
+	private:
+		void CreateIndexed( me::render::PrimitiveList & primitiveList, const ConeDesc & desc ) const;
 	};
 }
@@ -0,0 +1,47 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+namespace shapes
+{
+	/// <summary>
+	/// Makes an object current for the calling thread for the life of the scope, restoring the one it replaced
+	/// when it ends. Creators reach the side outputs and state a caller set up, such as a recorder or a table,
+	/// through T's Current, without the object being passed through every Create. Scopes nest, and must end in
+	/// the reverse order they began.
+	/// </summary>
+	template< typename T >
+	class CurrentScope
+	{
+	public:
+		CurrentScope( T & current )
+			: m_previous{ s_current }
+		{
+			s_current = &current;
+		}
+
+		~CurrentScope()
+		{
+			s_current = m_previous;
+		}
+
+		CurrentScope( const CurrentScope & ) = delete;
+		CurrentScope & operator=( const CurrentScope & ) = delete;
+
+		/// <summary>
+		/// Returns the object current for the calling thread, or nullptr.
+		/// </summary>
+		static T * Get()
+		{
+			return s_current;
+		}
+
+	private:
+		T * m_previous;
+
+		static thread_local T * s_current;
+	};
+
+	template< typename T >
+	thread_local T * CurrentScope< T >::s_current = nullptr;
+}
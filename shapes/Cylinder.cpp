@@ -2,6 +2,10 @@
 // All Rights Reserved
 
 #include <shapes/Cylinder.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapeTransform.h>
+#include <shapes/CollisionProxy.h>
+#include <shapes/ShapeKernels.h>
 #include <me/render/VertexUtil.h>
 #include <me/exception/NotImplemented.h>
 #include <me/exception/FailedToCreate.h>
@@ -16,7 +20,30 @@ using namespace shapes;
 
 const float PI = 3.14159265358979f;
 const float PI2 = 6.28318530717959f;
-const std::string DefaultBufferUsage = "Default";
+
+CylinderDesc::CylinderDesc()
+	: radius{ 0.5f }
+	, height{ 1.0f }
+	, segments{ 12 }
+	, texArea{ unify::TexCoords( 0, 0 ), unify::TexCoords( 1, 1 ) }
+	, caps{ true }
+	, merged{ false }
+	, indexed{ false }
+{
+}
+
+CylinderDesc::CylinderDesc( const unify::Parameters & parameters )
+	: ShapeDesc( parameters )
+	, radius{ parameters.Get( "radius", 0.5f ) }
+	, height{ parameters.Get( "height", 1.0f ) }
+	, segments{ parameters.Get< unsigned int >( "segments", 12 ) }
+	, texArea{ parameters.Get< unify::TexArea >( "texarea", unify::TexArea( unify::TexCoords( 0, 0 ), unify::TexCoords( 1, 1 ) ) ) }
+	, caps{ parameters.Get( "caps", true ) }
+	, merged{ parameters.Get( "merged", false ) }
+	, indexed{ parameters.Get( "indexed", false ) }
+	, autoSegments{ parameters }
+{
+}
 
 Cylinder::Cylinder()
 {
@@ -27,162 +54,300 @@ Cylinder::~Cylinder()
 }
 
 void Cylinder::Create(PrimitiveList & primitiveList, const unify::Parameters & parameters ) const
+{
+	try
+	{
+		Create( primitiveList, CylinderDesc( parameters ) );
+	}
+	catch( std::exception & ex )
+	{
+		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+	}
+}
+
+void Cylinder::Create(PrimitiveList & primitiveList, const CylinderDesc & desc ) const
 {
 	using namespace unify;
 
-	try
+	if( desc.canonical )
 	{
-		float radius = parameters.Get( "radius", 0.5f );
-		unsigned int segments = parameters.Get< unsigned int >( "segments", 12 );
-		float height = parameters.Get( "height", 1.0f );
-		Color diffuse = parameters.Get( "diffuse", ColorWhite() );
-		Color specular = parameters.Get( "specular", ColorWhite() );
-		V3< float > center = parameters.Get( "center", V3< float >( 0, 0, 0 ) );
-		TexArea texArea = parameters.Get< TexArea >( "texarea", TexArea( unify::TexCoords( 0, 0 ), TexCoords( 1, 1 ) ) );
-		// TODO: support top and bottom texArea.
-		Effect::ptr effect = parameters.Get< Effect::ptr >( "effect" );
-		VertexDeclaration::ptr vd = effect->GetVertexShader()->GetVertexDeclaration();
-		bool caps = parameters.Get( "caps", true );
-		BufferUsage::TYPE bufferUsage = BufferUsage::FromString( parameters.Get( "bufferusage", DefaultBufferUsage ) );
-
-		if( segments < 3 ) segments = 3;
-
-		height *= 0.5f;
-
-		size_t vertexCount = (segments + 1) * 2;
-		size_t indexCount = 0;
-		if( caps )
-		{
-			vertexCount += (segments + 2) * 2;
-			indexCount = segments * 3 * 2;
-		}
+		CylinderDesc unit = desc;
+		unit.canonical = false;
+		unit.center = V3< float >( 0, 0, 0 );
+		unit.radius = 1.0f;
+		unit.height = 1.0f;
+		unit.segments = desc.autoSegments.Resolve( desc.radius, desc.segments );
+		unit.autoSegments.enabled = false;
+		ShapeTransform::Report( V3< float >( desc.radius, desc.height, desc.radius ), desc.center );
+		Create( primitiveList, unit );
+		return;
+	}
+
+	if( desc.collision )
+	{
+		AddCollisionProxy( CollisionProxy::MakeCylinder( desc.center, desc.radius, desc.height ) );
+	}
+
+	if( desc.indexed )
+	{
+		CreateIndexed( primitiveList, desc );
+		return;
+	}
+
+	float radius = desc.radius;
+	unsigned int segments = desc.autoSegments.Resolve( desc.radius, desc.segments );
+	float height = desc.height;
+	Color diffuse = desc.diffuse;
+	Color specular = desc.specular;
+	V3< float > center = desc.center;
+	TexArea texArea = desc.texArea;
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	bool caps = desc.caps;
+	bool merged = desc.merged;
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
+
+	if( segments < 3 ) segments = 3;
 
-		BufferSet & set = primitiveList.AddBufferSet();
-		set.SetEffect( effect );
+	height *= 0.5f;
+
+	size_t vertexCount = (segments + 1) * 2;
+	size_t indexCount = 0;
+	if( caps )
+	{
+		vertexCount += (segments + 2) * 2;
+		indexCount = segments * 3 * 2;
+	}
 
-		std::shared_ptr< unsigned char > vertices( new unsigned char[vd->GetSizeInBytes( 0 ) * vertexCount] );
-		DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
+	// Merged, the side strip is converted to a list ahead of the caps.
+	size_t capStart = merged ? segments * 2 * 3 : 0;
+	indexCount += capStart;
 
-		std::vector< Index32 > indices( indexCount );
-		VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
 
+	std::shared_ptr< unsigned char > vertices( new unsigned char[vd->GetSizeInBytes( 0 ) * vertexCount] );
+	DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
+
+	VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
+
+	std::vector< Index32 > indices;
+	if( merged )
+	{
+		AppendTriangleStrip( indices, 0, segments * 2 );
+		AddMethod( set, RenderMethod::CreateTriangleListIndexed( (unsigned int)vertexCount, (unsigned int)indexCount, 0, 0 ) );
+	}
+	else
+	{
 		// Method 1 - Triangle Strip (sides)
-		set.AddMethod( RenderMethod::CreateTriangleStrip( 0, segments * 2 ) );
+		AddMethod( set, RenderMethod::CreateTriangleStrip( 0, segments * 2 ) );
 
 		if( caps )
 		{
-			set.AddMethod( RenderMethod::CreateTriangleListIndexed( segments + 1, segments * 3, 0, 0 ) );
-			set.AddMethod( RenderMethod::CreateTriangleListIndexed( segments + 1, segments * 3, segments * 3, 0 ) );
+			AddMethod( set, RenderMethod::CreateTriangleListIndexed( segments + 1, segments * 3, 0, 0 ) );
+			AddMethod( set, RenderMethod::CreateTriangleListIndexed( segments + 1, segments * 3, segments * 3, 0 ) );
 		}
+	}
+	indices.resize( indexCount );
 
-		unsigned short stream = 0;
-
-		VertexElement positionE = CommonVertexElement::Position( stream );
-		VertexElement normalE = CommonVertexElement::Normal( stream );
-		VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
-		VertexElement specularE = CommonVertexElement::Specular( stream );
-		VertexElement texE = CommonVertexElement::TexCoords( stream );
-	
-		V3< float > pos;
-		V3< float > norm;
-		float rad = 0;
-		float radChange = PI2 / segments;
-		TexCoords cChange;
-		cChange.u = (texArea.dr.u - texArea.ul.u) / segments;
-
-		// Sides...
-		double dRad = 0;
-		double dRadChange = PI2 / segments;
-		for( unsigned int s = 0; s <= segments; s++ )
+	unsigned short stream = 0;
+
+	VertexElement positionE = CommonVertexElement::Position( stream );
+	VertexElement normalE = CommonVertexElement::Normal( stream );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+	VertexElement specularE = CommonVertexElement::Specular( stream );
+	VertexElement texE = CommonVertexElement::TexCoords( stream );
+
+	// Positions are built around the origin, then normalized, moved to center and bounded in bulk.
+	std::vector< float > sines( segments + 1 );
+	std::vector< float > cosines( segments + 1 );
+	kernels::SinCos( 0.0f, PI2 / segments, segments + 1, sines.data(), cosines.data() );
+
+	std::vector< V3< float > > positions( vertexCount );
+	std::vector< TexCoords > coords( vertexCount );
+	float uChange = (texArea.dr.u - texArea.ul.u) / segments;
+
+	const unsigned int topRim = segments * 2 + 2;
+	const unsigned int topCenter = topRim + segments + 1;
+	const unsigned int bottomRim = topRim + segments + 2;
+	const unsigned int bottomCenter = topRim + ((segments + 1) * 2) + 1;
+
+	// Sides...
+	for( unsigned int s = 0; s <= segments; s++ )
+	{
+		float sine = sines[s];
+		float cosine = cosines[s];
+
+		positions[(s * 2) + 0] = V3< float >( sine * radius, -height, cosine * radius );
+		coords[(s * 2) + 0] = TexCoords( uChange * s, texArea.dr.v );
+
+		positions[(s * 2) + 1] = V3< float >( sine * radius, height, cosine * radius );
+		coords[(s * 2) + 1] = TexCoords( uChange * s, texArea.ul.v );
+
+		if( caps )
 		{
-			pos = unify::V3< float >( sin( rad ) * radius, -height, cos( rad ) * radius );
-			norm = pos;
-			norm.Normalize();
-			WriteVertex( *vd, lock, (s * 2) + 0, positionE, pos + center );
-			WriteVertex( *vd, lock, (s * 2) + 0, normalE, norm );
-			WriteVertex( *vd, lock, (s * 2) + 0, texE, TexCoords( cChange.u * s, texArea.dr.v ) );
-			WriteVertex( *vd, lock, (s * 2) + 0, diffuseE, diffuse );
-			WriteVertex( *vd, lock, (s * 2) + 0, specularE, specular );
-			vbParameters.bbox += pos + center;
-
-			pos = unify::V3< float >( sin( rad ) * radius, height, cos( rad ) * radius );
-			norm = pos;
-			norm.Normalize();
-			WriteVertex( *vd, lock, (s * 2) + 1, positionE, pos + center );
-			WriteVertex( *vd, lock, (s * 2) + 1, normalE, norm );
-			WriteVertex( *vd, lock, (s * 2) + 1, texE, TexCoords( cChange.u * s, texArea.ul.v ) );
-			WriteVertex( *vd, lock, (s * 2) + 1, diffuseE, diffuse );
-			WriteVertex( *vd, lock, (s * 2) + 1, specularE, specular );
-			vbParameters.bbox += pos + center;
-
-			if( caps )
-			{
-				pos = unify::V3< float >( sin( rad ) * radius, height, cos( rad ) * radius );
-				norm = pos;
-				norm.Normalize();
-				WriteVertex( *vd, lock, (segments * 2 + 2) + s, positionE, pos + center );
-				WriteVertex( *vd, lock, (segments * 2 + 2) + s, normalE, norm );
-				WriteVertex( *vd, lock, (segments * 2 + 2) + s, texE, TexCoords( 0.5f + (float)(sin( rad ) * 0.5f), 0.5f + (float)(cos( rad ) * -0.5f) ) );
-				WriteVertex( *vd, lock, (segments * 2 + 2) + s, diffuseE, diffuse );
-				WriteVertex( *vd, lock, (segments * 2 + 2) + s, specularE, specular );
-				vbParameters.bbox += pos + center;
-
-				pos = unify::V3< float >( cos( rad ) * radius, -height, sin( rad ) * radius );
-				norm = pos;
-				norm.Normalize();
-				WriteVertex( *vd, lock, (segments * 2 + 2) + (segments + 2) + s, positionE, pos + center );
-				WriteVertex( *vd, lock, (segments * 2 + 2) + (segments + 2) + s, normalE, norm );
-				WriteVertex( *vd, lock, (segments * 2 + 2) + (segments + 2) + s, texE, TexCoords( 0.5f + (float)(sin( rad ) * 0.5f), 0.5f + (float)(cos( rad ) * -0.5f) ) );
-				WriteVertex( *vd, lock, (segments * 2 + 2) + (segments + 2) + s, diffuseE, diffuse );
-				WriteVertex( *vd, lock, (segments * 2 + 2) + (segments + 2) + s, specularE, specular );
-				vbParameters.bbox += pos + center;
-			}
-			rad += radChange;
+			TexCoords capCoords( 0.5f + sine * 0.5f, 0.5f + cosine * -0.5f );
+
+			positions[topRim + s] = V3< float >( sine * radius, height, cosine * radius );
+			coords[topRim + s] = capCoords;
+
+			positions[bottomRim + s] = V3< float >( cosine * radius, -height, sine * radius );
+			coords[bottomRim + s] = capCoords;
 		}
+	}
 
-		if( caps )
+	if( caps )
+	{
+		for( unsigned int s = 0; s < segments; ++s )
 		{
-			for( unsigned int s = 0; s < segments; ++s )
-			{
-				indices[0 + s * 3] = (segments * 2) + 2 + (s);
-				indices[1 + s * 3] = (segments * 2) + 2 + (s)+1;
-				indices[2 + s * 3] = (segments * 2) + 2 + segments + 1;
-
-				indices[(segments * 3) + 0 + s * 3] = (segments * 2) + 2 + segments + 2 + (s);
-				indices[(segments * 3) + 2 + s * 3] = (segments * 2) + 2 + segments + 2 + (s)+1;
-				indices[(segments * 3) + 1 + s * 3] = (segments * 2) + 2 + segments + 2 + segments + 1;
-			}
-
-			pos = unify::V3< float >( 0, height, 0 );
-			norm = pos;
-			norm.Normalize();
-			WriteVertex( *vd, lock, segments * 2 + 2 + segments + 1, positionE, pos + center );
-			WriteVertex( *vd, lock, segments * 2 + 2 + segments + 1, normalE, norm );
-			WriteVertex( *vd, lock, segments * 2 + 2 + segments + 1, texE, TexCoords( 0.5f, 0.5f ) );
-			WriteVertex( *vd, lock, segments * 2 + 2 + segments + 1, diffuseE, diffuse );
-			WriteVertex( *vd, lock, segments * 2 + 2 + segments + 1, specularE, specular );
-			vbParameters.bbox += pos + center;
-
-			pos.y = -height;
-			norm = pos;
-			norm.Normalize();
-			WriteVertex( *vd, lock, segments * 2 + 2 + ((segments + 1) * 2) + 1, positionE, pos + center );
-			WriteVertex( *vd, lock, segments * 2 + 2 + ((segments + 1) * 2) + 1, normalE, norm );
-			WriteVertex( *vd, lock, segments * 2 + 2 + ((segments + 1) * 2) + 1, texE, TexCoords( 0.5f, 0.5f ) );
-			WriteVertex( *vd, lock, segments * 2 + 2 + ((segments + 1) * 2) + 1, diffuseE, diffuse );
-			WriteVertex( *vd, lock, segments * 2 + 2 + ((segments + 1) * 2) + 1, specularE, specular );
-			vbParameters.bbox += pos + center;
+			indices[capStart + 0 + s * 3] = topRim + (s);
+			indices[capStart + 1 + s * 3] = topRim + (s)+1;
+			indices[capStart + 2 + s * 3] = topCenter;
+
+			indices[capStart + (segments * 3) + 0 + s * 3] = bottomRim + (s);
+			indices[capStart + (segments * 3) + 2 + s * 3] = bottomRim + (s)+1;
+			indices[capStart + (segments * 3) + 1 + s * 3] = bottomCenter;
 		}
 
-		set.AddVertexBuffer( vbParameters );
+		positions[topCenter] = V3< float >( 0, height, 0 );
+		coords[topCenter] = TexCoords( 0.5f, 0.5f );
+
+		positions[bottomCenter] = V3< float >( 0, -height, 0 );
+		coords[bottomCenter] = TexCoords( 0.5f, 0.5f );
+	}
+
+	std::vector< V3< float > > normals( vertexCount );
+	kernels::Normalize( positions.data(), normals.data(), vertexCount );
+	kernels::Transform( kernels::Affine::Translation( center ), positions.data(), positions.data(), vertexCount );
+	kernels::Bounds( positions.data(), vertexCount, vbParameters.bbox );
+
+	for( size_t v = 0; v < vertexCount; ++v )
+	{
+		WriteVertex( *vd, lock, v, positionE, positions[v] );
+		WriteVertex( *vd, lock, v, normalE, normals[v] );
+		WriteVertex( *vd, lock, v, texE, coords[v] );
+		WriteVertex( *vd, lock, v, diffuseE, diffuse );
+		WriteVertex( *vd, lock, v, specularE, specular );
+	}
+
+	AddVertexBuffer( set, vbParameters );
+
+	if( indexCount > 0 )
+	{
+		AddIndexBuffer( set, { { { indexCount, &indices[0] } }, bufferUsage } );
+	}
+}
+
+void Cylinder::CreateIndexed( PrimitiveList & primitiveList, const CylinderDesc & desc ) const
+{
+	using namespace unify;
+
+	float radius = desc.radius;
+	unsigned int segments = desc.autoSegments.Resolve( desc.radius, desc.segments );
+	float height = desc.height;
+	V3< float > center = desc.center;
+	TexArea texArea = desc.texArea;
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	bool caps = desc.caps;
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
+
+	if( segments < 3 ) segments = 3;
+
+	height *= 0.5f;
+
+	// The side rings carry the same normals the caps used, so the caps are fanned from the rims around a
+	// single center vertex each. The caps take the sides' texture coordinates.
+	const unsigned int ringVertices = (segments + 1) * 2;
+	const unsigned int topCenter = ringVertices;
+	const unsigned int bottomCenter = ringVertices + 1;
+	size_t vertexCount = ringVertices + (caps ? 2 : 0);
+
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
+
+	std::vector< unsigned char > vertices( vd->GetSizeInBytes( 0 ) * vertexCount );
+	DataLock lock( vertices.data(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
+
+	VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.data() } }, bufferUsage };
 
-		if( indexCount > 0 )
+	unsigned short stream = 0;
+
+	VertexElement positionE = CommonVertexElement::Position( stream );
+	VertexElement normalE = CommonVertexElement::Normal( stream );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+	VertexElement specularE = CommonVertexElement::Specular( stream );
+	VertexElement texE = CommonVertexElement::TexCoords( stream );
+
+	// Vertices are staged around the origin, then normalized, moved to center and bounded in bulk.
+	std::vector< V3< float > > positions( vertexCount );
+	std::vector< TexCoords > coords( vertexCount );
+	auto place = [&]( size_t index, V3< float > pos, TexCoords texCoords )
+	{
+		positions[index] = pos;
+		coords[index] = texCoords;
+	};
+
+	std::vector< float > sines( segments + 1 );
+	std::vector< float > cosines( segments + 1 );
+	kernels::SinCos( 0.0f, PI2 / segments, segments + 1, sines.data(), cosines.data() );
+
+	float uChange = (texArea.dr.u - texArea.ul.u) / segments;
+	for( unsigned int s = 0; s <= segments; s++ )
+	{
+		place( (s * 2) + 0, V3< float >( sines[s] * radius, -height, cosines[s] * radius ), TexCoords( uChange * s, texArea.dr.v ) );
+		place( (s * 2) + 1, V3< float >( sines[s] * radius, height, cosines[s] * radius ), TexCoords( uChange * s, texArea.ul.v ) );
+	}
+
+	std::vector< Index32 > indices;
+	AppendTriangleStrip( indices, 0, segments * 2 );
+
+	if( caps )
+	{
+		place( topCenter, V3< float >( 0, height, 0 ), TexCoords( 0.5f, 0.5f ) );
+		place( bottomCenter, V3< float >( 0, -height, 0 ), TexCoords( 0.5f, 0.5f ) );
+
+		for( unsigned int s = 0; s < segments; ++s )
+		{
+			indices.push_back( (s * 2) + 1 );
+			indices.push_back( ((s + 1) * 2) + 1 );
+			indices.push_back( topCenter );
+		}
+		// The rim here runs the other way around from Create's bottom rim, which swaps sine and cosine, so the
+		// order is swapped too to face the same way.
+		for( unsigned int s = 0; s < segments; ++s )
 		{
-			set.AddIndexBuffer( { { { indexCount, &indices[0] } }, bufferUsage } );
+			indices.push_back( s * 2 );
+			indices.push_back( (s + 1) * 2 );
+			indices.push_back( bottomCenter );
 		}
 	}
-	catch( std::exception & ex )
+
+	std::vector< V3< float > > normals( vertexCount );
+	kernels::Normalize( positions.data(), normals.data(), vertexCount );
+	kernels::Transform( kernels::Affine::Translation( center ), positions.data(), positions.data(), vertexCount );
+	kernels::Bounds( positions.data(), vertexCount, vbParameters.bbox );
+
+	for( size_t v = 0; v < vertexCount; ++v )
 	{
-		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+		WriteVertex( *vd, lock, v, positionE, positions[v] );
+		WriteVertex( *vd, lock, v, normalE, normals[v] );
+		WriteVertex( *vd, lock, v, texE, coords[v] );
+		WriteVertex( *vd, lock, v, diffuseE, desc.diffuse );
+		WriteVertex( *vd, lock, v, specularE, desc.specular );
 	}
+
+	AddMethod( set, RenderMethod::CreateTriangleListIndexed( (unsigned int)vertexCount, (unsigned int)indices.size(), 0, 0 ) );
+	AddVertexBuffer( set, vbParameters );
+	AddIndexBuffer( set, { { { indices.size(), &indices[0] } }, bufferUsage } );
+}
+
+IShapeQuery::ptr Cylinder::CreateQuery( const CylinderDesc & desc ) const
+{
+	return RevolvedQuery::CreateCylinder( desc.center, desc.radius, desc.height, desc.caps );
+}
+
+OccluderMesh Cylinder::CreateOccluder( const CylinderDesc & desc, unsigned int segments ) const
+{
+	return OccluderMesh::MakeCylinder( desc.center, desc.radius, desc.height, segments, desc.caps );
 }
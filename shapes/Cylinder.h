@@ -3,9 +3,33 @@
 #pragma once
 
 #include <me/sculpter/IShapeCreator.h>
+#include <shapes/ShapeDesc.h>
+#include <shapes/ShapeQuery.h>
+#include <shapes/Occlusion.h>
+#include <shapes/AutoSegments.h>
+#include <unify/TexArea.h>
 
 namespace shapes
 {
+	struct CylinderDesc : public ShapeDesc
+	{
+		CylinderDesc();
+		CylinderDesc( const unify::Parameters & parameters );
+
+		float radius;
+		float height;
+		unsigned int segments;
+		unify::TexArea texArea;
+		bool caps;
+
+		// Every part shares one index buffer and draws as a single indexed triangle list.
+		bool merged;
+
+		// Each ring position is written once per distinct normal and the caps reuse the rims. Implies merged.
+		bool indexed;
+		AutoSegments autoSegments;
+	};
+
 	class Cylinder : public me::sculpter::IShapeCreator
 	{
 	public:
@@ -13,5 +37,19 @@ namespace shapes
 		~Cylinder() override;
 
 		void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+		void Create( me::render::PrimitiveList & primitiveList, const CylinderDesc & desc ) const;
+
+		/// <summary>
+		/// The exact shape desc describes, for picking and containment without its triangles.
+		/// </summary>
+		IShapeQuery::ptr CreateQuery( const CylinderDesc & desc ) const;
+
+		/// <summary>
+		/// A low detail stand in for occlusion culling, inside the shape desc describes.
+		/// </summary>
+		OccluderMesh CreateOccluder( const CylinderDesc & desc, unsigned int segments = 8 ) const;
+
+	private:
+		void CreateIndexed( me::render::PrimitiveList & primitiveList, const CylinderDesc & desc ) const;
 	};
 }
\ No newline at end of file
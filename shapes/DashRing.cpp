@@ -1,170 +1,366 @@
-// Copyright (c) 2002 - 2018, Kit10 Studios LLC
-// All Rights Reserved
-
-#include <shapes/DashRing.h>
-#include <me/render/VertexUtil.h>
-#include <me/exception/NotImplemented.h>
-#include <me/exception/FailedToCreate.h>
-#include <unify/String.h>
-#include <unify/Size3.h>
-#include <unify/TexArea.h>
-#include <unify/Angle.h>
-
-using namespace me;
-using namespace render;
-using namespace shapes;
-
-const float PI = 3.14159265358979f;
-const float PI2 = 6.28318530717959f;
-const std::string DefaultBufferUsage = "Default";
-
-DashRing::DashRing()
-{
-}
-
-DashRing::~DashRing()
-{
-}
-
-void DashRing::Create(PrimitiveList & primitiveList, const unify::Parameters & parameters ) const
-{
-	using namespace unify;
-
-	try
-	{
-		float radiusOuter = parameters.Get( "majorradius", 1.0f );
-		float radiusInner = parameters.Get( "minorradius", 0.9f );
-		unsigned int count = parameters.Get( "count", 12 );	// Number of dashes
-		float fSize = parameters.Get( "size1", 0.5f );	// Unit size of visible part of dash (0.0 to 1.0)
-		float definition = parameters.Get( "definition", 4.0f );		// Definition of each dash
-		Color diffuse = parameters.Get( "diffuse", ColorWhite() );
-		Color specular = parameters.Get( "specular", ColorWhite() );
-		V3< float > center = parameters.Get( "center", V3< float >( 0, 0, 0 ) );
-		Effect::ptr effect = parameters.Get< Effect::ptr >( "effect" );
-		VertexDeclaration::ptr vd = effect->GetVertexShader()->GetVertexDeclaration();
-		BufferUsage::TYPE bufferUsage = BufferUsage::FromString( parameters.Get( "bufferusage", DefaultBufferUsage ) );
-
-		int verticesPerSegment = (int)((definition + 1) * 2);
-		int indicesPerSegment = (int)(definition * 6);
-		int facesPerSegment = (int)(definition * 2);
-
-		unsigned int totalVertices = verticesPerSegment * count;
-		unsigned int totalIndices = indicesPerSegment * count;
-		unsigned int totalTriangles = facesPerSegment * count;
-
-		BufferSet & set = primitiveList.AddBufferSet();
-		set.SetEffect( effect );
-
-		// Method 1 - Triangle List...
-		set.AddMethod( RenderMethod::CreateTriangleListIndexed( totalVertices, totalIndices, 0, 0 ) );
-
-		char * vertices = new char[vd->GetSizeInBytes( 0 ) * totalVertices];
-		DataLock lock( vertices, vd->GetSizeInBytes( 0 ), totalVertices, DataLockAccess::ReadWrite, 0 );
-		VertexBufferParameters vbParameters{ vd, { { (unsigned int)count, vertices } }, bufferUsage };
-
-		unsigned short stream = 0;
-
-		VertexElement positionE = CommonVertexElement::Position( stream );
-		VertexElement normalE = CommonVertexElement::Normal( stream );
-		VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
-		VertexElement specularE = CommonVertexElement::Specular( stream );
-		VertexElement texE = CommonVertexElement::TexCoords( stream );
-
-		struct V
-		{
-			V3< float > pos;
-			V3< float > normal;
-			Color diffuse;
-			Color specular;
-			TexCoords coords;
-		};
-		qjson::Object jsonFormat;
-		jsonFormat.Add( { "Position", "Float3" } );
-		jsonFormat.Add( { "Normal", "Float3" } );
-		jsonFormat.Add( { "Diffuse", "Color" } );
-		jsonFormat.Add( { "Specular", "Color" } );
-		jsonFormat.Add( { "TexCoord", "TexCoord" } );
-		VertexDeclaration::ptr vFormat( new VertexDeclaration( jsonFormat ) );
-
-		// Create all the segments (clockwise from top)
-		unify::V3< float > vOuter, vInner, vNorm;
-		unify::TexCoords coordsInner, coordsOuter;
-
-		float fRadChange = ((PI2 / count) * fSize) / definition;
-		float fRadChangeSeg = (PI2 / count) * (1.0f - fSize);
-
-		float fRad = 0.0f;
-		for( unsigned int segment = 0; segment < count; segment++ )
-		{
-			// Set the starting vector for this segment
-			int vertex = segment * verticesPerSegment;
-			for( int d = 0; d < (int)(definition + 1); d++ )
-			{
-				coordsOuter = unify::TexCoords( cosf( fRad ) * 1.0f, sinf( fRad ) * 1.0f );
-				coordsInner = unify::TexCoords( cosf( fRad ) * (radiusInner / radiusOuter), sinf( fRad ) * (radiusInner / radiusOuter) );
-
-				vOuter = unify::V3< float >( cosf( fRad ) * radiusOuter, 0, sinf( fRad ) * radiusOuter );
-				vInner = unify::V3< float >( cosf( fRad ) * radiusInner, 0, sinf( fRad ) * radiusInner );
-
-				// Outter Radius...
-				WriteVertex( *vd, lock, vertex, positionE, vOuter + center );
-				WriteVertex( *vd, lock, vertex, normalE, unify::V3< float >( 0, 1, 0 ) );
-				WriteVertex( *vd, lock, vertex, diffuseE, diffuse );
-				WriteVertex( *vd, lock, vertex, specularE, specular );
-				WriteVertex( *vd, lock, vertex, texE, coordsOuter );
-
-				// Inner Radius...
-				WriteVertex( *vd, lock, vertex + 1, positionE, vInner + center );
-				WriteVertex( *vd, lock, vertex + 1, normalE, unify::V3< float >( 0, 1, 0 ) );
-				WriteVertex( *vd, lock, vertex + 1, diffuseE, diffuse );
-				WriteVertex( *vd, lock, vertex + 1, specularE, specular );
-				WriteVertex( *vd, lock, vertex + 1, texE, coordsInner );
-
-				vbParameters.bbox += vOuter + center;
-				vbParameters.bbox += vInner + center;
-
-				// Move to the next ver
-				vertex += 2;
-
-				//Move the vectors (rotate)
-				if( d != (int)(definition) ) fRad += fRadChange;
-			}
-			fRad += fRadChangeSeg;
-		}
-
-		set.AddVertexBuffer( vbParameters );
-		delete[] vertices;
-
-		// Create the index list...
-		std::vector< Index32 > indices( totalIndices );
-		Index32 io = 0, vo = 0;	// Index and vertex offset
-		for( unsigned int segment = 0; segment < count; ++segment )
-		{
-			for( int iDef = 0; iDef < (int)definition; ++iDef )
-			{
-				indices[io++] = 0 + vo;
-				indices[io++] = 1 + vo;
-				indices[io++] = 2 + vo;
-
-				indices[io++] = 1 + vo;
-				indices[io++] = 3 + vo;
-				indices[io++] = 2 + vo;
-
-				vo += 2;
-			}
-			vo += 2;
-		}
-
-		IndexBufferParameters ibParameters{ { { totalIndices, &indices[0] } }, bufferUsage };
-		set.AddIndexBuffer( ibParameters);
-
-		if ( parameters.AuditCount() != 0 )
-		{
-			throw me::exception::FailedToCreate( "Invalid parameters\n" + parameters.Audit() );
-		}
-	}
-	catch( std::exception & ex )
-	{
-		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
-	}
-}
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/DashRing.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapeTransform.h>
+#include <shapes/ShapeKernels.h>
+#include <me/render/VertexUtil.h>
+#include <me/exception/NotImplemented.h>
+#include <me/exception/FailedToCreate.h>
+#include <unify/String.h>
+#include <unify/Size3.h>
+#include <unify/TexArea.h>
+#include <unify/Angle.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+const float PI = 3.14159265358979f;
+const float PI2 = 6.28318530717959f;
+
+DashRingDesc::DashRingDesc()
+	: majorRadius{ 1.0f }
+	, minorRadius{ 0.9f }
+	, count{ 12 }
+	, size{ 0.5f }
+	, definition{ 4.0f }
+	, instanced{ false }
+	, visible{ 12 }
+{
+}
+
+DashRingDesc::DashRingDesc( const unify::Parameters & parameters )
+	: ShapeDesc( parameters )
+	, majorRadius{ parameters.Get( "majorradius", 1.0f ) }
+	, minorRadius{ parameters.Get( "minorradius", 0.9f ) }
+	, count{ (unsigned int)parameters.Get( "count", 12 ) }
+	, size{ parameters.Get( "size1", 0.5f ) }
+	, definition{ parameters.Get( "definition", 4.0f ) }
+	, instanced{ parameters.Get( "instanced", false ) }
+	, visible{ parameters.Get< unsigned int >( "visible", count ) }
+	, diffuses{ parameters.Get< std::vector< unify::Color > >( "diffuses", std::vector< unify::Color >() ) }
+	, autoSegments{ parameters }
+{
+}
+
+DashRing::DashRing()
+{
+}
+
+DashRing::~DashRing()
+{
+}
+
+void DashRing::Create(PrimitiveList & primitiveList, const unify::Parameters & parameters ) const
+{
+	try
+	{
+		Create( primitiveList, DashRingDesc( parameters ) );
+
+		if ( parameters.AuditCount() != 0 )
+		{
+			throw me::exception::FailedToCreate( "Invalid parameters\n" + parameters.Audit() );
+		}
+	}
+	catch( std::exception & ex )
+	{
+		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+	}
+}
+
+void DashRing::Create(PrimitiveList & primitiveList, const DashRingDesc & desc ) const
+{
+	using namespace unify;
+
+	if( desc.canonical )
+	{
+		// The unit shape is the real one divided by its outer radius.
+		if( !( desc.majorRadius > 0.0f ) )
+		{
+			throw me::exception::FailedToCreate( "Canonical DashRing needs a positive majorradius!" );
+		}
+
+		DashRingDesc unit = desc;
+		unit.canonical = false;
+		unit.center = V3< float >( 0, 0, 0 );
+		// The ratio of the radii is topology, so only the outer radius is scaled out.
+		unit.majorRadius = 1.0f;
+		unit.minorRadius = desc.minorRadius / desc.majorRadius;
+		unit.definition = (float)desc.autoSegments.Resolve( desc.majorRadius, (unsigned int)desc.definition, (PI2 / desc.count) * desc.size );
+		unit.autoSegments.enabled = false;
+		ShapeTransform::Report( V3< float >( desc.majorRadius, desc.majorRadius, desc.majorRadius ), desc.center );
+		Create( primitiveList, unit );
+		return;
+	}
+
+	if( desc.instanced )
+	{
+		CreateInstanced( primitiveList, desc );
+		return;
+	}
+
+	float radiusOuter = desc.majorRadius;
+	float radiusInner = desc.minorRadius;
+	unsigned int count = desc.count;	// Number of dashes
+	float fSize = desc.size;	// Unit size of visible part of dash (0.0 to 1.0)
+	float definition = (float)desc.autoSegments.Resolve( desc.majorRadius, (unsigned int)desc.definition, (PI2 / desc.count) * desc.size );		// Definition of each dash
+	Color diffuse = desc.diffuse;
+	Color specular = desc.specular;
+	V3< float > center = desc.center;
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
+
+	int verticesPerSegment = (int)((definition + 1) * 2);
+	int indicesPerSegment = (int)(definition * 6);
+	int facesPerSegment = (int)(definition * 2);
+
+	unsigned int totalVertices = verticesPerSegment * count;
+	unsigned int totalIndices = indicesPerSegment * count;
+	unsigned int totalTriangles = facesPerSegment * count;
+
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
+
+	// Method 1 - Triangle List...
+	AddMethod( set, RenderMethod::CreateTriangleListIndexed( totalVertices, totalIndices, 0, 0 ) );
+
+	char * vertices = new char[vd->GetSizeInBytes( 0 ) * totalVertices];
+	DataLock lock( vertices, vd->GetSizeInBytes( 0 ), totalVertices, DataLockAccess::ReadWrite, 0 );
+	VertexBufferParameters vbParameters{ vd, { { totalVertices, vertices } }, bufferUsage };
+
+	unsigned short stream = 0;
+
+	VertexElement positionE = CommonVertexElement::Position( stream );
+	VertexElement normalE = CommonVertexElement::Normal( stream );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+	VertexElement specularE = CommonVertexElement::Specular( stream );
+	VertexElement texE = CommonVertexElement::TexCoords( stream );
+
+	// Create all the segments (clockwise from top). Positions are staged around the origin, then moved to center
+	// and bounded in bulk.
+	const unsigned int ringPoints = (unsigned int)definition + 1;
+	std::vector< float > sines( ringPoints );
+	std::vector< float > cosines( ringPoints );
+	std::vector< V3< float > > positions( totalVertices );
+	std::vector< TexCoords > coords( totalVertices );
+
+	float fRadChange = ((PI2 / count) * fSize) / definition;
+	float ratio = radiusInner / radiusOuter;
+	for( unsigned int segment = 0; segment < count; segment++ )
+	{
+		// Each dash starts where the previous one started, plus its share of the circle.
+		kernels::SinCos( (PI2 / count) * segment, fRadChange, ringPoints, sines.data(), cosines.data() );
+
+		unsigned int vertex = segment * verticesPerSegment;
+		for( unsigned int d = 0; d < ringPoints; d++ )
+		{
+			// Outter Radius...
+			positions[vertex] = unify::V3< float >( cosines[d] * radiusOuter, 0, sines[d] * radiusOuter );
+			coords[vertex] = unify::TexCoords( cosines[d], sines[d] );
+
+			// Inner Radius...
+			positions[vertex + 1] = unify::V3< float >( cosines[d] * radiusInner, 0, sines[d] * radiusInner );
+			coords[vertex + 1] = unify::TexCoords( cosines[d] * ratio, sines[d] * ratio );
+
+			// Move to the next ver
+			vertex += 2;
+		}
+	}
+
+	kernels::Transform( kernels::Affine::Translation( center ), positions.data(), positions.data(), totalVertices );
+	kernels::Bounds( positions.data(), totalVertices, vbParameters.bbox );
+
+	for( unsigned int vertex = 0; vertex < totalVertices; ++vertex )
+	{
+		WriteVertex( *vd, lock, vertex, positionE, positions[vertex] );
+		WriteVertex( *vd, lock, vertex, normalE, unify::V3< float >( 0, 1, 0 ) );
+		WriteVertex( *vd, lock, vertex, diffuseE, diffuse );
+		WriteVertex( *vd, lock, vertex, specularE, specular );
+		WriteVertex( *vd, lock, vertex, texE, coords[vertex] );
+	}
+
+	AddVertexBuffer( set, vbParameters );
+	delete[] vertices;
+
+	// Create the index list, dash by dash and step by step around the ring, so GetArcIndexCount can draw part of it.
+	AddSharedIndexBuffer( set, { "DashRing", { count, (unsigned int)definition } }, bufferUsage, [&]( std::vector< Index32 > & indices )
+	{
+		indices.resize( totalIndices );
+		Index32 io = 0, vo = 0;	// Index and vertex offset
+		for( unsigned int segment = 0; segment < count; ++segment )
+		{
+			for( int iDef = 0; iDef < (int)definition; ++iDef )
+			{
+				indices[io++] = 0 + vo;
+				indices[io++] = 1 + vo;
+				indices[io++] = 2 + vo;
+
+				indices[io++] = 1 + vo;
+				indices[io++] = 3 + vo;
+				indices[io++] = 2 + vo;
+
+				vo += 2;
+			}
+			vo += 2;
+		}
+	} );
+}
+
+IShapeQuery::ptr DashRing::CreateQuery( const DashRingDesc & desc ) const
+{
+	// Every dash of a ring drawn whole shows; an instanced ring shows the first visible.
+	unsigned int visible = desc.instanced ? std::min( desc.visible, desc.count ) : desc.count;
+	if( visible == 0 || desc.size <= 0.0f )
+	{
+		return IShapeQuery::ptr();
+	}
+	return RevolvedQuery::CreateDashRing( desc.center, desc.minorRadius, desc.majorRadius, { desc.count, desc.size, visible } );
+}
+
+void DashRing::WriteInstances( const DashRingDesc & desc, const VertexDeclaration & vd, unify::DataLock & lock )
+{
+	using namespace unify;
+
+	VertexElement diffuseE = CommonVertexElement::Diffuse( 1 );
+
+	const float radPerDash = PI2 / desc.count;
+	const unsigned int visible = std::min( desc.visible, desc.count );
+	for( unsigned int dash = 0; dash < visible; ++dash )
+	{
+		// Rotation about Y by the dash's start angle, then translation to center (row vector layout).
+		float rad = radPerDash * dash;
+		float c = cosf( rad );
+		float s = sinf( rad );
+		const float matrix[16] =
+		{
+			c, 0, s, 0,
+			0, 1, 0, 0,
+			-s, 0, c, 0,
+			desc.center.x, desc.center.y, desc.center.z, 1
+		};
+		memcpy( lock.GetItem( dash ), matrix, sizeof( matrix ) );
+
+		Color diffuse = desc.diffuses.empty() ? desc.diffuse : desc.diffuses[dash % desc.diffuses.size()];
+		WriteVertex( vd, lock, dash, diffuseE, diffuse );
+	}
+}
+
+unsigned int DashRing::GetArcIndexCount( const DashRingDesc & desc, float fraction )
+{
+	const unsigned int definition = desc.autoSegments.Resolve( desc.majorRadius, (unsigned int)desc.definition, (PI2 / desc.count) * desc.size );
+	const unsigned int indicesPerSegment = definition * 6;
+
+	// Whole dashes, then the steps of the dash the arc ends in; the gap after a dash adds nothing.
+	float dashes = std::min( std::max( fraction, 0.0f ), 1.0f ) * desc.count;
+	unsigned int whole = std::min( (unsigned int)dashes, desc.count );
+	if( whole == desc.count || desc.size <= 0.0f )
+	{
+		return whole * indicesPerSegment;
+	}
+
+	float partial = std::min( ( dashes - whole ) / desc.size, 1.0f );
+	return whole * indicesPerSegment + (unsigned int)( partial * definition + 0.5f ) * 6;
+}
+
+void DashRing::CreateInstanced( PrimitiveList & primitiveList, const DashRingDesc & desc ) const
+{
+	using namespace unify;
+
+	float radiusOuter = desc.majorRadius;
+	float radiusInner = desc.minorRadius;
+	unsigned int count = desc.count;
+	float fSize = desc.size;
+	unsigned int definition = desc.autoSegments.Resolve( desc.majorRadius, (unsigned int)desc.definition, (PI2 / desc.count) * desc.size );
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
+
+	const size_t instanceStride = vd->GetSizeInBytes( 1 );
+	if( instanceStride < sizeof( float ) * 16 )
+	{
+		throw me::exception::FailedToCreate( "Instanced DashRing requires an effect with a per-instance Matrix4x4 in slot 1!" );
+	}
+	if( desc.visible > count )
+	{
+		throw me::exception::FailedToCreate( "DashRing visible must not be more than count!" );
+	}
+	if( desc.visible == 0 )
+	{
+		throw me::exception::FailedToCreate( "Instanced DashRing has no visible dash to draw, leave the ring out instead!" );
+	}
+
+	unsigned int dashVertices = (definition + 1) * 2;
+	unsigned int dashIndices = definition * 6;
+
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
+
+	AddMethod( set, RenderMethod::CreateTriangleListIndexed( dashVertices, dashIndices, 0, 0 ) );
+
+	std::vector< unsigned char > vertices( vd->GetSizeInBytes( 0 ) * dashVertices );
+	DataLock lock( vertices.data(), vd->GetSizeInBytes( 0 ), dashVertices, DataLockAccess::ReadWrite, 0 );
+
+	// One instance per visible dash; the slot's size is the draw's instance count.
+	std::vector< unsigned char > instances( instanceStride * desc.visible );
+	DataLock instanceLock( instances.data(), instanceStride, desc.visible, DataLockAccess::ReadWrite, 1 );
+	WriteInstances( desc, *vd, instanceLock );
+
+	VertexBufferParameters vbParameters{ vd, { { dashVertices, vertices.data() }, { desc.visible, instances.data() } }, bufferUsage };
+
+	unsigned short stream = 0;
+
+	VertexElement positionE = CommonVertexElement::Position( stream );
+	VertexElement normalE = CommonVertexElement::Normal( stream );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+	VertexElement specularE = CommonVertexElement::Specular( stream );
+	VertexElement texE = CommonVertexElement::TexCoords( stream );
+
+	// The first dash only, around the origin; the instances place it.
+	std::vector< float > sines( definition + 1 );
+	std::vector< float > cosines( definition + 1 );
+	kernels::SinCos( 0.0f, ((PI2 / count) * fSize) / definition, definition + 1, sines.data(), cosines.data() );
+	for( unsigned int d = 0; d <= definition; d++ )
+	{
+		V3< float > vOuter( cosines[d] * radiusOuter, 0, sines[d] * radiusOuter );
+		V3< float > vInner( cosines[d] * radiusInner, 0, sines[d] * radiusInner );
+
+		WriteVertex( *vd, lock, d * 2, positionE, vOuter );
+		WriteVertex( *vd, lock, d * 2, normalE, V3< float >( 0, 1, 0 ) );
+		WriteVertex( *vd, lock, d * 2, diffuseE, desc.diffuse );
+		WriteVertex( *vd, lock, d * 2, specularE, desc.specular );
+		WriteVertex( *vd, lock, d * 2, texE, TexCoords( cosines[d], sines[d] ) );
+
+		WriteVertex( *vd, lock, d * 2 + 1, positionE, vInner );
+		WriteVertex( *vd, lock, d * 2 + 1, normalE, V3< float >( 0, 1, 0 ) );
+		WriteVertex( *vd, lock, d * 2 + 1, diffuseE, desc.diffuse );
+		WriteVertex( *vd, lock, d * 2 + 1, specularE, desc.specular );
+		WriteVertex( *vd, lock, d * 2 + 1, texE, TexCoords( cosines[d] * (radiusInner / radiusOuter), sines[d] * (radiusInner / radiusOuter) ) );
+	}
+
+	// The bounds cover the whole ring, whichever dashes are showing.
+	vbParameters.bbox += desc.center + V3< float >( -radiusOuter, 0, -radiusOuter );
+	vbParameters.bbox += desc.center + V3< float >( radiusOuter, 0, radiusOuter );
+
+	AddVertexBuffer( set, vbParameters );
+
+	AddSharedIndexBuffer( set, { "DashRingInstanced", { definition } }, bufferUsage, [&]( std::vector< Index32 > & indices )
+	{
+		indices.reserve( dashIndices );
+		for( unsigned int d = 0; d < definition; ++d )
+		{
+			Index32 vo = d * 2;
+			indices.push_back( vo + 0 );
+			indices.push_back( vo + 1 );
+			indices.push_back( vo + 2 );
+
+			indices.push_back( vo + 1 );
+			indices.push_back( vo + 3 );
+			indices.push_back( vo + 2 );
+		}
+	} );
+}
@@ -3,9 +3,34 @@
 #pragma once
 
 #include <me/sculpter/IShapeCreator.h>
+#include <shapes/ShapeDesc.h>
+#include <shapes/ShapeQuery.h>
+#include <shapes/AutoSegments.h>
+#include <unify/DataLock.h>
+#include <vector>
 
 namespace shapes
 {
+	struct DashRingDesc : public ShapeDesc
+	{
+		DashRingDesc();
+		DashRingDesc( const unify::Parameters & parameters );
+
+		float majorRadius;
+		float minorRadius;
+		unsigned int count;
+		float size;
+		float definition;
+
+		// One dash mesh in slot 0, drawn once per visible dash from a per-instance slot 1 holding only those
+		// dashes, so hidden dashes cost nothing. The effect's vertex declaration needs an instance slot starting
+		// with a Matrix4x4, such as ColorAmbientInstanced. Instanced rings can't be recorded or baked.
+		bool instanced;
+		unsigned int visible;
+		std::vector< unify::Color > diffuses;
+		AutoSegments autoSegments;
+	};
+
 	class DashRing : public me::sculpter::IShapeCreator
 	{
 	public:
@@ -13,5 +38,31 @@ namespace shapes
 		~DashRing() override;
 
 		void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+		void Create( me::render::PrimitiveList & primitiveList, const DashRingDesc & desc ) const;
+
+		/// <summary>
+		/// The exact shape desc describes, for picking and containment without its triangles: the flat ring,
+		/// only where its dashes are. A ring showing no dash has nothing to query, and gives nullptr.
+		/// </summary>
+		IShapeQuery::ptr CreateQuery( const DashRingDesc & desc ) const;
+
+		/// <summary>
+		/// Fills the per-instance slot of an instanced dash ring, "lock" holding desc.visible instances: the
+		/// rotation and translation of each visible dash, clockwise from the top, and its color from "diffuses"
+		/// if the slot has a Diffuse element. The visible dashes come first in the ring, so the draw's instance
+		/// count, the slot's size, is how many show.
+		/// </summary>
+		static void WriteInstances( const DashRingDesc & desc, const me::render::VertexDeclaration & vd, unify::DataLock & lock );
+
+		/// <summary>
+		/// The index count that draws fraction, 0 to 1, of the ring desc describes, clockwise from the top as
+		/// the dashes are laid out, to the nearest step of a dash. The dashes and their steps are indexed in that
+		/// order, so a partial ring is the shape's method with only its index count changed. Instanced rings
+		/// show part of the ring through "visible" instead.
+		/// </summary>
+		static unsigned int GetArcIndexCount( const DashRingDesc & desc, float fraction );
+
+	private:
+		void CreateInstanced( me::render::PrimitiveList & primitiveList, const DashRingDesc & desc ) const;
 	};
 }
@@ -0,0 +1,137 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/DepthStream.h>
+#include <me/render/VertexUtil.h>
+#include <me/exception/FailedToCreate.h>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+DepthStream::Pending::Pending()
+	: mirrored{ false }
+	, vertexUsage{ BufferUsage::Default }
+	, indexUsage{ BufferUsage::Default }
+{
+}
+
+DepthStream::DepthStream( Effect::ptr effect )
+	: m_effect{ effect }
+	, m_vertexDeclaration{ effect->GetVertexShader()->GetVertexDeclaration() }
+{
+	if( m_vertexDeclaration->GetSizeInBytes( 0 ) != sizeof( unify::V3< float > ) )
+	{
+		throw me::exception::FailedToCreate( "DepthStream effects must take only a Float3 position!" );
+	}
+}
+
+void DepthStream::RecordVertexBuffer( const BufferSet & set, const VertexBufferParameters & parameters )
+{
+	Pending & pending = Get( set );
+
+	// An instanced shape's depth pass needs its instances too, which a position alone cannot carry.
+	if( parameters.countAndSource.size() != 1 )
+	{
+		return;
+	}
+
+	const auto & source = parameters.countAndSource[0];
+	const VertexDeclaration & vd = *parameters.vertexDeclaration;
+	unify::DataLock lock( const_cast< void * >( source.source ), vd.GetSizeInBytes( 0 ), source.count, unify::DataLockAccess::ReadOnly, 0 );
+
+	VertexElement positionE = CommonVertexElement::Position( 0 );
+	pending.positions.resize( source.count );
+	for( size_t v = 0; v < source.count; ++v )
+	{
+		if( !ReadVertex( vd, lock, v, positionE, pending.positions[v] ) )
+		{
+			pending.positions.clear();
+			return;
+		}
+	}
+
+	pending.mirrored = true;
+	pending.vertexUsage = parameters.usage;
+	pending.bbox = parameters.bbox;
+}
+
+void DepthStream::RecordIndexBuffer( const BufferSet & set, const IndexBufferParameters & parameters, IIndexBuffer::ptr buffer )
+{
+	Pending & pending = Get( set );
+	pending.indexUsage = parameters.usage;
+	pending.indexBuffer = buffer;
+	pending.indices.clear();
+	if( !buffer )
+	{
+		const auto & source = parameters.countAndSource[0];
+		const Index32 * indices = (const Index32 *)source.source;
+		pending.indices.assign( indices, indices + source.count );
+	}
+}
+
+void DepthStream::RecordMethod( const BufferSet & set, const RenderMethod & method )
+{
+	Get( set ).methods.push_back( method );
+}
+
+size_t DepthStream::GetVertexBytes() const
+{
+	size_t bytes = 0;
+	for( const auto & pending : m_pending )
+	{
+		bytes += pending.positions.size() * sizeof( unify::V3< float > );
+	}
+	return bytes;
+}
+
+void DepthStream::Commit( PrimitiveList & primitiveList )
+{
+	for( const auto & pending : m_pending )
+	{
+		if( !pending.mirrored )
+		{
+			continue;
+		}
+
+		BufferSet & set = primitiveList.AddBufferSet();
+		set.SetEffect( m_effect );
+
+		VertexBufferParameters vbParameters{ m_vertexDeclaration, { { pending.positions.size(), pending.positions.data() } }, pending.vertexUsage };
+		vbParameters.bbox = pending.bbox;
+		set.AddVertexBuffer( vbParameters );
+
+		if( pending.indexBuffer )
+		{
+			set.AddIndexBuffer( pending.indexBuffer );
+		}
+		else if( !pending.indices.empty() )
+		{
+			set.AddIndexBuffer( { { { pending.indices.size(), pending.indices.data() } }, pending.indexUsage } );
+		}
+
+		for( const auto & method : pending.methods )
+		{
+			set.AddMethod( method );
+		}
+	}
+
+	m_pending.clear();
+	m_index.clear();
+}
+
+DepthStream * DepthStream::Current()
+{
+	return CurrentScope< DepthStream >::Get();
+}
+
+DepthStream::Pending & DepthStream::Get( const BufferSet & set )
+{
+	auto itr = m_index.find( &set );
+	if( itr == m_index.end() )
+	{
+		itr = m_index.insert( { &set, m_pending.size() } ).first;
+		m_pending.push_back( Pending() );
+	}
+	return m_pending[itr->second];
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <shapes/CurrentScope.h>
+#include <me/render/PrimitiveList.h>
+#include <me/render/BufferSet.h>
+#include <me/render/RenderMethod.h>
+#include <me/render/Effect.h>
+#include <unify/BBox.h>
+#include <unify/V3.h>
+#include <vector>
+#include <map>
+
+namespace shapes
+{
+	/// <summary>
+	/// Mirrors every BufferSet created while it is current as a position only BufferSet, for shadow and depth
+	/// prepasses, which otherwise fetch a shape's normals, colors and texcoords only to ignore them. The
+	/// positions are packed tightly, twelve bytes a vertex, and drawn with the same methods.
+	///
+	/// Where an index buffer was created for the shape it is shared, not copied; while a pool is current the
+	/// indices are copied. Buffers with per-instance slots, and anything a capturing recorder keeps from the
+	/// renderer, are not mirrored. Nothing is drawable until Commit.
+	/// </summary>
+	class DepthStream
+	{
+	public:
+		typedef CurrentScope< DepthStream > Scope;
+
+		/// <summary>
+		/// effect's vertex declaration must be a single Float3 position.
+		/// </summary>
+		DepthStream( me::render::Effect::ptr effect );
+
+		void RecordVertexBuffer( const me::render::BufferSet & set, const me::render::VertexBufferParameters & parameters );
+
+		/// <summary>
+		/// buffer is the index buffer created from parameters, or nullptr when none was.
+		/// </summary>
+		void RecordIndexBuffer( const me::render::BufferSet & set, const me::render::IndexBufferParameters & parameters, me::render::IIndexBuffer::ptr buffer );
+
+		void RecordMethod( const me::render::BufferSet & set, const me::render::RenderMethod & method );
+
+		/// <summary>
+		/// The bytes of packed positions waiting for Commit.
+		/// </summary>
+		size_t GetVertexBytes() const;
+
+		/// <summary>
+		/// Adds a BufferSet to primitiveList for every mirrored set, in the order the sets were first touched,
+		/// then empties the stream so it can be reused.
+		/// </summary>
+		void Commit( me::render::PrimitiveList & primitiveList );
+
+		/// <summary>
+		/// Returns the stream current for the calling thread, or nullptr.
+		/// </summary>
+		static DepthStream * Current();
+
+	private:
+		struct Pending
+		{
+			Pending();
+
+			bool mirrored;
+			std::vector< unify::V3< float > > positions;
+			me::render::BufferUsage::TYPE vertexUsage;
+			unify::BBox< float > bbox;
+
+			me::render::IIndexBuffer::ptr indexBuffer;
+			std::vector< me::render::Index32 > indices;
+			me::render::BufferUsage::TYPE indexUsage;
+
+			std::vector< me::render::RenderMethod > methods;
+		};
+
+		Pending & Get( const me::render::BufferSet & set );
+
+		me::render::Effect::ptr m_effect;
+		me::render::VertexDeclaration::ptr m_vertexDeclaration;
+		std::vector< Pending > m_pending;
+		std::map< const me::render::BufferSet *, size_t > m_index;
+	};
+}
@@ -0,0 +1,187 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/DynamicShape.h>
+#include <me/render/VertexUtil.h>
+#include <me/exception/FailedToCreate.h>
+#include <unify/TexArea.h>
+#include <cstring>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+namespace
+{
+	template< typename T >
+	void CopyElement( const VertexDeclaration & vd, const unify::DataLock & source, unify::DataLock & target, VertexElement element, unsigned int count )
+	{
+		T value;
+		for( unsigned int v = 0; v < count; ++v )
+		{
+			if( !ReadVertex( vd, source, v, element, value ) )
+			{
+				return;
+			}
+			WriteVertex( vd, target, v, element, value );
+		}
+	}
+}
+
+DynamicShape::Set::Set()
+	: set{ nullptr }
+	, vertexStride{ 0 }
+	, vertexCount{ 0 }
+	, indexCount{ 0 }
+	, methodCount{ 0 }
+{
+}
+
+DynamicShape::DynamicShape( IRenderer * renderer, PrimitiveList & primitiveList, Effect::ptr effect, const Generator & generate, unsigned int frames )
+	: m_frames{ frames < 1 ? 1 : frames }
+	, m_frame{ 0 }
+	, m_recorder{ ShapeRecorder::Mode::Capture }
+{
+	Capture( generate );
+
+	for( const auto & recorded : m_recorder.GetSets() )
+	{
+		if( !recorded.vertexDeclaration || recorded.vertexUsage != BufferUsage::Dynamic )
+		{
+			throw me::exception::FailedToCreate( "DynamicShape needs shapes made with \"bufferusage\" Dynamic!" );
+		}
+
+		Set entry;
+		entry.vertexDeclaration = recorded.vertexDeclaration;
+		entry.vertexStride = recorded.vertexStride;
+		entry.vertexCount = recorded.vertexCount;
+		entry.indexCount = recorded.indices.size();
+		entry.methodCount = recorded.methods.size();
+		entry.vertices = recorded.vertices;
+
+		VertexBufferParameters vbParameters{ recorded.vertexDeclaration, { { recorded.vertexCount, recorded.vertices.data() } }, BufferUsage::Dynamic };
+		vbParameters.bbox = recorded.bbox;
+		for( unsigned int frame = 0; frame < m_frames; ++frame )
+		{
+			entry.vertexBuffers.push_back( renderer->ProduceVB( vbParameters ) );
+		}
+
+		BufferSet & set = primitiveList.AddBufferSet();
+		set.SetEffect( effect );
+		set.AddVertexBuffer( entry.vertexBuffers[0] );
+		if( !recorded.indices.empty() )
+		{
+			set.AddIndexBuffer( renderer->ProduceIB( { { { recorded.indices.size(), recorded.indices.data() } }, recorded.indexUsage } ) );
+		}
+		for( const auto & method : recorded.methods )
+		{
+			set.AddMethod( method );
+		}
+		entry.set = &set;
+
+		m_sets.push_back( entry );
+	}
+}
+
+void DynamicShape::Update( const Generator & generate, unsigned int attributes )
+{
+	Capture( generate );
+
+	const std::vector< RecordedBufferSet > & recorded = m_recorder.GetSets();
+	bool same = recorded.size() == m_sets.size();
+	for( size_t s = 0; same && s < m_sets.size(); ++s )
+	{
+		same = recorded[s].vertexStride == m_sets[s].vertexStride
+			&& recorded[s].vertexCount == m_sets[s].vertexCount
+			&& recorded[s].methods.size() == m_sets[s].methodCount
+			&& recorded[s].indices.size() == m_sets[s].indexCount;
+	}
+	if( !same )
+	{
+		throw me::exception::FailedToCreate( "DynamicShape updates must keep the shape's topology!" );
+	}
+
+	m_frame = ( m_frame + 1 ) % m_frames;
+	for( size_t s = 0; s < m_sets.size(); ++s )
+	{
+		Patch( m_sets[s], recorded[s], attributes );
+		Write( m_sets[s] );
+	}
+}
+
+void DynamicShape::Update( const Writer & write )
+{
+	m_frame = ( m_frame + 1 ) % m_frames;
+	for( size_t s = 0; s < m_sets.size(); ++s )
+	{
+		Set & set = m_sets[s];
+		unify::DataLock lock( set.vertices.data(), set.vertexStride, set.vertexCount, unify::DataLockAccess::ReadWrite, 0 );
+		write( s, *set.vertexDeclaration, lock );
+		Write( set );
+	}
+}
+
+unsigned int DynamicShape::GetFrames() const
+{
+	return m_frames;
+}
+
+unsigned int DynamicShape::GetFrame() const
+{
+	return m_frame;
+}
+
+void DynamicShape::Capture( const Generator & generate )
+{
+	m_recorder.Clear();
+
+	ShapeRecorder::Scope scope( m_recorder );
+	PrimitiveList primitiveList( nullptr );
+	generate( primitiveList );
+}
+
+void DynamicShape::Patch( Set & set, const RecordedBufferSet & recorded, unsigned int attributes )
+{
+	if( ( attributes & All ) == All )
+	{
+		set.vertices = recorded.vertices;
+	}
+	else
+	{
+		// The copy holds every element of the last update, so only the elements that change need writing.
+		const VertexDeclaration & vd = *set.vertexDeclaration;
+		unify::DataLock source( const_cast< unsigned char * >( recorded.vertices.data() ), set.vertexStride, set.vertexCount, unify::DataLockAccess::ReadOnly, 0 );
+		unify::DataLock lock( set.vertices.data(), set.vertexStride, set.vertexCount, unify::DataLockAccess::ReadWrite, 0 );
+		if( attributes & Position )
+		{
+			CopyElement< unify::V3< float > >( vd, source, lock, CommonVertexElement::Position( 0 ), set.vertexCount );
+		}
+		if( attributes & Normal )
+		{
+			CopyElement< unify::V3< float > >( vd, source, lock, CommonVertexElement::Normal( 0 ), set.vertexCount );
+		}
+		if( attributes & Diffuse )
+		{
+			CopyElement< unify::Color >( vd, source, lock, CommonVertexElement::Diffuse( 0 ), set.vertexCount );
+		}
+		if( attributes & Specular )
+		{
+			CopyElement< unify::Color >( vd, source, lock, CommonVertexElement::Specular( 0 ), set.vertexCount );
+		}
+		if( attributes & TexCoords )
+		{
+			CopyElement< unify::TexCoords >( vd, source, lock, CommonVertexElement::TexCoords( 0 ), set.vertexCount );
+		}
+	}
+}
+
+void DynamicShape::Write( const Set & set )
+{
+	IVertexBuffer::ptr buffer = set.vertexBuffers[m_frame];
+	unify::DataLock lock;
+	buffer->Lock( 0, lock );
+	memcpy( lock.GetData(), set.vertices.data(), set.vertices.size() );
+	buffer->Unlock( 0 );
+
+	set.set->AddVertexBuffer( buffer );
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <shapes/ShapeOutput.h>
+#include <me/render/IRenderer.h>
+#include <me/render/PrimitiveList.h>
+#include <me/render/BufferSet.h>
+#include <me/render/Effect.h>
+#include <unify/DataLock.h>
+#include <functional>
+#include <vector>
+
+namespace shapes
+{
+	/// <summary>
+	/// A shape whose parameters change every frame, a pulsing circle's radius or a growing tube's height,
+	/// without creating new buffers. The shape's BufferSets are made once, each with several Dynamic vertex
+	/// buffers and a single index buffer. A copy of each set's vertices is kept on the CPU; an update changes
+	/// the copy, either by running the creator again headless or through a Writer, then writes every vertex
+	/// in full into the next vertex buffer in turn, so the CPU never writes a buffer the GPU may still be
+	/// reading, and a lock that discards the buffer's contents loses nothing.
+	///
+	/// The topology must stay fixed: the same sets, vertex counts, indices and methods on every update; only
+	/// the counts are checked. The bounds of each vertex buffer are those of the first shape. Per-instance
+	/// slots are not supported.
+	/// </summary>
+	class DynamicShape
+	{
+	public:
+		/// <summary>
+		/// Runs a creator, such as [&]( PrimitiveList & list ){ circle.Create( list, desc ); }. Its
+		/// "bufferusage" must be Dynamic.
+		/// </summary>
+		typedef std::function< void( me::render::PrimitiveList & primitiveList ) > Generator;
+
+		/// <summary>
+		/// Changes the vertices of set, the index of a BufferSet in the order they were added, with WriteVertex,
+		/// without running the creator. vertices holds the set's vertices as the last update left them, so only
+		/// the elements that change need writing.
+		/// </summary>
+		typedef std::function< void( size_t set, const me::render::VertexDeclaration & vertexDeclaration, unify::DataLock & vertices ) > Writer;
+
+		/// <summary>
+		/// The vertex elements an update writes. Elements left out must not change from the first shape.
+		/// </summary>
+		enum Attributes : unsigned int
+		{
+			Position = 1 << 0,
+			Normal = 1 << 1,
+			Diffuse = 1 << 2,
+			Specular = 1 << 3,
+			TexCoords = 1 << 4,
+			All = Position | Normal | Diffuse | Specular | TexCoords
+		};
+
+		/// <summary>
+		/// Adds a BufferSet drawn with effect to primitiveList for every set generate makes. Three frames
+		/// covers a renderer that queues up to two frames ahead.
+		/// </summary>
+		DynamicShape( me::render::IRenderer * renderer, me::render::PrimitiveList & primitiveList, me::render::Effect::ptr effect, const Generator & generate, unsigned int frames = 3 );
+
+		/// <summary>
+		/// Writes the attributes of the shape generate makes into the next frame's vertex buffers, and
+		/// draws from them. Throws if the topology changed.
+		/// </summary>
+		void Update( const Generator & generate, unsigned int attributes = All );
+
+		/// <summary>
+		/// Has write change the vertices of every set, and draws them from the next frame's vertex buffers.
+		/// </summary>
+		void Update( const Writer & write );
+
+		unsigned int GetFrames() const;
+
+		/// <summary>
+		/// The vertex buffer drawn from, 0 to GetFrames() - 1.
+		/// </summary>
+		unsigned int GetFrame() const;
+
+	private:
+		struct Set
+		{
+			Set();
+
+			me::render::BufferSet * set;
+			me::render::VertexDeclaration::ptr vertexDeclaration;
+			unsigned int vertexStride;
+			unsigned int vertexCount;
+			size_t indexCount;
+			size_t methodCount;
+			std::vector< unsigned char > vertices;
+			std::vector< me::render::IVertexBuffer::ptr > vertexBuffers;
+		};
+
+		void Capture( const Generator & generate );
+		void Patch( Set & set, const RecordedBufferSet & recorded, unsigned int attributes );
+		void Write( const Set & set );
+
+		unsigned int m_frames;
+		unsigned int m_frame;
+		ShapeRecorder m_recorder;
+		std::vector< Set > m_sets;
+	};
+}
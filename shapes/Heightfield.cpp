@@ -0,0 +1,358 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/Heightfield.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapeKernels.h>
+#include <me/render/VertexUtil.h>
+#include <me/exception/FailedToCreate.h>
+#include <unify/TexArea.h>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+namespace
+{
+	unify::V3< float > GetOrigin( const HeightfieldDesc & desc )
+	{
+		return desc.center - unify::V3< float >( ( desc.columns - 1 ) * desc.spacing * 0.5f, 0, ( desc.rows - 1 ) * desc.spacing * 0.5f );
+	}
+
+	// Reads heights first to last of a row, scaled.
+	void ReadRow( const HeightfieldDesc & desc, const MappedFile & file, unsigned int row, unsigned int first, unsigned int last, float * out )
+	{
+		const size_t sampleSize = desc.bits / 8;
+		const unsigned char * data = file.GetData() + ( (size_t)row * desc.columns + first ) * sampleSize;
+		if( desc.bits == 16 )
+		{
+			const float scale = desc.heightScale / 65535.0f;
+			for( unsigned int c = first; c <= last; ++c, data += 2 )
+			{
+				uint16_t height;
+				memcpy( &height, data, sizeof( height ) );
+				*out++ = height * scale;
+			}
+		}
+		else
+		{
+			for( unsigned int c = first; c <= last; ++c, data += 4 )
+			{
+				float height;
+				memcpy( &height, data, sizeof( height ) );
+				*out++ = height * desc.heightScale;
+			}
+		}
+	}
+}
+
+HeightfieldDesc::HeightfieldDesc()
+	: columns{ 0 }
+	, rows{ 0 }
+	, bits{ 16 }
+	, heightScale{ 1.0f }
+	, spacing{ 1.0f }
+	, tileSize{ 64 }
+	, focus{ 0, 0, 0 }
+	, radius{ 0.0f }
+{
+}
+
+HeightfieldDesc::HeightfieldDesc( const unify::Parameters & parameters )
+	: ShapeDesc( parameters )
+	, path{ parameters.Get< std::string >( "path", std::string() ) }
+	, columns{ parameters.Get< unsigned int >( "columns", 0 ) }
+	, rows{ parameters.Get< unsigned int >( "rows", 0 ) }
+	, bits{ parameters.Get< unsigned int >( "bits", 16 ) }
+	, heightScale{ parameters.Get( "heightscale", 1.0f ) }
+	, spacing{ parameters.Get( "spacing", 1.0f ) }
+	, tileSize{ parameters.Get< unsigned int >( "tilesize", 64 ) }
+	, focus{ parameters.Get( "focus", center ) }
+	, radius{ parameters.Get( "radius", 0.0f ) }
+{
+}
+
+Heightfield::Heightfield()
+{
+}
+
+Heightfield::~Heightfield()
+{
+}
+
+void Heightfield::Create( PrimitiveList & primitiveList, const unify::Parameters & parameters ) const
+{
+	try
+	{
+		Create( primitiveList, HeightfieldDesc( parameters ) );
+	}
+	catch( std::exception & ex )
+	{
+		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+	}
+}
+
+void Heightfield::Create( PrimitiveList & primitiveList, const HeightfieldDesc & desc ) const
+{
+	if( desc.canonical )
+	{
+		throw me::exception::FailedToCreate( "Heightfield does not support canonical!" );
+	}
+
+	MappedFile::ptr file = Open( desc );
+	for( unsigned int z = 0; z < GetTilesZ( desc ); ++z )
+	{
+		for( unsigned int x = 0; x < GetTilesX( desc ); ++x )
+		{
+			if( desc.radius <= 0.0f || IsTileInRange( desc, x, z, desc.focus, desc.radius ) )
+			{
+				CreateTile( primitiveList, desc, *file, x, z );
+			}
+		}
+	}
+}
+
+unsigned int Heightfield::GetTilesX( const HeightfieldDesc & desc )
+{
+	return ( desc.columns - 1 + desc.tileSize - 1 ) / desc.tileSize;
+}
+
+unsigned int Heightfield::GetTilesZ( const HeightfieldDesc & desc )
+{
+	return ( desc.rows - 1 + desc.tileSize - 1 ) / desc.tileSize;
+}
+
+bool Heightfield::IsTileInRange( const HeightfieldDesc & desc, unsigned int x, unsigned int z, const unify::V3< float > & focus, float radius )
+{
+	const unify::V3< float > origin = GetOrigin( desc );
+	const float tileExtent = desc.tileSize * desc.spacing;
+	float minX = origin.x + x * tileExtent;
+	float minZ = origin.z + z * tileExtent;
+	float maxX = origin.x + std::min( ( x + 1 ) * desc.tileSize, desc.columns - 1 ) * desc.spacing;
+	float maxZ = origin.z + std::min( ( z + 1 ) * desc.tileSize, desc.rows - 1 ) * desc.spacing;
+
+	float dx = std::max( std::max( minX - focus.x, focus.x - maxX ), 0.0f );
+	float dz = std::max( std::max( minZ - focus.z, focus.z - maxZ ), 0.0f );
+	return dx * dx + dz * dz <= radius * radius;
+}
+
+void Heightfield::CreateTile( PrimitiveList & primitiveList, const HeightfieldDesc & desc, const MappedFile & file, unsigned int x, unsigned int z )
+{
+	using namespace unify;
+
+	const unsigned int c0 = x * desc.tileSize;
+	const unsigned int r0 = z * desc.tileSize;
+	const unsigned int c1 = std::min( c0 + desc.tileSize, desc.columns - 1 );
+	const unsigned int r1 = std::min( r0 + desc.tileSize, desc.rows - 1 );
+	const unsigned int columns = c1 - c0 + 1;
+	const unsigned int rows = r1 - r0 + 1;
+	const size_t vertexCount = (size_t)columns * rows;
+
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
+
+	// The tile's heights with a border of one sample, repeating the edge of the map where there is no neighbor,
+	// so the normals along a tile's edge match those of the tile beside it.
+	const size_t stride = columns + 2;
+	std::vector< float > heights( stride * ( rows + 2 ) );
+	for( unsigned int r = 0; r < rows + 2; ++r )
+	{
+		unsigned int row = (unsigned int)std::min( std::max( (int)( r0 + r ) - 1, 0 ), (int)desc.rows - 1 );
+		float * out = &heights[r * stride];
+		unsigned int first = c0 > 0 ? c0 - 1 : c0;
+		unsigned int last = std::min( c1 + 1, desc.columns - 1 );
+		ReadRow( desc, file, row, first, last, out + ( c0 > 0 ? 0 : 1 ) );
+		if( c0 == 0 )
+		{
+			out[0] = out[1];
+		}
+		if( c1 + 1 >= desc.columns )
+		{
+			out[stride - 1] = out[stride - 2];
+		}
+	}
+
+	std::vector< V3< float > > normals( vertexCount );
+	kernels::HeightNormals( heights.data(), stride, columns, rows, desc.spacing, desc.spacing, normals.data() );
+
+	const V3< float > origin = GetOrigin( desc );
+	std::vector< V3< float > > positions( vertexCount );
+	for( unsigned int r = 0; r < rows; ++r )
+	{
+		const float * row = &heights[( r + 1 ) * stride + 1];
+		for( unsigned int c = 0; c < columns; ++c )
+		{
+			positions[r * columns + c] = V3< float >( ( c0 + c ) * desc.spacing, row[c], ( r0 + r ) * desc.spacing );
+		}
+	}
+	kernels::Transform( kernels::Affine::Translation( origin ), positions.data(), positions.data(), vertexCount );
+
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
+
+	std::vector< unsigned char > vertices( vd->GetSizeInBytes( 0 ) * vertexCount );
+	DataLock lock( vertices.data(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
+	VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.data() } }, bufferUsage };
+	kernels::Bounds( positions.data(), vertexCount, vbParameters.bbox );
+
+	unsigned short stream = 0;
+	VertexElement positionE = CommonVertexElement::Position( stream );
+	VertexElement normalE = CommonVertexElement::Normal( stream );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+	VertexElement specularE = CommonVertexElement::Specular( stream );
+	VertexElement texE = CommonVertexElement::TexCoords( stream );
+
+	// Texture coordinates run across the whole map, so a texture does not repeat per tile.
+	const float u = 1.0f / ( desc.columns - 1 );
+	const float v = 1.0f / ( desc.rows - 1 );
+	for( unsigned int r = 0; r < rows; ++r )
+	{
+		for( unsigned int c = 0; c < columns; ++c )
+		{
+			size_t index = r * columns + c;
+			WriteVertex( *vd, lock, index, positionE, positions[index] );
+			WriteVertex( *vd, lock, index, normalE, normals[index] );
+			WriteVertex( *vd, lock, index, diffuseE, desc.diffuse );
+			WriteVertex( *vd, lock, index, specularE, desc.specular );
+			WriteVertex( *vd, lock, index, texE, TexCoords( ( c0 + c ) * u, ( r0 + r ) * v ) );
+		}
+	}
+
+	AddVertexBuffer( set, vbParameters );
+
+	const unsigned int quadsX = columns - 1;
+	const unsigned int quadsZ = rows - 1;
+	const unsigned int indexCount = 6 * quadsX * quadsZ;
+	AddMethod( set, RenderMethod::CreateTriangleListIndexed( (unsigned int)vertexCount, indexCount, 0, 0 ) );
+
+	// Wound as Plane's grid is. Only the tiles along the far edges can differ in size, so few buffers are made.
+	AddSharedIndexBuffer( set, { "Heightfield", { quadsX, quadsZ } }, bufferUsage, [&]( std::vector< Index32 > & indices )
+	{
+		indices.resize( indexCount );
+		for( unsigned int r = 0; r < quadsZ; ++r )
+		{
+			for( unsigned int c = 0; c < quadsX; ++c )
+			{
+				Index32 offset = 6 * ( c + r * quadsX );
+				indices[offset + 0] = 0 + columns * r + c;
+				indices[offset + 1] = 1 + columns * r + c;
+				indices[offset + 2] = 0 + columns * ( r + 1 ) + c;
+				indices[offset + 3] = 0 + columns * ( r + 1 ) + c;
+				indices[offset + 4] = 1 + columns * r + c;
+				indices[offset + 5] = 1 + columns * ( r + 1 ) + c;
+			}
+		}
+	} );
+}
+
+MappedFile::ptr Heightfield::Open( const HeightfieldDesc & desc )
+{
+	if( desc.bits != 16 && desc.bits != 32 )
+	{
+		throw me::exception::FailedToCreate( "Heightfield bits must be 16 or 32!" );
+	}
+	if( desc.columns < 2 || desc.rows < 2 || desc.tileSize == 0 )
+	{
+		throw me::exception::FailedToCreate( "Heightfield needs at least 2 columns and 2 rows, and a tile size!" );
+	}
+
+	MappedFile::ptr file( new MappedFile( unify::Path( desc.path ) ) );
+	if( file->GetSize() < (size_t)desc.columns * desc.rows * ( desc.bits / 8 ) )
+	{
+		throw me::exception::FailedToCreate( "Heightfield \"" + desc.path + "\" is smaller than its columns and rows!" );
+	}
+	return file;
+}
+
+HeightfieldStreamer::HeightfieldStreamer( IRenderer * renderer, const HeightfieldDesc & desc, unsigned int loadsPerUpdate )
+	: m_renderer{ renderer }
+	, m_desc{ desc }
+	, m_loadsPerUpdate{ std::max( loadsPerUpdate, 1u ) }
+	, m_file{ Heightfield::Open( desc ) }
+	, m_resident( (size_t)Heightfield::GetTilesX( desc ) * Heightfield::GetTilesZ( desc ), false )
+	, m_maxTiles{ 0 }
+{
+	if( desc.radius <= 0.0f )
+	{
+		throw me::exception::FailedToCreate( "HeightfieldStreamer needs a radius!" );
+	}
+	if( desc.canonical )
+	{
+		throw me::exception::FailedToCreate( "HeightfieldStreamer does not support canonical!" );
+	}
+}
+
+bool HeightfieldStreamer::Update( const unify::V3< float > & focus )
+{
+	const unsigned int tilesX = Heightfield::GetTilesX( m_desc );
+	const unsigned int tilesZ = Heightfield::GetTilesZ( m_desc );
+	const float tileExtent = m_desc.tileSize * m_desc.spacing;
+	bool changed = false;
+
+	auto released = std::stable_partition( m_tiles.begin(), m_tiles.end(), [&]( const Tile & tile )
+	{
+		return Heightfield::IsTileInRange( m_desc, tile.x, tile.z, focus, m_desc.radius + tileExtent );
+	} );
+	for( auto itr = released; itr != m_tiles.end(); ++itr )
+	{
+		m_resident[itr->z * tilesX + itr->x] = false;
+		changed = true;
+	}
+	m_tiles.erase( released, m_tiles.end() );
+
+	// Only the tiles under the square around the circle can be in range.
+	const unify::V3< float > origin = GetOrigin( m_desc );
+	auto clampTile = []( float tile, unsigned int count )
+	{
+		return (unsigned int)std::min( std::max( tile, 0.0f ), (float)( count - 1 ) );
+	};
+	unsigned int x0 = clampTile( floorf( ( focus.x - m_desc.radius - origin.x ) / tileExtent ), tilesX );
+	unsigned int x1 = clampTile( floorf( ( focus.x + m_desc.radius - origin.x ) / tileExtent ), tilesX );
+	unsigned int z0 = clampTile( floorf( ( focus.z - m_desc.radius - origin.z ) / tileExtent ), tilesZ );
+	unsigned int z1 = clampTile( floorf( ( focus.z + m_desc.radius - origin.z ) / tileExtent ), tilesZ );
+
+	std::vector< std::pair< float, unsigned int > > wanted;
+	for( unsigned int z = z0; z <= z1; ++z )
+	{
+		for( unsigned int x = x0; x <= x1; ++x )
+		{
+			if( !m_resident[z * tilesX + x] && Heightfield::IsTileInRange( m_desc, x, z, focus, m_desc.radius ) )
+			{
+				float dx = origin.x + ( x + 0.5f ) * tileExtent - focus.x;
+				float dz = origin.z + ( z + 0.5f ) * tileExtent - focus.z;
+				wanted.push_back( { dx * dx + dz * dz, z * tilesX + x } );
+			}
+		}
+	}
+
+	size_t loads = std::min< size_t >( wanted.size(), m_loadsPerUpdate );
+	std::partial_sort( wanted.begin(), wanted.begin() + loads, wanted.end() );
+	for( size_t i = 0; i < loads; ++i )
+	{
+		Tile tile;
+		tile.x = wanted[i].second % tilesX;
+		tile.z = wanted[i].second / tilesX;
+		tile.primitiveList.reset( new PrimitiveList( m_renderer ) );
+		Heightfield::CreateTile( *tile.primitiveList, m_desc, *m_file, tile.x, tile.z );
+		m_tiles.push_back( tile );
+		m_resident[wanted[i].second] = true;
+		changed = true;
+	}
+	m_maxTiles = std::max( m_maxTiles, m_tiles.size() );
+
+	return changed;
+}
+
+const std::vector< HeightfieldStreamer::Tile > & HeightfieldStreamer::GetTiles() const
+{
+	return m_tiles;
+}
+
+size_t HeightfieldStreamer::GetMaxTiles() const
+{
+	return m_maxTiles;
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <me/sculpter/IShapeCreator.h>
+#include <me/render/IRenderer.h>
+#include <shapes/ShapeDesc.h>
+#include <shapes/MappedFile.h>
+#include <unify/V3.h>
+#include <memory>
+#include <vector>
+
+namespace shapes
+{
+	struct HeightfieldDesc : public ShapeDesc
+	{
+		HeightfieldDesc();
+		HeightfieldDesc( const unify::Parameters & parameters );
+
+		// A raw file of rows by columns heights, a row at a time along x, rows along z. 16 bit heights are
+		// unsigned, 0 to 65535 mapping to 0 to heightScale; 32 bit heights are floats, scaled by heightScale.
+		std::string path;
+		unsigned int columns;
+		unsigned int rows;
+		unsigned int bits;
+		float heightScale;
+
+		// The distance between samples; the map is centered on center in xz, with heights above center.y.
+		float spacing;
+
+		// Quads along each side of a tile; every tile is its own BufferSet with its own bounds.
+		unsigned int tileSize;
+
+		// Only tiles within radius of focus, in xz, are created. A radius of 0 creates the whole map.
+		unify::V3< float > focus;
+		float radius;
+	};
+
+	class Heightfield : public me::sculpter::IShapeCreator
+	{
+	public:
+		Heightfield();
+		~Heightfield() override;
+
+		void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+
+		/// <summary>
+		/// Throws for a canonical desc: tiles are placed by their samples, and are not unit sized.
+		/// </summary>
+		void Create( me::render::PrimitiveList & primitiveList, const HeightfieldDesc & desc ) const;
+
+		static unsigned int GetTilesX( const HeightfieldDesc & desc );
+		static unsigned int GetTilesZ( const HeightfieldDesc & desc );
+
+		/// <summary>
+		/// Whether any of tile x, z is within desc.radius of focus, in xz.
+		/// </summary>
+		static bool IsTileInRange( const HeightfieldDesc & desc, unsigned int x, unsigned int z, const unify::V3< float > & focus, float radius );
+
+		/// <summary>
+		/// Adds the BufferSet of a single tile, reading only the rows of file the tile and its normals need.
+		/// Tiles of the same size share an index buffer.
+		/// </summary>
+		static void CreateTile( me::render::PrimitiveList & primitiveList, const HeightfieldDesc & desc, const MappedFile & file, unsigned int x, unsigned int z );
+
+		/// <summary>
+		/// Maps desc.path, checking it holds every height desc describes.
+		/// </summary>
+		static MappedFile::ptr Open( const HeightfieldDesc & desc );
+	};
+
+	/// <summary>
+	/// Keeps the tiles of a heightfield around a moving focus resident, each in its own PrimitiveList, and no
+	/// others, so memory stays bounded however large the map is. Tiles within desc.radius are loaded nearest
+	/// first, a few per update; tiles are released once beyond desc.radius plus a tile, so a focus moving back
+	/// and forth over a tile edge does not reload them.
+	/// </summary>
+	class HeightfieldStreamer
+	{
+	public:
+		struct Tile
+		{
+			unsigned int x;
+			unsigned int z;
+			std::shared_ptr< me::render::PrimitiveList > primitiveList;
+		};
+
+		HeightfieldStreamer( me::render::IRenderer * renderer, const HeightfieldDesc & desc, unsigned int loadsPerUpdate = 4 );
+
+		/// <summary>
+		/// Releases the tiles out of range of focus, then loads up to loadsPerUpdate of those in range. Returns
+		/// true if any tile was loaded or released.
+		/// </summary>
+		bool Update( const unify::V3< float > & focus );
+
+		const std::vector< Tile > & GetTiles() const;
+
+		/// <summary>
+		/// The most tiles resident at once over every update so far.
+		/// </summary>
+		size_t GetMaxTiles() const;
+
+	private:
+		me::render::IRenderer * m_renderer;
+		HeightfieldDesc m_desc;
+		unsigned int m_loadsPerUpdate;
+		MappedFile::ptr m_file;
+		std::vector< Tile > m_tiles;
+		std::vector< bool > m_resident;
+		size_t m_maxTiles;
+	};
+}
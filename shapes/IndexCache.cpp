@@ -0,0 +1,134 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/IndexCache.h>
+#include <algorithm>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+IndexCache::Key::Key( const std::string & shape, const std::vector< unsigned int > & topology, unsigned int indexWidth )
+	: shape{ shape }
+	, topology{ topology }
+	, indexWidth{ indexWidth }
+{
+}
+
+bool IndexCache::Key::operator<( const Key & key ) const
+{
+	if( shape != key.shape ) return shape < key.shape;
+	if( indexWidth != key.indexWidth ) return indexWidth < key.indexWidth;
+	return topology < key.topology;
+}
+
+IndexCache & IndexCache::Instance()
+{
+	static IndexCache cache;
+	return cache;
+}
+
+IndexCache::IndexCache()
+	: m_uses{ 0 }
+{
+}
+
+IndexCache::Indices IndexCache::GetIndices( const Key & key, const Generator & generate )
+{
+	{
+		std::lock_guard< std::mutex > lock( m_lock );
+		auto found = m_entries.find( key );
+		if( found != m_entries.end() && found->second.indices )
+		{
+			found->second.lastUse = ++m_uses;
+			return found->second.indices;
+		}
+	}
+
+	std::shared_ptr< std::vector< Index32 > > indices( new std::vector< Index32 >() );
+	generate( *indices );
+
+	std::lock_guard< std::mutex > lock( m_lock );
+	Entry & entry = m_entries[key];
+	if( !entry.indices )
+	{
+		entry.indices = indices;
+	}
+	entry.lastUse = ++m_uses;
+	Indices result = entry.indices;
+	Trim();
+	return result;
+}
+
+IIndexBuffer::ptr IndexCache::GetBuffer( const Key & key, BufferUsage::TYPE usage ) const
+{
+	std::lock_guard< std::mutex > lock( m_lock );
+	auto entry = m_entries.find( key );
+	if( entry == m_entries.end() )
+	{
+		return IIndexBuffer::ptr();
+	}
+
+	auto buffer = entry->second.buffers.find( usage );
+	return buffer == entry->second.buffers.end() ? IIndexBuffer::ptr() : buffer->second.lock();
+}
+
+void IndexCache::SetBuffer( const Key & key, BufferUsage::TYPE usage, IIndexBuffer::ptr buffer )
+{
+	std::lock_guard< std::mutex > lock( m_lock );
+	Entry & entry = m_entries[key];
+	entry.buffers[usage] = buffer;
+	entry.lastUse = ++m_uses;
+}
+
+size_t IndexCache::GetEntryCount() const
+{
+	std::lock_guard< std::mutex > lock( m_lock );
+	return m_entries.size();
+}
+
+size_t IndexCache::GetIndexCount() const
+{
+	std::lock_guard< std::mutex > lock( m_lock );
+	size_t count = 0;
+	for( const auto & entry : m_entries )
+	{
+		count += entry.second.indices ? entry.second.indices->size() : 0;
+	}
+	return count;
+}
+
+void IndexCache::Clear()
+{
+	std::lock_guard< std::mutex > lock( m_lock );
+	m_entries.clear();
+}
+
+void IndexCache::Trim()
+{
+	std::vector< std::pair< uint64_t, std::map< Key, Entry >::iterator > > idle;
+	for( auto entry = m_entries.begin(); entry != m_entries.end(); ++entry )
+	{
+		auto & buffers = entry->second.buffers;
+		for( auto buffer = buffers.begin(); buffer != buffers.end(); )
+		{
+			buffer = buffer->second.expired() ? buffers.erase( buffer ) : std::next( buffer );
+		}
+		if( buffers.empty() )
+		{
+			idle.push_back( { entry->second.lastUse, entry } );
+		}
+	}
+
+	if( idle.size() <= IdleLimit )
+	{
+		return;
+	}
+
+	std::nth_element( idle.begin(), idle.begin() + ( idle.size() - IdleLimit ), idle.end(),
+		[]( const auto & a, const auto & b ) { return a.first < b.first; } );
+	for( size_t i = 0; i < idle.size() - IdleLimit; ++i )
+	{
+		m_entries.erase( idle[i].second );
+	}
+}
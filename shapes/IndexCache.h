@@ -0,0 +1,85 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <me/render/BufferSet.h>
+#include <me/render/BufferUsage.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace shapes
+{
+	/// <summary>
+	/// A process wide cache of the index lists of shapes whose indices depend only on their topology, such as a
+	/// sphere's segments, along with the index buffers made from them. Index memory and generation time then grow
+	/// with the number of distinct tessellations rather than the number of shapes.
+	///
+	/// Buffers are only held weakly, so a buffer is released with the last BufferSet using it, and made again the
+	/// next time it is asked for. An entry with no buffer alive is idle; only the IdleLimit most recently used
+	/// idle entries are kept, so tessellations that are no longer drawn, as automatic segments leave behind, do
+	/// not pile up.
+	/// </summary>
+	class IndexCache
+	{
+	public:
+		struct Key
+		{
+			Key( const std::string & shape, const std::vector< unsigned int > & topology, unsigned int indexWidth = sizeof( me::render::Index32 ) );
+
+			bool operator<( const Key & key ) const;
+
+			std::string shape;
+			std::vector< unsigned int > topology;
+			unsigned int indexWidth;
+		};
+
+		typedef std::shared_ptr< const std::vector< me::render::Index32 > > Indices;
+		typedef std::function< void( std::vector< me::render::Index32 > & indices ) > Generator;
+
+		static const size_t IdleLimit = 64;
+
+		static IndexCache & Instance();
+
+		IndexCache();
+
+		/// <summary>
+		/// Returns the indices for key, calling generate to fill them the first time. generate runs without the
+		/// cache locked, so threads asking for other keys are not held up; threads racing on the same key may
+		/// each generate, and all get the first result stored.
+		/// </summary>
+		Indices GetIndices( const Key & key, const Generator & generate );
+
+		/// <summary>
+		/// Returns the buffer made from key's indices with usage, or nullptr if there is none alive.
+		/// </summary>
+		me::render::IIndexBuffer::ptr GetBuffer( const Key & key, me::render::BufferUsage::TYPE usage ) const;
+		void SetBuffer( const Key & key, me::render::BufferUsage::TYPE usage, me::render::IIndexBuffer::ptr buffer );
+
+		size_t GetEntryCount() const;
+		size_t GetIndexCount() const;
+
+		void Clear();
+
+	private:
+		struct Entry
+		{
+			Indices indices;
+			std::map< me::render::BufferUsage::TYPE, std::weak_ptr< me::render::IIndexBuffer > > buffers;
+			uint64_t lastUse;
+		};
+
+		/// <summary>
+		/// Forgets released buffers, then the least recently used idle entries past IdleLimit. Called locked.
+		/// </summary>
+		void Trim();
+
+		mutable std::mutex m_lock;
+		std::map< Key, Entry > m_entries;
+		uint64_t m_uses;
+	};
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/MappedFile.h>
+#include <me/exception/FailedToCreate.h>
+
+#if defined( _WIN32 )
+#include <port/win/Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace shapes;
+
+#if defined( _WIN32 )
+
+MappedFile::MappedFile( const unify::Path & path )
+	: m_path{ path }
+	, m_data{ nullptr }
+	, m_size{ 0 }
+	, m_file{ INVALID_HANDLE_VALUE }
+	, m_mapping{ nullptr }
+{
+	m_file = CreateFileA( path.ToString().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr );
+	if( m_file == INVALID_HANDLE_VALUE )
+	{
+		throw me::exception::FailedToCreate( "Failed to open \"" + path.ToString() + "\" for mapping!" );
+	}
+
+	LARGE_INTEGER size{};
+	GetFileSizeEx( m_file, &size );
+	m_size = (size_t)size.QuadPart;
+	if( m_size == 0 )
+	{
+		CloseHandle( m_file );
+		throw me::exception::FailedToCreate( "Failed to map \"" + path.ToString() + "\", file is empty!" );
+	}
+
+	m_mapping = CreateFileMappingA( m_file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if( m_mapping == nullptr )
+	{
+		CloseHandle( m_file );
+		throw me::exception::FailedToCreate( "Failed to create mapping for \"" + path.ToString() + "\"!" );
+	}
+
+	m_data = (const unsigned char *)MapViewOfFile( m_mapping, FILE_MAP_READ, 0, 0, 0 );
+	if( m_data == nullptr )
+	{
+		CloseHandle( m_mapping );
+		CloseHandle( m_file );
+		throw me::exception::FailedToCreate( "Failed to map view of \"" + path.ToString() + "\"!" );
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	UnmapViewOfFile( m_data );
+	CloseHandle( m_mapping );
+	CloseHandle( m_file );
+}
+
+#else
+
+MappedFile::MappedFile( const unify::Path & path )
+	: m_path{ path }
+	, m_data{ nullptr }
+	, m_size{ 0 }
+	, m_file{ -1 }
+{
+	m_file = open( path.ToString().c_str(), O_RDONLY );
+	if( m_file == -1 )
+	{
+		throw me::exception::FailedToCreate( "Failed to open \"" + path.ToString() + "\" for mapping!" );
+	}
+
+	struct stat status{};
+	fstat( m_file, &status );
+	m_size = (size_t)status.st_size;
+	if( m_size == 0 )
+	{
+		close( m_file );
+		throw me::exception::FailedToCreate( "Failed to map \"" + path.ToString() + "\", file is empty!" );
+	}
+
+	void * data = mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0 );
+	if( data == MAP_FAILED )
+	{
+		close( m_file );
+		throw me::exception::FailedToCreate( "Failed to map view of \"" + path.ToString() + "\"!" );
+	}
+	m_data = (const unsigned char *)data;
+}
+
+MappedFile::~MappedFile()
+{
+	munmap( (void *)m_data, m_size );
+	close( m_file );
+}
+
+#endif
+
+const unify::Path & MappedFile::GetPath() const
+{
+	return m_path;
+}
+
+const unsigned char * MappedFile::GetData() const
+{
+	return m_data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return m_size;
+}
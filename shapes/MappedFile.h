@@ -0,0 +1,39 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <unify/Path.h>
+#include <memory>
+
+namespace shapes
+{
+	/// <summary>
+	/// A read-only view of an entire file, mapped into memory for the life of the object.
+	/// </summary>
+	class MappedFile
+	{
+	public:
+		typedef std::shared_ptr< const MappedFile > ptr;
+
+		MappedFile( const unify::Path & path );
+		~MappedFile();
+
+		MappedFile( const MappedFile & ) = delete;
+		MappedFile & operator=( const MappedFile & ) = delete;
+
+		const unify::Path & GetPath() const;
+		const unsigned char * GetData() const;
+		size_t GetSize() const;
+
+	private:
+		unify::Path m_path;
+		const unsigned char * m_data;
+		size_t m_size;
+#if defined( _WIN32 )
+		void * m_file;
+		void * m_mapping;
+#else
+		int m_file;
+#endif
+	};
+}
@@ -0,0 +1,341 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/Meshlets.h>
+#include <shapes/VectorMath.h>
+#include <shapes/ShapeOutput.h>
+#include <me/exception/FailedToCreate.h>
+#include <unify/BBox.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+using vectormath::Dot;
+using vectormath::Cross;
+
+namespace
+{
+	// Fills in the bounds and cone of a meshlet from its triangles.
+	void Finish( Meshlet & meshlet, const unify::V3< float > * positions, const unify::V3< float > * normals, const Index32 * indices )
+	{
+		unify::BBox< float > bbox;
+		std::vector< unify::V3< float > > faces;
+		faces.reserve( meshlet.indexCount / 3 );
+		unify::V3< float > sum( 0, 0, 0 );
+		for( unsigned int i = meshlet.startIndex; i < meshlet.startIndex + meshlet.indexCount; i += 3 )
+		{
+			const unify::V3< float > & a = positions[indices[i]];
+			const unify::V3< float > & b = positions[indices[i + 1]];
+			const unify::V3< float > & c = positions[indices[i + 2]];
+			bbox += a;
+			bbox += b;
+			bbox += c;
+
+			unify::V3< float > face = Cross( b - a, c - a );
+			if( face.Length() == 0.0f )
+			{
+				continue;
+			}
+			face.Normalize();
+
+			unify::V3< float > vertexNormals = normals[indices[i]] + normals[indices[i + 1]] + normals[indices[i + 2]];
+			if( Dot( face, vertexNormals ) < 0.0f )
+			{
+				face = face * -1.0f;
+			}
+			faces.push_back( face );
+			sum += face;
+		}
+
+		meshlet.center = ( bbox.inf + bbox.sup ) * 0.5f;
+		meshlet.radius = 0.0f;
+		for( unsigned int i = meshlet.startIndex; i < meshlet.startIndex + meshlet.indexCount; ++i )
+		{
+			meshlet.radius = std::max( meshlet.radius, ( positions[indices[i]] - meshlet.center ).Length() );
+		}
+
+		meshlet.coneAxis = unify::V3< float >( 0, 1, 0 );
+		meshlet.coneCutoff = 1.0f;
+		if( faces.empty() || sum.Length() == 0.0f )
+		{
+			return;
+		}
+
+		sum.Normalize();
+		float minimum = 1.0f;
+		for( const auto & face : faces )
+		{
+			minimum = std::min( minimum, Dot( face, sum ) );
+		}
+
+		meshlet.coneAxis = sum;
+		if( minimum > 0.0f )
+		{
+			meshlet.coneCutoff = sqrtf( 1.0f - minimum * minimum );
+		}
+	}
+}
+
+MeshletOptions::MeshletOptions()
+	: enabled{ false }
+	, maxVertices{ 64 }
+	, maxTriangles{ 124 }
+{
+}
+
+MeshletOptions::MeshletOptions( const unify::Parameters & parameters )
+	: enabled{ parameters.Get( "meshlets", false ) }
+	, maxVertices{ parameters.Get< unsigned int >( "meshletvertices", 64 ) }
+	, maxTriangles{ parameters.Get< unsigned int >( "meshlettriangles", 124 ) }
+{
+	if( maxVertices < 3 )
+	{
+		throw me::exception::FailedToCreate( "\"meshletvertices\" must be at least 3!" );
+	}
+	if( maxTriangles == 0 )
+	{
+		throw me::exception::FailedToCreate( "\"meshlettriangles\" must be more than zero!" );
+	}
+}
+
+Meshlet::Meshlet()
+	: set{ nullptr }
+	, method{ 0 }
+	, startIndex{ 0 }
+	, indexCount{ 0 }
+	, vertexCount{ 0 }
+	, center{ 0, 0, 0 }
+	, radius{ 0 }
+	, coneAxis{ 0, 1, 0 }
+	, coneCutoff{ 1.0f }
+{
+}
+
+void MeshletTable::Add( const Meshlet & meshlet )
+{
+	m_meshlets.push_back( meshlet );
+}
+
+const std::vector< Meshlet > & MeshletTable::GetMeshlets() const
+{
+	return m_meshlets;
+}
+
+void MeshletTable::Clear()
+{
+	m_meshlets.clear();
+}
+
+MeshletTable * MeshletTable::Current()
+{
+	return CurrentScope< MeshletTable >::Get();
+}
+
+void shapes::OrderForMeshlets( std::vector< Index32 > & indices, unsigned int maxVertices, unsigned int maxTriangles )
+{
+	const size_t triangleCount = indices.size() / 3;
+	if( triangleCount == 0 )
+	{
+		return;
+	}
+
+	Index32 vertexCount = *std::max_element( indices.begin(), indices.end() ) + 1;
+
+	// The triangles using each vertex, as offsets into one array.
+	std::vector< unsigned int > firstTriangle( vertexCount + 1, 0 );
+	for( size_t i = 0; i < triangleCount * 3; ++i )
+	{
+		++firstTriangle[indices[i] + 1];
+	}
+	for( Index32 v = 0; v < vertexCount; ++v )
+	{
+		firstTriangle[v + 1] += firstTriangle[v];
+	}
+	std::vector< unsigned int > vertexTriangles( triangleCount * 3 );
+	{
+		std::vector< unsigned int > fill( firstTriangle.begin(), firstTriangle.end() - 1 );
+		for( size_t i = 0; i < triangleCount * 3; ++i )
+		{
+			vertexTriangles[fill[indices[i]]++] = (unsigned int)( i / 3 );
+		}
+	}
+
+	// A vertex is in the current meshlet when its stamp is the meshlet's.
+	std::vector< unsigned int > stamp( vertexCount, 0 );
+	std::vector< bool > emitted( triangleCount, false );
+	std::vector< Index32 > ordered;
+	ordered.reserve( triangleCount * 3 );
+
+	auto newVertices = [&]( unsigned int triangle, unsigned int meshlet )
+	{
+		unsigned int added = 0;
+		for( size_t corner = 0; corner < 3; ++corner )
+		{
+			added += stamp[indices[triangle * 3 + corner]] != meshlet ? 1 : 0;
+		}
+		return added;
+	};
+
+	unsigned int meshlet = 0;
+	size_t seed = 0;
+	std::vector< unsigned int > candidates;
+	while( ordered.size() < triangleCount * 3 )
+	{
+		while( emitted[seed] ) ++seed;
+
+		++meshlet;
+		unsigned int vertices = 0;
+		unsigned int triangles = 0;
+		candidates.assign( 1, (unsigned int)seed );
+		while( triangles == 0 || triangles < maxTriangles )
+		{
+			// The candidate adding the fewest new vertices, the earliest on a tie.
+			unsigned int best = 0;
+			unsigned int bestAdded = 4;
+			for( unsigned int candidate : candidates )
+			{
+				if( emitted[candidate] ) continue;
+				unsigned int added = newVertices( candidate, meshlet );
+				if( added < bestAdded || ( added == bestAdded && candidate < best ) )
+				{
+					best = candidate;
+					bestAdded = added;
+				}
+			}
+			// The seed is always taken, whatever the limits, so every meshlet moves the order on.
+			if( bestAdded == 4 || ( triangles != 0 && vertices + bestAdded > maxVertices ) )
+			{
+				break;
+			}
+
+			emitted[best] = true;
+			++triangles;
+			vertices += bestAdded;
+			for( size_t corner = 0; corner < 3; ++corner )
+			{
+				Index32 vertex = indices[best * 3 + corner];
+				ordered.push_back( vertex );
+				if( stamp[vertex] != meshlet )
+				{
+					stamp[vertex] = meshlet;
+					for( unsigned int t = firstTriangle[vertex]; t < firstTriangle[vertex + 1]; ++t )
+					{
+						if( !emitted[vertexTriangles[t]] )
+						{
+							candidates.push_back( vertexTriangles[t] );
+						}
+					}
+				}
+			}
+		}
+	}
+
+	indices.swap( ordered );
+}
+
+std::vector< Meshlet > shapes::BuildMeshlets( const unify::V3< float > * positions, const unify::V3< float > * normals,
+	const Index32 * indices, size_t indexCount, unsigned int maxVertices, unsigned int maxTriangles )
+{
+	std::vector< Meshlet > meshlets;
+	std::vector< Index32 > used;
+	used.reserve( maxVertices );
+
+	Meshlet meshlet;
+	for( size_t i = 0; i + 2 < indexCount; i += 3 )
+	{
+		unsigned int added = 0;
+		for( size_t corner = 0; corner < 3; ++corner )
+		{
+			if( std::find( used.begin(), used.end(), indices[i + corner] ) == used.end() )
+			{
+				++added;
+			}
+		}
+
+		if( meshlet.indexCount != 0 && ( used.size() + added > maxVertices || meshlet.indexCount / 3 + 1 > maxTriangles ) )
+		{
+			meshlet.vertexCount = (unsigned int)used.size();
+			Finish( meshlet, positions, normals, indices );
+			meshlets.push_back( meshlet );
+
+			meshlet = Meshlet();
+			meshlet.startIndex = (unsigned int)i;
+			used.clear();
+		}
+
+		for( size_t corner = 0; corner < 3; ++corner )
+		{
+			if( std::find( used.begin(), used.end(), indices[i + corner] ) == used.end() )
+			{
+				used.push_back( indices[i + corner] );
+			}
+		}
+		meshlet.indexCount += 3;
+	}
+
+	if( meshlet.indexCount != 0 )
+	{
+		meshlet.vertexCount = (unsigned int)used.size();
+		Finish( meshlet, positions, normals, indices );
+		meshlets.push_back( meshlet );
+	}
+
+	return meshlets;
+}
+
+void shapes::AddMeshletMethods( BufferSet & set, std::vector< Meshlet > & meshlets, unsigned int vertexCount )
+{
+	MeshletTable * table = MeshletTable::Current();
+	for( unsigned int m = 0; m < meshlets.size(); ++m )
+	{
+		Meshlet & meshlet = meshlets[m];
+		meshlet.set = &set;
+		meshlet.method = m;
+		AddMethod( set, RenderMethod::CreateTriangleListIndexed( vertexCount, meshlet.indexCount, meshlet.startIndex, 0 ) );
+		if( table )
+		{
+			table->Add( meshlet );
+		}
+	}
+}
+
+MeshletCuller::MeshletCuller( const unify::V3< float > & eye )
+	: m_eye{ eye }
+{
+}
+
+void MeshletCuller::AddPlane( const unify::V3< float > & normal, float distance )
+{
+	m_planes.push_back( { normal, distance } );
+}
+
+bool MeshletCuller::IsVisible( const Meshlet & meshlet ) const
+{
+	for( const auto & plane : m_planes )
+	{
+		if( Dot( plane.normal, meshlet.center ) + plane.distance < -meshlet.radius )
+		{
+			return false;
+		}
+	}
+
+	// Back facing when the eye is behind every triangle, allowing for the meshlet's size.
+	unify::V3< float > toCenter = meshlet.center - m_eye;
+	return Dot( toCenter, meshlet.coneAxis ) < meshlet.coneCutoff * toCenter.Length() + meshlet.radius;
+}
+
+std::vector< size_t > MeshletCuller::Cull( const std::vector< Meshlet > & meshlets ) const
+{
+	std::vector< size_t > visible;
+	visible.reserve( meshlets.size() );
+	for( size_t m = 0; m < meshlets.size(); ++m )
+	{
+		if( IsVisible( meshlets[m] ) )
+		{
+			visible.push_back( m );
+		}
+	}
+	return visible;
+}
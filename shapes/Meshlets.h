@@ -0,0 +1,122 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <shapes/CurrentScope.h>
+#include <me/render/BufferSet.h>
+#include <unify/Parameters.h>
+#include <unify/V3.h>
+#include <vector>
+
+namespace shapes
+{
+	/// <summary>
+	/// The meshlet parameters shared by the creators that can output meshlets. Limits that could not hold a
+	/// single triangle are rejected.
+	/// </summary>
+	struct MeshletOptions
+	{
+		MeshletOptions();
+		MeshletOptions( const unify::Parameters & parameters );
+
+		bool enabled;
+		unsigned int maxVertices;
+		unsigned int maxTriangles;
+	};
+
+	/// <summary>
+	/// A run of a triangle list small enough to cull on its own, drawn by its own RenderMethod. The bounding
+	/// sphere and normal cone are in the shape's space.
+	/// </summary>
+	struct Meshlet
+	{
+		Meshlet();
+
+		const me::render::BufferSet * set;
+		unsigned int method;
+
+		unsigned int startIndex;
+		unsigned int indexCount;
+		unsigned int vertexCount;
+
+		unify::V3< float > center;
+		float radius;
+
+		// Every triangle faces within the cone about coneAxis. coneCutoff is the sine of the cone's half angle,
+		// or 1 when the triangles face too many ways for the cluster to be back facing as a whole.
+		unify::V3< float > coneAxis;
+		float coneCutoff;
+	};
+
+	/// <summary>
+	/// The side table of the meshlets written by creators while it is current, in the order they were written.
+	/// </summary>
+	class MeshletTable
+	{
+	public:
+		typedef CurrentScope< MeshletTable > Scope;
+
+		void Add( const Meshlet & meshlet );
+
+		const std::vector< Meshlet > & GetMeshlets() const;
+
+		void Clear();
+
+		/// <summary>
+		/// Returns the table current for the calling thread, or nullptr.
+		/// </summary>
+		static MeshletTable * Current();
+
+	private:
+		std::vector< Meshlet > m_meshlets;
+	};
+
+	/// <summary>
+	/// Reorders the triangles of a triangle list so that each run BuildMeshlets takes grows out from a seed
+	/// triangle over shared vertices, rather than following the list's rows. Compact meshlets have tighter
+	/// spheres and narrower cones. Only the topology is used, so the result can be cached with the indices.
+	/// </summary>
+	void OrderForMeshlets( std::vector< me::render::Index32 > & indices, unsigned int maxVertices = 64, unsigned int maxTriangles = 124 );
+
+	/// <summary>
+	/// Splits a triangle list into meshlets of at most maxVertices distinct vertices and maxTriangles triangles,
+	/// taking triangles in index order, so the index buffer is left as it is; see OrderForMeshlets. The normals only orient each
+	/// triangle's face normal, so the winding convention does not matter.
+	/// </summary>
+	std::vector< Meshlet > BuildMeshlets( const unify::V3< float > * positions, const unify::V3< float > * normals,
+		const me::render::Index32 * indices, size_t indexCount, unsigned int maxVertices = 64, unsigned int maxTriangles = 124 );
+
+	/// <summary>
+	/// Adds one triangle list method per meshlet to the BufferSet, and the meshlets to the current MeshletTable.
+	/// </summary>
+	void AddMeshletMethods( me::render::BufferSet & set, std::vector< Meshlet > & meshlets, unsigned int vertexCount );
+
+	/// <summary>
+	/// Rejects meshlets that are outside the frustum, or that face away from the eye. The eye and planes are in
+	/// the shape's space; a plane keeps what is on the side its normal points to.
+	/// </summary>
+	class MeshletCuller
+	{
+	public:
+		MeshletCuller( const unify::V3< float > & eye );
+
+		void AddPlane( const unify::V3< float > & normal, float distance );
+
+		bool IsVisible( const Meshlet & meshlet ) const;
+
+		/// <summary>
+		/// Returns the indices of the visible meshlets.
+		/// </summary>
+		std::vector< size_t > Cull( const std::vector< Meshlet > & meshlets ) const;
+
+	private:
+		struct Plane
+		{
+			unify::V3< float > normal;
+			float distance;
+		};
+
+		unify::V3< float > m_eye;
+		std::vector< Plane > m_planes;
+	};
+}
@@ -0,0 +1,132 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/Morton.h>
+#include <algorithm>
+#include <thread>
+
+using namespace shapes;
+
+namespace
+{
+	const unsigned int RadixBits = 8;
+	const unsigned int Buckets = 1 << RadixBits;
+	const unsigned int CodeBits = 30;
+
+	// Below this a single thread sorts faster than starting others.
+	const size_t ParallelThreshold = 1 << 16;
+
+	// Runs work( thread, begin, end ) over even blocks of count, one per thread.
+	template< typename Work >
+	void ForBlocks( size_t count, unsigned int threads, Work work )
+	{
+		if( threads == 1 )
+		{
+			work( 0, 0, count );
+			return;
+		}
+
+		std::vector< std::thread > workers;
+		size_t block = ( count + threads - 1 ) / threads;
+		for( unsigned int t = 0; t < threads; ++t )
+		{
+			size_t begin = std::min( count, block * t );
+			size_t end = std::min( count, begin + block );
+			workers.push_back( std::thread( work, t, begin, end ) );
+		}
+		for( auto & worker : workers )
+		{
+			worker.join();
+		}
+	}
+}
+
+uint32_t morton::Expand( uint32_t value )
+{
+	value &= 0x000003ff;
+	value = ( value | ( value << 16 ) ) & 0x030000ff;
+	value = ( value | ( value << 8 ) ) & 0x0300f00f;
+	value = ( value | ( value << 4 ) ) & 0x030c30c3;
+	value = ( value | ( value << 2 ) ) & 0x09249249;
+	return value;
+}
+
+uint32_t morton::Encode( const unify::V3< float > & position, const unify::BBox< float > & bounds )
+{
+	auto quantize = []( float value, float inf, float sup )
+	{
+		float extent = sup - inf;
+		float unit = extent > 0.0f ? ( value - inf ) / extent : 0.0f;
+		return (uint32_t)std::min( 1023.0f, std::max( 0.0f, unit * 1024.0f ) );
+	};
+
+	return
+		( Expand( quantize( position.x, bounds.inf.x, bounds.sup.x ) ) << 2 ) |
+		( Expand( quantize( position.y, bounds.inf.y, bounds.sup.y ) ) << 1 ) |
+		Expand( quantize( position.z, bounds.inf.z, bounds.sup.z ) );
+}
+
+std::vector< uint32_t > morton::Order( const unify::V3< float > * positions, size_t count, const unify::BBox< float > & bounds )
+{
+	unsigned int threads = 1;
+	if( count >= ParallelThreshold )
+	{
+		threads = std::max( 1u, std::min( 8u, std::thread::hardware_concurrency() ) );
+	}
+
+	std::vector< uint32_t > keys( count );
+	std::vector< uint32_t > order( count );
+	ForBlocks( count, threads, [&]( unsigned int, size_t begin, size_t end )
+	{
+		for( size_t i = begin; i < end; ++i )
+		{
+			keys[i] = Encode( positions[i], bounds );
+			order[i] = (uint32_t)i;
+		}
+	} );
+
+	std::vector< uint32_t > keysOut( count );
+	std::vector< uint32_t > orderOut( count );
+	std::vector< size_t > histograms( threads * Buckets );
+	for( unsigned int shift = 0; shift < CodeBits; shift += RadixBits )
+	{
+		std::fill( histograms.begin(), histograms.end(), 0 );
+		ForBlocks( count, threads, [&]( unsigned int thread, size_t begin, size_t end )
+		{
+			size_t * histogram = &histograms[thread * Buckets];
+			for( size_t i = begin; i < end; ++i )
+			{
+				++histogram[( keys[i] >> shift ) & ( Buckets - 1 )];
+			}
+		} );
+
+		// Each thread writes a digit after every smaller digit, and after the same digit from earlier threads,
+		// which keeps the sort stable.
+		size_t offset = 0;
+		for( unsigned int digit = 0; digit < Buckets; ++digit )
+		{
+			for( unsigned int thread = 0; thread < threads; ++thread )
+			{
+				size_t digitCount = histograms[thread * Buckets + digit];
+				histograms[thread * Buckets + digit] = offset;
+				offset += digitCount;
+			}
+		}
+
+		ForBlocks( count, threads, [&]( unsigned int thread, size_t begin, size_t end )
+		{
+			size_t * offsets = &histograms[thread * Buckets];
+			for( size_t i = begin; i < end; ++i )
+			{
+				size_t destination = offsets[( keys[i] >> shift ) & ( Buckets - 1 )]++;
+				keysOut[destination] = keys[i];
+				orderOut[destination] = order[i];
+			}
+		} );
+
+		keys.swap( keysOut );
+		order.swap( orderOut );
+	}
+
+	return order;
+}
@@ -0,0 +1,34 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <unify/V3.h>
+#include <unify/BBox.h>
+#include <cstdint>
+#include <vector>
+
+namespace shapes
+{
+	/// <summary>
+	/// Morton (Z order) codes, which interleave the bits of quantized x, y and z so that points close in space
+	/// are mostly close in the sorted order.
+	/// </summary>
+	namespace morton
+	{
+		/// <summary>
+		/// Spreads the low 10 bits of value so two zero bits fall between each.
+		/// </summary>
+		uint32_t Expand( uint32_t value );
+
+		/// <summary>
+		/// The 30 bit code of position, quantized to 1024 steps per axis of bounds.
+		/// </summary>
+		uint32_t Encode( const unify::V3< float > & position, const unify::BBox< float > & bounds );
+
+		/// <summary>
+		/// The indices of positions in Morton order. Sorted with a stable least significant digit radix sort, with
+		/// the histogram and scatter of each pass split across threads for large inputs.
+		/// </summary>
+		std::vector< uint32_t > Order( const unify::V3< float > * positions, size_t count, const unify::BBox< float > & bounds );
+	}
+}
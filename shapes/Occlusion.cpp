@@ -0,0 +1,485 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/Occlusion.h>
+#include <shapes/ShapeKernels.h>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <cmath>
+
+#if defined( SHAPES_KERNELS_SSE2 )
+#include <emmintrin.h>
+#elif defined( SHAPES_KERNELS_NEON )
+#include <arm_neon.h>
+#endif
+
+using namespace shapes;
+
+namespace
+{
+	const float PI2 = 6.28318530717959f;
+
+	// Fills the pixels of one row, from x0 to x1, that are inside the triangle and nearer than what is there.
+	// x0 is a multiple of four and the row is a whole number of tiles wide, so every group of four is in the row.
+	void FillSpan( float * row, int x0, int x1, float py, const float * edgeA, const float * edgeB, const float * edgeC, float depthA, float depthB, float depthC )
+	{
+		const float row0 = edgeB[0] * py + edgeC[0];
+		const float row1 = edgeB[1] * py + edgeC[1];
+		const float row2 = edgeB[2] * py + edgeC[2];
+		const float rowDepth = depthB * py + depthC;
+		int x = x0;
+
+#if defined( SHAPES_KERNELS_SSE2 )
+		const __m128 lanes = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+		const __m128 zero = _mm_setzero_ps();
+		for( ; x <= x1; x += 4 )
+		{
+			__m128 px = _mm_add_ps( _mm_set1_ps( (float)x ), lanes );
+			__m128 e0 = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( edgeA[0] ), px ), _mm_set1_ps( row0 ) );
+			__m128 e1 = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( edgeA[1] ), px ), _mm_set1_ps( row1 ) );
+			__m128 e2 = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( edgeA[2] ), px ), _mm_set1_ps( row2 ) );
+			__m128 inside = _mm_and_ps( _mm_and_ps( _mm_cmpge_ps( e0, zero ), _mm_cmpge_ps( e1, zero ) ), _mm_cmpge_ps( e2, zero ) );
+			if( _mm_movemask_ps( inside ) == 0 )
+			{
+				continue;
+			}
+			__m128 z = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( depthA ), px ), _mm_set1_ps( rowDepth ) );
+			__m128 depth = _mm_loadu_ps( row + x );
+			__m128 nearer = _mm_min_ps( depth, z );
+			_mm_storeu_ps( row + x, _mm_or_ps( _mm_and_ps( inside, nearer ), _mm_andnot_ps( inside, depth ) ) );
+		}
+#elif defined( SHAPES_KERNELS_NEON )
+		const float laneOffsets[4] = { 0.5f, 1.5f, 2.5f, 3.5f };
+		const float32x4_t lanes = vld1q_f32( laneOffsets );
+		const float32x4_t zero = vdupq_n_f32( 0.0f );
+		for( ; x <= x1; x += 4 )
+		{
+			float32x4_t px = vaddq_f32( vdupq_n_f32( (float)x ), lanes );
+			float32x4_t e0 = vmlaq_f32( vdupq_n_f32( row0 ), vdupq_n_f32( edgeA[0] ), px );
+			float32x4_t e1 = vmlaq_f32( vdupq_n_f32( row1 ), vdupq_n_f32( edgeA[1] ), px );
+			float32x4_t e2 = vmlaq_f32( vdupq_n_f32( row2 ), vdupq_n_f32( edgeA[2] ), px );
+			uint32x4_t inside = vandq_u32( vandq_u32( vcgeq_f32( e0, zero ), vcgeq_f32( e1, zero ) ), vcgeq_f32( e2, zero ) );
+			float32x4_t z = vmlaq_f32( vdupq_n_f32( rowDepth ), vdupq_n_f32( depthA ), px );
+			float32x4_t depth = vld1q_f32( row + x );
+			vst1q_f32( row + x, vbslq_f32( inside, vminq_f32( depth, z ), depth ) );
+		}
+#endif
+
+		for( ; x <= x1; ++x )
+		{
+			float px = x + 0.5f;
+			if( edgeA[0] * px + row0 >= 0.0f && edgeA[1] * px + row1 >= 0.0f && edgeA[2] * px + row2 >= 0.0f )
+			{
+				row[x] = std::min( row[x], depthA * px + rowDepth );
+			}
+		}
+	}
+}
+
+OccluderMesh OccluderMesh::MakeBox( const unify::V3< float > & inf, const unify::V3< float > & sup )
+{
+	OccluderMesh mesh;
+	for( unsigned int corner = 0; corner < 8; ++corner )
+	{
+		mesh.positions.push_back( unify::V3< float >(
+			( corner & 1 ) ? sup.x : inf.x,
+			( corner & 2 ) ? sup.y : inf.y,
+			( corner & 4 ) ? sup.z : inf.z ) );
+	}
+
+	// Two triangles for each face; the rasterizer draws both sides, so winding does not matter.
+	mesh.indices = {
+		0, 1, 3, 0, 3, 2,	// -z
+		4, 5, 7, 4, 7, 6,	// +z
+		0, 2, 6, 0, 6, 4,	// -x
+		1, 3, 7, 1, 7, 5,	// +x
+		0, 1, 5, 0, 5, 4,	// -y
+		2, 3, 7, 2, 7, 6	// +y
+	};
+	return mesh;
+}
+
+OccluderMesh OccluderMesh::MakePlane( const unify::V3< float > & center, const unify::Size< float > & size )
+{
+	OccluderMesh mesh;
+	float halfWidth = size.width * 0.5f;
+	float halfDepth = size.height * 0.5f;
+	mesh.positions.push_back( center + unify::V3< float >( -halfWidth, 0, -halfDepth ) );
+	mesh.positions.push_back( center + unify::V3< float >( halfWidth, 0, -halfDepth ) );
+	mesh.positions.push_back( center + unify::V3< float >( halfWidth, 0, halfDepth ) );
+	mesh.positions.push_back( center + unify::V3< float >( -halfWidth, 0, halfDepth ) );
+	mesh.indices = { 0, 1, 2, 0, 2, 3 };
+	return mesh;
+}
+
+OccluderMesh OccluderMesh::MakeCylinder( const unify::V3< float > & center, float radius, float height, unsigned int segments, bool caps )
+{
+	OccluderMesh mesh;
+	// Both rings are indexed with 16 bits.
+	segments = std::min( std::max( 3u, segments ), 0x7fffu );
+	float half = height * 0.5f;
+
+	// The bottom ring, then the top ring.
+	for( unsigned int ring = 0; ring < 2; ++ring )
+	{
+		for( unsigned int s = 0; s < segments; ++s )
+		{
+			float angle = PI2 * s / segments;
+			mesh.positions.push_back( center + unify::V3< float >( sinf( angle ) * radius, ring ? half : -half, cosf( angle ) * radius ) );
+		}
+	}
+
+	const unsigned int top = segments;
+	for( unsigned int s = 0; s < segments; ++s )
+	{
+		unsigned int next = ( s + 1 ) % segments;
+		mesh.indices.insert( mesh.indices.end(), { (uint16_t)s, (uint16_t)next, (uint16_t)( top + next ), (uint16_t)s, (uint16_t)( top + next ), (uint16_t)( top + s ) } );
+	}
+	if( caps )
+	{
+		for( unsigned int s = 1; s + 1 < segments; ++s )
+		{
+			mesh.indices.insert( mesh.indices.end(), { 0, (uint16_t)s, (uint16_t)( s + 1 ), (uint16_t)top, (uint16_t)( top + s ), (uint16_t)( top + s + 1 ) } );
+		}
+	}
+	return mesh;
+}
+
+OcclusionBuffer::OcclusionBuffer( unsigned int width, unsigned int height )
+	: m_tilesX{ std::max( 1u, ( width + TileSize - 1 ) / TileSize ) }
+	, m_tilesY{ std::max( 1u, ( height + TileSize - 1 ) / TileSize ) }
+{
+	m_width = m_tilesX * TileSize;
+	m_height = m_tilesY * TileSize;
+
+	// Each level halves the one before, rounding up, down to a single texel.
+	unsigned int levelWidth = m_width;
+	unsigned int levelHeight = m_height;
+	while( true )
+	{
+		m_levelWidths.push_back( levelWidth );
+		m_levelHeights.push_back( levelHeight );
+		m_levels.push_back( std::vector< float >( levelWidth * levelHeight, 1.0f ) );
+		if( levelWidth == 1 && levelHeight == 1 )
+		{
+			break;
+		}
+		levelWidth = ( levelWidth + 1 ) / 2;
+		levelHeight = ( levelHeight + 1 ) / 2;
+	}
+
+	SetViewProjection( unify::MatrixIdentity() );
+}
+
+void OcclusionBuffer::SetViewProjection( const unify::Matrix & viewProjection )
+{
+	for( int r = 0; r < 4; ++r )
+	{
+		for( int c = 0; c < 4; ++c )
+		{
+			m_viewProjection[r][c] = viewProjection( r, c );
+		}
+	}
+}
+
+void OcclusionBuffer::Clear()
+{
+	m_triangles.clear();
+	for( auto & level : m_levels )
+	{
+		std::fill( level.begin(), level.end(), 1.0f );
+	}
+}
+
+void OcclusionBuffer::AddOccluder( const OccluderMesh & occluder )
+{
+	const float ( &m )[4][4] = m_viewProjection;
+	std::vector< float > clip( occluder.positions.size() * 4 );
+	for( size_t v = 0; v < occluder.positions.size(); ++v )
+	{
+		const unify::V3< float > & p = occluder.positions[v];
+		for( int c = 0; c < 4; ++c )
+		{
+			clip[v * 4 + c] = p.x * m[0][c] + p.y * m[1][c] + p.z * m[2][c] + m[3][c];
+		}
+	}
+
+	for( size_t i = 0; i + 2 < occluder.indices.size(); i += 3 )
+	{
+		const float * corners[3] = { &clip[occluder.indices[i] * 4], &clip[occluder.indices[i + 1] * 4], &clip[occluder.indices[i + 2] * 4] };
+
+		// Clip against the near plane, z >= 0, which leaves a triangle or a quad.
+		float polygon[4][4];
+		int count = 0;
+		for( int k = 0; k < 3; ++k )
+		{
+			const float * current = corners[k];
+			const float * next = corners[( k + 1 ) % 3];
+			if( current[2] >= 0.0f )
+			{
+				std::copy( current, current + 4, polygon[count++] );
+			}
+			if( ( current[2] >= 0.0f ) != ( next[2] >= 0.0f ) )
+			{
+				float t = current[2] / ( current[2] - next[2] );
+				for( int c = 0; c < 4; ++c )
+				{
+					polygon[count][c] = current[c] + ( next[c] - current[c] ) * t;
+				}
+				++count;
+			}
+		}
+
+		if( count >= 3 )
+		{
+			AddTriangle( polygon[0], polygon[1], polygon[2] );
+		}
+		if( count == 4 )
+		{
+			AddTriangle( polygon[0], polygon[2], polygon[3] );
+		}
+	}
+}
+
+void OcclusionBuffer::AddTriangle( const float * a, const float * b, const float * c )
+{
+	if( a[3] <= 0.0f || b[3] <= 0.0f || c[3] <= 0.0f )
+	{
+		return;
+	}
+
+	float x[3], y[3], z[3];
+	const float * clip[3] = { a, b, c };
+	for( int v = 0; v < 3; ++v )
+	{
+		float inverseW = 1.0f / clip[v][3];
+		x[v] = ( clip[v][0] * inverseW * 0.5f + 0.5f ) * m_width;
+		y[v] = ( 0.5f - clip[v][1] * inverseW * 0.5f ) * m_height;
+		z[v] = clip[v][2] * inverseW;
+	}
+
+	float area = ( x[1] - x[0] ) * ( y[2] - y[0] ) - ( y[1] - y[0] ) * ( x[2] - x[0] );
+	if( area < 0.0f )
+	{
+		std::swap( x[1], x[2] );
+		std::swap( y[1], y[2] );
+		std::swap( z[1], z[2] );
+		area = -area;
+	}
+	if( area < 1e-6f )
+	{
+		return;
+	}
+
+	Triangle triangle;
+	triangle.minX = std::max( 0, (int)std::floor( std::min( x[0], std::min( x[1], x[2] ) ) ) );
+	triangle.minY = std::max( 0, (int)std::floor( std::min( y[0], std::min( y[1], y[2] ) ) ) );
+	triangle.maxX = std::min( (int)m_width - 1, (int)std::ceil( std::max( x[0], std::max( x[1], x[2] ) ) ) );
+	triangle.maxY = std::min( (int)m_height - 1, (int)std::ceil( std::max( y[0], std::max( y[1], y[2] ) ) ) );
+	if( triangle.minX > triangle.maxX || triangle.minY > triangle.maxY )
+	{
+		return;
+	}
+
+	// Edge v -> w is positive on the inside of a triangle with positive area.
+	for( int e = 0; e < 3; ++e )
+	{
+		int w = ( e + 1 ) % 3;
+		triangle.edgeA[e] = y[e] - y[w];
+		triangle.edgeB[e] = x[w] - x[e];
+		triangle.edgeC[e] = -( triangle.edgeA[e] * x[e] + triangle.edgeB[e] * y[e] );
+	}
+
+	float dx1 = x[1] - x[0], dy1 = y[1] - y[0], dz1 = z[1] - z[0];
+	float dx2 = x[2] - x[0], dy2 = y[2] - y[0], dz2 = z[2] - z[0];
+	triangle.depthA = ( dz1 * dy2 - dz2 * dy1 ) / area;
+	triangle.depthB = ( dx1 * dz2 - dx2 * dz1 ) / area;
+	triangle.depthC = z[0] - triangle.depthA * x[0] - triangle.depthB * y[0];
+
+	m_triangles.push_back( triangle );
+}
+
+void OcclusionBuffer::Rasterize( unsigned int threads )
+{
+	const unsigned int tileCount = m_tilesX * m_tilesY;
+	std::vector< std::vector< uint32_t > > bins( tileCount );
+	for( uint32_t t = 0; t < m_triangles.size(); ++t )
+	{
+		const Triangle & triangle = m_triangles[t];
+		for( int ty = triangle.minY / (int)TileSize; ty <= triangle.maxY / (int)TileSize; ++ty )
+		{
+			for( int tx = triangle.minX / (int)TileSize; tx <= triangle.maxX / (int)TileSize; ++tx )
+			{
+				bins[ty * m_tilesX + tx].push_back( t );
+			}
+		}
+	}
+
+	if( threads == 0 )
+	{
+		threads = std::max( 1u, std::min( 8u, std::thread::hardware_concurrency() ) );
+	}
+	threads = std::min( threads, tileCount );
+
+	// Each tile belongs to one thread at a time, so the depth needs no locking.
+	std::atomic< unsigned int > nextTile{ 0 };
+	auto work = [&]()
+	{
+		for( unsigned int tile = nextTile++; tile < tileCount; tile = nextTile++ )
+		{
+			RasterizeTile( tile, bins[tile] );
+		}
+	};
+
+	std::vector< std::thread > workers;
+	for( unsigned int t = 1; t < threads; ++t )
+	{
+		workers.push_back( std::thread( work ) );
+	}
+	work();
+	for( auto & worker : workers )
+	{
+		worker.join();
+	}
+
+	BuildHierarchy();
+}
+
+void OcclusionBuffer::RasterizeTile( unsigned int tile, const std::vector< uint32_t > & triangles )
+{
+	const int tileX = (int)( tile % m_tilesX * TileSize );
+	const int tileY = (int)( tile / m_tilesX * TileSize );
+	float * depth = m_levels[0].data();
+
+	for( uint32_t t : triangles )
+	{
+		const Triangle & triangle = m_triangles[t];
+		int x0 = std::max( triangle.minX, tileX ) & ~3;
+		int x1 = std::min( triangle.maxX, tileX + (int)TileSize - 1 );
+		int y0 = std::max( triangle.minY, tileY );
+		int y1 = std::min( triangle.maxY, tileY + (int)TileSize - 1 );
+		for( int y = y0; y <= y1; ++y )
+		{
+			FillSpan( depth + y * m_width, x0, x1, y + 0.5f, triangle.edgeA, triangle.edgeB, triangle.edgeC, triangle.depthA, triangle.depthB, triangle.depthC );
+		}
+	}
+}
+
+void OcclusionBuffer::BuildHierarchy()
+{
+	for( size_t level = 1; level < m_levels.size(); ++level )
+	{
+		const std::vector< float > & below = m_levels[level - 1];
+		const unsigned int belowWidth = m_levelWidths[level - 1];
+		const unsigned int belowHeight = m_levelHeights[level - 1];
+		std::vector< float > & above = m_levels[level];
+		for( unsigned int y = 0; y < m_levelHeights[level]; ++y )
+		{
+			unsigned int y0 = y * 2;
+			unsigned int y1 = std::min( y0 + 1, belowHeight - 1 );
+			for( unsigned int x = 0; x < m_levelWidths[level]; ++x )
+			{
+				unsigned int x0 = x * 2;
+				unsigned int x1 = std::min( x0 + 1, belowWidth - 1 );
+				above[y * m_levelWidths[level] + x] = std::max(
+					std::max( below[y0 * belowWidth + x0], below[y0 * belowWidth + x1] ),
+					std::max( below[y1 * belowWidth + x0], below[y1 * belowWidth + x1] ) );
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::IsVisible( const unify::BBox< float > & bounds ) const
+{
+	const float ( &m )[4][4] = m_viewProjection;
+	float minX = std::numeric_limits< float >::infinity();
+	float minY = std::numeric_limits< float >::infinity();
+	float maxX = -std::numeric_limits< float >::infinity();
+	float maxY = -std::numeric_limits< float >::infinity();
+	float minZ = std::numeric_limits< float >::infinity();
+	unsigned int behind = 0;
+	for( unsigned int corner = 0; corner < 8; ++corner )
+	{
+		unify::V3< float > p(
+			( corner & 1 ) ? bounds.sup.x : bounds.inf.x,
+			( corner & 2 ) ? bounds.sup.y : bounds.inf.y,
+			( corner & 4 ) ? bounds.sup.z : bounds.inf.z );
+		float clip[4];
+		for( int c = 0; c < 4; ++c )
+		{
+			clip[c] = p.x * m[0][c] + p.y * m[1][c] + p.z * m[2][c] + m[3][c];
+		}
+		if( clip[2] < 0.0f || clip[3] <= 0.0f )
+		{
+			++behind;
+			continue;
+		}
+
+		float inverseW = 1.0f / clip[3];
+		float x = ( clip[0] * inverseW * 0.5f + 0.5f ) * m_width;
+		float y = ( 0.5f - clip[1] * inverseW * 0.5f ) * m_height;
+		minX = std::min( minX, x );
+		maxX = std::max( maxX, x );
+		minY = std::min( minY, y );
+		maxY = std::max( maxY, y );
+		minZ = std::min( minZ, clip[2] * inverseW );
+	}
+
+	if( behind )
+	{
+		return behind < 8;
+	}
+
+	if( maxX < 0.0f || maxY < 0.0f || minX >= (float)m_width || minY >= (float)m_height )
+	{
+		return false;
+	}
+
+	int x0 = std::max( 0, (int)std::floor( minX ) );
+	int y0 = std::max( 0, (int)std::floor( minY ) );
+	int x1 = std::min( (int)m_width - 1, (int)std::floor( maxX ) );
+	int y1 = std::min( (int)m_height - 1, (int)std::floor( maxY ) );
+
+	// The finest level where the rectangle covers at most 2x2 texels.
+	size_t level = 0;
+	while( level + 1 < m_levels.size() && ( ( x1 >> level ) - ( x0 >> level ) > 1 || ( y1 >> level ) - ( y0 >> level ) > 1 ) )
+	{
+		++level;
+	}
+
+	const std::vector< float > & depth = m_levels[level];
+	const unsigned int width = m_levelWidths[level];
+	for( int y = y0 >> level; y <= ( y1 >> level ); ++y )
+	{
+		for( int x = x0 >> level; x <= ( x1 >> level ); ++x )
+		{
+			if( minZ <= depth[y * width + x] )
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+unsigned int OcclusionBuffer::GetWidth() const
+{
+	return m_width;
+}
+
+unsigned int OcclusionBuffer::GetHeight() const
+{
+	return m_height;
+}
+
+size_t OcclusionBuffer::GetTriangleCount() const
+{
+	return m_triangles.size();
+}
+
+const float * OcclusionBuffer::GetDepth() const
+{
+	return m_levels[0].data();
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <unify/V3.h>
+#include <unify/BBox.h>
+#include <unify/Matrix.h>
+#include <unify/Size3.h>
+#include <cstdint>
+#include <vector>
+
+namespace shapes
+{
+	/// <summary>
+	/// A few triangles standing in for a large shape when it hides others. An occluder must lie inside the shape
+	/// it stands for, or it would hide what the shape does not.
+	/// </summary>
+	struct OccluderMesh
+	{
+		static OccluderMesh MakeBox( const unify::V3< float > & inf, const unify::V3< float > & sup );
+
+		/// <summary>
+		/// A rectangle in xz, centered on center.
+		/// </summary>
+		static OccluderMesh MakePlane( const unify::V3< float > & center, const unify::Size< float > & size );
+
+		/// <summary>
+		/// A prism of segments sides, 3 to 32767, spanning -height/2 to height/2, whose edges are chords inside the cylinder.
+		/// </summary>
+		static OccluderMesh MakeCylinder( const unify::V3< float > & center, float radius, float height, unsigned int segments, bool caps );
+
+		std::vector< unify::V3< float > > positions;
+		std::vector< uint16_t > indices;
+	};
+
+	/// <summary>
+	/// A low resolution depth buffer rasterized on the CPU from occluders, to test whether bounding boxes behind
+	/// them could be seen, without a GPU. Occluders are transformed, clipped and set up as they are added;
+	/// Rasterize then bins their triangles into tiles and fills the tiles on several threads, four pixels at a
+	/// time, and builds a hierarchy of the farthest depth of each 2x2 block for IsVisible.
+	/// Depth is z / w, 0 near to 1 far, and positions are row vectors, clip = position * viewProjection.
+	/// </summary>
+	class OcclusionBuffer
+	{
+	public:
+		static const unsigned int TileSize = 32;
+
+		/// <summary>
+		/// The size is rounded up to whole tiles.
+		/// </summary>
+		OcclusionBuffer( unsigned int width = 256, unsigned int height = 128 );
+
+		void SetViewProjection( const unify::Matrix & viewProjection );
+
+		/// <summary>
+		/// Removes every occluder and clears the depth to far.
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Adds an occluder, in the space the view projection takes.
+		/// </summary>
+		void AddOccluder( const OccluderMesh & occluder );
+
+		/// <summary>
+		/// Rasterizes the occluders added since the last Clear. threads of 0 uses the hardware's, up to 8.
+		/// </summary>
+		void Rasterize( unsigned int threads = 0 );
+
+		/// <summary>
+		/// False only when every pixel the bounds could cover is already nearer than the bounds' nearest point.
+		/// Bounds crossing the near plane are always visible; bounds entirely behind it or off screen never are.
+		/// </summary>
+		bool IsVisible( const unify::BBox< float > & bounds ) const;
+
+		unsigned int GetWidth() const;
+		unsigned int GetHeight() const;
+		size_t GetTriangleCount() const;
+
+		/// <summary>
+		/// The rasterized depth, a row at a time.
+		/// </summary>
+		const float * GetDepth() const;
+
+	private:
+		// A screen space triangle: three edge functions, A x + B y + C, that are positive inside, and its depth plane.
+		struct Triangle
+		{
+			float edgeA[3];
+			float edgeB[3];
+			float edgeC[3];
+			float depthA;
+			float depthB;
+			float depthC;
+			int minX, minY, maxX, maxY;
+		};
+
+		void AddTriangle( const float * a, const float * b, const float * c );
+		void RasterizeTile( unsigned int tile, const std::vector< uint32_t > & triangles );
+		void BuildHierarchy();
+
+		unsigned int m_width;
+		unsigned int m_height;
+		unsigned int m_tilesX;
+		unsigned int m_tilesY;
+		float m_viewProjection[4][4];
+		std::vector< Triangle > m_triangles;
+
+		// m_levels[0] is the depth buffer; each level after holds the farthest depth of 2x2 texels of the one before.
+		std::vector< std::vector< float > > m_levels;
+		std::vector< unsigned int > m_levelWidths;
+		std::vector< unsigned int > m_levelHeights;
+	};
+}
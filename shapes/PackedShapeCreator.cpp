@@ -0,0 +1,34 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/PackedShapeCreator.h>
+#include <me/exception/FailedToCreate.h>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+PackedShapeCreator::PackedShapeCreator( ShapePack::ptr pack, me::sculpter::IShapeCreator::ptr creator )
+	: m_pack{ pack }
+	, m_creator{ std::move( creator ) }
+{
+}
+
+PackedShapeCreator::~PackedShapeCreator()
+{
+}
+
+void PackedShapeCreator::Create( PrimitiveList & primitiveList, const unify::Parameters & parameters ) const
+{
+	if( parameters.Exists( "baked" ) )
+	{
+		std::string name = parameters.Get< std::string >( "baked" );
+		Effect::ptr effect = parameters.Get< Effect::ptr >( "effect" );
+		if( m_pack->Produce( primitiveList, name, effect ) )
+		{
+			return;
+		}
+	}
+
+	m_creator->Create( primitiveList, parameters );
+}
@@ -0,0 +1,26 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <me/sculpter/IShapeCreator.h>
+#include <shapes/ShapePack.h>
+
+namespace shapes
+{
+	/// <summary>
+	/// Serves requests carrying a "baked" name from a shape pack, falling back to the wrapped creator
+	/// when the pack does not have the shape, or has it baked for a different vertex layout.
+	/// </summary>
+	class PackedShapeCreator : public me::sculpter::IShapeCreator
+	{
+	public:
+		PackedShapeCreator( ShapePack::ptr pack, me::sculpter::IShapeCreator::ptr creator );
+		~PackedShapeCreator() override;
+
+		void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+
+	private:
+		ShapePack::ptr m_pack;
+		me::sculpter::IShapeCreator::ptr m_creator;
+	};
+}
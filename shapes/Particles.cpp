@@ -0,0 +1,385 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/Particles.h>
+#include <shapes/ShapeKernels.h>
+#include <me/render/VertexUtil.h>
+#include <me/exception/FailedToCreate.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cmath>
+#include <cstring>
+
+#if defined( SHAPES_KERNELS_SSE2 )
+#include <emmintrin.h>
+#elif defined( SHAPES_KERNELS_NEON )
+#include <arm_neon.h>
+#endif
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+namespace
+{
+	// One update's constants: velocity = ( velocity + acceleration * elapsed ) * damping, then position +=
+	// velocity * elapsed. A particle whose age reaches lifetime goes back to its start.
+	struct Step
+	{
+		float elapsed;
+		float lifetime;
+		float damping;
+		float ax, ay, az;
+	};
+
+	struct State
+	{
+		float * x;
+		float * y;
+		float * z;
+		float * vx;
+		float * vy;
+		float * vz;
+		float * age;
+		const float * startX;
+		const float * startY;
+		const float * startZ;
+		const float * startVX;
+		const float * startVY;
+		const float * startVZ;
+	};
+
+	void Advance( const State & s, size_t first, size_t last, const Step & step )
+	{
+		size_t i = first;
+
+#if defined( SHAPES_KERNELS_SSE2 )
+		const __m128 elapsed = _mm_set1_ps( step.elapsed );
+		const __m128 lifetime = _mm_set1_ps( step.lifetime );
+		const __m128 damping = _mm_set1_ps( step.damping );
+		const __m128 dvx = _mm_set1_ps( step.ax * step.elapsed );
+		const __m128 dvy = _mm_set1_ps( step.ay * step.elapsed );
+		const __m128 dvz = _mm_set1_ps( step.az * step.elapsed );
+		for( ; i + 4 <= last; i += 4 )
+		{
+			__m128 vx = _mm_mul_ps( _mm_add_ps( _mm_loadu_ps( s.vx + i ), dvx ), damping );
+			__m128 vy = _mm_mul_ps( _mm_add_ps( _mm_loadu_ps( s.vy + i ), dvy ), damping );
+			__m128 vz = _mm_mul_ps( _mm_add_ps( _mm_loadu_ps( s.vz + i ), dvz ), damping );
+			__m128 x = _mm_add_ps( _mm_loadu_ps( s.x + i ), _mm_mul_ps( vx, elapsed ) );
+			__m128 y = _mm_add_ps( _mm_loadu_ps( s.y + i ), _mm_mul_ps( vy, elapsed ) );
+			__m128 z = _mm_add_ps( _mm_loadu_ps( s.z + i ), _mm_mul_ps( vz, elapsed ) );
+			__m128 age = _mm_add_ps( _mm_loadu_ps( s.age + i ), elapsed );
+
+			__m128 expired = _mm_cmpge_ps( age, lifetime );
+			if( _mm_movemask_ps( expired ) )
+			{
+				age = _mm_sub_ps( age, _mm_and_ps( expired, lifetime ) );
+				x = _mm_or_ps( _mm_and_ps( expired, _mm_loadu_ps( s.startX + i ) ), _mm_andnot_ps( expired, x ) );
+				y = _mm_or_ps( _mm_and_ps( expired, _mm_loadu_ps( s.startY + i ) ), _mm_andnot_ps( expired, y ) );
+				z = _mm_or_ps( _mm_and_ps( expired, _mm_loadu_ps( s.startZ + i ) ), _mm_andnot_ps( expired, z ) );
+				vx = _mm_or_ps( _mm_and_ps( expired, _mm_loadu_ps( s.startVX + i ) ), _mm_andnot_ps( expired, vx ) );
+				vy = _mm_or_ps( _mm_and_ps( expired, _mm_loadu_ps( s.startVY + i ) ), _mm_andnot_ps( expired, vy ) );
+				vz = _mm_or_ps( _mm_and_ps( expired, _mm_loadu_ps( s.startVZ + i ) ), _mm_andnot_ps( expired, vz ) );
+			}
+
+			_mm_storeu_ps( s.x + i, x );
+			_mm_storeu_ps( s.y + i, y );
+			_mm_storeu_ps( s.z + i, z );
+			_mm_storeu_ps( s.vx + i, vx );
+			_mm_storeu_ps( s.vy + i, vy );
+			_mm_storeu_ps( s.vz + i, vz );
+			_mm_storeu_ps( s.age + i, age );
+		}
+#elif defined( SHAPES_KERNELS_NEON )
+		const float32x4_t elapsed = vdupq_n_f32( step.elapsed );
+		const float32x4_t lifetime = vdupq_n_f32( step.lifetime );
+		const float32x4_t damping = vdupq_n_f32( step.damping );
+		const float32x4_t dvx = vdupq_n_f32( step.ax * step.elapsed );
+		const float32x4_t dvy = vdupq_n_f32( step.ay * step.elapsed );
+		const float32x4_t dvz = vdupq_n_f32( step.az * step.elapsed );
+		for( ; i + 4 <= last; i += 4 )
+		{
+			float32x4_t vx = vmulq_f32( vaddq_f32( vld1q_f32( s.vx + i ), dvx ), damping );
+			float32x4_t vy = vmulq_f32( vaddq_f32( vld1q_f32( s.vy + i ), dvy ), damping );
+			float32x4_t vz = vmulq_f32( vaddq_f32( vld1q_f32( s.vz + i ), dvz ), damping );
+			float32x4_t x = vmlaq_f32( vld1q_f32( s.x + i ), vx, elapsed );
+			float32x4_t y = vmlaq_f32( vld1q_f32( s.y + i ), vy, elapsed );
+			float32x4_t z = vmlaq_f32( vld1q_f32( s.z + i ), vz, elapsed );
+			float32x4_t age = vaddq_f32( vld1q_f32( s.age + i ), elapsed );
+
+			uint32x4_t expired = vcgeq_f32( age, lifetime );
+			age = vbslq_f32( expired, vsubq_f32( age, lifetime ), age );
+			vst1q_f32( s.x + i, vbslq_f32( expired, vld1q_f32( s.startX + i ), x ) );
+			vst1q_f32( s.y + i, vbslq_f32( expired, vld1q_f32( s.startY + i ), y ) );
+			vst1q_f32( s.z + i, vbslq_f32( expired, vld1q_f32( s.startZ + i ), z ) );
+			vst1q_f32( s.vx + i, vbslq_f32( expired, vld1q_f32( s.startVX + i ), vx ) );
+			vst1q_f32( s.vy + i, vbslq_f32( expired, vld1q_f32( s.startVY + i ), vy ) );
+			vst1q_f32( s.vz + i, vbslq_f32( expired, vld1q_f32( s.startVZ + i ), vz ) );
+			vst1q_f32( s.age + i, age );
+		}
+#endif
+
+		for( ; i < last; ++i )
+		{
+			float vx = ( s.vx[i] + step.ax * step.elapsed ) * step.damping;
+			float vy = ( s.vy[i] + step.ay * step.elapsed ) * step.damping;
+			float vz = ( s.vz[i] + step.az * step.elapsed ) * step.damping;
+			float x = s.x[i] + vx * step.elapsed;
+			float y = s.y[i] + vy * step.elapsed;
+			float z = s.z[i] + vz * step.elapsed;
+			float age = s.age[i] + step.elapsed;
+			if( age >= step.lifetime )
+			{
+				age -= step.lifetime;
+				x = s.startX[i];
+				y = s.startY[i];
+				z = s.startZ[i];
+				vx = s.startVX[i];
+				vy = s.startVY[i];
+				vz = s.startVZ[i];
+			}
+			s.x[i] = x;
+			s.y[i] = y;
+			s.z[i] = z;
+			s.vx[i] = vx;
+			s.vy[i] = vy;
+			s.vz[i] = vz;
+			s.age[i] = age;
+		}
+	}
+}
+
+ParticleDesc::ParticleDesc()
+	: speed{ 1.0f }
+	, lifetime{ 1.0f }
+	, acceleration{ 0, 0, 0 }
+	, drag{ 0.0f }
+	, maxElapsed{ 0.1f }
+{
+}
+
+ParticleDesc::ParticleDesc( const unify::Parameters & parameters )
+	: speed{ parameters.Get( "speed", 1.0f ) }
+	, lifetime{ parameters.Get( "lifetime", 1.0f ) }
+	, acceleration{ parameters.Get( "acceleration", unify::V3< float >( 0, 0, 0 ) ) }
+	, drag{ parameters.Get( "drag", 0.0f ) }
+	, maxElapsed{ parameters.Get( "maxelapsed", 0.1f ) }
+{
+}
+
+ParticleSystem::ParticleSystem( const ParticleDesc & desc, const std::vector< unify::V3< float > > & positions, const std::vector< unify::V3< float > > & directions )
+	: m_desc{ desc }
+	, m_count{ positions.size() }
+	, m_set{ nullptr }
+	, m_frame{ 0 }
+{
+	if( directions.size() != positions.size() )
+	{
+		throw me::exception::FailedToCreate( "ParticleSystem needs a direction for every position!" );
+	}
+	if( desc.lifetime <= 0.0f )
+	{
+		throw me::exception::FailedToCreate( "ParticleSystem lifetime must be more than zero!" );
+	}
+	if( desc.maxElapsed <= 0.0f )
+	{
+		throw me::exception::FailedToCreate( "ParticleSystem maxElapsed must be more than zero!" );
+	}
+	// The bounds assume drag only slows particles; a negative drag would speed them up without limit.
+	if( !( desc.drag >= 0.0f ) )
+	{
+		throw me::exception::FailedToCreate( "ParticleSystem drag must not be negative!" );
+	}
+
+	for( auto * component : { &m_x, &m_y, &m_z, &m_vx, &m_vy, &m_vz, &m_age, &m_startX, &m_startY, &m_startZ, &m_startVX, &m_startVY, &m_startVZ } )
+	{
+		component->resize( m_count );
+	}
+
+	for( size_t i = 0; i < m_count; ++i )
+	{
+		m_x[i] = m_startX[i] = positions[i].x;
+		m_y[i] = m_startY[i] = positions[i].y;
+		m_z[i] = m_startZ[i] = positions[i].z;
+		m_vx[i] = m_startVX[i] = directions[i].x * desc.speed;
+		m_vy[i] = m_startVY[i] = directions[i].y * desc.speed;
+		m_vz[i] = m_startVZ[i] = directions[i].z * desc.speed;
+		m_age[i] = desc.lifetime * ( (float)i / (float)m_count );
+	}
+}
+
+void ParticleSystem::CreateBuffers( IRenderer * renderer, PrimitiveList & primitiveList, Effect::ptr effect, const unify::Color & diffuse, unsigned int frames )
+{
+	using namespace unify;
+
+	m_vertexDeclaration = effect->GetVertexShader()->GetVertexDeclaration();
+	const VertexDeclaration & vd = *m_vertexDeclaration;
+	const size_t stride = vd.GetSizeInBytes( 0 );
+
+	m_vertices.assign( stride * m_count, 0 );
+	DataLock lock( m_vertices.data(), stride, m_count, DataLockAccess::ReadWrite, 0 );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( 0 );
+	VertexElement specularE = CommonVertexElement::Specular( 0 );
+	for( size_t i = 0; i < m_count; ++i )
+	{
+		WriteVertex( vd, lock, i, diffuseE, diffuse );
+		WriteVertex( vd, lock, i, specularE, ColorWhite() );
+	}
+	Stream( lock, 0, m_count );
+
+	// Drag only slows a particle, so none gets further from its start than speed and acceleration take it,
+	// plus the most stepping at maxElapsed overshoots by.
+	VertexBufferParameters vbParameters{ m_vertexDeclaration, { { m_count, m_vertices.data() } }, BufferUsage::Dynamic };
+	std::vector< V3< float > > starts( m_count );
+	for( size_t i = 0; i < m_count; ++i )
+	{
+		starts[i] = V3< float >( m_startX[i], m_startY[i], m_startZ[i] );
+	}
+	kernels::Bounds( starts.data(), m_count, vbParameters.bbox );
+	float accelerationLength = sqrtf( m_desc.acceleration.x * m_desc.acceleration.x + m_desc.acceleration.y * m_desc.acceleration.y + m_desc.acceleration.z * m_desc.acceleration.z );
+	float reach = fabsf( m_desc.speed ) * m_desc.lifetime + 0.5f * accelerationLength * m_desc.lifetime * ( m_desc.lifetime + m_desc.maxElapsed );
+	if( m_count )
+	{
+		vbParameters.bbox.sup += V3< float >( reach, reach, reach );
+		vbParameters.bbox.inf -= V3< float >( reach, reach, reach );
+	}
+
+	m_vertexBuffers.clear();
+	for( unsigned int frame = 0; frame < std::max( frames, 1u ); ++frame )
+	{
+		m_vertexBuffers.push_back( renderer->ProduceVB( vbParameters ) );
+	}
+	m_frame = 0;
+
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
+	set.AddVertexBuffer( m_vertexBuffers[0] );
+	set.AddMethod( RenderMethod::CreatePointList( 0, (unsigned int)m_count ) );
+	m_set = &set;
+}
+
+void ParticleSystem::Update( float elapsed, unsigned int threads )
+{
+	const unsigned int steps = std::max( 1u, (unsigned int)ceilf( std::max( 0.0f, elapsed ) / m_desc.maxElapsed ) );
+	elapsed /= steps;
+
+	Step step;
+	step.elapsed = elapsed;
+	step.lifetime = m_desc.lifetime;
+	step.damping = std::max( 0.0f, 1.0f - m_desc.drag * elapsed );
+	step.ax = m_desc.acceleration.x;
+	step.ay = m_desc.acceleration.y;
+	step.az = m_desc.acceleration.z;
+
+	State state{ m_x.data(), m_y.data(), m_z.data(), m_vx.data(), m_vy.data(), m_vz.data(), m_age.data(),
+		m_startX.data(), m_startY.data(), m_startZ.data(), m_startVX.data(), m_startVY.data(), m_startVZ.data() };
+
+	IVertexBuffer * buffer = nullptr;
+	unify::DataLock lock;
+	if( !m_vertexBuffers.empty() )
+	{
+		m_frame = ( m_frame + 1 ) % (unsigned int)m_vertexBuffers.size();
+		buffer = m_vertexBuffers[m_frame].get();
+		buffer->Lock( 0, lock );
+	}
+
+	const size_t chunkCount = ( m_count + ChunkSize - 1 ) / ChunkSize;
+	if( threads == 0 )
+	{
+		threads = std::max( 1u, std::min( 8u, std::thread::hardware_concurrency() ) );
+	}
+	threads = (unsigned int)std::max< size_t >( 1, std::min< size_t >( threads, chunkCount ) );
+
+	// Each chunk is streamed while it is still in cache, by the thread that advanced it.
+	std::atomic< size_t > nextChunk{ 0 };
+	auto work = [&]()
+	{
+		for( size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++ )
+		{
+			size_t first = chunk * ChunkSize;
+			size_t last = std::min( first + ChunkSize, m_count );
+			for( unsigned int s = 0; s < steps; ++s )
+			{
+				Advance( state, first, last, step );
+			}
+			if( buffer )
+			{
+				Stream( lock, first, last );
+			}
+		}
+	};
+
+	std::vector< std::thread > workers;
+	for( unsigned int t = 1; t < threads; ++t )
+	{
+		workers.push_back( std::thread( work ) );
+	}
+	work();
+	for( auto & worker : workers )
+	{
+		worker.join();
+	}
+
+	if( buffer )
+	{
+		buffer->Unlock( 0 );
+		m_set->AddVertexBuffer( m_vertexBuffers[m_frame] );
+	}
+}
+
+size_t ParticleSystem::GetCount() const
+{
+	return m_count;
+}
+
+const float * ParticleSystem::GetX() const
+{
+	return m_x.data();
+}
+
+const float * ParticleSystem::GetY() const
+{
+	return m_y.data();
+}
+
+const float * ParticleSystem::GetZ() const
+{
+	return m_z.data();
+}
+
+const float * ParticleSystem::GetAge() const
+{
+	return m_age.data();
+}
+
+unsigned int ParticleSystem::GetFrame() const
+{
+	return m_frame;
+}
+
+void ParticleSystem::Stream( unify::DataLock & lock, size_t first, size_t last ) const
+{
+	const VertexDeclaration & vd = *m_vertexDeclaration;
+	if( vd.GetSizeInBytes( 0 ) == sizeof( unify::V3< float > ) )
+	{
+		// A position only declaration, the usual for particles, is written directly.
+		float * out = (float *)lock.GetData() + first * 3;
+		for( size_t i = first; i < last; ++i )
+		{
+			*out++ = m_x[i];
+			*out++ = m_y[i];
+			*out++ = m_z[i];
+		}
+		return;
+	}
+
+	// The lock may have discarded the buffer, so whole vertices are copied from the template, then placed.
+	const size_t stride = vd.GetSizeInBytes( 0 );
+	memcpy( (unsigned char *)lock.GetData() + first * stride, m_vertices.data() + first * stride, ( last - first ) * stride );
+	VertexElement positionE = CommonVertexElement::Position( 0 );
+	for( size_t i = first; i < last; ++i )
+	{
+		WriteVertex( vd, lock, i, positionE, unify::V3< float >( m_x[i], m_y[i], m_z[i] ) );
+	}
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <me/render/IRenderer.h>
+#include <me/render/PrimitiveList.h>
+#include <me/render/BufferSet.h>
+#include <me/render/Effect.h>
+#include <unify/Parameters.h>
+#include <unify/Color.h>
+#include <unify/DataLock.h>
+#include <unify/V3.h>
+#include <vector>
+
+namespace shapes
+{
+	struct ParticleDesc
+	{
+		ParticleDesc();
+		ParticleDesc( const unify::Parameters & parameters );
+
+		// Each particle leaves its start along its direction at speed.
+		float speed;
+
+		// Seconds before a particle returns to its start. Particles begin spread evenly over their lifetime, so
+		// they do not all return at once.
+		float lifetime;
+
+		unify::V3< float > acceleration;
+
+		// The fraction of velocity lost per second, zero or more.
+		float drag;
+
+		// The longest step an update takes; a longer elapsed is taken in several steps. Each step moves a
+		// particle up to acceleration * maxElapsed * lifetime / 2 further than the exact path, which the
+		// bounds allow for.
+		float maxElapsed;
+	};
+
+	/// <summary>
+	/// Particles simulated on the CPU, starting from the points and directions of a PointField or PointRing's
+	/// Generate. The state is held as separate arrays of x, y, z, velocity and age, so an update moves four
+	/// particles at a time, and the particles are split into chunks shared among threads. Once CreateBuffers has
+	/// been called, each update also streams the positions into the next of several Dynamic vertex buffers.
+	/// </summary>
+	class ParticleSystem
+	{
+	public:
+		static const size_t ChunkSize = 16384;
+
+		ParticleSystem( const ParticleDesc & desc, const std::vector< unify::V3< float > > & positions, const std::vector< unify::V3< float > > & directions );
+
+		/// <summary>
+		/// Gives primitiveList a BufferSet drawing the particles as points with effect, from frames Dynamic vertex
+		/// buffers. The bounds cover everywhere a particle can reach within its lifetime. Elements other than
+		/// the position are kept here, and copied with every position an update writes, so every vertex is
+		/// written in full.
+		/// </summary>
+		void CreateBuffers( me::render::IRenderer * renderer, me::render::PrimitiveList & primitiveList, me::render::Effect::ptr effect, const unify::Color & diffuse, unsigned int frames = 3 );
+
+		/// <summary>
+		/// Advances every particle by elapsed seconds, in steps of at most desc.maxElapsed. threads of 0 uses the
+		/// hardware's, up to 8.
+		/// </summary>
+		void Update( float elapsed, unsigned int threads = 0 );
+
+		size_t GetCount() const;
+		const float * GetX() const;
+		const float * GetY() const;
+		const float * GetZ() const;
+		const float * GetAge() const;
+
+		/// <summary>
+		/// The vertex buffer drawn from, 0 to the frames given to CreateBuffers - 1.
+		/// </summary>
+		unsigned int GetFrame() const;
+
+	private:
+		void Stream( unify::DataLock & lock, size_t first, size_t last ) const;
+
+		ParticleDesc m_desc;
+		size_t m_count;
+
+		std::vector< float > m_x, m_y, m_z;
+		std::vector< float > m_vx, m_vy, m_vz;
+		std::vector< float > m_age;
+		std::vector< float > m_startX, m_startY, m_startZ;
+		std::vector< float > m_startVX, m_startVY, m_startVZ;
+
+		std::vector< unsigned char > m_vertices;
+
+		me::render::BufferSet * m_set;
+		me::render::VertexDeclaration::ptr m_vertexDeclaration;
+		std::vector< me::render::IVertexBuffer::ptr > m_vertexBuffers;
+		unsigned int m_frame;
+	};
+}
@@ -2,6 +2,8 @@
 // All Rights Reserved
 
 #include <shapes/Plane.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapeTransform.h>
 #include <me/render/VertexUtil.h>
 #include <me/exception/NotImplemented.h>
 #include <me/exception/FailedToCreate.h>
@@ -14,7 +16,21 @@ using namespace me;
 using namespace render;
 using namespace shapes;
 
-const std::string DefaultBufferUsage = "Default";
+PlaneDesc::PlaneDesc()
+	: size{ 1.0f, 1.0f }
+	, segments{ 1 }
+	, texArea{ unify::TexCoords( 0, 0 ), unify::TexCoords( 1, 1 ) }
+{
+}
+
+PlaneDesc::PlaneDesc( const unify::Parameters & parameters )
+	: ShapeDesc( parameters )
+	, size{ parameters.Get( "size2", unify::Size< float >( 1.0f, 1.0f ) ) }
+	, segments{ parameters.Get< unsigned int >( "segments", 1 ) }
+	, texArea{ parameters.Get( "texarea", unify::TexArea( unify::TexCoords( 0, 0 ), unify::TexCoords( 1, 1 ) ) ) }
+	, meshlets{ parameters }
+{
+}
 
 Plane::Plane()
 {
@@ -26,79 +42,87 @@ Plane::~Plane()
 
 void Plane::Create(PrimitiveList & primitiveList, const unify::Parameters & parameters ) const
 {
-	using namespace unify;
-
 	try
 	{
-		Size< float > size = parameters.Get( "size2", Size< float >( 1.0f, 1.0f ) );
-		Color diffuse = parameters.Get( "diffuse", ColorWhite() );
-		Color specular = parameters.Get( "specular", ColorWhite() );
-		unsigned int segments = parameters.Get< unsigned int >( "segments", 1 );
-		V3< float > center = parameters.Get( "center", V3< float >( 0, 0, 0 ) );
-		TexArea texArea = parameters.Get( "texarea", TexArea( unify::TexCoords( 0, 0 ), TexCoords( 1, 1 ) ) );
-		Effect::ptr effect = parameters.Get< Effect::ptr >( "effect" );
-		VertexDeclaration::ptr vd = effect->GetVertexShader()->GetVertexDeclaration();
-		BufferUsage::TYPE bufferUsage = BufferUsage::FromString( parameters.Get( "bufferusage", DefaultBufferUsage ) );
-		size_t vertexCount = (segments + 1) * (segments + 1);
-		size_t indexCount = 6 * segments * segments;
-
-		BufferSet & set = primitiveList.AddBufferSet();
-		set.SetEffect( effect );
-
-		set.AddMethod( RenderMethod::CreateTriangleListIndexed( vertexCount, (unsigned int)indexCount, 0, 0 ) );
-
-		unsigned short stream = 0;
-
-		VertexElement positionE = CommonVertexElement::Position( stream );
-		VertexElement normalE = CommonVertexElement::Normal( stream );
-		VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
-		VertexElement specularE = CommonVertexElement::Specular( stream );
-		VertexElement texE = CommonVertexElement::TexCoords( stream );
-
-		struct V
-		{
-			V3< float > pos;
-			V3< float > normal;
-			Color diffuse;
-			Color specular;
-			TexCoords coords;
-		};
-		qjson::Object jsonFormat;
-		jsonFormat.Add( { "Position", "Float3" } );
-		jsonFormat.Add( { "Normal", "Float3" } );
-		jsonFormat.Add( { "Diffuse", "Color" } );
-		jsonFormat.Add( { "Specular", "Color" } );
-		jsonFormat.Add( { "TexCoord", "TexCoord" } );
-		VertexDeclaration::ptr vFormat( new VertexDeclaration( jsonFormat ) );
+		Create( primitiveList, PlaneDesc( parameters ) );
+	}
+	catch( std::exception & ex )
+	{
+		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+	}
+}
 
-		std::shared_ptr< unsigned char > vertices( new unsigned char[vd->GetSizeInBytes( 0 ) * vertexCount] );
-		DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
+void Plane::Create(PrimitiveList & primitiveList, const PlaneDesc & desc ) const
+{
+	using namespace unify;
 
-		VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
+	if( desc.canonical )
+	{
+		PlaneDesc unit = desc;
+		unit.canonical = false;
+		unit.center = V3< float >( 0, 0, 0 );
+		unit.size = Size< float >( 1.0f, 1.0f );
+		ShapeTransform::Report( V3< float >( desc.size.width, 1.0f, desc.size.height ), desc.center );
+		Create( primitiveList, unit );
+		return;
+	}
 
-		unify::V3< float > posUL = center - unify::V3< float >( size.width * 0.5f, 0, size.height * 0.5f );
-		for( unsigned int v = 0; v < (segments + 1); ++v )
+	Size< float > size = desc.size;
+	Color diffuse = desc.diffuse;
+	Color specular = desc.specular;
+	unsigned int segments = desc.segments;
+	V3< float > center = desc.center;
+	TexArea texArea = desc.texArea;
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
+	size_t vertexCount = (segments + 1) * (segments + 1);
+	size_t indexCount = 6 * segments * segments;
+
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
+
+	unsigned short stream = 0;
+
+	VertexElement positionE = CommonVertexElement::Position( stream );
+	VertexElement normalE = CommonVertexElement::Normal( stream );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+	VertexElement specularE = CommonVertexElement::Specular( stream );
+	VertexElement texE = CommonVertexElement::TexCoords( stream );
+
+	std::shared_ptr< unsigned char > vertices( new unsigned char[vd->GetSizeInBytes( 0 ) * vertexCount] );
+	DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
+
+	VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
+
+	std::vector< unify::V3< float > > positions( vertexCount );
+	unify::V3< float > posUL = center - unify::V3< float >( size.width * 0.5f, 0, size.height * 0.5f );
+	for( unsigned int v = 0; v < (segments + 1); ++v )
+	{
+		float factorY = 1.0f / float( segments ) * v;
+		for( unsigned int h = 0; h < (segments + 1); ++h )
 		{
-			float factorY = 1.0f / float( segments ) * v;
-			for( unsigned int h = 0; h < (segments + 1); ++h )
-			{
-				float factorX = 1.0f / float( segments ) * h;
-				unify::V3< float > pos = posUL + unify::V3< float >( size.width * factorX, 0, size.height * factorY );
-
-				unsigned int index = v * (segments + 1) + h;
-				WriteVertex( *vd, lock, index, positionE, pos );
-				WriteVertex( *vd, lock, index, normalE, unify::V3< float >( 0, 1, 0 ) );
-				WriteVertex( *vd, lock, index, diffuseE, diffuse );
-				WriteVertex( *vd, lock, index, specularE, specular );
-				WriteVertex( *vd, lock, index, texE, unify::TexCoords( factorX, factorY ) );
-				vbParameters.bbox += pos;
-			}
-			unify::V3< float > pos = center - unify::V3< float >( size.width * 0.5f, 0, size.height * 0.5f );
+			float factorX = 1.0f / float( segments ) * h;
+			unify::V3< float > pos = posUL + unify::V3< float >( size.width * factorX, 0, size.height * factorY );
+
+			unsigned int index = v * (segments + 1) + h;
+			positions[index] = pos;
+			WriteVertex( *vd, lock, index, positionE, pos );
+			WriteVertex( *vd, lock, index, normalE, unify::V3< float >( 0, 1, 0 ) );
+			WriteVertex( *vd, lock, index, diffuseE, diffuse );
+			WriteVertex( *vd, lock, index, specularE, specular );
+			WriteVertex( *vd, lock, index, texE, unify::TexCoords( factorX, factorY ) );
+			vbParameters.bbox += pos;
 		}
+		unify::V3< float > pos = center - unify::V3< float >( size.width * 0.5f, 0, size.height * 0.5f );
+	}
 
-		set.AddVertexBuffer( vbParameters );
+	AddVertexBuffer( set, vbParameters );
 
-		std::vector< Index32 > indices( 6 * segments * segments );
+	IndexCache::Key key{ "Plane", { segments } };
+	IndexCache::Generator generate = [&]( std::vector< Index32 > & indices )
+	{
+		indices.resize( 6 * segments * segments );
 		for( unsigned int v = 0; v < segments; ++v )
 		{
 			for( unsigned int h = 0; h < segments; ++h )
@@ -112,10 +136,36 @@ void Plane::Create(PrimitiveList & primitiveList, const unify::Parameters & para
 				indices[offset + 5] = 1 + (segments + 1) * (v + 1) + h;
 			}
 		}
+	};
 
-		set.AddIndexBuffer( { { { indexCount, &indices[0] } }, bufferUsage } );
-	} catch( std::exception & ex )
+	if( desc.meshlets.enabled )
 	{
-		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+		std::vector< unify::V3< float > > normals( vertexCount, unify::V3< float >( 0, 1, 0 ) );
+		// Meshlet order is topology too, so the reordered indices are cached alongside the plain ones.
+		key = IndexCache::Key{ "PlaneMeshlets", { segments, desc.meshlets.maxVertices, desc.meshlets.maxTriangles } };
+		generate = [plain = generate, &desc]( std::vector< Index32 > & indices )
+		{
+			plain( indices );
+			OrderForMeshlets( indices, desc.meshlets.maxVertices, desc.meshlets.maxTriangles );
+		};
+		IndexCache::Indices indices = IndexCache::Instance().GetIndices( key, generate );
+		std::vector< Meshlet > meshlets = BuildMeshlets( positions.data(), normals.data(), indices->data(), indices->size(), desc.meshlets.maxVertices, desc.meshlets.maxTriangles );
+		AddMeshletMethods( set, meshlets, (unsigned int)vertexCount );
 	}
+	else
+	{
+		AddMethod( set, RenderMethod::CreateTriangleListIndexed( vertexCount, (unsigned int)indexCount, 0, 0 ) );
+	}
+
+	AddSharedIndexBuffer( set, key, bufferUsage, generate );
+}
+
+IShapeQuery::ptr Plane::CreateQuery( const PlaneDesc & desc ) const
+{
+	return IShapeQuery::ptr( new PlaneQuery( desc.center, desc.size ) );
+}
+
+OccluderMesh Plane::CreateOccluder( const PlaneDesc & desc ) const
+{
+	return OccluderMesh::MakePlane( desc.center, desc.size );
 }
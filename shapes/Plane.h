@@ -3,9 +3,28 @@
 #pragma once
 
 #include <me/sculpter/IShapeCreator.h>
+#include <shapes/ShapeDesc.h>
+#include <shapes/ShapeQuery.h>
+#include <shapes/Occlusion.h>
+#include <shapes/Meshlets.h>
+#include <unify/Size3.h>
+#include <unify/TexArea.h>
 
 namespace shapes
 {
+	struct PlaneDesc : public ShapeDesc
+	{
+		PlaneDesc();
+		PlaneDesc( const unify::Parameters & parameters );
+
+		unify::Size< float > size;
+		unsigned int segments;
+		unify::TexArea texArea;
+
+		// Draw as meshlets, one method each, with their bounds and cones in the current MeshletTable.
+		MeshletOptions meshlets;
+	};
+
 	class Plane : public me::sculpter::IShapeCreator
 	{
 	public:
@@ -13,5 +32,16 @@ namespace shapes
 		~Plane() override;
 
 		void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+		void Create( me::render::PrimitiveList & primitiveList, const PlaneDesc & desc ) const;
+
+		/// <summary>
+		/// The exact shape desc describes, for picking and containment without its triangles.
+		/// </summary>
+		IShapeQuery::ptr CreateQuery( const PlaneDesc & desc ) const;
+
+		/// <summary>
+		/// A low detail stand in for occlusion culling, inside the shape desc describes.
+		/// </summary>
+		OccluderMesh CreateOccluder( const PlaneDesc & desc ) const;
 	};
 }
@@ -0,0 +1,66 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/PointChunks.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapeKernels.h>
+#include <shapes/Morton.h>
+#include <me/render/VertexUtil.h>
+#include <me/exception/FailedToCreate.h>
+#include <algorithm>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+void shapes::CreatePointChunks( PrimitiveList & primitiveList, const ShapeDesc & desc,
+	const std::vector< unify::V3< float > > & positions, const std::vector< unify::V3< float > > & normals, unsigned int chunkSize )
+{
+	using namespace unify;
+
+	if( chunkSize == 0 )
+	{
+		throw me::exception::FailedToCreate( "Point chunk size must be more than zero!" );
+	}
+
+	const size_t count = positions.size();
+
+	BBox< float > bounds;
+	kernels::Bounds( positions.data(), count, bounds );
+	std::vector< uint32_t > order = morton::Order( positions.data(), count, bounds );
+
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	const size_t stride = vd->GetSizeInBytes( 0 );
+
+	unsigned short stream = 0;
+	VertexElement positionE = CommonVertexElement::Position( stream );
+	VertexElement normalE = CommonVertexElement::Normal( stream );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+	VertexElement specularE = CommonVertexElement::Specular( stream );
+
+	std::vector< unsigned char > vertices( stride * std::min< size_t >( count, chunkSize ) );
+	for( size_t start = 0; start < count; start += chunkSize )
+	{
+		const unsigned int chunkCount = (unsigned int)std::min< size_t >( chunkSize, count - start );
+
+		BufferSet & set = primitiveList.AddBufferSet();
+		set.SetEffect( effect );
+		AddMethod( set, RenderMethod::CreatePointList( 0, chunkCount ) );
+
+		DataLock lock( vertices.data(), (unsigned int)stride, chunkCount, DataLockAccess::ReadWrite, 0 );
+		VertexBufferParameters vbParameters{ vd, { { chunkCount, vertices.data() } }, desc.bufferUsage };
+
+		for( unsigned int v = 0; v < chunkCount; ++v )
+		{
+			const uint32_t point = order[start + v];
+			WriteVertex( *vd, lock, v, positionE, positions[point] );
+			WriteVertex( *vd, lock, v, normalE, normals[point] );
+			WriteVertex( *vd, lock, v, diffuseE, desc.diffuse );
+			WriteVertex( *vd, lock, v, specularE, desc.specular );
+			vbParameters.bbox += positions[point];
+		}
+
+		AddBoundedVertexBuffer( set, vbParameters );
+	}
+}
@@ -0,0 +1,20 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <shapes/ShapeDesc.h>
+#include <me/render/PrimitiveList.h>
+#include <unify/V3.h>
+#include <vector>
+
+namespace shapes
+{
+	/// <summary>
+	/// Writes a point cloud sorted in Morton order and split into chunks of chunkSize points. Each chunk is its
+	/// own BufferSet, with its own point list and bounds, so chunks outside the frustum, or hidden, can be skipped.
+	/// The bounds stay per chunk with a BufferPool current, so chunks are not pooled.
+	/// Points near each other in space end up near each other in the buffer, which also helps vertex fetch.
+	/// </summary>
+	void CreatePointChunks( me::render::PrimitiveList & primitiveList, const ShapeDesc & desc,
+		const std::vector< unify::V3< float > > & positions, const std::vector< unify::V3< float > > & normals, unsigned int chunkSize );
+}
@@ -2,6 +2,11 @@
 // All Rights Reserved
 
 #include <shapes/PointField.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapeTransform.h>
+#include <shapes/ShapeKernels.h>
+#include <shapes/Progressive.h>
+#include <shapes/PointChunks.h>
 #include <me/render/VertexUtil.h>
 #include <me/exception/NotImplemented.h>
 #include <me/exception/FailedToCreate.h>
@@ -16,7 +21,27 @@ using namespace shapes;
 
 const float PI = 3.14159265358979f;
 const float PI2 = 6.28318530717959f;
-const std::string DefaultBufferUsage = "Default";
+
+PointFieldDesc::PointFieldDesc()
+	: majorRadius{ 1.0f }
+	, minorRadius{ 0.0f }
+	, count{ 100 }
+	, progressive{ false }
+	, morton{ false }
+	, chunkSize{ 4096 }
+{
+}
+
+PointFieldDesc::PointFieldDesc( const unify::Parameters & parameters )
+	: ShapeDesc( parameters )
+	, majorRadius{ parameters.Get( "majorradius", 1.0f ) }
+	, minorRadius{ parameters.Get( "minorradius", 0.0f ) }
+	, count{ (unsigned int)parameters.Get( "count", 100 ) }
+	, progressive{ parameters.Get( "progressive", false ) }
+	, morton{ parameters.Get( "morton", false ) }
+	, chunkSize{ parameters.Get< unsigned int >( "chunksize", 4096 ) }
+{
+}
 
 PointField::PointField()
 {
@@ -27,86 +52,140 @@ PointField::~PointField()
 }
 
 void PointField::Create(PrimitiveList & primitiveList, const unify::Parameters & parameters ) const
+{
+	try
+	{
+		Create( primitiveList, PointFieldDesc( parameters ) );
+	}
+	catch( std::exception & ex )
+	{
+		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+	}
+}
+
+void PointField::Create(PrimitiveList & primitiveList, const PointFieldDesc & desc ) const
 {
 	using namespace unify;
 
-	try
+	if( desc.canonical )
 	{
-		float majorRadius = parameters.Get( "majorradius", 1.0f );
-		float minorRadius = parameters.Get( "minorradius", 0.0f );
-		unsigned int count = parameters.Get( "count", 100 );
-		Color diffuse = parameters.Get( "diffuse", unify::ColorWhite() );
-		Color specular = parameters.Get( "specular", unify::ColorWhite() );
-		V3< float > center = parameters.Get( "center", unify::V3< float >( 0, 0, 0 ) );
-		Effect::ptr effect = parameters.Get< Effect::ptr >( "effect" );
-		VertexDeclaration::ptr vd = effect->GetVertexShader()->GetVertexDeclaration();
-		BufferUsage::TYPE bufferUsage = BufferUsage::FromString( parameters.Get( "bufferusage", DefaultBufferUsage ) );
-
-		BufferSet & set = primitiveList.AddBufferSet();
-		set.SetEffect( effect );
-
-		// Method 1 - Triangle List...
-		set.AddMethod( RenderMethod::CreatePointList( 0, count ) );
-
-		// Randomize the vertices positions...
-		unify::V3< float > vec, norm;
-
-		unsigned short stream = 0;
-		VertexElement positionE = CommonVertexElement::Position( stream );
-		VertexElement normalE = CommonVertexElement::Normal( stream );
-		VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
-		VertexElement specularE = CommonVertexElement::Specular( stream );
-		VertexElement texE = CommonVertexElement::TexCoords( stream );
-
-		struct V
+		// The unit shape is the real one divided by its outer radius.
+		if( !( desc.majorRadius > 0.0f ) )
 		{
-			V3< float > pos;
-			V3< float > normal;
-			Color diffuse;
-			Color specular;
-			TexCoords coords;
-		};
-		qjson::Object jsonFormat;
-		jsonFormat.Add( { "Position", "Float3" } );
-		jsonFormat.Add( { "Normal", "Float3" } );
-		jsonFormat.Add( { "Diffuse", "Color" } );
-		jsonFormat.Add( { "Specular", "Color" } );
-		jsonFormat.Add( { "TexCoord", "TexCoord" } );
-		VertexDeclaration::ptr vFormat( new VertexDeclaration( jsonFormat ) );
-
-		char * vertices = new char[vd->GetSizeInBytes( 0 ) * count];
-		DataLock lock( vertices, vd->GetSizeInBytes( 0 ), count, DataLockAccess::ReadWrite, 0 );
-		VertexBufferParameters vbParameters{ vd, { { count, vertices } }, bufferUsage };
-
-		float distance;
-		unsigned int v;
-		for( v = 0; v < count; v++ )
+			throw me::exception::FailedToCreate( "Canonical PointField needs a positive majorradius!" );
+		}
+
+		PointFieldDesc unit = desc;
+		unit.canonical = false;
+		unit.center = V3< float >( 0, 0, 0 );
+		unit.majorRadius = 1.0f;
+		unit.minorRadius = desc.minorRadius / desc.majorRadius;
+		ShapeTransform::Report( V3< float >( desc.majorRadius, desc.majorRadius, desc.majorRadius ), desc.center );
+		Create( primitiveList, unit );
+		return;
+	}
+
+	if( desc.morton && desc.progressive )
+	{
+		// Sorting would scatter the Halton sequence, so no prefix would be an even subsample any more.
+		throw me::exception::FailedToCreate( "PointField \"morton\" and \"progressive\" cannot be combined!" );
+	}
+
+	unsigned int count = desc.count;
+	Color diffuse = desc.diffuse;
+	Color specular = desc.specular;
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
+
+	unsigned short stream = 0;
+	VertexElement positionE = CommonVertexElement::Position( stream );
+	VertexElement normalE = CommonVertexElement::Normal( stream );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+	VertexElement specularE = CommonVertexElement::Specular( stream );
+	VertexElement texE = CommonVertexElement::TexCoords( stream );
+
+	std::vector< V3< float > > positions;
+	std::vector< V3< float > > normals;
+	Generate( desc, positions, normals );
+
+	if( desc.morton )
+	{
+		CreatePointChunks( primitiveList, desc, positions, normals, desc.chunkSize );
+		return;
+	}
+
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
+
+	// Method 1 - Triangle List...
+	AddMethod( set, RenderMethod::CreatePointList( 0, count ) );
+
+	char * vertices = new char[vd->GetSizeInBytes( 0 ) * count];
+	DataLock lock( vertices, vd->GetSizeInBytes( 0 ), count, DataLockAccess::ReadWrite, 0 );
+	VertexBufferParameters vbParameters{ vd, { { count, vertices } }, bufferUsage };
+	kernels::Bounds( positions.data(), count, vbParameters.bbox );
+
+	for( unsigned int v = 0; v < count; v++ )
+	{
+		WriteVertex( *vd, lock, v, positionE, positions[v] );
+		WriteVertex( *vd, lock, v, normalE, normals[v] );
+		WriteVertex( *vd, lock, v, diffuseE, diffuse );
+		WriteVertex( *vd, lock, v, specularE, specular );
+	}
+
+	AddVertexBuffer( set, vbParameters );
+
+	delete[] vertices;
+}
+
+void PointField::Generate( const PointFieldDesc & desc, std::vector< unify::V3< float > > & positions, std::vector< unify::V3< float > > & normals )
+{
+	using namespace unify;
+
+	float majorRadius = desc.majorRadius;
+	float minorRadius = desc.minorRadius;
+	unsigned int count = desc.count;
+	V3< float > center = desc.center;
+	V3< float > norm;
+
+	// Draw the random directions and distances first, in the same order as before, then normalize, place and
+	// bound every point in bulk.
+	normals.resize( count );
+	positions.resize( count );
+	std::vector< float > distances( count );
+	if( desc.progressive )
+	{
+		// Directions even over the sphere and distances even over the radii. The shifts are the only rand() use.
+		const float shift[3] = { (float)(rand() % 10000) * 0.0001f, (float)(rand() % 10000) * 0.0001f, (float)(rand() % 10000) * 0.0001f };
+		for( unsigned int v = 0; v < count; v++ )
+		{
+			float y = progressive::Halton( v + 1, 2, shift[0] ) * 2.0f - 1.0f;
+			float rad = progressive::Halton( v + 1, 3, shift[1] ) * PI2;
+			float r = sqrtf( 1.0f - y * y );
+			normals[v] = V3< float >( cosf( rad ) * r, y, sinf( rad ) * r );
+			distances[v] = minorRadius + progressive::Halton( v + 1, 5, shift[2] ) * (majorRadius - minorRadius);
+		}
+	}
+	else
+	{
+		for( unsigned int v = 0; v < count; v++ )
 		{
 			// Direction...
 			norm.x = (float)(rand() % 10000) * 0.0001f * 2.0f + -1.0f;
 			norm.y = (float)(rand() % 10000) * 0.0001f * 2.0f + -1.0f;
 			norm.z = (float)(rand() % 10000) * 0.0001f * 2.0f + -1.0f;
-			norm.Normalize();
+			normals[v] = norm;
 
 			// Distance...
-			distance = minorRadius + ((float)(rand() % 10000) * 0.0001f * (majorRadius - minorRadius));
-			vec = norm * distance;
-
-			vec += center;
-
-			WriteVertex( *vd, lock, v, positionE, vec );
-			WriteVertex( *vd, lock, v, normalE, norm );
-			WriteVertex( *vd, lock, v, diffuseE, diffuse );
-			WriteVertex( *vd, lock, v, specularE, specular );
-
-			vbParameters.bbox += vec;
+			distances[v] = minorRadius + ((float)(rand() % 10000) * 0.0001f * (majorRadius - minorRadius));
 		}
+	}
 
-		set.AddVertexBuffer( vbParameters );
-
-		delete[] vertices;
-	} catch( std::exception & ex )
+	kernels::Normalize( normals.data(), normals.data(), count );
+	for( unsigned int v = 0; v < count; v++ )
 	{
-		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+		positions[v] = normals[v] * distances[v];
 	}
+	kernels::Transform( kernels::Affine::Translation( center ), positions.data(), positions.data(), count );
 }
@@ -3,9 +3,29 @@
 #pragma once
 
 #include <me/sculpter/IShapeCreator.h>
+#include <shapes/ShapeDesc.h>
+#include <vector>
 
 namespace shapes
 {
+	struct PointFieldDesc : public ShapeDesc
+	{
+		PointFieldDesc();
+		PointFieldDesc( const unify::Parameters & parameters );
+
+		float majorRadius;
+		float minorRadius;
+		unsigned int count;
+
+		// Points follow a Halton sequence instead of rand(), so any prefix is an even subsample of the field.
+		bool progressive;
+
+		// Points are sorted in Morton order and split into BufferSets of chunkSize points, each with its own
+		// bounds. Cannot be combined with progressive, whose order it would undo.
+		bool morton;
+		unsigned int chunkSize;
+	};
+
 	class PointField : public me::sculpter::IShapeCreator
 	{
 	public:
@@ -13,6 +33,13 @@ namespace shapes
 		~PointField() override;
 
 	void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+	void Create( me::render::PrimitiveList & primitiveList, const PointFieldDesc & desc ) const;
+
+		/// <summary>
+		/// The points of the field desc describes, placed about its center, and the direction of each from the
+		/// center, without any buffers; also the starting state of particles.
+		/// </summary>
+		static void Generate( const PointFieldDesc & desc, std::vector< unify::V3< float > > & positions, std::vector< unify::V3< float > > & normals );
 	};
 }
 
@@ -2,6 +2,11 @@
 // All Rights Reserved
 
 #include <shapes/PointRing.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapeTransform.h>
+#include <shapes/ShapeKernels.h>
+#include <shapes/Progressive.h>
+#include <shapes/PointChunks.h>
 #include <me/render/VertexUtil.h>
 #include <me/exception/NotImplemented.h>
 #include <me/exception/FailedToCreate.h>
@@ -16,9 +21,29 @@ using namespace shapes;
 
 const float PI = 3.14159265358979f;
 const float PI2 = 6.28318530717959f;
-const std::string DefaultBufferUsage = "Default";
 
 
+PointRingDesc::PointRingDesc()
+	: majorRadius{ 0.5f }
+	, minorRadius{ 1.0f }
+	, count{ 100 }
+	, progressive{ false }
+	, morton{ false }
+	, chunkSize{ 4096 }
+{
+}
+
+PointRingDesc::PointRingDesc( const unify::Parameters & parameters )
+	: ShapeDesc( parameters )
+	, majorRadius{ parameters.Get( "majorradius", 0.5f ) }
+	, minorRadius{ parameters.Get( "minorradius", 1.0f ) }
+	, count{ (unsigned int)parameters.Get( "count", 100 ) }
+	, progressive{ parameters.Get( "progressive", false ) }
+	, morton{ parameters.Get( "morton", false ) }
+	, chunkSize{ parameters.Get< unsigned int >( "chunksize", 4096 ) }
+{
+}
+
 PointRing::PointRing()
 {
 }
@@ -28,104 +53,160 @@ PointRing::~PointRing()
 }
 
 void PointRing::Create(PrimitiveList & primitiveList, const unify::Parameters & parameters ) const
+{
+	try
+	{
+		Create( primitiveList, PointRingDesc( parameters ) );
+	}
+	catch( std::exception & ex )
+	{
+		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+	}
+}
+
+void PointRing::Create(PrimitiveList & primitiveList, const PointRingDesc & desc ) const
 {
 	using namespace unify;
 
-	try
+	if( desc.canonical )
+	{
+		// The unit shape is the real one divided by its outer radius.
+		if( !( desc.majorRadius > 0.0f ) )
+		{
+			throw me::exception::FailedToCreate( "Canonical PointRing needs a positive majorradius!" );
+		}
+
+		PointRingDesc unit = desc;
+		unit.canonical = false;
+		unit.center = V3< float >( 0, 0, 0 );
+		unit.majorRadius = 1.0f;
+		unit.minorRadius = desc.minorRadius / desc.majorRadius;
+		ShapeTransform::Report( V3< float >( desc.majorRadius, desc.majorRadius, desc.majorRadius ), desc.center );
+		Create( primitiveList, unit );
+		return;
+	}
+
+	if( desc.morton && desc.progressive )
+	{
+		// Sorting would scatter the Halton sequence, so no prefix would be an even subsample any more.
+		throw me::exception::FailedToCreate( "PointRing \"morton\" and \"progressive\" cannot be combined!" );
+	}
+
+	unsigned int count = desc.count;
+	Color diffuse = desc.diffuse;
+	Color specular = desc.specular;
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
+
+	unsigned short stream = 0;
+
+	VertexElement positionE = CommonVertexElement::Position( stream );
+	VertexElement normalE = CommonVertexElement::Normal( stream );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+	VertexElement specularE = CommonVertexElement::Specular( stream );
+	VertexElement texE = CommonVertexElement::TexCoords( stream );
+
+	std::vector< V3< float > > positions;
+	std::vector< V3< float > > normals;
+	Generate( desc, positions, normals );
+
+	if( desc.morton )
+	{
+		CreatePointChunks( primitiveList, desc, positions, normals, desc.chunkSize );
+		return;
+	}
+
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
+
+	AddMethod( set, RenderMethod::CreatePointList( 0, count ) );
+
+	char * vertices = new char[vd->GetSizeInBytes( 0 ) * count];
+	DataLock lock( vertices, vd->GetSizeInBytes( 0 ), count, DataLockAccess::ReadWrite, 0 );
+	VertexBufferParameters vbParameters{ vd, { { count, vertices } }, bufferUsage };
+	kernels::Bounds( positions.data(), count, vbParameters.bbox );
+
+	for( unsigned int v = 0; v < count; v++ )
 	{
-		float majorRadius = parameters.Get( "majorradius", 0.5f );	// Size radius
-		float minorRadius = parameters.Get( "minorradius", 1.0f );	// Radius of ring
-		unsigned int count = parameters.Get( "count", 100 );
-		Color diffuse = parameters.Get( "diffuse", unify::ColorWhite() );
-		Color specular = parameters.Get( "specular", unify::ColorWhite() );
-		V3< float > center = parameters.Get( "center", unify::V3< float >( 0, 0, 0 ) );
-		Effect::ptr effect = parameters.Get< Effect::ptr >( "effect" );
-		VertexDeclaration::ptr vd = effect->GetVertexShader()->GetVertexDeclaration();
-		BufferUsage::TYPE bufferUsage = BufferUsage::FromString( parameters.Get( "bufferusage", DefaultBufferUsage ) );
-
-		BufferSet & set = primitiveList.AddBufferSet();
-		set.SetEffect( effect );
-
-		set.AddMethod( RenderMethod::CreatePointList( 0, count ) );
-
-		V3< float > vec;
-		V2< float > vPos2;	// Initial position ( by radius1 )
-		V3< float > vPos3;
-		V3< float > norm;
-
-		char * vertices = new char[vd->GetSizeInBytes( 0 ) * count];
-		DataLock lock( vertices, vd->GetSizeInBytes( 0 ), count, DataLockAccess::ReadWrite, 0 );
-		VertexBufferParameters vbParameters{ vd, { { count, vertices } }, bufferUsage };
-		unsigned short stream = 0;
-
-		VertexElement positionE = CommonVertexElement::Position( stream );
-		VertexElement normalE = CommonVertexElement::Normal( stream );
-		VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
-		VertexElement specularE = CommonVertexElement::Specular( stream );
-		VertexElement texE = CommonVertexElement::TexCoords( stream );
-
-		class V
+		WriteVertex( *vd, lock, v, positionE, positions[v] );
+		WriteVertex( *vd, lock, v, normalE, normals[v] );
+		WriteVertex( *vd, lock, v, diffuseE, diffuse );
+		WriteVertex( *vd, lock, v, specularE, specular );
+	}
+	AddVertexBuffer( set, vbParameters );
+	delete[] vertices;
+}
+
+void PointRing::Generate( const PointRingDesc & desc, std::vector< unify::V3< float > > & positions, std::vector< unify::V3< float > > & normals )
+{
+	using namespace unify;
+
+	float majorRadius = desc.majorRadius;	// Size radius
+	float minorRadius = desc.minorRadius;	// Radius of ring
+	unsigned int count = desc.count;
+	V3< float > center = desc.center;
+
+	V2< float > vPos2;	// Initial position ( by radius1 )
+	V3< float > vPos3;
+
+	// Draw the random directions first, in the same order as before, then normalize, combine, place and bound
+	// every point in bulk. Flipping signs does not change a vector's length, so the flips may come first.
+	std::vector< V3< float > > rings( count );
+	std::vector< V3< float > > offsets( count );
+	if( desc.progressive )
+	{
+		// Angles even around the ring and offsets even over the sphere. The shifts are the only rand() use.
+		const float shift[3] = { (float)(rand() % 10000) * 0.0001f, (float)(rand() % 10000) * 0.0001f, (float)(rand() % 10000) * 0.0001f };
+		for( unsigned int v = 0; v < count; v++ )
 		{
-		public:
-			unify::V3< float > pos;
-			unify::V3< float > normal;
-			unify::Color diffuse;
-			unify::Color specular;
-			unify::TexCoords coords;
-		};
-		qjson::Object jsonFormat;
-		jsonFormat.Add( { "Position", "Float3" } );
-		jsonFormat.Add( { "Normal", "Float3" } );
-		jsonFormat.Add( { "Diffuse", "Color" } );
-		jsonFormat.Add( { "Specular", "Color" } );
-		jsonFormat.Add( { "TexCoord", "TexCoord" } );
-		VertexDeclaration::ptr vFormat( new VertexDeclaration( jsonFormat ) );
+			float ringRad = progressive::Halton( v + 1, 2, shift[0] ) * PI2;
+			rings[v] = V3< float >( cosf( ringRad ), 0, sinf( ringRad ) );
 
+			float y = progressive::Halton( v + 1, 3, shift[1] ) * 2.0f - 1.0f;
+			float rad = progressive::Halton( v + 1, 5, shift[2] ) * PI2;
+			float r = sqrtf( 1.0f - y * y );
+			offsets[v] = V3< float >( cosf( rad ) * r, y, sinf( rad ) * r );
+		}
+	}
+	else
+	{
 		for( unsigned int v = 0; v < count; v++ )
 		{
 			// Generate initial position...
 			vPos2.x = (float)(rand() % 10000) * 0.0001f;
 			vPos2.y = (float)(rand() % 10000) * 0.0001f;
-			vPos2.Normalize();
-			vPos2 *= majorRadius;
 
 			// Allow inversions...
 			if( (rand() % 2) ) vPos2.x *= -1.0f;
 			if( (rand() % 2) ) vPos2.y *= -1.0f;
 
-			vec.x = vPos2.x;
-			vec.z = vPos2.y;
-			vec.y = 0;
+			rings[v] = V3< float >( vPos2.x, 0, vPos2.y );
 
 			// Generate from Radius2
 			vPos3.x = (float)(rand() % 10000) * 0.0001f;
 			vPos3.y = (float)(rand() % 10000) * 0.0001f;
 			vPos3.z = (float)(rand() % 10000) * 0.0001f;
-			vPos3.Normalize();
-			vPos3 *= minorRadius;
 
 			// Allow inversions...
 			if( (rand() % 2) ) vPos3.x *= -1.0f;
 			if( (rand() % 2) ) vPos3.y *= -1.0f;
 			if( (rand() % 2) ) vPos3.z *= -1.0f;
 
-			vec += vPos3;
-
-			norm = vec;
-			norm.Normalize();
+			offsets[v] = vPos3;
+		}
+	}
 
-			vec += center;
+	kernels::Normalize( rings.data(), rings.data(), count );
+	kernels::Normalize( offsets.data(), offsets.data(), count );
 
-			WriteVertex( *vd, lock, v, positionE, vec );
-			WriteVertex( *vd, lock, v, normalE, norm );
-			WriteVertex( *vd, lock, v, diffuseE, diffuse );
-			WriteVertex( *vd, lock, v, specularE, specular );   
-			vbParameters.bbox += vec;
-		}
-		set.AddVertexBuffer( vbParameters );
-		delete[] vertices;
-	} catch( std::exception & ex )
+	positions.resize( count );
+	for( unsigned int v = 0; v < count; v++ )
 	{
-		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+		positions[v] = rings[v] * majorRadius + offsets[v] * minorRadius;
 	}
+
+	normals.resize( count );
+	kernels::Normalize( positions.data(), normals.data(), count );
+	kernels::Transform( kernels::Affine::Translation( center ), positions.data(), positions.data(), count );
 }
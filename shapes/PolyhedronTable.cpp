@@ -0,0 +1,170 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/PolyhedronTable.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapeTransform.h>
+#include <shapes/CollisionProxy.h>
+#include <me/render/VertexUtil.h>
+#include <me/render/TextureMode.h>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+namespace
+{
+	struct V
+	{
+		unify::V3< float > pos;
+		unify::V3< float > normal;
+		unify::Color diffuse;
+		unify::Color specular;
+		unify::TexCoords coords;
+	};
+
+	VertexDeclaration::ptr CreateFormat()
+	{
+		qjson::Object jsonFormat;
+		jsonFormat.Add( { "Position", "Float3" } );
+		jsonFormat.Add( { "Normal", "Float3" } );
+		jsonFormat.Add( { "Diffuse", "Color" } );
+		jsonFormat.Add( { "Specular", "Color" } );
+		jsonFormat.Add( { "TexCoord", "TexCoord" } );
+		return VertexDeclaration::ptr( new VertexDeclaration( jsonFormat ) );
+	}
+
+	// A table whose corners all sit on corners of its bounds is a box; anything else becomes a hull of its corners,
+	// with the triangles of its faces.
+	void AddCollisionProxy( const PolyhedronTable & table, const V * corners, const unify::V3< float > & low, const unify::V3< float > & center, const unify::V3< float > & extent )
+	{
+		bool box = true;
+		for( unsigned int c = 0; c < table.cornerCount; ++c )
+		{
+			for( unsigned int axis = 0; axis < 3; ++axis )
+			{
+				box = box && ( table.corners[c][axis] == 0.0f || table.corners[c][axis] == 1.0f );
+			}
+		}
+
+		if( box )
+		{
+			shapes::AddCollisionProxy( CollisionProxy::MakeBox( low + extent * 0.5f + center, extent * 0.5f ) );
+			return;
+		}
+
+		unify::V3< float > positions[PolyhedronTable::MaxCorners];
+		for( unsigned int c = 0; c < table.cornerCount; ++c )
+		{
+			positions[c] = corners[c].pos;
+		}
+
+		uint16_t indices[PolyhedronTable::MaxIndices];
+		for( unsigned int i = 0; i < table.indexCount; ++i )
+		{
+			indices[i] = table.slotCorner[table.indices[i]];
+		}
+		AddCollisionHull( positions, table.cornerCount, indices, table.indexCount );
+	}
+}
+
+void shapes::CreatePolyhedron( PrimitiveList & primitiveList, const PolyhedronTable & table, const ShapeDesc & desc,
+	const unify::V3< float > & inf, const unify::V3< float > & sup, int textureMode,
+	const std::vector< unify::Color > & diffuses, const std::vector< unify::TexArea > & faceUV )
+{
+	using namespace unify;
+
+	// The format of V never changes, so it is built once rather than per shape.
+	static const VertexDeclaration::ptr vFormat = CreateFormat();
+
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	const size_t stride = vd->GetSizeInBytes( 0 );
+
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
+
+	AddMethod( set, RenderMethod::CreateTriangleListIndexed( table.slotCount, table.indexCount, 0, 0 ) );
+
+	std::vector< unsigned char > verticesRaw( stride * table.slotCount );
+	DataLock lock( verticesRaw.data(), (unsigned int)stride, table.slotCount, DataLockAccess::ReadWrite, 0 );
+
+	VertexBufferParameters vbParameters{ vd, { { table.slotCount, verticesRaw.data() } }, desc.bufferUsage };
+
+	const bool perCornerDiffuse = diffuses.size() == table.cornerCount;
+	const bool perFaceDiffuse = table.faceCount != 0 && diffuses.size() == table.faceCount;
+
+	// A canonical polyhedron is a unit cube's worth of corners around the origin; the extent and center are reported.
+	V3< float > low = inf;
+	V3< float > center = desc.center;
+	V3< float > extent = sup - inf;
+	if( desc.canonical )
+	{
+		ShapeTransform::Report( extent, desc.center + ( inf + sup ) * 0.5f );
+		low = V3< float >( -0.5f, -0.5f, -0.5f );
+		center = V3< float >( 0, 0, 0 );
+		extent = V3< float >( 1, 1, 1 );
+	}
+
+	// Scale and translate the unit corners. The normal is taken before translating for center.
+	V corners[PolyhedronTable::MaxCorners];
+	for( unsigned int c = 0; c < table.cornerCount; ++c )
+	{
+		V3< float > local(
+			low.x + extent.x * table.corners[c][0],
+			low.y + extent.y * table.corners[c][1],
+			low.z + extent.z * table.corners[c][2] );
+		corners[c].normal.Normalize( local );
+		corners[c].pos = local + center;
+		corners[c].diffuse = perCornerDiffuse ? diffuses[c] : desc.diffuse;
+		corners[c].specular = desc.specular;
+		vbParameters.bbox += corners[c].pos;
+	}
+
+	if( desc.collision )
+	{
+		AddCollisionProxy( table, corners, low, center, extent );
+	}
+
+	const float ( *uvs )[2] =
+		textureMode == TextureMode::Correct ? table.correctUV :
+		textureMode == TextureMode::Wrapped ? table.wrappedUV :
+		nullptr;
+
+	V slots[PolyhedronTable::MaxSlots];
+	for( unsigned int s = 0; s < table.slotCount; ++s )
+	{
+		const unsigned char corner = table.slotCorner[s];
+		slots[s] = corners[corner];
+		slots[s].coords = uvs ? TexCoords( uvs[s][0], uvs[s][1] ) : TexCoords( table.cornerUV[corner][0], table.cornerUV[corner][1] );
+	}
+
+	for( unsigned int face = 0; face < table.faceCount; ++face )
+	{
+		const unsigned char * faceSlots = table.faceSlots[face];
+		if( !faceUV.empty() )
+		{
+			const TexArea & texArea = faceUV[face % faceUV.size()];
+			slots[faceSlots[0]].coords = texArea.UL();
+			slots[faceSlots[1]].coords = texArea.UR();
+			slots[faceSlots[2]].coords = texArea.DL();
+			slots[faceSlots[3]].coords = texArea.DR();
+		}
+		if( perFaceDiffuse )
+		{
+			const Color & faceDiffuse = diffuses[table.faceDiffuse[face]];
+			for( unsigned int i = 0; i < 4; ++i )
+			{
+				slots[faceSlots[i]].diffuse = faceDiffuse;
+			}
+		}
+	}
+
+	for( unsigned int s = 0; s < table.slotCount; ++s )
+	{
+		WriteVertex( *vd, lock, s, *vFormat, (void*)&slots[s] );
+	}
+
+	AddVertexBuffer( set, vbParameters );
+	AddIndexBuffer( set, { { { table.indexCount, table.indices } }, desc.bufferUsage } );
+}
@@ -0,0 +1,175 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <shapes/ShapeDesc.h>
+#include <me/render/PrimitiveList.h>
+#include <unify/TexArea.h>
+#include <vector>
+
+namespace shapes
+{
+	/// <summary>
+	/// The complete topology of a small polyhedron. Corners are in unit space, 0 being inf and 1 being sup on each
+	/// axis. Each output vertex (slot) is a copy of one corner with its own texture coordinates, so faces can have
+	/// hard edges.
+	/// </summary>
+	struct PolyhedronTable
+	{
+		static constexpr unsigned int MaxCorners = 8;
+		static constexpr unsigned int MaxSlots = 24;
+		static constexpr unsigned int MaxFaces = 6;
+		static constexpr unsigned int MaxIndices = 36;
+
+		unsigned int cornerCount;
+		float corners[MaxCorners][3];
+
+		// Texture coordinates used when the texture mode is neither Correct nor Wrapped.
+		float cornerUV[MaxCorners][2];
+
+		unsigned int slotCount;
+		unsigned char slotCorner[MaxSlots];
+		float correctUV[MaxSlots][2];
+		float wrappedUV[MaxSlots][2];
+
+		// Quad faces, for per-face diffuse and faceUV. faceDiffuse is the index into "diffuses" for each face.
+		unsigned int faceCount;
+		unsigned char faceSlots[MaxFaces][4];
+		unsigned char faceDiffuse[MaxFaces];
+
+		unsigned int indexCount;
+		me::render::Index32 indices[MaxIndices];
+	};
+
+	namespace polyhedron
+	{
+		constexpr float l1 = 0.0f, l2 = 0.33f;
+		constexpr float m1 = 0.33f, m2 = 0.66f;
+		constexpr float r1 = 0.66f, r2 = 1.0f;
+		constexpr float t1 = 0.0f, t2 = 0.5f;
+		constexpr float b1 = 0.5f, b2 = 1.0f;
+
+		constexpr PolyhedronTable Box =
+		{
+			8,
+			{ { 0, 1, 1 }, { 1, 1, 1 }, { 0, 1, 0 }, { 1, 1, 0 }, { 0, 0, 1 }, { 1, 0, 1 }, { 0, 0, 0 }, { 1, 0, 0 } },
+			{ { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } },
+
+			24,
+			{ 0, 1, 2, 3, 4, 5, 6, 7, 1, 0, 5, 4, 2, 3, 6, 7, 0, 2, 4, 6, 3, 1, 7, 5 },
+			{
+				{ 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 },
+				{ 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 },
+				{ 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }
+			},
+			{
+				{ m1, b1 }, { m1, b2 }, { m2, b1 }, { m2, b2 }, // Front
+				{ r1, b1 }, { r1, b2 }, { r2, b1 }, { r2, b2 }, // Right Side
+				{ l1, t1 }, { l1, t2 }, { l2, t1 }, { l2, t2 }, // Rear
+				{ l1, b1 }, { l1, b2 }, { l2, b1 }, { l2, b2 }, // Left Side
+				{ m1, t1 }, { m1, t2 }, { m2, t1 }, { m2, t2 }, // Top
+				{ r1, t1 }, { r1, t2 }, { r2, t1 }, { r2, t2 }  // Bottom
+			},
+
+			6,
+			{ { 0, 1, 2, 3 }, { 4, 5, 6, 7 }, { 8, 9, 10, 11 }, { 12, 13, 14, 15 }, { 16, 17, 18, 19 }, { 20, 21, 22, 23 } },
+			{ 1, 2, 3, 0, 4, 5 },
+
+			36,
+			{
+				0, 1, 2, 1, 3, 2,
+				4, 5, 6, 5, 7, 6,
+				8, 9, 10, 9, 11, 10,
+				12, 13, 14, 13, 15, 14,
+				16, 17, 18, 17, 19, 18,
+				20, 21, 22, 21, 23, 22
+			}
+		};
+
+		constexpr PolyhedronTable BeveledBox =
+		{
+			8,
+			{ { 0, 1, 0 }, { 0, 0, 0 }, { 1, 1, 0 }, { 1, 0, 0 }, { 1, 1, 1 }, { 1, 0, 1 }, { 0, 1, 1 }, { 0, 0, 1 } },
+			{ { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } },
+
+			24,
+			{ 0, 1, 2, 3, 2, 3, 4, 5, 4, 5, 6, 7, 6, 7, 0, 1, 6, 0, 4, 2, 1, 7, 3, 5 },
+			{
+				{ 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 },
+				{ 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 },
+				{ 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }
+			},
+			{
+				{ m1, b1 }, { m1, b2 }, { m2, b1 }, { m2, b2 }, // Front
+				{ r1, b1 }, { r1, b2 }, { r2, b1 }, { r2, b2 }, // Right Side
+				{ l1, t1 }, { l1, t2 }, { l2, t1 }, { l2, t2 }, // Rear
+				{ l1, b1 }, { l1, b2 }, { l2, b1 }, { l2, b2 }, // Left Side
+				{ m1, t1 }, { m1, t2 }, { m2, t1 }, { m2, t2 }, // Top
+				{ r1, t1 }, { r1, t2 }, { r2, t1 }, { r2, t2 }  // Bottom
+			},
+
+			6,
+			{ { 0, 1, 2, 3 }, { 4, 5, 6, 7 }, { 8, 9, 10, 11 }, { 12, 13, 14, 15 }, { 16, 17, 18, 19 }, { 20, 21, 22, 23 } },
+			{ 1, 2, 3, 0, 4, 5 },
+
+			36,
+			{
+				0, 2, 1, 2, 3, 1,
+				4, 6, 5, 6, 7, 5,
+				8, 10, 9, 10, 11, 9,
+				12, 14, 13, 14, 15, 13,
+				16, 18, 17, 18, 19, 17,
+				20, 22, 21, 22, 23, 21
+			}
+		};
+
+		constexpr PolyhedronTable Pyramid =
+		{
+			5,
+			{ { 0.5f, 1, 0.5f }, { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 } },
+			{ { 0.5f, 0.5f }, { 0, 1 }, { 1, 1 }, { 0, 1 }, { 1, 1 } },
+
+			16,
+			{ 0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 4, 1, 1, 4, 2, 3 },
+			{
+				{ 0.5f, 0.5f }, { 0, 1 }, { 1, 1 },
+				{ 0.5f, 0.5f }, { 0, 1 }, { 1, 1 },
+				{ 0.5f, 0.5f }, { 0, 1 }, { 1, 1 },
+				{ 0.5f, 0.5f }, { 0, 1 }, { 1, 1 },
+				{ 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }
+			},
+			{
+				{ 0.5f, b1 }, { m1, b2 }, { m2, b2 },		// Front
+				{ 0.8333f, b1 }, { r1, b2 }, { r2, b2 },	// Right Side
+				{ 0.1667f, t1 }, { l1, t2 }, { l2, t2 },	// Rear
+				{ 0.1667f, b1 }, { l1, b2 }, { l2, b2 },	// Left Side
+				{ r1, t1 }, { r1, t2 }, { r2, t1 }, { r2, t2 }	// Bottom
+			},
+
+			// Only the bottom is a quad, so no per-face diffuse.
+			0,
+			{},
+			{},
+
+			18,
+			{
+				0, 2, 1,
+				3, 5, 4,
+				6, 8, 7,
+				9, 11, 10,
+				12, 14, 13, 14, 15, 13
+			}
+		};
+	}
+
+	/// <summary>
+	/// Builds a polyhedron from its table in one pass: corners are scaled from unit space to inf/sup, translated by
+	/// center, then copied out to each slot with the texture coordinates of the texture mode.
+	/// "diffuses" may hold one color per corner, or one per face; otherwise desc.diffuse is used.
+	/// Each face takes faceUV[face % faceUV.size()] when faceUV is not empty. With desc.canonical the corners span
+	/// -0.5 to 0.5 about the origin and inf, sup and center go to ShapeTransform.
+	/// </summary>
+	void CreatePolyhedron( me::render::PrimitiveList & primitiveList, const PolyhedronTable & table, const ShapeDesc & desc,
+		const unify::V3< float > & inf, const unify::V3< float > & sup, int textureMode,
+		const std::vector< unify::Color > & diffuses, const std::vector< unify::TexArea > & faceUV );
+}
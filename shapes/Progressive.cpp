@@ -0,0 +1,35 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/Progressive.h>
+#include <algorithm>
+
+using namespace shapes;
+
+float progressive::Halton( unsigned int index, unsigned int base, float shift )
+{
+	float result = 0.0f;
+	float fraction = 1.0f / base;
+	while( index > 0 )
+	{
+		result += fraction * (index % base);
+		index /= base;
+		fraction /= base;
+	}
+
+	result += shift;
+	return result - (float)(int)result;
+}
+
+unsigned int progressive::GetLODCount( unsigned int count, float distance, float fullDistance, unsigned int minimum )
+{
+	minimum = std::min( minimum, count );
+	if( distance <= fullDistance || distance <= 0.0f )
+	{
+		return count;
+	}
+
+	float ratio = fullDistance / distance;
+	unsigned int lodCount = (unsigned int)( count * ratio * ratio );
+	return std::max( lodCount, minimum );
+}
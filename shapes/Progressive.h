@@ -0,0 +1,27 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+namespace shapes
+{
+	/// <summary>
+	/// Low discrepancy sequences for shapes whose points are emitted in progressive order, where every prefix of
+	/// the vertex buffer is an even subsample of the whole. Level of detail is then only a matter of drawing fewer
+	/// points.
+	/// </summary>
+	namespace progressive
+	{
+		/// <summary>
+		/// The index-th term of the Halton sequence in base, in [0, 1), shifted by shift and wrapped. One random
+		/// shift per dimension makes shapes differ without losing the sequence's evenness.
+		/// </summary>
+		float Halton( unsigned int index, unsigned int base, float shift = 0.0f );
+
+		/// <summary>
+		/// The number of points to draw from a progressive point list of count points seen from distance. Points
+		/// cover screen area, which falls with the square of distance, so the count does too beyond fullDistance.
+		/// Never less than minimum, or more than count.
+		/// </summary>
+		unsigned int GetLODCount( unsigned int count, float distance, float fullDistance, unsigned int minimum = 1 );
+	}
+}
@@ -3,9 +3,24 @@
 #pragma once
 
 #include <me/sculpter/IShapeCreator.h>
+#include <shapes/ShapeDesc.h>
+#include <shapes/ShapeQuery.h>
+#include <me/render/TextureMode.h>
+#include <unify/Size3.h>
+#include <vector>
 
 namespace shapes
 {
+	struct PyramidDesc : public ShapeDesc
+	{
+		PyramidDesc();
+		PyramidDesc( const unify::Parameters & parameters );
+
+		unify::Size3< float > size;
+		me::render::TextureMode::TYPE textureMode;
+		std::vector< unify::Color > diffuses;
+	};
+
 	class Pyramid : public me::sculpter::IShapeCreator
 	{
 	public:
@@ -13,5 +28,11 @@ namespace shapes
 		~Pyramid() override;
 
 		void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+		void Create( me::render::PrimitiveList & primitiveList, const PyramidDesc & desc ) const;
+
+		/// <summary>
+		/// The exact shape desc describes, for picking and containment without its triangles.
+		/// </summary>
+		IShapeQuery::ptr CreateQuery( const PyramidDesc & desc ) const;
 	};
 }
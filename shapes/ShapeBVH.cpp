@@ -0,0 +1,534 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/ShapeBVH.h>
+#include <shapes/VectorMath.h>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <cmath>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+using vectormath::Dot;
+using vectormath::Cross;
+
+namespace
+{
+	// Split candidates per axis, evaluated with the surface area heuristic.
+	const int Bins = 12;
+
+	// A node this small always becomes a leaf, and one this large never does.
+	const uint32_t MinLeafSize = 2;
+	const uint32_t MaxLeafSize = 16;
+
+	// The cost of visiting a node, relative to testing one primitive.
+	const float TraversalCost = 1.0f;
+
+	// Nodes at least this large, and no deeper than ParallelDepth, build their left child on another thread.
+	const uint32_t ParallelThreshold = 1 << 14;
+	const unsigned int ParallelDepth = 3;
+
+	// Traversal stacks reserve this much; a lopsided tree can go deeper.
+	const size_t StackReserve = 64;
+
+	float Axis( const unify::V3< float > & v, int axis )
+	{
+		return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+	}
+
+	bool IsEmpty( const unify::BBox< float > & bounds )
+	{
+		return bounds.sup.x < bounds.inf.x || bounds.sup.y < bounds.inf.y || bounds.sup.z < bounds.inf.z;
+	}
+
+	void Grow( unify::BBox< float > & bounds, const unify::BBox< float > & other )
+	{
+		if( !IsEmpty( other ) )
+		{
+			bounds += other.inf;
+			bounds += other.sup;
+		}
+	}
+
+	float SurfaceArea( const unify::BBox< float > & bounds )
+	{
+		if( IsEmpty( bounds ) )
+		{
+			return 0.0f;
+		}
+		unify::V3< float > size = bounds.sup - bounds.inf;
+		return 2.0f * ( size.x * size.y + size.y * size.z + size.z * size.x );
+	}
+
+	// Narrows [tNear, tFar] to where the ray is between low and high on one axis. A ray parallel to the axis's
+	// planes is between them throughout or never, which the inverse can't tell: 0 * inf is NaN.
+	bool Clip( float low, float high, float origin, float direction, float inverse, float & tNear, float & tFar )
+	{
+		if( direction == 0.0f )
+		{
+			return origin >= low && origin <= high;
+		}
+
+		float t1 = ( low - origin ) * inverse;
+		float t2 = ( high - origin ) * inverse;
+		tNear = std::max( tNear, std::min( t1, t2 ) );
+		tFar = std::min( tFar, std::max( t1, t2 ) );
+		return true;
+	}
+
+	// The entry distance of a ray into bounds, or infinity when it misses or enters beyond limit.
+	float Enter( const unify::BBox< float > & bounds, const unify::V3< float > & origin, const unify::V3< float > & direction, const unify::V3< float > & inverse, float limit )
+	{
+		float tNear = -std::numeric_limits< float >::infinity();
+		float tFar = std::numeric_limits< float >::infinity();
+		if( !Clip( bounds.inf.x, bounds.sup.x, origin.x, direction.x, inverse.x, tNear, tFar )
+			|| !Clip( bounds.inf.y, bounds.sup.y, origin.y, direction.y, inverse.y, tNear, tFar )
+			|| !Clip( bounds.inf.z, bounds.sup.z, origin.z, direction.z, inverse.z, tNear, tFar ) )
+		{
+			return std::numeric_limits< float >::infinity();
+		}
+
+		if( tFar < std::max( tNear, 0.0f ) || tNear > limit )
+		{
+			return std::numeric_limits< float >::infinity();
+		}
+		return std::max( tNear, 0.0f );
+	}
+
+	bool IsOutside( const unify::BBox< float > & bounds, const ShapeBVH::Plane & plane )
+	{
+		// The corner furthest along the normal; if even it is behind the plane, so is the box.
+		unify::V3< float > corner(
+			plane.normal.x >= 0.0f ? bounds.sup.x : bounds.inf.x,
+			plane.normal.y >= 0.0f ? bounds.sup.y : bounds.inf.y,
+			plane.normal.z >= 0.0f ? bounds.sup.z : bounds.inf.z );
+		return Dot( plane.normal, corner ) + plane.distance < 0.0f;
+	}
+
+	bool IsOutside( const unify::BBox< float > & bounds, const std::vector< ShapeBVH::Plane > & planes )
+	{
+		for( const auto & plane : planes )
+		{
+			if( IsOutside( bounds, plane ) )
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+ShapeBVH::Hit::Hit()
+	: object{ ~(size_t)0 }
+	, triangle{ NoTriangle }
+{
+}
+
+ShapeBVH::ShapeBVH()
+{
+}
+
+size_t ShapeBVH::AddShape( IShapeQuery::ptr query )
+{
+	Object object;
+	object.query = query;
+	object.firstPrimitive = m_primitives.size();
+	m_objects.push_back( object );
+
+	Primitive primitive;
+	primitive.object = m_objects.size() - 1;
+	primitive.triangle = NoTriangle;
+	m_primitives.push_back( primitive );
+	return primitive.object;
+}
+
+size_t ShapeBVH::AddMesh( const unify::V3< float > * positions, const Index32 * indices, size_t indexCount )
+{
+	Object object;
+	object.firstPrimitive = m_primitives.size();
+	object.indices.assign( indices, indices + indexCount - indexCount % 3 );
+	m_objects.push_back( object );
+
+	Primitive primitive;
+	primitive.object = m_objects.size() - 1;
+	for( size_t triangle = 0; triangle < indexCount / 3; ++triangle )
+	{
+		primitive.triangle = triangle;
+		for( size_t corner = 0; corner < 3; ++corner )
+		{
+			primitive.corners[corner] = positions[indices[triangle * 3 + corner]];
+		}
+		m_primitives.push_back( primitive );
+	}
+	return primitive.object;
+}
+
+void ShapeBVH::SetShape( size_t object, IShapeQuery::ptr query )
+{
+	m_objects[object].query = query;
+}
+
+void ShapeBVH::SetMeshPositions( size_t object, const unify::V3< float > * positions )
+{
+	const Object & mesh = m_objects[object];
+	for( size_t triangle = 0; triangle < mesh.indices.size() / 3; ++triangle )
+	{
+		Primitive & primitive = m_primitives[mesh.firstPrimitive + triangle];
+		for( size_t corner = 0; corner < 3; ++corner )
+		{
+			primitive.corners[corner] = positions[mesh.indices[triangle * 3 + corner]];
+		}
+	}
+}
+
+void ShapeBVH::Build()
+{
+	const uint32_t count = (uint32_t)m_primitives.size();
+	m_order.resize( count );
+	std::iota( m_order.begin(), m_order.end(), 0 );
+	if( count == 0 )
+	{
+		m_nodes.clear();
+		return;
+	}
+
+	std::vector< unify::BBox< float > > bounds( count );
+	std::vector< unify::V3< float > > centers( count );
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		bounds[i] = GetPrimitiveBounds( m_primitives[i] );
+		centers[i] = ( bounds[i].inf + bounds[i].sup ) * 0.5f;
+	}
+
+	// A binary tree over count leaves has at most 2 * count - 1 nodes. They are allocated up front, so threads
+	// can claim pairs of them without locking.
+	m_nodes.resize( count * 2 - 1 );
+	std::atomic< uint32_t > nodeCount{ 1 };
+	BuildNode( 0, 0, count, 0, bounds, centers, nodeCount );
+	m_nodes.resize( nodeCount );
+}
+
+void ShapeBVH::BuildNode( uint32_t index, uint32_t begin, uint32_t end, unsigned int depth, const std::vector< unify::BBox< float > > & bounds, const std::vector< unify::V3< float > > & centers, std::atomic< uint32_t > & nodeCount )
+{
+	Node & node = m_nodes[index];
+	node.bounds = unify::BBox< float >();
+	unify::BBox< float > centerBounds;
+	for( uint32_t i = begin; i < end; ++i )
+	{
+		Grow( node.bounds, bounds[m_order[i]] );
+		centerBounds += centers[m_order[i]];
+	}
+
+	const uint32_t count = end - begin;
+	node.first = begin;
+	node.count = count;
+	if( count <= MinLeafSize )
+	{
+		return;
+	}
+
+	// Bin the centers along each axis, and find the bin boundary with the least area weighted cost.
+	int bestAxis = -1;
+	int bestSplit = 0;
+	float bestCost = std::numeric_limits< float >::infinity();
+	for( int axis = 0; axis < 3; ++axis )
+	{
+		float low = Axis( centerBounds.inf, axis );
+		float extent = Axis( centerBounds.sup, axis ) - low;
+		if( !( extent > 0.0f ) )
+		{
+			continue;
+		}
+
+		unify::BBox< float > binBounds[Bins];
+		uint32_t binCounts[Bins] = {};
+		for( uint32_t i = begin; i < end; ++i )
+		{
+			uint32_t primitive = m_order[i];
+			int bin = std::min( Bins - 1, (int)( ( Axis( centers[primitive], axis ) - low ) / extent * Bins ) );
+			Grow( binBounds[bin], bounds[primitive] );
+			++binCounts[bin];
+		}
+
+		// Sweep from the right to get the cost right of each split, then from the left to add the cost left of it.
+		float rightCosts[Bins];
+		unify::BBox< float > sweep;
+		uint32_t sweepCount = 0;
+		for( int bin = Bins - 1; bin > 0; --bin )
+		{
+			Grow( sweep, binBounds[bin] );
+			sweepCount += binCounts[bin];
+			rightCosts[bin - 1] = SurfaceArea( sweep ) * sweepCount;
+		}
+
+		sweep = unify::BBox< float >();
+		sweepCount = 0;
+		for( int split = 0; split < Bins - 1; ++split )
+		{
+			Grow( sweep, binBounds[split] );
+			sweepCount += binCounts[split];
+			float cost = SurfaceArea( sweep ) * sweepCount + rightCosts[split];
+			if( cost < bestCost )
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	uint32_t middle = begin;
+	if( bestAxis >= 0 )
+	{
+		float area = SurfaceArea( node.bounds );
+		float splitCost = TraversalCost + ( area > 0.0f ? bestCost / area : 0.0f );
+		if( splitCost >= (float)count && count <= MaxLeafSize )
+		{
+			return;
+		}
+
+		float low = Axis( centerBounds.inf, bestAxis );
+		float extent = Axis( centerBounds.sup, bestAxis ) - low;
+		middle = (uint32_t)( std::partition( m_order.begin() + begin, m_order.begin() + end, [&]( uint32_t primitive )
+		{
+			return std::min( Bins - 1, (int)( ( Axis( centers[primitive], bestAxis ) - low ) / extent * Bins ) ) <= bestSplit;
+		} ) - m_order.begin() );
+	}
+	else if( count <= MaxLeafSize )
+	{
+		return;
+	}
+
+	// Every center in one place: split the range in half rather than make a huge leaf.
+	if( middle == begin || middle == end )
+	{
+		middle = begin + count / 2;
+	}
+
+	uint32_t children = nodeCount.fetch_add( 2 );
+	node.first = children;
+	node.count = 0;
+
+	if( count >= ParallelThreshold && depth < ParallelDepth )
+	{
+		std::thread left( [&]()
+		{
+			BuildNode( children, begin, middle, depth + 1, bounds, centers, nodeCount );
+		} );
+		BuildNode( children + 1, middle, end, depth + 1, bounds, centers, nodeCount );
+		left.join();
+	}
+	else
+	{
+		BuildNode( children, begin, middle, depth + 1, bounds, centers, nodeCount );
+		BuildNode( children + 1, middle, end, depth + 1, bounds, centers, nodeCount );
+	}
+}
+
+void ShapeBVH::Refit()
+{
+	// Children are always claimed after their parent, so walking backwards finishes each child first.
+	for( size_t index = m_nodes.size(); index-- > 0; )
+	{
+		Node & node = m_nodes[index];
+		node.bounds = unify::BBox< float >();
+		if( node.count )
+		{
+			for( uint32_t i = node.first; i < node.first + node.count; ++i )
+			{
+				Grow( node.bounds, GetPrimitiveBounds( m_primitives[m_order[i]] ) );
+			}
+		}
+		else
+		{
+			Grow( node.bounds, m_nodes[node.first].bounds );
+			Grow( node.bounds, m_nodes[node.first + 1].bounds );
+		}
+	}
+}
+
+bool ShapeBVH::Intersect( const unify::V3< float > & origin, const unify::V3< float > & direction, Hit & hit ) const
+{
+	// A ray without a direction, or with a NaN in it, has nowhere to go.
+	if( m_nodes.empty() || !( Dot( direction, direction ) > 0.0f ) )
+	{
+		return false;
+	}
+
+	const unify::V3< float > inverse( 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z );
+	float best = std::numeric_limits< float >::infinity();
+	bool found = false;
+
+	if( Enter( m_nodes[0].bounds, origin, direction, inverse, best ) == std::numeric_limits< float >::infinity() )
+	{
+		return false;
+	}
+
+	std::vector< uint32_t > stack;
+	stack.reserve( StackReserve );
+	stack.push_back( 0 );
+	while( !stack.empty() )
+	{
+		const Node & node = m_nodes[stack.back()];
+		stack.pop_back();
+		if( node.count )
+		{
+			for( uint32_t i = node.first; i < node.first + node.count; ++i )
+			{
+				const Primitive & primitive = m_primitives[m_order[i]];
+				RayHit primitiveHit;
+				if( IntersectPrimitive( primitive, origin, direction, primitiveHit ) && primitiveHit.distance < best )
+				{
+					best = primitiveHit.distance;
+					hit.object = primitive.object;
+					hit.triangle = primitive.triangle;
+					hit.hit = primitiveHit;
+					found = true;
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first, so the farther one is often skipped once a hit is found.
+		uint32_t near = node.first;
+		uint32_t far = node.first + 1;
+		float tNear = Enter( m_nodes[near].bounds, origin, direction, inverse, best );
+		float tFar = Enter( m_nodes[far].bounds, origin, direction, inverse, best );
+		if( tFar < tNear )
+		{
+			std::swap( near, far );
+			std::swap( tNear, tFar );
+		}
+		if( tFar != std::numeric_limits< float >::infinity() )
+		{
+			stack.push_back( far );
+		}
+		if( tNear != std::numeric_limits< float >::infinity() )
+		{
+			stack.push_back( near );
+		}
+	}
+	return found;
+}
+
+std::vector< size_t > ShapeBVH::Query( const std::vector< Plane > & planes ) const
+{
+	std::vector< size_t > objects;
+	if( m_nodes.empty() )
+	{
+		return objects;
+	}
+
+	std::vector< bool > seen( m_objects.size() );
+	std::vector< uint32_t > stack;
+	stack.reserve( StackReserve );
+	stack.push_back( 0 );
+	while( !stack.empty() )
+	{
+		const Node & node = m_nodes[stack.back()];
+		stack.pop_back();
+		if( IsOutside( node.bounds, planes ) )
+		{
+			continue;
+		}
+
+		if( node.count == 0 )
+		{
+			stack.push_back( node.first );
+			stack.push_back( node.first + 1 );
+			continue;
+		}
+
+		for( uint32_t i = node.first; i < node.first + node.count; ++i )
+		{
+			const Primitive & primitive = m_primitives[m_order[i]];
+			if( !seen[primitive.object] && !IsOutside( GetPrimitiveBounds( primitive ), planes ) )
+			{
+				seen[primitive.object] = true;
+				objects.push_back( primitive.object );
+			}
+		}
+	}
+	return objects;
+}
+
+size_t ShapeBVH::GetObjectCount() const
+{
+	return m_objects.size();
+}
+
+size_t ShapeBVH::GetPrimitiveCount() const
+{
+	return m_primitives.size();
+}
+
+size_t ShapeBVH::GetNodeCount() const
+{
+	return m_nodes.size();
+}
+
+unify::BBox< float > ShapeBVH::GetPrimitiveBounds( const Primitive & primitive ) const
+{
+	if( primitive.triangle == NoTriangle )
+	{
+		return m_objects[primitive.object].query->GetBounds();
+	}
+
+	unify::BBox< float > bounds;
+	bounds += primitive.corners[0];
+	bounds += primitive.corners[1];
+	bounds += primitive.corners[2];
+	return bounds;
+}
+
+bool ShapeBVH::IntersectPrimitive( const Primitive & primitive, const unify::V3< float > & origin, const unify::V3< float > & direction, RayHit & hit ) const
+{
+	if( primitive.triangle == NoTriangle )
+	{
+		return m_objects[primitive.object].query->Intersect( origin, direction, hit );
+	}
+
+	// Moller-Trumbore, hitting either side.
+	const unify::V3< float > edge1 = primitive.corners[1] - primitive.corners[0];
+	const unify::V3< float > edge2 = primitive.corners[2] - primitive.corners[0];
+	const unify::V3< float > p = Cross( direction, edge2 );
+	const float determinant = Dot( edge1, p );
+	if( std::abs( determinant ) < 1e-12f )
+	{
+		return false;
+	}
+
+	const float inverse = 1.0f / determinant;
+	const unify::V3< float > toOrigin = origin - primitive.corners[0];
+	const float u = Dot( toOrigin, p ) * inverse;
+	if( u < 0.0f || u > 1.0f )
+	{
+		return false;
+	}
+
+	const unify::V3< float > q = Cross( toOrigin, edge1 );
+	const float v = Dot( direction, q ) * inverse;
+	if( v < 0.0f || u + v > 1.0f )
+	{
+		return false;
+	}
+
+	const float t = Dot( edge2, q ) * inverse;
+	if( t < 0.0f )
+	{
+		return false;
+	}
+
+	hit.distance = t;
+	hit.point = origin + direction * t;
+	hit.normal = Cross( edge1, edge2 );
+	hit.normal.Normalize();
+	if( Dot( hit.normal, direction ) > 0.0f )
+	{
+		hit.normal *= -1.0f;
+	}
+	return true;
+}
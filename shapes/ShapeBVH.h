@@ -0,0 +1,133 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <shapes/ShapeQuery.h>
+#include <me/render/BufferSet.h>
+#include <unify/V3.h>
+#include <unify/BBox.h>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+namespace shapes
+{
+	/// <summary>
+	/// A bounding volume hierarchy over placed shapes, for picking and ray casts without testing every shape.
+	/// An object is either an analytic shape (an IShapeQuery) or a triangle mesh, whose triangles are each a
+	/// primitive of their own. Objects are added, then Build sorts them with the surface area heuristic; when
+	/// objects move, SetShape or SetMeshPositions followed by Refit updates the bounds without rebuilding.
+	/// </summary>
+	class ShapeBVH
+	{
+	public:
+		static constexpr size_t NoTriangle = ~(size_t)0;
+
+		/// <summary>
+		/// What a ray hit: the object, and for a mesh, the triangle in it.
+		/// </summary>
+		struct Hit
+		{
+			Hit();
+
+			size_t object;
+
+			// NoTriangle for a shape.
+			size_t triangle;
+			RayHit hit;
+		};
+
+		/// <summary>
+		/// A frustum plane; a plane keeps what is on the side its normal points to.
+		/// </summary>
+		struct Plane
+		{
+			unify::V3< float > normal;
+			float distance;
+		};
+
+		ShapeBVH();
+
+		/// <summary>
+		/// Adds an analytic shape, returning its object id.
+		/// </summary>
+		size_t AddShape( IShapeQuery::ptr query );
+
+		/// <summary>
+		/// Adds a triangle list, returning its object id. The positions are copied.
+		/// </summary>
+		size_t AddMesh( const unify::V3< float > * positions, const me::render::Index32 * indices, size_t indexCount );
+
+		/// <summary>
+		/// Replaces a shape's query, such as when it has moved. Call Refit before the next query.
+		/// </summary>
+		void SetShape( size_t object, IShapeQuery::ptr query );
+
+		/// <summary>
+		/// Moves a mesh's vertices, keeping the indices it was added with. Call Refit before the next query.
+		/// </summary>
+		void SetMeshPositions( size_t object, const unify::V3< float > * positions );
+
+		/// <summary>
+		/// Builds the tree over every primitive, splitting large nodes across threads. Objects added after a Build
+		/// are not found until the next Build.
+		/// </summary>
+		void Build();
+
+		/// <summary>
+		/// Recomputes the bounds of every node from its primitives, keeping the tree as it is. Cheap, but the tree
+		/// loosens as objects move away from where it was built, so Build again after large changes.
+		/// </summary>
+		void Refit();
+
+		/// <summary>
+		/// The nearest hit along origin + direction * t, t >= 0.
+		/// </summary>
+		bool Intersect( const unify::V3< float > & origin, const unify::V3< float > & direction, Hit & hit ) const;
+
+		/// <summary>
+		/// The objects with any primitive whose bounds are not wholly outside a plane, each once.
+		/// </summary>
+		std::vector< size_t > Query( const std::vector< Plane > & planes ) const;
+
+		size_t GetObjectCount() const;
+		size_t GetPrimitiveCount() const;
+		size_t GetNodeCount() const;
+
+	private:
+		struct Node
+		{
+			unify::BBox< float > bounds;
+
+			// A leaf holds count primitives from first in m_order; otherwise first is the left child, and the
+			// right child follows it.
+			uint32_t first;
+			uint32_t count;
+		};
+
+		struct Primitive
+		{
+			size_t object;
+
+			// The triangle's corners, or NoTriangle for a shape.
+			size_t triangle;
+			unify::V3< float > corners[3];
+		};
+
+		struct Object
+		{
+			IShapeQuery::ptr query;
+			size_t firstPrimitive;
+			std::vector< me::render::Index32 > indices;
+		};
+
+		unify::BBox< float > GetPrimitiveBounds( const Primitive & primitive ) const;
+		bool IntersectPrimitive( const Primitive & primitive, const unify::V3< float > & origin, const unify::V3< float > & direction, RayHit & hit ) const;
+		void BuildNode( uint32_t node, uint32_t begin, uint32_t end, unsigned int depth, const std::vector< unify::BBox< float > > & bounds, const std::vector< unify::V3< float > > & centers, std::atomic< uint32_t > & nodeCount );
+
+		std::vector< Object > m_objects;
+		std::vector< Primitive > m_primitives;
+		std::vector< uint32_t > m_order;
+		std::vector< Node > m_nodes;
+	};
+}
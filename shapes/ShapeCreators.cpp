@@ -0,0 +1,61 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/ShapeCreators.h>
+#include <shapes/PackedShapeCreator.h>
+#include <shapes/ShapeStats.h>
+#include <shapes/BeveledBox.h>
+#include <shapes/Circle.h>
+#include <shapes/Cone.h>
+#include <shapes/Box.h>
+#include <shapes/Cylinder.h>
+#include <shapes/DashRing.h>
+#include <shapes/Heightfield.h>
+#include <shapes/Plane.h>
+#include <shapes/PointField.h>
+#include <shapes/PointRing.h>
+#include <shapes/Pyramid.h>
+#include <shapes/Sphere.h>
+#include <shapes/Tube.h>
+
+using namespace me;
+using namespace shapes;
+
+namespace
+{
+	void Deleter( me::sculpter::IShapeCreator * creator )
+	{
+		delete creator;
+	}
+}
+
+void shapes::AddShapeCreators( me::sculpter::SculpterFactory & shapeFactory, ShapePack::ptr pack, ShapeStats::ptr stats )
+{
+	auto add = [&]( std::string name, me::sculpter::IShapeCreator * creator )
+	{
+		me::sculpter::IShapeCreator::ptr shapeCreator( creator, Deleter );
+		if( pack )
+		{
+			shapeCreator = me::sculpter::IShapeCreator::ptr( new PackedShapeCreator( pack, std::move( shapeCreator ) ), Deleter );
+		}
+		if( stats )
+		{
+			shapeCreator = me::sculpter::IShapeCreator::ptr( new StatsShapeCreator( stats, name, std::move( shapeCreator ) ), Deleter );
+		}
+		shapeFactory.AddShapeCreator( name, std::move( shapeCreator ) );
+	};
+
+	add( "box", new shapes::Box() );
+	add( "beveledbox", new shapes::BeveledBox() );
+	add( "Circle", new shapes::Circle() );
+	add( "Cone", new shapes::Cone() );
+	add( "Cylinder", new shapes::Cylinder() );
+	add( "DashRing", new shapes::DashRing() );
+	add( "Heightfield", new shapes::Heightfield() );
+	add( "Plane", new shapes::Plane() );
+	add( "PointField", new shapes::PointField() );
+	add( "PointRing", new shapes::PointRing() );
+	add( "Pyramid", new shapes::Pyramid() );
+	add( "Sphere", new shapes::Sphere() );
+	add( "Tube", new shapes::Tube() );
+}
@@ -0,0 +1,16 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <me/sculpter/SculpterFactory.h>
+#include <shapes/ShapePack.h>
+#include <shapes/ShapeStats.h>
+
+namespace shapes
+{
+	/// <summary>
+	/// Adds every shape creator to the factory. When a pack is given, each creator first looks for its
+	/// request in the pack. When stats are given, each creator is timed and counted under its shape type.
+	/// </summary>
+	void AddShapeCreators( me::sculpter::SculpterFactory & shapeFactory, ShapePack::ptr pack, ShapeStats::ptr stats );
+}
@@ -0,0 +1,52 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/ShapeDesc.h>
+#include <me/exception/FailedToCreate.h>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+const std::string DefaultBufferUsage = "Default";
+
+ShapeDesc::ShapeDesc()
+	: bufferUsage{ BufferUsage::FromString( DefaultBufferUsage ) }
+	, diffuse{ unify::ColorWhite() }
+	, specular{ unify::ColorWhite() }
+	, center{ 0, 0, 0 }
+	, canonical{ false }
+	, collision{ false }
+{
+}
+
+ShapeDesc::ShapeDesc( const unify::Parameters & parameters )
+	: effect{ parameters.Get( "effect", Effect::ptr() ) }
+	, vertexDeclaration{ parameters.Get( "vertexdeclaration", VertexDeclaration::ptr() ) }
+	, bufferUsage{ BufferUsage::FromString( parameters.Get( "bufferusage", DefaultBufferUsage ) ) }
+	, diffuse{ parameters.Get( "diffuse", unify::ColorWhite() ) }
+	, specular{ parameters.Get( "specular", unify::ColorWhite() ) }
+	, center{ parameters.Get( "center", unify::V3< float >( 0, 0, 0 ) ) }
+	, canonical{ false }
+	, collision{ parameters.Get( "collision", false ) }
+{
+	// Shapes made from parameters, by .me_shape files and the sculpter factory, have no caller to hand the
+	// size and center back to, or to share the unit shape with.
+	if( parameters.Get( "canonical", false ) )
+	{
+		throw me::exception::FailedToCreate( "\"canonical\" is not supported from parameters, set ShapeDesc::canonical and call the creator's typed Create with a ShapeTransform current!" );
+	}
+}
+
+VertexDeclaration::ptr ShapeDesc::GetVertexDeclaration() const
+{
+	if( vertexDeclaration )
+	{
+		return vertexDeclaration;
+	}
+	if( !effect )
+	{
+		throw me::exception::FailedToCreate( "Shape needs an \"effect\" or a \"vertexdeclaration\"!" );
+	}
+	return effect->GetVertexShader()->GetVertexDeclaration();
+}
@@ -0,0 +1,45 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <me/render/Effect.h>
+#include <me/render/BufferUsage.h>
+#include <unify/Parameters.h>
+#include <unify/Color.h>
+#include <unify/V3.h>
+
+namespace shapes
+{
+	/// <summary>
+	/// Members shared by every shape descriptor. A descriptor is the typed form of the parameters a creator
+	/// takes; constructing one from unify::Parameters reads each parameter once, with the same defaults.
+	/// </summary>
+	struct ShapeDesc
+	{
+		ShapeDesc();
+		ShapeDesc( const unify::Parameters & parameters );
+
+		/// <summary>
+		/// Returns vertexDeclaration if set, otherwise the effect's.
+		/// </summary>
+		me::render::VertexDeclaration::ptr GetVertexDeclaration() const;
+
+		me::render::Effect::ptr effect;
+
+		// The layout to write vertices in, from "vertexdeclaration". Without one the effect's vertex shader
+		// decides, so shapes can be captured headless, with no renderer to build effects, given only a layout.
+		me::render::VertexDeclaration::ptr vertexDeclaration;
+
+		me::render::BufferUsage::TYPE bufferUsage;
+		unify::Color diffuse;
+		unify::Color specular;
+		unify::V3< float > center;
+
+		// Build unit sized and centered on the origin, reporting size and center through ShapeTransform. Only
+		// through the typed Create; descriptors made from parameters reject "canonical".
+		bool canonical;
+
+		// Also write a collision proxy to the current CollisionTable, from creators that have one.
+		bool collision;
+	};
+}
@@ -0,0 +1,420 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/ShapeKernels.h>
+#include <algorithm>
+#include <cmath>
+
+#if defined( SHAPES_KERNELS_SSE2 )
+#include <emmintrin.h>
+#elif defined( SHAPES_KERNELS_NEON )
+#include <arm_neon.h>
+#endif
+
+using namespace shapes;
+using namespace kernels;
+
+static_assert( sizeof( unify::V3< float > ) == sizeof( float ) * 3, "The kernels treat V3 arrays as packed floats." );
+
+namespace
+{
+	// A rotated sine/cosine drifts by a few ulps per step, so each block restarts from exact values.
+	const size_t SinCosBlock = 64;
+
+	void NormalizeScalar( const unify::V3< float > & in, unify::V3< float > & out )
+	{
+		float lengthSquared = in.x * in.x + in.y * in.y + in.z * in.z;
+		float scale = lengthSquared > 0.0f ? 1.0f / sqrtf( lengthSquared ) : 0.0f;
+		out = unify::V3< float >( in.x * scale, in.y * scale, in.z * scale );
+	}
+
+	void TransformScalar( const Affine & affine, const unify::V3< float > & in, unify::V3< float > & out )
+	{
+		const float ( &m )[3][4] = affine.m;
+		out = unify::V3< float >(
+			m[0][0] * in.x + m[0][1] * in.y + m[0][2] * in.z + m[0][3],
+			m[1][0] * in.x + m[1][1] * in.y + m[1][2] * in.z + m[1][3],
+			m[2][0] * in.x + m[2][1] * in.y + m[2][2] * in.z + m[2][3] );
+	}
+
+#if defined( SHAPES_KERNELS_SSE2 )
+	// Four packed V3 (x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3) to and from one register per axis.
+	inline void Load4( const float * p, __m128 & x, __m128 & y, __m128 & z )
+	{
+		__m128 a = _mm_loadu_ps( p );
+		__m128 b = _mm_loadu_ps( p + 4 );
+		__m128 c = _mm_loadu_ps( p + 8 );
+		x = _mm_shuffle_ps( a, _mm_shuffle_ps( b, c, _MM_SHUFFLE( 1, 0, 3, 2 ) ), _MM_SHUFFLE( 3, 0, 3, 0 ) );
+		y = _mm_shuffle_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 0, 0, 1, 1 ) ), _mm_shuffle_ps( b, c, _MM_SHUFFLE( 2, 2, 3, 3 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) );
+		z = _mm_shuffle_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 1, 1, 2, 2 ) ), _mm_shuffle_ps( c, c, _MM_SHUFFLE( 3, 3, 0, 0 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) );
+	}
+
+	inline void Store4( float * p, __m128 x, __m128 y, __m128 z )
+	{
+		__m128 a = _mm_shuffle_ps( _mm_shuffle_ps( x, y, _MM_SHUFFLE( 0, 0, 0, 0 ) ), _mm_shuffle_ps( z, x, _MM_SHUFFLE( 1, 1, 0, 0 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) );
+		__m128 b = _mm_shuffle_ps( _mm_shuffle_ps( y, z, _MM_SHUFFLE( 1, 1, 1, 1 ) ), _mm_shuffle_ps( x, y, _MM_SHUFFLE( 2, 2, 2, 2 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) );
+		__m128 c = _mm_shuffle_ps( _mm_shuffle_ps( z, x, _MM_SHUFFLE( 3, 3, 2, 2 ) ), _mm_shuffle_ps( y, z, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) );
+		_mm_storeu_ps( p, a );
+		_mm_storeu_ps( p + 4, b );
+		_mm_storeu_ps( p + 8, c );
+	}
+
+	inline float HorizontalMin( __m128 v )
+	{
+		v = _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+		v = _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+		return _mm_cvtss_f32( v );
+	}
+
+	inline float HorizontalMax( __m128 v )
+	{
+		v = _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+		v = _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+		return _mm_cvtss_f32( v );
+	}
+#endif
+}
+
+Affine Affine::Identity()
+{
+	return ScaleTranslation( unify::V3< float >( 1, 1, 1 ), unify::V3< float >( 0, 0, 0 ) );
+}
+
+Affine Affine::Translation( const unify::V3< float > & translation )
+{
+	return ScaleTranslation( unify::V3< float >( 1, 1, 1 ), translation );
+}
+
+Affine Affine::ScaleTranslation( const unify::V3< float > & scale, const unify::V3< float > & translation )
+{
+	Affine affine =
+	{
+		{
+			{ scale.x, 0, 0, translation.x },
+			{ 0, scale.y, 0, translation.y },
+			{ 0, 0, scale.z, translation.z }
+		}
+	};
+	return affine;
+}
+
+const char * kernels::GetInstructionSet()
+{
+#if defined( SHAPES_KERNELS_SSE2 )
+	return "SSE2";
+#elif defined( SHAPES_KERNELS_NEON )
+	return "NEON";
+#else
+	return "Scalar";
+#endif
+}
+
+void kernels::SinCos( float start, float step, size_t count, float * sines, float * cosines )
+{
+	size_t i = 0;
+
+#if defined( SHAPES_KERNELS_SSE2 ) || defined( SHAPES_KERNELS_NEON )
+	// Each block starts from four exact lanes, then every lane is rotated by four steps at a time.
+	const float stepSin = sinf( step * 4.0f );
+	const float stepCos = cosf( step * 4.0f );
+	while( i + 4 <= count )
+	{
+		alignas( 16 ) float s[4];
+		alignas( 16 ) float c[4];
+		for( size_t lane = 0; lane < 4; ++lane )
+		{
+			float angle = start + step * (float)( i + lane );
+			s[lane] = sinf( angle );
+			c[lane] = cosf( angle );
+		}
+
+		const size_t blockEnd = std::min( count, i + SinCosBlock );
+#if defined( SHAPES_KERNELS_SSE2 )
+		__m128 vs = _mm_load_ps( s );
+		__m128 vc = _mm_load_ps( c );
+		const __m128 ds = _mm_set1_ps( stepSin );
+		const __m128 dc = _mm_set1_ps( stepCos );
+		for( ; i + 4 <= blockEnd; i += 4 )
+		{
+			_mm_storeu_ps( sines + i, vs );
+			_mm_storeu_ps( cosines + i, vc );
+			__m128 ns = _mm_add_ps( _mm_mul_ps( vs, dc ), _mm_mul_ps( vc, ds ) );
+			vc = _mm_sub_ps( _mm_mul_ps( vc, dc ), _mm_mul_ps( vs, ds ) );
+			vs = ns;
+		}
+#else
+		float32x4_t vs = vld1q_f32( s );
+		float32x4_t vc = vld1q_f32( c );
+		for( ; i + 4 <= blockEnd; i += 4 )
+		{
+			vst1q_f32( sines + i, vs );
+			vst1q_f32( cosines + i, vc );
+			float32x4_t ns = vmlaq_n_f32( vmulq_n_f32( vs, stepCos ), vc, stepSin );
+			vc = vmlsq_n_f32( vmulq_n_f32( vc, stepCos ), vs, stepSin );
+			vs = ns;
+		}
+#endif
+	}
+#endif
+
+	for( ; i < count; ++i )
+	{
+		float angle = start + step * (float)i;
+		sines[i] = sinf( angle );
+		cosines[i] = cosf( angle );
+	}
+}
+
+void kernels::Normalize( const unify::V3< float > * in, unify::V3< float > * out, size_t count )
+{
+	size_t i = 0;
+
+#if defined( SHAPES_KERNELS_SSE2 )
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 half = _mm_set1_ps( 0.5f );
+	const __m128 threeHalves = _mm_set1_ps( 1.5f );
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128 x, y, z;
+		Load4( &in[i].x, x, y, z );
+		__m128 lengthSquared = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+
+		// r = r * (1.5 - 0.5 * l * r * r)
+		__m128 r = _mm_rsqrt_ps( lengthSquared );
+		r = _mm_mul_ps( r, _mm_sub_ps( threeHalves, _mm_mul_ps( _mm_mul_ps( half, lengthSquared ), _mm_mul_ps( r, r ) ) ) );
+		r = _mm_and_ps( r, _mm_cmpgt_ps( lengthSquared, zero ) );
+
+		Store4( &out[i].x, _mm_mul_ps( x, r ), _mm_mul_ps( y, r ), _mm_mul_ps( z, r ) );
+	}
+#elif defined( SHAPES_KERNELS_NEON )
+	for( ; i + 4 <= count; i += 4 )
+	{
+		float32x4x3_t v = vld3q_f32( &in[i].x );
+		float32x4_t lengthSquared = vmlaq_f32( vmlaq_f32( vmulq_f32( v.val[0], v.val[0] ), v.val[1], v.val[1] ), v.val[2], v.val[2] );
+
+		// vrsqrtsq_f32 computes (3 - a * b) / 2, the Newton-Raphson step.
+		float32x4_t r = vrsqrteq_f32( lengthSquared );
+		r = vmulq_f32( r, vrsqrtsq_f32( vmulq_f32( lengthSquared, r ), r ) );
+		uint32x4_t nonZero = vcgtq_f32( lengthSquared, vdupq_n_f32( 0.0f ) );
+		r = vreinterpretq_f32_u32( vandq_u32( vreinterpretq_u32_f32( r ), nonZero ) );
+
+		v.val[0] = vmulq_f32( v.val[0], r );
+		v.val[1] = vmulq_f32( v.val[1], r );
+		v.val[2] = vmulq_f32( v.val[2], r );
+		vst3q_f32( &out[i].x, v );
+	}
+#endif
+
+	for( ; i < count; ++i )
+	{
+		NormalizeScalar( in[i], out[i] );
+	}
+}
+
+void kernels::Lengths( const unify::V3< float > * in, float * lengths, size_t count )
+{
+	size_t i = 0;
+
+#if defined( SHAPES_KERNELS_SSE2 )
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128 x, y, z;
+		Load4( &in[i].x, x, y, z );
+		__m128 lengthSquared = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+		_mm_storeu_ps( &lengths[i], _mm_sqrt_ps( lengthSquared ) );
+	}
+#elif defined( SHAPES_KERNELS_NEON )
+	for( ; i + 4 <= count; i += 4 )
+	{
+		float32x4x3_t v = vld3q_f32( &in[i].x );
+		float32x4_t lengthSquared = vmlaq_f32( vmlaq_f32( vmulq_f32( v.val[0], v.val[0] ), v.val[1], v.val[1] ), v.val[2], v.val[2] );
+
+		// l = l^2 / sqrt( l^2 ), with two Newton-Raphson steps on the estimate, as not every NEON has vsqrtq_f32.
+		float32x4_t r = vrsqrteq_f32( lengthSquared );
+		r = vmulq_f32( r, vrsqrtsq_f32( vmulq_f32( lengthSquared, r ), r ) );
+		r = vmulq_f32( r, vrsqrtsq_f32( vmulq_f32( lengthSquared, r ), r ) );
+		uint32x4_t nonZero = vcgtq_f32( lengthSquared, vdupq_n_f32( 0.0f ) );
+		float32x4_t length = vmulq_f32( lengthSquared, r );
+		vst1q_f32( &lengths[i], vreinterpretq_f32_u32( vandq_u32( vreinterpretq_u32_f32( length ), nonZero ) ) );
+	}
+#endif
+
+	for( ; i < count; ++i )
+	{
+		lengths[i] = in[i].Length();
+	}
+}
+
+void kernels::Transform( const Affine & affine, const unify::V3< float > * in, unify::V3< float > * out, size_t count )
+{
+	size_t i = 0;
+
+#if defined( SHAPES_KERNELS_SSE2 )
+	const float ( &m )[3][4] = affine.m;
+	__m128 rows[3][4];
+	for( int r = 0; r < 3; ++r )
+	{
+		for( int c = 0; c < 4; ++c )
+		{
+			rows[r][c] = _mm_set1_ps( m[r][c] );
+		}
+	}
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128 x, y, z;
+		Load4( &in[i].x, x, y, z );
+		__m128 result[3];
+		for( int r = 0; r < 3; ++r )
+		{
+			result[r] = _mm_add_ps(
+				_mm_add_ps( _mm_mul_ps( rows[r][0], x ), _mm_mul_ps( rows[r][1], y ) ),
+				_mm_add_ps( _mm_mul_ps( rows[r][2], z ), rows[r][3] ) );
+		}
+		Store4( &out[i].x, result[0], result[1], result[2] );
+	}
+#elif defined( SHAPES_KERNELS_NEON )
+	const float ( &m )[3][4] = affine.m;
+	for( ; i + 4 <= count; i += 4 )
+	{
+		float32x4x3_t v = vld3q_f32( &in[i].x );
+		float32x4x3_t result;
+		for( int r = 0; r < 3; ++r )
+		{
+			float32x4_t sum = vdupq_n_f32( m[r][3] );
+			sum = vmlaq_n_f32( sum, v.val[0], m[r][0] );
+			sum = vmlaq_n_f32( sum, v.val[1], m[r][1] );
+			result.val[r] = vmlaq_n_f32( sum, v.val[2], m[r][2] );
+		}
+		vst3q_f32( &out[i].x, result );
+	}
+#endif
+
+	for( ; i < count; ++i )
+	{
+		TransformScalar( affine, in[i], out[i] );
+	}
+}
+
+void kernels::Bounds( const unify::V3< float > * positions, size_t count, unify::BBox< float > & bbox )
+{
+	if( count == 0 )
+	{
+		return;
+	}
+
+	unify::V3< float > inf = positions[0];
+	unify::V3< float > sup = positions[0];
+	size_t i = 0;
+
+#if defined( SHAPES_KERNELS_SSE2 )
+	if( count >= 4 )
+	{
+		__m128 minX, minY, minZ;
+		Load4( &positions[0].x, minX, minY, minZ );
+		__m128 maxX = minX, maxY = minY, maxZ = minZ;
+		for( i = 4; i + 4 <= count; i += 4 )
+		{
+			__m128 x, y, z;
+			Load4( &positions[i].x, x, y, z );
+			minX = _mm_min_ps( minX, x );
+			minY = _mm_min_ps( minY, y );
+			minZ = _mm_min_ps( minZ, z );
+			maxX = _mm_max_ps( maxX, x );
+			maxY = _mm_max_ps( maxY, y );
+			maxZ = _mm_max_ps( maxZ, z );
+		}
+		inf = unify::V3< float >( HorizontalMin( minX ), HorizontalMin( minY ), HorizontalMin( minZ ) );
+		sup = unify::V3< float >( HorizontalMax( maxX ), HorizontalMax( maxY ), HorizontalMax( maxZ ) );
+	}
+#elif defined( SHAPES_KERNELS_NEON )
+	if( count >= 4 )
+	{
+		float32x4x3_t first = vld3q_f32( &positions[0].x );
+		float32x4x3_t low = first;
+		float32x4x3_t high = first;
+		for( i = 4; i + 4 <= count; i += 4 )
+		{
+			float32x4x3_t v = vld3q_f32( &positions[i].x );
+			for( int axis = 0; axis < 3; ++axis )
+			{
+				low.val[axis] = vminq_f32( low.val[axis], v.val[axis] );
+				high.val[axis] = vmaxq_f32( high.val[axis], v.val[axis] );
+			}
+		}
+		float lows[3], highs[3];
+		for( int axis = 0; axis < 3; ++axis )
+		{
+			float32x2_t l = vpmin_f32( vget_low_f32( low.val[axis] ), vget_high_f32( low.val[axis] ) );
+			float32x2_t h = vpmax_f32( vget_low_f32( high.val[axis] ), vget_high_f32( high.val[axis] ) );
+			lows[axis] = vget_lane_f32( vpmin_f32( l, l ), 0 );
+			highs[axis] = vget_lane_f32( vpmax_f32( h, h ), 0 );
+		}
+		inf = unify::V3< float >( lows[0], lows[1], lows[2] );
+		sup = unify::V3< float >( highs[0], highs[1], highs[2] );
+	}
+#endif
+
+	for( ; i < count; ++i )
+	{
+		const unify::V3< float > & p = positions[i];
+		inf = unify::V3< float >( std::min( inf.x, p.x ), std::min( inf.y, p.y ), std::min( inf.z, p.z ) );
+		sup = unify::V3< float >( std::max( sup.x, p.x ), std::max( sup.y, p.y ), std::max( sup.z, p.z ) );
+	}
+
+	bbox += inf;
+	bbox += sup;
+}
+
+void kernels::HeightNormals( const float * heights, size_t stride, size_t columns, size_t rows, float spacingX, float spacingZ, unify::V3< float > * normals )
+{
+	// n = ( ( left - right ) / 2 spacingX, 1, ( back - front ) / 2 spacingZ ), normalized.
+	const float scaleX = 0.5f / spacingX;
+	const float scaleZ = 0.5f / spacingZ;
+	for( size_t r = 0; r < rows; ++r )
+	{
+		const float * back = heights + r * stride + 1;
+		const float * row = heights + ( r + 1 ) * stride;
+		const float * front = heights + ( r + 2 ) * stride + 1;
+		unify::V3< float > * out = normals + r * columns;
+		size_t c = 0;
+
+#if defined( SHAPES_KERNELS_SSE2 )
+		const __m128 kx = _mm_set1_ps( scaleX );
+		const __m128 kz = _mm_set1_ps( scaleZ );
+		const __m128 one = _mm_set1_ps( 1.0f );
+		const __m128 half = _mm_set1_ps( 0.5f );
+		const __m128 threeHalves = _mm_set1_ps( 1.5f );
+		for( ; c + 4 <= columns; c += 4 )
+		{
+			__m128 x = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( row + c ), _mm_loadu_ps( row + c + 2 ) ), kx );
+			__m128 z = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( back + c ), _mm_loadu_ps( front + c ) ), kz );
+			__m128 lengthSquared = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), one ), _mm_mul_ps( z, z ) );
+			__m128 s = _mm_rsqrt_ps( lengthSquared );
+			s = _mm_mul_ps( s, _mm_sub_ps( threeHalves, _mm_mul_ps( _mm_mul_ps( half, lengthSquared ), _mm_mul_ps( s, s ) ) ) );
+			Store4( &out[c].x, _mm_mul_ps( x, s ), s, _mm_mul_ps( z, s ) );
+		}
+#elif defined( SHAPES_KERNELS_NEON )
+		const float32x4_t kx = vdupq_n_f32( scaleX );
+		const float32x4_t kz = vdupq_n_f32( scaleZ );
+		const float32x4_t one = vdupq_n_f32( 1.0f );
+		for( ; c + 4 <= columns; c += 4 )
+		{
+			float32x4_t x = vmulq_f32( vsubq_f32( vld1q_f32( row + c ), vld1q_f32( row + c + 2 ) ), kx );
+			float32x4_t z = vmulq_f32( vsubq_f32( vld1q_f32( back + c ), vld1q_f32( front + c ) ), kz );
+			float32x4_t lengthSquared = vmlaq_f32( vmlaq_f32( one, x, x ), z, z );
+			float32x4_t s = vrsqrteq_f32( lengthSquared );
+			s = vmulq_f32( s, vrsqrtsq_f32( vmulq_f32( lengthSquared, s ), s ) );
+			float32x4x3_t v;
+			v.val[0] = vmulq_f32( x, s );
+			v.val[1] = s;
+			v.val[2] = vmulq_f32( z, s );
+			vst3q_f32( &out[c].x, v );
+		}
+#endif
+
+		for( ; c < columns; ++c )
+		{
+			NormalizeScalar( unify::V3< float >( ( row[c] - row[c + 2] ) * scaleX, 1.0f, ( back[c] - front[c] ) * scaleZ ), out[c] );
+		}
+	}
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <unify/V3.h>
+#include <unify/BBox.h>
+#include <cstddef>
+
+// The instruction set is chosen at compile time. Define SHAPES_KERNELS_SCALAR to force the portable fallback.
+#if !defined( SHAPES_KERNELS_SCALAR )
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define SHAPES_KERNELS_SSE2
+#elif defined( __ARM_NEON ) || defined( _M_ARM64 )
+#define SHAPES_KERNELS_NEON
+#endif
+#endif
+
+namespace shapes
+{
+	/// <summary>
+	/// Batched math used by the shape generators. Each kernel processes whole arrays four lanes at a time, with
+	/// a scalar tail, so the generators compute positions and normals in bulk before writing vertices.
+	/// </summary>
+	namespace kernels
+	{
+		/// <summary>
+		/// A 3x4 affine transform, applied as out = m[r][0] * x + m[r][1] * y + m[r][2] * z + m[r][3] for each row r.
+		/// </summary>
+		struct Affine
+		{
+			float m[3][4];
+
+			static Affine Identity();
+			static Affine Translation( const unify::V3< float > & translation );
+			static Affine ScaleTranslation( const unify::V3< float > & scale, const unify::V3< float > & translation );
+		};
+
+		/// <summary>
+		/// The name of the instruction set the kernels were built for: "SSE2", "NEON" or "Scalar".
+		/// </summary>
+		const char * GetInstructionSet();
+
+		/// <summary>
+		/// sines[i] and cosines[i] of start + step * i, for i in [0, count).
+		/// </summary>
+		void SinCos( float start, float step, size_t count, float * sines, float * cosines );
+
+		/// <summary>
+		/// Normalizes "in" into "out" (which may be the same array), using a reciprocal square root estimate refined
+		/// by one Newton-Raphson step. Zero length vectors stay zero.
+		/// </summary>
+		void Normalize( const unify::V3< float > * in, unify::V3< float > * out, size_t count );
+
+		/// <summary>
+		/// The length of each vector in "in".
+		/// </summary>
+		void Lengths( const unify::V3< float > * in, float * lengths, size_t count );
+
+		/// <summary>
+		/// Transforms positions from "in" into "out" (which may be the same array).
+		/// </summary>
+		void Transform( const Affine & affine, const unify::V3< float > * in, unify::V3< float > * out, size_t count );
+
+		/// <summary>
+		/// Grows bbox to contain every position.
+		/// </summary>
+		void Bounds( const unify::V3< float > * positions, size_t count, unify::BBox< float > & bbox );
+
+		/// <summary>
+		/// The normals of a height grid, y = height, from central differences. heights holds ( columns + 2 ) by
+		/// ( rows + 2 ) samples, stride apart, with a border of one sample all around; normals receives columns by
+		/// rows normals, one for each sample inside the border. spacingX and spacingZ are the distances between
+		/// samples.
+		/// </summary>
+		void HeightNormals( const float * heights, size_t stride, size_t columns, size_t rows, float spacingX, float spacingZ, unify::V3< float > * normals );
+	}
+}
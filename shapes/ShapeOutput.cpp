@@ -0,0 +1,272 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapeStats.h>
+#include <shapes/BufferPool.h>
+#include <shapes/DepthStream.h>
+#include <me/exception/FailedToCreate.h>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+RecordedBufferSet::RecordedBufferSet()
+	: vertexStride{ 0 }
+	, vertexCount{ 0 }
+	, vertexUsage{ BufferUsage::Default }
+	, indexUsage{ BufferUsage::Default }
+{
+}
+
+ShapeRecorder::ShapeRecorder( Mode mode )
+	: m_mode{ mode }
+{
+}
+
+ShapeRecorder::Mode ShapeRecorder::GetMode() const
+{
+	return m_mode;
+}
+
+void ShapeRecorder::RecordVertexBuffer( const BufferSet & set, const VertexBufferParameters & parameters )
+{
+	if( parameters.countAndSource.size() != 1 )
+	{
+		throw me::exception::FailedToCreate( "ShapeRecorder records per-vertex data only, instanced shapes can't be recorded or baked!" );
+	}
+
+	RecordedBufferSet & recorded = Get( set );
+
+	const auto & source = parameters.countAndSource[0];
+	recorded.vertexDeclaration = parameters.vertexDeclaration;
+	recorded.vertexStride = (unsigned int)parameters.vertexDeclaration->GetSizeInBytes( 0 );
+	recorded.vertexCount = (unsigned int)source.count;
+	recorded.vertexUsage = parameters.usage;
+	recorded.bbox = parameters.bbox;
+
+	const unsigned char * bytes = (const unsigned char *)source.source;
+	recorded.vertices.assign( bytes, bytes + recorded.vertexStride * recorded.vertexCount );
+}
+
+void ShapeRecorder::RecordIndexBuffer( const BufferSet & set, const IndexBufferParameters & parameters )
+{
+	RecordedBufferSet & recorded = Get( set );
+
+	const auto & source = parameters.countAndSource[0];
+	const Index32 * indices = (const Index32 *)source.source;
+	recorded.indices.assign( indices, indices + source.count );
+	recorded.indexUsage = parameters.usage;
+}
+
+void ShapeRecorder::RecordMethod( const BufferSet & set, const RenderMethod & method )
+{
+	Get( set ).methods.push_back( method );
+}
+
+const std::vector< RecordedBufferSet > & ShapeRecorder::GetSets() const
+{
+	return m_sets;
+}
+
+size_t ShapeRecorder::GetVertexBytes() const
+{
+	size_t bytes = 0;
+	for( const auto & set : m_sets )
+	{
+		bytes += set.vertices.size();
+	}
+	return bytes;
+}
+
+size_t ShapeRecorder::GetIndexBytes() const
+{
+	size_t bytes = 0;
+	for( const auto & set : m_sets )
+	{
+		bytes += set.indices.size() * sizeof( Index32 );
+	}
+	return bytes;
+}
+
+size_t ShapeRecorder::GetDrawCount() const
+{
+	size_t draws = 0;
+	for( const auto & set : m_sets )
+	{
+		draws += set.methods.size();
+	}
+	return draws;
+}
+
+void ShapeRecorder::Clear()
+{
+	m_sets.clear();
+	m_index.clear();
+}
+
+ShapeRecorder * ShapeRecorder::Current()
+{
+	return CurrentScope< ShapeRecorder >::Get();
+}
+
+RecordedBufferSet & ShapeRecorder::Get( const BufferSet & set )
+{
+	auto itr = m_index.find( &set );
+	if( itr == m_index.end() )
+	{
+		itr = m_index.insert( { &set, m_sets.size() } ).first;
+		m_sets.push_back( RecordedBufferSet() );
+	}
+	return m_sets[itr->second];
+}
+
+namespace
+{
+	void AddVertices( BufferSet & set, const VertexBufferParameters & parameters, bool poolable )
+	{
+		ShapeRecorder * recorder = ShapeRecorder::Current();
+		if( recorder )
+		{
+			recorder->RecordVertexBuffer( set, parameters );
+		}
+		if( ShapeCounters * counters = ShapeCounters::Current() )
+		{
+			const auto & source = parameters.countAndSource[0];
+			counters->AddVertices( source.count, source.count * parameters.vertexDeclaration->GetSizeInBytes( 0 ) );
+		}
+
+		if( recorder && recorder->GetMode() == ShapeRecorder::Mode::Capture )
+		{
+			return;
+		}
+
+		if( DepthStream * depth = DepthStream::Current() )
+		{
+			depth->RecordVertexBuffer( set, parameters );
+		}
+
+		BufferPool * pool = poolable ? BufferPool::Current() : nullptr;
+		if( !pool || !pool->AddVertexBuffer( set, parameters ) )
+		{
+			set.AddVertexBuffer( parameters );
+		}
+	}
+}
+
+void shapes::AddVertexBuffer( BufferSet & set, const VertexBufferParameters & parameters )
+{
+	AddVertices( set, parameters, true );
+}
+
+void shapes::AddBoundedVertexBuffer( BufferSet & set, const VertexBufferParameters & parameters )
+{
+	AddVertices( set, parameters, false );
+}
+
+void shapes::AddIndexBuffer( BufferSet & set, const IndexBufferParameters & parameters )
+{
+	ShapeRecorder * recorder = ShapeRecorder::Current();
+	if( recorder )
+	{
+		recorder->RecordIndexBuffer( set, parameters );
+	}
+	if( ShapeCounters * counters = ShapeCounters::Current() )
+	{
+		const auto & source = parameters.countAndSource[0];
+		counters->AddIndices( source.count, source.count * sizeof( Index32 ) );
+	}
+
+	if( recorder && recorder->GetMode() == ShapeRecorder::Mode::Capture )
+	{
+		return;
+	}
+
+	IIndexBuffer::ptr buffer;
+	BufferPool * pool = BufferPool::Current();
+	if( !pool || !pool->AddIndexBuffer( set, parameters ) )
+	{
+		set.AddIndexBuffer( parameters );
+		buffer = set.GetIndexBuffer();
+	}
+
+	if( DepthStream * depth = DepthStream::Current() )
+	{
+		depth->RecordIndexBuffer( set, parameters, buffer );
+	}
+}
+
+void shapes::AddMethod( BufferSet & set, const RenderMethod & method )
+{
+	ShapeRecorder * recorder = ShapeRecorder::Current();
+	if( recorder )
+	{
+		recorder->RecordMethod( set, method );
+	}
+
+	if( recorder && recorder->GetMode() == ShapeRecorder::Mode::Capture )
+	{
+		return;
+	}
+
+	if( DepthStream * depth = DepthStream::Current() )
+	{
+		depth->RecordMethod( set, method );
+	}
+
+	BufferPool * pool = BufferPool::Current();
+	if( !pool || !pool->AddMethod( set, method ) )
+	{
+		set.AddMethod( method );
+	}
+}
+
+void shapes::AddSharedIndexBuffer( BufferSet & set, const IndexCache::Key & key, BufferUsage::TYPE usage, const IndexCache::Generator & generate )
+{
+	IndexCache & cache = IndexCache::Instance();
+	IndexCache::Indices indices = cache.GetIndices( key, generate );
+	IndexBufferParameters parameters{ { { indices->size(), indices->data() } }, usage };
+
+	const bool writable = usage == BufferUsage::Dynamic || usage == BufferUsage::Staging;
+	if( writable || ShapeRecorder::Current() || BufferPool::Current() )
+	{
+		AddIndexBuffer( set, parameters );
+		return;
+	}
+
+	// Only new buffers are counted, so the counters show the index memory actually used.
+	IIndexBuffer::ptr buffer = cache.GetBuffer( key, usage );
+	if( buffer )
+	{
+		set.AddIndexBuffer( buffer );
+		if( DepthStream * depth = DepthStream::Current() )
+		{
+			depth->RecordIndexBuffer( set, parameters, buffer );
+		}
+		return;
+	}
+
+	AddIndexBuffer( set, parameters );
+	cache.SetBuffer( key, usage, set.GetIndexBuffer() );
+}
+
+void shapes::AppendTriangleStrip( std::vector< Index32 > & indices, unsigned int firstVertex, unsigned int triangleCount )
+{
+	indices.reserve( indices.size() + triangleCount * 3 );
+	for( unsigned int t = 0; t < triangleCount; ++t )
+	{
+		unsigned int v = firstVertex + t;
+		if( ( t & 1 ) == 0 )
+		{
+			indices.push_back( v );
+			indices.push_back( v + 1 );
+			indices.push_back( v + 2 );
+		}
+		else
+		{
+			indices.push_back( v );
+			indices.push_back( v + 2 );
+			indices.push_back( v + 1 );
+		}
+	}
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <me/render/PrimitiveList.h>
+#include <me/render/BufferSet.h>
+#include <me/render/RenderMethod.h>
+#include <shapes/CurrentScope.h>
+#include <shapes/IndexCache.h>
+#include <unify/BBox.h>
+#include <vector>
+#include <map>
+
+namespace shapes
+{
+	/// <summary>
+	/// A CPU side copy of everything a creator handed to a single BufferSet.
+	/// </summary>
+	struct RecordedBufferSet
+	{
+		RecordedBufferSet();
+
+		me::render::VertexDeclaration::ptr vertexDeclaration;
+		unsigned int vertexStride;
+		unsigned int vertexCount;
+		std::vector< unsigned char > vertices;
+		me::render::BufferUsage::TYPE vertexUsage;
+		unify::BBox< float > bbox;
+
+		std::vector< me::render::Index32 > indices;
+		me::render::BufferUsage::TYPE indexUsage;
+
+		std::vector< me::render::RenderMethod > methods;
+	};
+
+	/// <summary>
+	/// Records the output of shape creators on the current thread, in the order BufferSets were first touched.
+	/// </summary>
+	class ShapeRecorder
+	{
+	public:
+		/// <summary>
+		/// Forward records and still hands everything to the BufferSet. Capture only records, so no buffer is
+		/// created and nothing reaches the renderer; creators can be run and timed headless.
+		/// </summary>
+		enum class Mode
+		{
+			Forward,
+			Capture
+		};
+
+		typedef CurrentScope< ShapeRecorder > Scope;
+
+		ShapeRecorder( Mode mode = Mode::Forward );
+
+		Mode GetMode() const;
+
+		void RecordVertexBuffer( const me::render::BufferSet & set, const me::render::VertexBufferParameters & parameters );
+		void RecordIndexBuffer( const me::render::BufferSet & set, const me::render::IndexBufferParameters & parameters );
+		void RecordMethod( const me::render::BufferSet & set, const me::render::RenderMethod & method );
+
+		const std::vector< RecordedBufferSet > & GetSets() const;
+
+		/// <summary>
+		/// Totals over everything recorded, as a renderer would have seen it.
+		/// </summary>
+		size_t GetVertexBytes() const;
+		size_t GetIndexBytes() const;
+		size_t GetDrawCount() const;
+
+		void Clear();
+
+		/// <summary>
+		/// Returns the recorder current for the calling thread, or nullptr.
+		/// </summary>
+		static ShapeRecorder * Current();
+
+	private:
+		RecordedBufferSet & Get( const me::render::BufferSet & set );
+
+		Mode m_mode;
+		std::vector< RecordedBufferSet > m_sets;
+		std::map< const me::render::BufferSet *, size_t > m_index;
+	};
+
+	/// Every creator hands its buffers and methods to its BufferSet through these, so the output of any
+	/// creator can be observed (baking, statistics, depth streams) or redirected (capture, pooling) without the
+	/// creators knowing about it.
+	void AddVertexBuffer( me::render::BufferSet & set, const me::render::VertexBufferParameters & parameters );
+	void AddIndexBuffer( me::render::BufferSet & set, const me::render::IndexBufferParameters & parameters );
+	void AddMethod( me::render::BufferSet & set, const me::render::RenderMethod & method );
+
+	/// <summary>
+	/// AddVertexBuffer for a BufferSet whose bounds must stay its own, such as one chunk of a point cloud
+	/// culled apart from the rest. A pool current would merge its bounds with every other shape's, so the set
+	/// keeps a vertex buffer of its own, and its indices go with it.
+	/// </summary>
+	void AddBoundedVertexBuffer( me::render::BufferSet & set, const me::render::VertexBufferParameters & parameters );
+
+	/// <summary>
+	/// Hands the BufferSet the index buffer cached for key, so shapes with the same topology share one buffer.
+	/// The indices are generated, and the buffer created, only when the cache has none. Dynamic and staging
+	/// buffers may be written to, so they are never shared. While a recorder or pool is current the indices go
+	/// through AddIndexBuffer as usual.
+	/// </summary>
+	void AddSharedIndexBuffer( me::render::BufferSet & set, const IndexCache::Key & key, me::render::BufferUsage::TYPE usage, const IndexCache::Generator & generate );
+
+	/// <summary>
+	/// Appends the triangles of a triangle strip starting at firstVertex as a triangle list, keeping the strip's
+	/// alternating winding. Used to merge a shape's strips and lists into a single indexed draw.
+	/// </summary>
+	void AppendTriangleStrip( std::vector< me::render::Index32 > & indices, unsigned int firstVertex, unsigned int triangleCount );
+}
@@ -0,0 +1,482 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/ShapePack.h>
+#include <me/exception/FailedToCreate.h>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <string_view>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+// Pack layout (little endian, every block 16 byte aligned):
+//   Header
+//   Entry[entryCount]    sorted by name
+//   Set[setCount]
+//   Method[methodCount]
+//   names, vertex data and index data, referenced by offsets from the start of the file.
+
+const unsigned int ShapePack::Version = 2;
+
+namespace
+{
+	const char Magic[4] = { 'M', 'E', 'S', 'P' };
+	const uint64_t Alignment = 16;
+
+	uint64_t Align( uint64_t offset )
+	{
+		return (offset + Alignment - 1) & ~(Alignment - 1);
+	}
+
+	const size_t LayoutElements = 5;
+
+	// The offset + 1 (0 when missing) and format of each common element in slot 0, so a set is only drawn
+	// with a declaration that places every element where it was baked.
+	void DescribeLayout( const VertexDeclaration & vd, uint32_t layout[LayoutElements * 2] )
+	{
+		const VertexElement elements[LayoutElements] =
+		{
+			CommonVertexElement::Position( 0 ),
+			CommonVertexElement::Normal( 0 ),
+			CommonVertexElement::Diffuse( 0 ),
+			CommonVertexElement::Specular( 0 ),
+			CommonVertexElement::TexCoords( 0 )
+		};
+
+		for( size_t e = 0; e < LayoutElements; ++e )
+		{
+			VertexElement found = elements[e];
+			bool present = vd.GetElement( elements[e], found ) && found.InputSlot == 0;
+			layout[e * 2] = present ? found.AlignedByteOffset + 1 : 0;
+			layout[e * 2 + 1] = present ? (uint32_t)found.Format : 0;
+		}
+	}
+
+	// The indices a method reads when it uses an index buffer, otherwise the vertices.
+	uint64_t ElementsUsed( uint32_t primitiveType, uint32_t primitiveCount )
+	{
+		if( primitiveCount == 0 )
+		{
+			return 0;
+		}
+
+		switch( primitiveType )
+		{
+		case PrimitiveType::PointList: return primitiveCount;
+		case PrimitiveType::LineList: return (uint64_t)primitiveCount * 2;
+		case PrimitiveType::LineStrip: return (uint64_t)primitiveCount + 1;
+		case PrimitiveType::TriangleList: return (uint64_t)primitiveCount * 3;
+		case PrimitiveType::TriangleStrip: return (uint64_t)primitiveCount + 2;
+		default: return UINT64_MAX;
+		}
+	}
+
+	// Whether count items of size bytes at offset lie within a file of fileSize bytes.
+	bool InFile( uint64_t offset, uint64_t count, uint64_t size, uint64_t fileSize )
+	{
+		return offset <= fileSize && ( size == 0 || count <= ( fileSize - offset ) / size );
+	}
+}
+
+struct ShapePack::Header
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t setCount;
+	uint32_t methodCount;
+	uint32_t reserved[3];
+	uint64_t entryOffset;
+	uint64_t setOffset;
+	uint64_t methodOffset;
+	uint64_t fileSize;
+};
+
+struct ShapePack::Entry
+{
+	uint64_t nameOffset;
+	uint32_t nameLength;
+	uint32_t firstSet;
+	uint32_t setCount;
+	uint32_t reserved;
+};
+
+struct ShapePack::Set
+{
+	uint32_t vertexStride;
+	uint32_t vertexCount;
+	uint32_t vertexUsage;
+	uint32_t indexCount;
+	uint32_t indexUsage;
+	uint32_t firstMethod;
+	uint32_t methodCount;
+	uint32_t reserved;
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	float bboxInf[3];
+	float bboxSup[3];
+	uint32_t layout[LayoutElements * 2];
+};
+
+struct ShapePack::Method
+{
+	uint32_t primitiveType;
+	int32_t baseVertexIndex;
+	uint32_t minIndex;
+	uint32_t vertexCount;
+	uint32_t startIndex;
+	uint32_t primitiveCount;
+	uint32_t useIB;
+	uint32_t reserved;
+};
+
+ShapePackWriter::ShapePackWriter()
+{
+}
+
+void ShapePackWriter::Add( const std::string & name, const std::vector< RecordedBufferSet > & sets )
+{
+	if( m_entries.find( name ) != m_entries.end() )
+	{
+		throw me::exception::FailedToCreate( "Shape \"" + name + "\" already added to shape pack!" );
+	}
+	m_entries[name] = sets;
+}
+
+size_t ShapePackWriter::GetCount() const
+{
+	return m_entries.size();
+}
+
+void ShapePackWriter::Save( const unify::Path & path ) const
+{
+	typedef ShapePack::Header Header;
+	typedef ShapePack::Entry Entry;
+	typedef ShapePack::Set Set;
+	typedef ShapePack::Method Method;
+
+	std::vector< Entry > entries;
+	std::vector< Set > sets;
+	std::vector< Method > methods;
+
+	for( auto & entry : m_entries )
+	{
+		Entry entryRecord{};
+		entryRecord.nameLength = (uint32_t)entry.first.length();
+		entryRecord.firstSet = (uint32_t)sets.size();
+		entryRecord.setCount = (uint32_t)entry.second.size();
+		entries.push_back( entryRecord );
+
+		for( auto & set : entry.second )
+		{
+			Set setRecord{};
+			setRecord.vertexStride = set.vertexStride;
+			setRecord.vertexCount = set.vertexCount;
+			setRecord.vertexUsage = (uint32_t)set.vertexUsage;
+			setRecord.indexCount = (uint32_t)set.indices.size();
+			setRecord.indexUsage = (uint32_t)set.indexUsage;
+			setRecord.firstMethod = (uint32_t)methods.size();
+			setRecord.methodCount = (uint32_t)set.methods.size();
+			setRecord.bboxInf[0] = set.bbox.inf.x;
+			setRecord.bboxInf[1] = set.bbox.inf.y;
+			setRecord.bboxInf[2] = set.bbox.inf.z;
+			setRecord.bboxSup[0] = set.bbox.sup.x;
+			setRecord.bboxSup[1] = set.bbox.sup.y;
+			setRecord.bboxSup[2] = set.bbox.sup.z;
+			if( set.vertexDeclaration )
+			{
+				DescribeLayout( *set.vertexDeclaration, setRecord.layout );
+			}
+			sets.push_back( setRecord );
+
+			for( auto & method : set.methods )
+			{
+				Method methodRecord{};
+				methodRecord.primitiveType = (uint32_t)method.primitiveType;
+				methodRecord.baseVertexIndex = (int32_t)method.baseVertexIndex;
+				methodRecord.minIndex = (uint32_t)method.minIndex;
+				methodRecord.vertexCount = (uint32_t)method.vertexCount;
+				methodRecord.startIndex = (uint32_t)method.startIndex;
+				methodRecord.primitiveCount = (uint32_t)method.primitiveCount;
+				methodRecord.useIB = method.useIB ? 1 : 0;
+				methods.push_back( methodRecord );
+			}
+		}
+	}
+
+	// Lay out the tables, then the variable sized data behind them.
+	Header header{};
+	std::memcpy( header.magic, Magic, sizeof( Magic ) );
+	header.version = ShapePack::Version;
+	header.entryCount = (uint32_t)entries.size();
+	header.setCount = (uint32_t)sets.size();
+	header.methodCount = (uint32_t)methods.size();
+	header.entryOffset = Align( sizeof( Header ) );
+	header.setOffset = Align( header.entryOffset + sizeof( Entry ) * entries.size() );
+	header.methodOffset = Align( header.setOffset + sizeof( Set ) * sets.size() );
+
+	uint64_t offset = Align( header.methodOffset + sizeof( Method ) * methods.size() );
+	{
+		size_t entryIndex = 0;
+		size_t setIndex = 0;
+		for( auto & entry : m_entries )
+		{
+			entries[entryIndex++].nameOffset = offset;
+			offset = Align( offset + entry.first.length() );
+
+			for( auto & set : entry.second )
+			{
+				sets[setIndex].vertexOffset = offset;
+				offset = Align( offset + set.vertices.size() );
+				sets[setIndex].indexOffset = offset;
+				offset = Align( offset + set.indices.size() * sizeof( Index32 ) );
+				++setIndex;
+			}
+		}
+	}
+	header.fileSize = offset;
+
+	std::ofstream stream( path.ToString(), std::ios::binary | std::ios::trunc );
+	if( !stream )
+	{
+		throw me::exception::FailedToCreate( "Failed to open shape pack \"" + path.ToString() + "\" for writing!" );
+	}
+
+	auto pad = [&]( uint64_t to )
+	{
+		static const char zeros[Alignment] = {};
+		uint64_t at = (uint64_t)stream.tellp();
+		stream.write( zeros, (std::streamsize)(to - at) );
+	};
+
+	stream.write( (const char *)&header, sizeof( Header ) );
+	pad( header.entryOffset );
+	stream.write( (const char *)entries.data(), (std::streamsize)(sizeof( Entry ) * entries.size()) );
+	pad( header.setOffset );
+	stream.write( (const char *)sets.data(), (std::streamsize)(sizeof( Set ) * sets.size()) );
+	pad( header.methodOffset );
+	stream.write( (const char *)methods.data(), (std::streamsize)(sizeof( Method ) * methods.size()) );
+
+	size_t setIndex = 0;
+	size_t entryIndex = 0;
+	for( auto & entry : m_entries )
+	{
+		pad( entries[entryIndex++].nameOffset );
+		stream.write( entry.first.data(), (std::streamsize)entry.first.length() );
+
+		for( auto & set : entry.second )
+		{
+			pad( sets[setIndex].vertexOffset );
+			stream.write( (const char *)set.vertices.data(), (std::streamsize)set.vertices.size() );
+			pad( sets[setIndex].indexOffset );
+			stream.write( (const char *)set.indices.data(), (std::streamsize)(set.indices.size() * sizeof( Index32 )) );
+			++setIndex;
+		}
+	}
+	pad( header.fileSize );
+
+	if( !stream )
+	{
+		throw me::exception::FailedToCreate( "Failed to write shape pack \"" + path.ToString() + "\"!" );
+	}
+}
+
+ShapePack::ShapePack( const unify::Path & path )
+	: m_file( path )
+{
+	static_assert( sizeof( Header ) % 16 == 0, "Shape pack header must keep 16 byte alignment." );
+	static_assert( sizeof( Entry ) % 8 == 0, "Shape pack entry must keep 8 byte alignment." );
+	static_assert( sizeof( Set ) % 8 == 0, "Shape pack set must keep 8 byte alignment." );
+	static_assert( sizeof( Method ) == 32, "Shape pack method size changed, bump ShapePack::Version." );
+
+	if( m_file.GetSize() < sizeof( Header ) )
+	{
+		throw me::exception::FailedToCreate( "Shape pack \"" + path.ToString() + "\" is truncated!" );
+	}
+
+	const Header & header = GetHeader();
+	if( std::memcmp( header.magic, Magic, sizeof( Magic ) ) != 0 )
+	{
+		throw me::exception::FailedToCreate( "\"" + path.ToString() + "\" is not a shape pack!" );
+	}
+
+	if( header.version != Version )
+	{
+		throw me::exception::FailedToCreate( "Shape pack \"" + path.ToString() + "\" is version " + std::to_string( header.version ) + ", expected version " + std::to_string( Version ) + "!" );
+	}
+
+	if( header.fileSize != m_file.GetSize() )
+	{
+		throw me::exception::FailedToCreate( "Shape pack \"" + path.ToString() + "\" size does not match its header!" );
+	}
+
+	// Check every offset and count once here, so Find and Produce can trust the mapping.
+	auto corrupt = [&]( const std::string & what )
+	{
+		return me::exception::FailedToCreate( "Shape pack \"" + path.ToString() + "\" is corrupt, " + what + " out of range!" );
+	};
+
+	const uint64_t fileSize = header.fileSize;
+	if( !InFile( header.entryOffset, header.entryCount, sizeof( Entry ), fileSize ) || header.entryOffset % 8 != 0 )
+	{
+		throw corrupt( "entries" );
+	}
+	if( !InFile( header.setOffset, header.setCount, sizeof( Set ), fileSize ) || header.setOffset % 8 != 0 )
+	{
+		throw corrupt( "sets" );
+	}
+	if( !InFile( header.methodOffset, header.methodCount, sizeof( Method ), fileSize ) || header.methodOffset % 8 != 0 )
+	{
+		throw corrupt( "methods" );
+	}
+
+	const unsigned char * data = m_file.GetData();
+	const Entry * entries = (const Entry *)(data + header.entryOffset);
+	const Set * sets = (const Set *)(data + header.setOffset);
+	const Method * methods = (const Method *)(data + header.methodOffset);
+
+	for( uint32_t e = 0; e < header.entryCount; ++e )
+	{
+		const Entry & entry = entries[e];
+		if( !InFile( entry.nameOffset, entry.nameLength, 1, fileSize ) )
+		{
+			throw corrupt( "entry " + std::to_string( e ) + " name" );
+		}
+		if( (uint64_t)entry.firstSet + entry.setCount > header.setCount )
+		{
+			throw corrupt( "entry " + std::to_string( e ) + " sets" );
+		}
+	}
+
+	for( uint32_t s = 0; s < header.setCount; ++s )
+	{
+		const Set & set = sets[s];
+		if( (uint64_t)set.firstMethod + set.methodCount > header.methodCount )
+		{
+			throw corrupt( "set " + std::to_string( s ) + " methods" );
+		}
+		if( set.vertexStride == 0 || !InFile( set.vertexOffset, set.vertexCount, set.vertexStride, fileSize ) )
+		{
+			throw corrupt( "set " + std::to_string( s ) + " vertices" );
+		}
+		if( !InFile( set.indexOffset, set.indexCount, sizeof( Index32 ), fileSize ) || set.indexOffset % sizeof( Index32 ) != 0 )
+		{
+			throw corrupt( "set " + std::to_string( s ) + " indices" );
+		}
+
+		for( uint32_t m = 0; m < set.methodCount; ++m )
+		{
+			const Method & method = methods[set.firstMethod + m];
+			uint64_t used = ElementsUsed( method.primitiveType, method.primitiveCount );
+			bool inRange = method.useIB != 0
+				? (uint64_t)method.startIndex + used <= set.indexCount
+				: method.baseVertexIndex >= 0 && (uint64_t)method.baseVertexIndex + used <= set.vertexCount;
+			if( !inRange )
+			{
+				throw corrupt( "set " + std::to_string( s ) + " method " + std::to_string( m ) );
+			}
+		}
+	}
+}
+
+const unify::Path & ShapePack::GetPath() const
+{
+	return m_file.GetPath();
+}
+
+size_t ShapePack::GetCount() const
+{
+	return GetHeader().entryCount;
+}
+
+bool ShapePack::Exists( const std::string & name ) const
+{
+	return Find( name ) != nullptr;
+}
+
+bool ShapePack::Produce( PrimitiveList & primitiveList, const std::string & name, Effect::ptr effect ) const
+{
+	const Entry * entry = Find( name );
+	if( entry == nullptr )
+	{
+		return false;
+	}
+
+	const unsigned char * data = m_file.GetData();
+	const Header & header = GetHeader();
+	const Set * sets = (const Set *)(data + header.setOffset) + entry->firstSet;
+	const Method * methods = (const Method *)(data + header.methodOffset);
+
+	VertexDeclaration::ptr vd = effect->GetVertexShader()->GetVertexDeclaration();
+
+	// Only serve the request if every set matches the layout it will be drawn with.
+	uint32_t layout[LayoutElements * 2];
+	DescribeLayout( *vd, layout );
+	for( uint32_t s = 0; s < entry->setCount; ++s )
+	{
+		if( sets[s].vertexStride != vd->GetSizeInBytes( 0 ) || std::memcmp( sets[s].layout, layout, sizeof( layout ) ) != 0 )
+		{
+			return false;
+		}
+	}
+
+	for( uint32_t s = 0; s < entry->setCount; ++s )
+	{
+		const Set & setRecord = sets[s];
+
+		BufferSet & set = primitiveList.AddBufferSet();
+		set.SetEffect( effect );
+
+		for( uint32_t m = 0; m < setRecord.methodCount; ++m )
+		{
+			const Method & method = methods[setRecord.firstMethod + m];
+			AddMethod( set, RenderMethod( (PrimitiveType::TYPE)method.primitiveType, method.baseVertexIndex, method.minIndex, method.vertexCount, method.startIndex, method.primitiveCount, method.useIB != 0 ) );
+		}
+
+		VertexBufferParameters vbParameters{ vd, { { setRecord.vertexCount, data + setRecord.vertexOffset } }, (BufferUsage::TYPE)setRecord.vertexUsage };
+		vbParameters.bbox = unify::BBox< float >(
+			unify::V3< float >( setRecord.bboxInf[0], setRecord.bboxInf[1], setRecord.bboxInf[2] ),
+			unify::V3< float >( setRecord.bboxSup[0], setRecord.bboxSup[1], setRecord.bboxSup[2] ) );
+		AddVertexBuffer( set, vbParameters );
+
+		if( setRecord.indexCount > 0 )
+		{
+			AddIndexBuffer( set, { { { setRecord.indexCount, (const Index32 *)(data + setRecord.indexOffset) } }, (BufferUsage::TYPE)setRecord.indexUsage } );
+		}
+	}
+
+	return true;
+}
+
+const ShapePack::Header & ShapePack::GetHeader() const
+{
+	return *(const Header *)m_file.GetData();
+}
+
+const ShapePack::Entry * ShapePack::Find( const std::string & name ) const
+{
+	const unsigned char * data = m_file.GetData();
+	const Header & header = GetHeader();
+	const Entry * first = (const Entry *)(data + header.entryOffset);
+	const Entry * last = first + header.entryCount;
+
+	auto nameOf = [&]( const Entry & entry )
+	{
+		return std::string_view( (const char *)(data + entry.nameOffset), entry.nameLength );
+	};
+
+	const Entry * found = std::lower_bound( first, last, std::string_view( name ), [&]( const Entry & entry, std::string_view value )
+	{
+		return nameOf( entry ) < value;
+	} );
+
+	if( found == last || nameOf( *found ) != name )
+	{
+		return nullptr;
+	}
+	return found;
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <shapes/ShapeOutput.h>
+#include <shapes/MappedFile.h>
+#include <me/render/Effect.h>
+#include <string>
+
+namespace shapes
+{
+	/// <summary>
+	/// Accumulates recorded shapes by name and writes them into a single versioned pack file.
+	/// </summary>
+	class ShapePackWriter
+	{
+	public:
+		ShapePackWriter();
+
+		void Add( const std::string & name, const std::vector< RecordedBufferSet > & sets );
+
+		size_t GetCount() const;
+
+		/// <summary>
+		/// Writes the pack. Entries are sorted by name so the reader can search them without building an index.
+		/// </summary>
+		void Save( const unify::Path & path ) const;
+
+	private:
+		std::map< std::string, std::vector< RecordedBufferSet > > m_entries;
+	};
+
+	/// <summary>
+	/// A memory mapped pack of baked shapes. Nothing is copied on load, BufferSets are built directly from the mapping.
+	/// </summary>
+	class ShapePack
+	{
+	public:
+		typedef std::shared_ptr< const ShapePack > ptr;
+
+		static const unsigned int Version;
+
+		ShapePack( const unify::Path & path );
+
+		const unify::Path & GetPath() const;
+		size_t GetCount() const;
+		bool Exists( const std::string & name ) const;
+
+		/// <summary>
+		/// Adds the baked BufferSets for "name" to the primitive list. Returns false, adding nothing, if the name
+		/// is not in the pack, or if it was baked against a vertex layout that does not match the effect's.
+		/// </summary>
+		bool Produce( me::render::PrimitiveList & primitiveList, const std::string & name, me::render::Effect::ptr effect ) const;
+
+	private:
+		friend class ShapePackWriter;
+
+		struct Header;
+		struct Entry;
+		struct Set;
+		struct Method;
+
+		const Header & GetHeader() const;
+		const Entry * Find( const std::string & name ) const;
+
+		MappedFile m_file;
+	};
+}
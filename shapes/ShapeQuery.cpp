@@ -0,0 +1,924 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/ShapeQuery.h>
+#include <shapes/VectorMath.h>
+#include <shapes/ShapeKernels.h>
+#include <me/exception/FailedToCreate.h>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+using namespace shapes;
+using vectormath::Dot;
+using vectormath::Cross;
+
+namespace
+{
+	// Batches are staged in blocks of this many points, so they need no allocation.
+	const size_t BlockSize = 64;
+
+	const float PI2 = 6.28318530717959f;
+
+	float Clamp( float value, float low, float high )
+	{
+		return std::min( std::max( value, low ), high );
+	}
+}
+
+RayHit::RayHit()
+	: distance{ std::numeric_limits< float >::infinity() }
+	, point{ 0, 0, 0 }
+	, normal{ 0, 0, 0 }
+{
+}
+
+bool IShapeQuery::Contains( const unify::V3< float > & point ) const
+{
+	return SignedDistance( point ) < 0.0f;
+}
+
+void IShapeQuery::SignedDistance( const unify::V3< float > * points, size_t count, float * distances ) const
+{
+	for( size_t i = 0; i < count; ++i )
+	{
+		distances[i] = SignedDistance( points[i] );
+	}
+}
+
+void IShapeQuery::Contains( const unify::V3< float > * points, size_t count, bool * inside ) const
+{
+	float distances[BlockSize];
+	for( size_t start = 0; start < count; start += BlockSize )
+	{
+		size_t block = std::min( BlockSize, count - start );
+		SignedDistance( points + start, block, distances );
+		for( size_t i = 0; i < block; ++i )
+		{
+			inside[start + i] = distances[i] < 0.0f;
+		}
+	}
+}
+
+void IShapeQuery::Intersect( const unify::V3< float > * origins, const unify::V3< float > * directions, size_t count, float * distances ) const
+{
+	for( size_t i = 0; i < count; ++i )
+	{
+		RayHit hit;
+		distances[i] = Intersect( origins[i], directions[i], hit ) ? hit.distance : std::numeric_limits< float >::infinity();
+	}
+}
+
+SphereQuery::SphereQuery( const unify::V3< float > & center, float radius )
+	: m_center{ center }
+	, m_radius{ radius }
+{
+}
+
+bool SphereQuery::Intersect( const unify::V3< float > & origin, const unify::V3< float > & direction, RayHit & hit ) const
+{
+	unify::V3< float > offset = origin - m_center;
+	float a = Dot( direction, direction );
+	float b = Dot( offset, direction );
+	float c = Dot( offset, offset ) - m_radius * m_radius;
+	float discriminant = b * b - a * c;
+	if( !( a > 0.0f ) || discriminant < 0.0f )
+	{
+		return false;
+	}
+
+	float root = std::sqrt( discriminant );
+	float t = ( -b - root ) / a;
+	if( t < 0.0f )
+	{
+		t = ( -b + root ) / a;
+	}
+	if( t < 0.0f )
+	{
+		return false;
+	}
+
+	hit.distance = t;
+	hit.point = origin + direction * t;
+	hit.normal = ( hit.point - m_center ) / m_radius;
+	return true;
+}
+
+float SphereQuery::SignedDistance( const unify::V3< float > & point ) const
+{
+	return ( point - m_center ).Length() - m_radius;
+}
+
+unify::V3< float > SphereQuery::ClosestPoint( const unify::V3< float > & point ) const
+{
+	unify::V3< float > offset = point - m_center;
+	float length = offset.Length();
+	if( length == 0.0f )
+	{
+		return m_center + unify::V3< float >( m_radius, 0, 0 );
+	}
+	return m_center + offset * ( m_radius / length );
+}
+
+unify::BBox< float > SphereQuery::GetBounds() const
+{
+	unify::V3< float > extent( m_radius, m_radius, m_radius );
+	return unify::BBox< float >( m_center - extent, m_center + extent );
+}
+
+void SphereQuery::SignedDistance( const unify::V3< float > * points, size_t count, float * distances ) const
+{
+	unify::V3< float > offsets[BlockSize];
+	const kernels::Affine toCenter = kernels::Affine::Translation( unify::V3< float >( -m_center.x, -m_center.y, -m_center.z ) );
+	for( size_t start = 0; start < count; start += BlockSize )
+	{
+		size_t block = std::min( BlockSize, count - start );
+		kernels::Transform( toCenter, points + start, offsets, block );
+		kernels::Lengths( offsets, distances + start, block );
+		for( size_t i = 0; i < block; ++i )
+		{
+			distances[start + i] -= m_radius;
+		}
+	}
+}
+
+BoxQuery::BoxQuery( const unify::V3< float > & inf, const unify::V3< float > & sup )
+	: m_center{ ( inf + sup ) * 0.5f }
+	, m_extent{ ( sup - inf ) * 0.5f }
+{
+}
+
+bool BoxQuery::Intersect( const unify::V3< float > & origin, const unify::V3< float > & direction, RayHit & hit ) const
+{
+	// A ray without a direction (or with a NaN one) crosses no slab, so has no face to hit.
+	if( !( Dot( direction, direction ) > 0.0f ) )
+	{
+		return false;
+	}
+
+	const float o[3] = { origin.x - m_center.x, origin.y - m_center.y, origin.z - m_center.z };
+	const float d[3] = { direction.x, direction.y, direction.z };
+	const float e[3] = { m_extent.x, m_extent.y, m_extent.z };
+
+	// Slabs: the ray is inside the box between the latest entry and the earliest exit.
+	float tNear = -std::numeric_limits< float >::infinity();
+	float tFar = std::numeric_limits< float >::infinity();
+	int nearAxis = -1;
+	int farAxis = -1;
+	for( int axis = 0; axis < 3; ++axis )
+	{
+		if( d[axis] == 0.0f )
+		{
+			if( std::abs( o[axis] ) > e[axis] )
+			{
+				return false;
+			}
+			continue;
+		}
+
+		float t1 = ( -e[axis] - o[axis] ) / d[axis];
+		float t2 = ( e[axis] - o[axis] ) / d[axis];
+		if( t1 > t2 ) std::swap( t1, t2 );
+		if( t1 > tNear )
+		{
+			tNear = t1;
+			nearAxis = axis;
+		}
+		if( t2 < tFar )
+		{
+			tFar = t2;
+			farAxis = axis;
+		}
+	}
+
+	if( tNear > tFar || tFar < 0.0f )
+	{
+		return false;
+	}
+
+	const int axis = tNear >= 0.0f ? nearAxis : farAxis;
+	if( axis < 0 )
+	{
+		return false;
+	}
+
+	float normal[3] = { 0, 0, 0 };
+	if( tNear >= 0.0f )
+	{
+		hit.distance = tNear;
+		normal[axis] = d[axis] > 0.0f ? -1.0f : 1.0f;
+	}
+	else
+	{
+		hit.distance = tFar;
+		normal[axis] = d[axis] > 0.0f ? 1.0f : -1.0f;
+	}
+	hit.point = origin + direction * hit.distance;
+	hit.normal = unify::V3< float >( normal[0], normal[1], normal[2] );
+	return true;
+}
+
+float BoxQuery::SignedDistance( const unify::V3< float > & point ) const
+{
+	unify::V3< float > q(
+		std::abs( point.x - m_center.x ) - m_extent.x,
+		std::abs( point.y - m_center.y ) - m_extent.y,
+		std::abs( point.z - m_center.z ) - m_extent.z );
+	unify::V3< float > outside( std::max( q.x, 0.0f ), std::max( q.y, 0.0f ), std::max( q.z, 0.0f ) );
+	return outside.Length() + std::min( std::max( q.x, std::max( q.y, q.z ) ), 0.0f );
+}
+
+unify::V3< float > BoxQuery::ClosestPoint( const unify::V3< float > & point ) const
+{
+	unify::V3< float > local = point - m_center;
+	unify::V3< float > q( std::abs( local.x ) - m_extent.x, std::abs( local.y ) - m_extent.y, std::abs( local.z ) - m_extent.z );
+	if( q.x > 0.0f || q.y > 0.0f || q.z > 0.0f )
+	{
+		return m_center + unify::V3< float >(
+			Clamp( local.x, -m_extent.x, m_extent.x ),
+			Clamp( local.y, -m_extent.y, m_extent.y ),
+			Clamp( local.z, -m_extent.z, m_extent.z ) );
+	}
+
+	// Inside, the nearest face is the one with the least room to it.
+	if( q.x >= q.y && q.x >= q.z )
+	{
+		local.x = local.x < 0.0f ? -m_extent.x : m_extent.x;
+	}
+	else if( q.y >= q.z )
+	{
+		local.y = local.y < 0.0f ? -m_extent.y : m_extent.y;
+	}
+	else
+	{
+		local.z = local.z < 0.0f ? -m_extent.z : m_extent.z;
+	}
+	return m_center + local;
+}
+
+unify::BBox< float > BoxQuery::GetBounds() const
+{
+	return unify::BBox< float >( m_center - m_extent, m_center + m_extent );
+}
+
+void BoxQuery::SignedDistance( const unify::V3< float > * points, size_t count, float * distances ) const
+{
+	unify::V3< float > outside[BlockSize];
+	float inside[BlockSize];
+	for( size_t start = 0; start < count; start += BlockSize )
+	{
+		size_t block = std::min( BlockSize, count - start );
+		for( size_t i = 0; i < block; ++i )
+		{
+			const unify::V3< float > & point = points[start + i];
+			float qx = std::abs( point.x - m_center.x ) - m_extent.x;
+			float qy = std::abs( point.y - m_center.y ) - m_extent.y;
+			float qz = std::abs( point.z - m_center.z ) - m_extent.z;
+			outside[i] = unify::V3< float >( std::max( qx, 0.0f ), std::max( qy, 0.0f ), std::max( qz, 0.0f ) );
+			inside[i] = std::min( std::max( qx, std::max( qy, qz ) ), 0.0f );
+		}
+		kernels::Lengths( outside, distances + start, block );
+		for( size_t i = 0; i < block; ++i )
+		{
+			distances[start + i] += inside[i];
+		}
+	}
+}
+
+ConvexQuery::ConvexQuery( const std::vector< unify::V3< float > > & corners, const std::vector< std::vector< unsigned int > > & faces )
+	: m_corners( corners )
+{
+	if( corners.size() < 4 || faces.size() < 4 )
+	{
+		throw me::exception::FailedToCreate( "ConvexQuery needs at least four corners and four faces!" );
+	}
+
+	unify::V3< float > middle( 0, 0, 0 );
+	for( const auto & corner : corners )
+	{
+		middle += corner;
+	}
+	middle /= (float)corners.size();
+
+	for( const auto & indices : faces )
+	{
+		Face face;
+		face.corners = indices;
+		if( indices.size() < 3 )
+		{
+			throw me::exception::FailedToCreate( "ConvexQuery faces need at least three corners!" );
+		}
+
+		// Newell's normal, which holds up for polygons that are not quite flat.
+		face.normal = unify::V3< float >( 0, 0, 0 );
+		for( size_t i = 0; i < indices.size(); ++i )
+		{
+			if( indices[i] >= corners.size() )
+			{
+				throw me::exception::FailedToCreate( "ConvexQuery face corner out of range!" );
+			}
+			const unify::V3< float > & a = corners[indices[i]];
+			const unify::V3< float > & b = corners[indices[( i + 1 ) % indices.size()]];
+			face.normal += unify::V3< float >( ( a.y - b.y ) * ( a.z + b.z ), ( a.z - b.z ) * ( a.x + b.x ), ( a.x - b.x ) * ( a.y + b.y ) );
+		}
+		float length = face.normal.Length();
+		if( !( length > 0.0f ) )
+		{
+			throw me::exception::FailedToCreate( "ConvexQuery faces need an area!" );
+		}
+		face.normal /= length;
+		face.offset = Dot( face.normal, corners[indices[0]] );
+
+		// Whichever way the face is wound, the middle of a convex solid is behind every face.
+		if( Dot( face.normal, middle ) > face.offset )
+		{
+			face.normal *= -1.0f;
+			face.offset = -face.offset;
+		}
+		m_faces.push_back( face );
+	}
+}
+
+IShapeQuery::ptr ConvexQuery::CreatePyramid( const unify::V3< float > & center, const unify::Size3< float > & size )
+{
+	const float w = size.width * 0.5f;
+	const float h = size.height * 0.5f;
+	const float d = size.depth * 0.5f;
+	std::vector< unify::V3< float > > corners =
+	{
+		center + unify::V3< float >( 0, h, 0 ),
+		center + unify::V3< float >( -w, -h, -d ),
+		center + unify::V3< float >( w, -h, -d ),
+		center + unify::V3< float >( w, -h, d ),
+		center + unify::V3< float >( -w, -h, d )
+	};
+	std::vector< std::vector< unsigned int > > faces = { { 0, 1, 2 }, { 0, 2, 3 }, { 0, 3, 4 }, { 0, 4, 1 }, { 1, 4, 3, 2 } };
+	return IShapeQuery::ptr( new ConvexQuery( corners, faces ) );
+}
+
+bool ConvexQuery::Intersect( const unify::V3< float > & origin, const unify::V3< float > & direction, RayHit & hit ) const
+{
+	if( !( Dot( direction, direction ) > 0.0f ) )
+	{
+		return false;
+	}
+
+	// The ray is inside between the last plane it enters and the first it leaves.
+	float tNear = -std::numeric_limits< float >::infinity();
+	float tFar = std::numeric_limits< float >::infinity();
+	const Face * nearFace = nullptr;
+	const Face * farFace = nullptr;
+	for( const auto & face : m_faces )
+	{
+		float facing = Dot( face.normal, direction );
+		float height = Dot( face.normal, origin ) - face.offset;
+		if( facing == 0.0f )
+		{
+			if( height > 0.0f )
+			{
+				return false;
+			}
+			continue;
+		}
+
+		float t = -height / facing;
+		if( facing < 0.0f )
+		{
+			if( t > tNear )
+			{
+				tNear = t;
+				nearFace = &face;
+			}
+		}
+		else if( t < tFar )
+		{
+			tFar = t;
+			farFace = &face;
+		}
+	}
+
+	if( tNear > tFar || tFar < 0.0f )
+	{
+		return false;
+	}
+
+	const Face * face = tNear >= 0.0f ? nearFace : farFace;
+	if( !face )
+	{
+		return false;
+	}
+
+	hit.distance = tNear >= 0.0f ? tNear : tFar;
+	hit.point = origin + direction * hit.distance;
+	hit.normal = face->normal;
+	return true;
+}
+
+float ConvexQuery::SignedDistance( const unify::V3< float > & point ) const
+{
+	// Inside, the nearest face is the one whose plane is nearest.
+	float height = -std::numeric_limits< float >::infinity();
+	for( const auto & face : m_faces )
+	{
+		height = std::max( height, Dot( face.normal, point ) - face.offset );
+	}
+	if( height <= 0.0f )
+	{
+		return height;
+	}
+	return ( ClosestPoint( point ) - point ).Length();
+}
+
+unify::V3< float > ConvexQuery::ClosestPoint( const unify::V3< float > & point ) const
+{
+	const Face * nearest = nullptr;
+	float height = -std::numeric_limits< float >::infinity();
+	for( const auto & face : m_faces )
+	{
+		float faceHeight = Dot( face.normal, point ) - face.offset;
+		if( faceHeight > height )
+		{
+			height = faceHeight;
+			nearest = &face;
+		}
+	}
+	if( height <= 0.0f )
+	{
+		return point - nearest->normal * height;
+	}
+
+	// Outside, the nearest point is on a face the point is in front of.
+	unify::V3< float > best = point;
+	float bestDistance = std::numeric_limits< float >::infinity();
+	for( const auto & face : m_faces )
+	{
+		if( Dot( face.normal, point ) - face.offset <= 0.0f )
+		{
+			continue;
+		}
+		unify::V3< float > onFace = Nearest( face, point );
+		float distance = Dot( onFace - point, onFace - point );
+		if( distance < bestDistance )
+		{
+			bestDistance = distance;
+			best = onFace;
+		}
+	}
+	return best;
+}
+
+unify::BBox< float > ConvexQuery::GetBounds() const
+{
+	unify::BBox< float > bounds( m_corners[0], m_corners[0] );
+	for( const auto & corner : m_corners )
+	{
+		bounds += corner;
+	}
+	return bounds;
+}
+
+unify::V3< float > ConvexQuery::Nearest( const Face & face, const unify::V3< float > & point ) const
+{
+	// On the face if the point's projection is on the same side of every edge.
+	unify::V3< float > projected = point - face.normal * ( Dot( face.normal, point ) - face.offset );
+	bool anyIn = false;
+	bool anyOut = false;
+	for( size_t i = 0; i < face.corners.size(); ++i )
+	{
+		const unify::V3< float > & a = m_corners[face.corners[i]];
+		const unify::V3< float > & b = m_corners[face.corners[( i + 1 ) % face.corners.size()]];
+		float side = Dot( Cross( b - a, projected - a ), face.normal );
+		anyIn = anyIn || side > 0.0f;
+		anyOut = anyOut || side < 0.0f;
+	}
+	if( !( anyIn && anyOut ) )
+	{
+		return projected;
+	}
+
+	// Otherwise on its nearest edge.
+	unify::V3< float > best = projected;
+	float bestDistance = std::numeric_limits< float >::infinity();
+	for( size_t i = 0; i < face.corners.size(); ++i )
+	{
+		const unify::V3< float > & a = m_corners[face.corners[i]];
+		const unify::V3< float > & b = m_corners[face.corners[( i + 1 ) % face.corners.size()]];
+		unify::V3< float > edge = b - a;
+		float lengthSquared = Dot( edge, edge );
+		float s = lengthSquared == 0.0f ? 0.0f : Clamp( Dot( point - a, edge ) / lengthSquared, 0.0f, 1.0f );
+		unify::V3< float > onEdge = a + edge * s;
+		float distance = Dot( onEdge - point, onEdge - point );
+		if( distance < bestDistance )
+		{
+			bestDistance = distance;
+			best = onEdge;
+		}
+	}
+	return best;
+}
+
+PlaneQuery::PlaneQuery( const unify::V3< float > & center, const unify::Size< float > & size )
+	: m_center{ center }
+	, m_halfWidth{ size.width * 0.5f }
+	, m_halfDepth{ size.height * 0.5f }
+{
+}
+
+bool PlaneQuery::Intersect( const unify::V3< float > & origin, const unify::V3< float > & direction, RayHit & hit ) const
+{
+	if( direction.y == 0.0f )
+	{
+		return false;
+	}
+
+	float t = ( m_center.y - origin.y ) / direction.y;
+	if( t < 0.0f )
+	{
+		return false;
+	}
+
+	unify::V3< float > point = origin + direction * t;
+	if( std::abs( point.x - m_center.x ) > m_halfWidth || std::abs( point.z - m_center.z ) > m_halfDepth )
+	{
+		return false;
+	}
+
+	hit.distance = t;
+	hit.point = point;
+	hit.normal = unify::V3< float >( 0, direction.y > 0.0f ? -1.0f : 1.0f, 0 );
+	return true;
+}
+
+float PlaneQuery::SignedDistance( const unify::V3< float > & point ) const
+{
+	return ( ClosestPoint( point ) - point ).Length();
+}
+
+unify::V3< float > PlaneQuery::ClosestPoint( const unify::V3< float > & point ) const
+{
+	return unify::V3< float >(
+		m_center.x + Clamp( point.x - m_center.x, -m_halfWidth, m_halfWidth ),
+		m_center.y,
+		m_center.z + Clamp( point.z - m_center.z, -m_halfDepth, m_halfDepth ) );
+}
+
+unify::BBox< float > PlaneQuery::GetBounds() const
+{
+	return unify::BBox< float >(
+		m_center - unify::V3< float >( m_halfWidth, 0, m_halfDepth ),
+		m_center + unify::V3< float >( m_halfWidth, 0, m_halfDepth ) );
+}
+
+RevolvedQuery::Segment::Segment( const unify::V2< float > & a, const unify::V2< float > & b )
+	: a{ a }
+	, b{ b }
+	, normal{ 0, 0 }
+{
+}
+
+RevolvedQuery::ArcMask::ArcMask()
+	: count{ 0 }
+	, fraction{ 1.0f }
+	, visible{ 0 }
+{
+}
+
+RevolvedQuery::ArcMask::ArcMask( unsigned int count, float fraction, unsigned int visible )
+	: count{ count }
+	, fraction{ fraction }
+	, visible{ visible }
+{
+}
+
+RevolvedQuery::RevolvedQuery( const unify::V3< float > & center, const std::vector< Segment > & profile, bool solid, const ArcMask & mask )
+	: m_center{ center }
+	, m_profile( profile )
+	, m_solid{ solid }
+	, m_mask( mask )
+{
+	if( m_mask.count )
+	{
+		if( m_solid )
+		{
+			throw me::exception::FailedToCreate( "RevolvedQuery can only mask surfaces!" );
+		}
+		if( m_mask.visible == 0 || !( m_mask.fraction > 0.0f ) )
+		{
+			throw me::exception::FailedToCreate( "RevolvedQuery arc mask keeps none of the surface!" );
+		}
+		m_mask.visible = std::min( m_mask.visible, m_mask.count );
+		m_mask.fraction = std::min( m_mask.fraction, 1.0f );
+	}
+
+	for( auto & segment : m_profile )
+	{
+		float dx = segment.b.x - segment.a.x;
+		float dy = segment.b.y - segment.a.y;
+		float length = std::sqrt( dx * dx + dy * dy );
+		segment.normal = length == 0.0f ? unify::V2< float >( 0, 0 ) : unify::V2< float >( dy / length, -dx / length );
+
+		// Step off the middle of the segment; if that is inside, the normal points the wrong way.
+		float step = length * 0.001f;
+		unify::V2< float > probe( ( segment.a.x + segment.b.x ) * 0.5f + segment.normal.x * step, ( segment.a.y + segment.b.y ) * 0.5f + segment.normal.y * step );
+		if( m_solid && IsInside( probe ) )
+		{
+			segment.normal = unify::V2< float >( -segment.normal.x, -segment.normal.y );
+		}
+	}
+}
+
+IShapeQuery::ptr RevolvedQuery::CreateCylinder( const unify::V3< float > & center, float radius, float height, bool caps )
+{
+	float half = height * 0.5f;
+	std::vector< Segment > profile;
+	if( caps )
+	{
+		profile.push_back( { { 0, -half }, { radius, -half } } );
+	}
+	profile.push_back( { { radius, -half }, { radius, half } } );
+	if( caps )
+	{
+		profile.push_back( { { radius, half }, { 0, half } } );
+	}
+	return IShapeQuery::ptr( new RevolvedQuery( center, profile, caps ) );
+}
+
+IShapeQuery::ptr RevolvedQuery::CreateCone( const unify::V3< float > & center, float radius, float rise, bool caps )
+{
+	std::vector< Segment > profile;
+	profile.push_back( { { 0, 0 }, { radius, rise } } );
+	if( caps )
+	{
+		profile.push_back( { { radius, rise }, { 0, rise } } );
+	}
+	return IShapeQuery::ptr( new RevolvedQuery( center, profile, caps ) );
+}
+
+IShapeQuery::ptr RevolvedQuery::CreateTube( const unify::V3< float > & center, float innerRadius, float outerRadius, float height )
+{
+	float half = height * 0.5f;
+	std::vector< Segment > profile;
+	profile.push_back( { { innerRadius, -half }, { outerRadius, -half } } );
+	profile.push_back( { { outerRadius, -half }, { outerRadius, half } } );
+	profile.push_back( { { outerRadius, half }, { innerRadius, half } } );
+	profile.push_back( { { innerRadius, half }, { innerRadius, -half } } );
+	return IShapeQuery::ptr( new RevolvedQuery( center, profile, true ) );
+}
+
+IShapeQuery::ptr RevolvedQuery::CreateDisc( const unify::V3< float > & center, float radius )
+{
+	std::vector< Segment > profile;
+	profile.push_back( { { 0, 0 }, { radius, 0 } } );
+	return IShapeQuery::ptr( new RevolvedQuery( center, profile, false ) );
+}
+
+IShapeQuery::ptr RevolvedQuery::CreateDashRing( const unify::V3< float > & center, float innerRadius, float outerRadius, const ArcMask & dashes )
+{
+	std::vector< Segment > profile;
+	profile.push_back( { { innerRadius, 0 }, { outerRadius, 0 } } );
+	return IShapeQuery::ptr( new RevolvedQuery( center, profile, false, dashes ) );
+}
+
+bool RevolvedQuery::Intersect( const unify::V3< float > & origin, const unify::V3< float > & direction, RayHit & hit ) const
+{
+	const unify::V3< float > o = origin - m_center;
+	const unify::V3< float > & d = direction;
+
+	float best = std::numeric_limits< float >::infinity();
+	const Segment * bestSegment = nullptr;
+
+	auto consider = [&]( float t, const Segment & segment )
+	{
+		if( t >= 0.0f && t < best && IsInMask( std::atan2( o.z + d.z * t, o.x + d.x * t ) ) )
+		{
+			best = t;
+			bestSegment = &segment;
+		}
+	};
+
+	for( const auto & segment : m_profile )
+	{
+		float dx = segment.b.x - segment.a.x;
+		float dy = segment.b.y - segment.a.y;
+
+		// A flat segment sweeps an annulus (or disc) in the plane y = a.y.
+		if( dy == 0.0f )
+		{
+			if( d.y == 0.0f )
+			{
+				continue;
+			}
+			float t = ( segment.a.y - o.y ) / d.y;
+			float x = o.x + d.x * t;
+			float z = o.z + d.z * t;
+			float radius = std::sqrt( x * x + z * z );
+			if( radius >= std::min( segment.a.x, segment.b.x ) && radius <= std::max( segment.a.x, segment.b.x ) )
+			{
+				consider( t, segment );
+			}
+			continue;
+		}
+
+		// Otherwise the radius is linear in y, r( y ) = m + n * t along the ray, and x^2 + z^2 = r^2 is a quadratic in t.
+		float k = dx / dy;
+		float m = segment.a.x + k * ( o.y - segment.a.y );
+		float n = k * d.y;
+		float a = d.x * d.x + d.z * d.z - n * n;
+		float b = 2.0f * ( o.x * d.x + o.z * d.z - m * n );
+		float c = o.x * o.x + o.z * o.z - m * m;
+
+		float roots[2];
+		int rootCount = 0;
+		if( std::abs( a ) < 1e-12f )
+		{
+			if( b != 0.0f )
+			{
+				roots[rootCount++] = -c / b;
+			}
+		}
+		else
+		{
+			float discriminant = b * b - 4.0f * a * c;
+			if( discriminant >= 0.0f )
+			{
+				float root = std::sqrt( discriminant );
+				roots[rootCount++] = ( -b - root ) / ( 2.0f * a );
+				roots[rootCount++] = ( -b + root ) / ( 2.0f * a );
+			}
+		}
+
+		// Keep roots on the segment; that also drops the mirror cone, where the radius would be negative.
+		for( int r = 0; r < rootCount; ++r )
+		{
+			float s = ( o.y + d.y * roots[r] - segment.a.y ) / dy;
+			if( s >= -1e-6f && s <= 1.0f + 1e-6f )
+			{
+				consider( roots[r], segment );
+			}
+		}
+	}
+
+	if( !bestSegment )
+	{
+		return false;
+	}
+
+	hit.distance = best;
+	hit.point = origin + direction * best;
+
+	unify::V3< float > local = hit.point - m_center;
+	float radius = std::sqrt( local.x * local.x + local.z * local.z );
+	unify::V3< float > radial = radius > 0.0f ? unify::V3< float >( local.x / radius, 0, local.z / radius ) : unify::V3< float >( 0, 0, 0 );
+	hit.normal = radial * bestSegment->normal.x + unify::V3< float >( 0, bestSegment->normal.y, 0 );
+	hit.normal.Normalize();
+	if( !m_solid && Dot( hit.normal, direction ) > 0.0f )
+	{
+		hit.normal *= -1.0f;
+	}
+	return true;
+}
+
+float RevolvedQuery::SignedDistance( const unify::V3< float > & point ) const
+{
+	unify::V3< float > local = point - m_center;
+	if( m_mask.count )
+	{
+		return ( NearestInMask( local ) - local ).Length();
+	}
+
+	unify::V2< float > profilePoint( std::sqrt( local.x * local.x + local.z * local.z ), local.y );
+	unify::V2< float > nearest = Nearest( profilePoint );
+	float dx = profilePoint.x - nearest.x;
+	float dy = profilePoint.y - nearest.y;
+	float distance = std::sqrt( dx * dx + dy * dy );
+	return m_solid && IsInside( profilePoint ) ? -distance : distance;
+}
+
+unify::V3< float > RevolvedQuery::ClosestPoint( const unify::V3< float > & point ) const
+{
+	unify::V3< float > local = point - m_center;
+	if( m_mask.count )
+	{
+		return m_center + NearestInMask( local );
+	}
+
+	float radius = std::sqrt( local.x * local.x + local.z * local.z );
+	unify::V2< float > nearest = Nearest( unify::V2< float >( radius, local.y ) );
+
+	// On the axis every direction is as near; x is used.
+	if( radius == 0.0f )
+	{
+		return m_center + unify::V3< float >( nearest.x, nearest.y, 0 );
+	}
+	float scale = nearest.x / radius;
+	return m_center + unify::V3< float >( local.x * scale, nearest.y, local.z * scale );
+}
+
+unify::BBox< float > RevolvedQuery::GetBounds() const
+{
+	float radius = 0.0f;
+	float low = std::numeric_limits< float >::infinity();
+	float high = -std::numeric_limits< float >::infinity();
+	for( const auto & segment : m_profile )
+	{
+		radius = std::max( radius, std::max( segment.a.x, segment.b.x ) );
+		low = std::min( low, std::min( segment.a.y, segment.b.y ) );
+		high = std::max( high, std::max( segment.a.y, segment.b.y ) );
+	}
+	return unify::BBox< float >( m_center + unify::V3< float >( -radius, low, -radius ), m_center + unify::V3< float >( radius, high, radius ) );
+}
+
+bool RevolvedQuery::IsInside( const unify::V2< float > & point ) const
+{
+	// Count crossings going out from the axis. The axis never crosses, which is what closes an open profile.
+	bool inside = false;
+	for( const auto & segment : m_profile )
+	{
+		if( ( segment.a.y > point.y ) != ( segment.b.y > point.y ) )
+		{
+			float x = segment.a.x + ( point.y - segment.a.y ) * ( segment.b.x - segment.a.x ) / ( segment.b.y - segment.a.y );
+			if( point.x < x )
+			{
+				inside = !inside;
+			}
+		}
+	}
+	return inside;
+}
+
+unify::V2< float > RevolvedQuery::Nearest( const unify::V2< float > & point ) const
+{
+	unify::V2< float > best( 0, 0 );
+	float bestDistance = std::numeric_limits< float >::infinity();
+	for( const auto & segment : m_profile )
+	{
+		float dx = segment.b.x - segment.a.x;
+		float dy = segment.b.y - segment.a.y;
+		float lengthSquared = dx * dx + dy * dy;
+		float s = lengthSquared == 0.0f ? 0.0f : Clamp( ( ( point.x - segment.a.x ) * dx + ( point.y - segment.a.y ) * dy ) / lengthSquared, 0.0f, 1.0f );
+		unify::V2< float > onSegment( segment.a.x + dx * s, segment.a.y + dy * s );
+		float ex = point.x - onSegment.x;
+		float ey = point.y - onSegment.y;
+		float distance = ex * ex + ey * ey;
+		if( distance < bestDistance )
+		{
+			bestDistance = distance;
+			best = onSegment;
+		}
+	}
+	return best;
+}
+
+bool RevolvedQuery::IsInMask( float angle ) const
+{
+	if( !m_mask.count )
+	{
+		return true;
+	}
+
+	const float share = PI2 / m_mask.count;
+	float around = std::fmod( angle, PI2 );
+	if( around < 0.0f )
+	{
+		around += PI2;
+	}
+	unsigned int arc = std::min( (unsigned int)( around / share ), m_mask.count - 1 );
+	return arc < m_mask.visible && around - arc * share <= m_mask.fraction * share;
+}
+
+unify::V3< float > RevolvedQuery::NearestInMask( const unify::V3< float > & local ) const
+{
+	float radius = std::sqrt( local.x * local.x + local.z * local.z );
+	float angle = std::atan2( local.z, local.x );
+	if( radius > 0.0f && IsInMask( angle ) )
+	{
+		unify::V2< float > nearest = Nearest( unify::V2< float >( radius, local.y ) );
+		float scale = nearest.x / radius;
+		return unify::V3< float >( local.x * scale, nearest.y, local.z * scale );
+	}
+
+	// Otherwise the nearest point is on the profile swept to the start or end of a kept arc. In the plane of that
+	// edge, the point is radius * cos( apart ) out from the axis and radius * sin( apart ) off the plane.
+	const float share = PI2 / m_mask.count;
+	unify::V3< float > best( 0, 0, 0 );
+	float bestDistance = std::numeric_limits< float >::infinity();
+	for( unsigned int arc = 0; arc < m_mask.visible; ++arc )
+	{
+		for( float edge : { share * arc, share * ( arc + m_mask.fraction ) } )
+		{
+			float apart = angle - edge;
+			float along = radius * std::cos( apart );
+			float off = radius * std::sin( apart );
+			unify::V2< float > nearest = Nearest( unify::V2< float >( along, local.y ) );
+			float dx = nearest.x - along;
+			float dy = nearest.y - local.y;
+			float distance = dx * dx + dy * dy + off * off;
+			if( distance < bestDistance )
+			{
+				bestDistance = distance;
+				best = unify::V3< float >( nearest.x * std::cos( edge ), nearest.y, nearest.x * std::sin( edge ) );
+			}
+		}
+	}
+	return best;
+}
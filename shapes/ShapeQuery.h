@@ -0,0 +1,250 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <unify/V2.h>
+#include <unify/V3.h>
+#include <unify/BBox.h>
+#include <unify/Size3.h>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+namespace shapes
+{
+	/// <summary>
+	/// Where a ray met a shape. distance is in units of the ray's direction, and normal faces out of solids, or back
+	/// along the ray for surfaces.
+	/// </summary>
+	struct RayHit
+	{
+		RayHit();
+
+		float distance;
+		unify::V3< float > point;
+		unify::V3< float > normal;
+	};
+
+	/// <summary>
+	/// The exact form of a created shape, for picking and trigger volumes without going through its triangles.
+	/// Queries are in the space the shape was created in: desc.center is applied, and canonical is ignored.
+	/// Solids (sphere, box, pyramid, tube, capped cylinder and cone) have an inside; surfaces (plane, circle, dash
+	/// ring, and an uncapped cylinder or cone) do not, so their distance is never negative and they contain nothing.
+	/// </summary>
+	class IShapeQuery
+	{
+	public:
+		typedef std::shared_ptr< IShapeQuery > ptr;
+
+		virtual ~IShapeQuery() {}
+
+		/// <summary>
+		/// The first hit along origin + direction * t, t >= 0. A ray starting inside a solid hits its way out.
+		/// </summary>
+		virtual bool Intersect( const unify::V3< float > & origin, const unify::V3< float > & direction, RayHit & hit ) const = 0;
+
+		/// <summary>
+		/// The distance to the surface, negative inside.
+		/// </summary>
+		virtual float SignedDistance( const unify::V3< float > & point ) const = 0;
+
+		/// <summary>
+		/// The nearest point on the surface.
+		/// </summary>
+		virtual unify::V3< float > ClosestPoint( const unify::V3< float > & point ) const = 0;
+
+		/// <summary>
+		/// An axis aligned box that holds the whole shape.
+		/// </summary>
+		virtual unify::BBox< float > GetBounds() const = 0;
+
+		bool Contains( const unify::V3< float > & point ) const;
+
+		/// <summary>
+		/// SignedDistance for each point. Shapes with a kernel path evaluate four points at a time.
+		/// </summary>
+		virtual void SignedDistance( const unify::V3< float > * points, size_t count, float * distances ) const;
+
+		void Contains( const unify::V3< float > * points, size_t count, bool * inside ) const;
+
+		/// <summary>
+		/// The hit distance for each ray, or infinity for a miss.
+		/// </summary>
+		void Intersect( const unify::V3< float > * origins, const unify::V3< float > * directions, size_t count, float * distances ) const;
+	};
+
+	class SphereQuery : public IShapeQuery
+	{
+	public:
+		SphereQuery( const unify::V3< float > & center, float radius );
+
+		bool Intersect( const unify::V3< float > & origin, const unify::V3< float > & direction, RayHit & hit ) const override;
+		float SignedDistance( const unify::V3< float > & point ) const override;
+		unify::V3< float > ClosestPoint( const unify::V3< float > & point ) const override;
+		unify::BBox< float > GetBounds() const override;
+		void SignedDistance( const unify::V3< float > * points, size_t count, float * distances ) const override;
+
+	private:
+		unify::V3< float > m_center;
+		float m_radius;
+	};
+
+	/// <summary>
+	/// An axis aligned box from inf to sup.
+	/// </summary>
+	class BoxQuery : public IShapeQuery
+	{
+	public:
+		BoxQuery( const unify::V3< float > & inf, const unify::V3< float > & sup );
+
+		bool Intersect( const unify::V3< float > & origin, const unify::V3< float > & direction, RayHit & hit ) const override;
+		float SignedDistance( const unify::V3< float > & point ) const override;
+		unify::V3< float > ClosestPoint( const unify::V3< float > & point ) const override;
+		unify::BBox< float > GetBounds() const override;
+		void SignedDistance( const unify::V3< float > * points, size_t count, float * distances ) const override;
+
+	private:
+		unify::V3< float > m_center;
+		unify::V3< float > m_extent;
+	};
+
+	/// <summary>
+	/// A convex solid bounded by flat faces, each a convex polygon of corners. Rays are clipped against the plane of
+	/// every face, so the cost grows with the faces rather than the triangles drawn.
+	/// </summary>
+	class ConvexQuery : public IShapeQuery
+	{
+	public:
+		ConvexQuery( const std::vector< unify::V3< float > > & corners, const std::vector< std::vector< unsigned int > > & faces );
+
+		/// <summary>
+		/// The square based pyramid Pyramid makes: the base at center.y - height/2, the apex height/2 above center.
+		/// </summary>
+		static IShapeQuery::ptr CreatePyramid( const unify::V3< float > & center, const unify::Size3< float > & size );
+
+		bool Intersect( const unify::V3< float > & origin, const unify::V3< float > & direction, RayHit & hit ) const override;
+		float SignedDistance( const unify::V3< float > & point ) const override;
+		unify::V3< float > ClosestPoint( const unify::V3< float > & point ) const override;
+		unify::BBox< float > GetBounds() const override;
+
+	private:
+		struct Face
+		{
+			std::vector< unsigned int > corners;
+
+			// The plane, normal . p = offset, with the normal pointing out.
+			unify::V3< float > normal;
+			float offset;
+		};
+
+		// The nearest point of a face to a point.
+		unify::V3< float > Nearest( const Face & face, const unify::V3< float > & point ) const;
+
+		std::vector< unify::V3< float > > m_corners;
+		std::vector< Face > m_faces;
+	};
+
+	/// <summary>
+	/// A rectangle in xz, centered on center, as made by Plane.
+	/// </summary>
+	class PlaneQuery : public IShapeQuery
+	{
+	public:
+		PlaneQuery( const unify::V3< float > & center, const unify::Size< float > & size );
+
+		bool Intersect( const unify::V3< float > & origin, const unify::V3< float > & direction, RayHit & hit ) const override;
+		float SignedDistance( const unify::V3< float > & point ) const override;
+		unify::V3< float > ClosestPoint( const unify::V3< float > & point ) const override;
+		unify::BBox< float > GetBounds() const override;
+
+	private:
+		unify::V3< float > m_center;
+		float m_halfWidth;
+		float m_halfDepth;
+	};
+
+	/// <summary>
+	/// A profile of line segments revolved about the y axis through center. Profile points are ( radius, y ), with
+	/// radius >= 0. A solid profile is the boundary of a region, closed by the axis where it does not close itself.
+	/// Each segment sweeps a cone, cylinder or annulus, so rays are solved exactly rather than against segments.
+	/// </summary>
+	class RevolvedQuery : public IShapeQuery
+	{
+	public:
+		struct Segment
+		{
+			Segment( const unify::V2< float > & a, const unify::V2< float > & b );
+
+			unify::V2< float > a;
+			unify::V2< float > b;
+
+			// The unit normal in the profile, pointing out of a solid; filled in by RevolvedQuery.
+			unify::V2< float > normal;
+		};
+
+		/// <summary>
+		/// Keeps only count arcs of a surface, evenly spaced about y from +x toward +z: arc k spans share * k to
+		/// share * ( k + fraction ), share being 2 pi / count, and only the first visible arcs are kept. A count
+		/// of 0 keeps the whole surface.
+		/// </summary>
+		struct ArcMask
+		{
+			ArcMask();
+			ArcMask( unsigned int count, float fraction, unsigned int visible );
+
+			unsigned int count;
+			float fraction;
+			unsigned int visible;
+		};
+
+		/// <summary>
+		/// Only surfaces can be masked, and a mask must keep some of the surface.
+		/// </summary>
+		RevolvedQuery( const unify::V3< float > & center, const std::vector< Segment > & profile, bool solid, const ArcMask & mask = ArcMask() );
+
+		/// <summary>
+		/// Spans -height/2 to height/2.
+		/// </summary>
+		static IShapeQuery::ptr CreateCylinder( const unify::V3< float > & center, float radius, float height, bool caps );
+
+		/// <summary>
+		/// The apex is at center and the base, of the given radius, is "rise" above it.
+		/// </summary>
+		static IShapeQuery::ptr CreateCone( const unify::V3< float > & center, float radius, float rise, bool caps );
+
+		static IShapeQuery::ptr CreateTube( const unify::V3< float > & center, float innerRadius, float outerRadius, float height );
+
+		/// <summary>
+		/// A disc in xz.
+		/// </summary>
+		static IShapeQuery::ptr CreateDisc( const unify::V3< float > & center, float radius );
+
+		/// <summary>
+		/// A flat ring in xz, from innerRadius to outerRadius, kept only where its dashes are.
+		/// </summary>
+		static IShapeQuery::ptr CreateDashRing( const unify::V3< float > & center, float innerRadius, float outerRadius, const ArcMask & dashes );
+
+		bool Intersect( const unify::V3< float > & origin, const unify::V3< float > & direction, RayHit & hit ) const override;
+		float SignedDistance( const unify::V3< float > & point ) const override;
+		unify::V3< float > ClosestPoint( const unify::V3< float > & point ) const override;
+		unify::BBox< float > GetBounds() const override;
+
+	private:
+		// Whether a profile point is inside the region.
+		bool IsInside( const unify::V2< float > & point ) const;
+
+		// The nearest profile point to a profile point.
+		unify::V2< float > Nearest( const unify::V2< float > & point ) const;
+
+		// Whether the mask keeps the direction at angle, in radians from +x toward +z.
+		bool IsInMask( float angle ) const;
+
+		// The nearest point of a masked surface to a point, both relative to center.
+		unify::V3< float > NearestInMask( const unify::V3< float > & local ) const;
+
+		unify::V3< float > m_center;
+		std::vector< Segment > m_profile;
+		bool m_solid;
+		ArcMask m_mask;
+	};
+}
@@ -0,0 +1,142 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/ShapeStats.h>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+
+using namespace me;
+using namespace render;
+using namespace shapes;
+
+ShapeCounters::ShapeCounters()
+	: calls{ 0 }
+	, failures{ 0 }
+	, totalNanoseconds{ 0 }
+	, maxNanoseconds{ 0 }
+	, vertices{ 0 }
+	, indices{ 0 }
+	, bytes{ 0 }
+{
+}
+
+void ShapeCounters::AddCall( uint64_t nanoseconds, bool failed )
+{
+	calls.fetch_add( 1, std::memory_order_relaxed );
+	if( failed )
+	{
+		failures.fetch_add( 1, std::memory_order_relaxed );
+	}
+	totalNanoseconds.fetch_add( nanoseconds, std::memory_order_relaxed );
+
+	uint64_t max = maxNanoseconds.load( std::memory_order_relaxed );
+	while( nanoseconds > max && !maxNanoseconds.compare_exchange_weak( max, nanoseconds, std::memory_order_relaxed ) )
+	{
+	}
+}
+
+void ShapeCounters::AddVertices( uint64_t count, uint64_t size )
+{
+	vertices.fetch_add( count, std::memory_order_relaxed );
+	bytes.fetch_add( size, std::memory_order_relaxed );
+}
+
+void ShapeCounters::AddIndices( uint64_t count, uint64_t size )
+{
+	indices.fetch_add( count, std::memory_order_relaxed );
+	bytes.fetch_add( size, std::memory_order_relaxed );
+}
+
+ShapeCounters * ShapeCounters::Current()
+{
+	return CurrentScope< ShapeCounters >::Get();
+}
+
+ShapeStats::ShapeStats()
+{
+}
+
+ShapeStats::~ShapeStats()
+{
+}
+
+ShapeCounters & ShapeStats::Add( const std::string & type )
+{
+	std::lock_guard< std::mutex > lock( m_lock );
+	m_counters.emplace_back( std::piecewise_construct, std::forward_as_tuple( type ), std::forward_as_tuple() );
+	return m_counters.back().second;
+}
+
+std::vector< ShapeStatsEntry > ShapeStats::GetEntries() const
+{
+	std::lock_guard< std::mutex > lock( m_lock );
+	std::vector< ShapeStatsEntry > entries;
+	for( const auto & counters : m_counters )
+	{
+		const ShapeCounters & c = counters.second;
+		entries.push_back( ShapeStatsEntry{
+			counters.first,
+			c.calls.load( std::memory_order_relaxed ),
+			c.failures.load( std::memory_order_relaxed ),
+			c.totalNanoseconds.load( std::memory_order_relaxed ),
+			c.maxNanoseconds.load( std::memory_order_relaxed ),
+			c.vertices.load( std::memory_order_relaxed ),
+			c.indices.load( std::memory_order_relaxed ),
+			c.bytes.load( std::memory_order_relaxed )
+		} );
+	}
+	return entries;
+}
+
+void ShapeStats::Log( me::debug::IDebug * debug ) const
+{
+	for( const auto & entry : GetEntries() )
+	{
+		if( entry.calls == 0 )
+		{
+			continue;
+		}
+
+		std::stringstream line;
+		line << std::fixed << std::setprecision( 3 )
+			<< entry.type << ": " << entry.calls << " calls (" << entry.failures << " failed), "
+			<< entry.totalNanoseconds / 1000000.0 << "ms total, "
+			<< entry.maxNanoseconds / 1000000.0 << "ms max, "
+			<< entry.vertices << " vertices, " << entry.indices << " indices, " << entry.bytes << " bytes";
+		debug->LogLine( "MEShapes", line.str() );
+	}
+}
+
+StatsShapeCreator::StatsShapeCreator( ShapeStats::ptr stats, const std::string & type, me::sculpter::IShapeCreator::ptr creator )
+	: m_stats{ stats }
+	, m_counters{ stats->Add( type ) }
+	, m_creator{ std::move( creator ) }
+{
+}
+
+StatsShapeCreator::~StatsShapeCreator()
+{
+}
+
+void StatsShapeCreator::Create( PrimitiveList & primitiveList, const unify::Parameters & parameters ) const
+{
+	using clock = std::chrono::steady_clock;
+	auto start = clock::now();
+	auto elapsed = [&]()
+	{
+		return (uint64_t)std::chrono::duration_cast< std::chrono::nanoseconds >( clock::now() - start ).count();
+	};
+
+	ShapeCounters::Scope scope( m_counters );
+	try
+	{
+		m_creator->Create( primitiveList, parameters );
+	}
+	catch( ... )
+	{
+		m_counters.AddCall( elapsed(), true );
+		throw;
+	}
+	m_counters.AddCall( elapsed(), false );
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <shapes/CurrentScope.h>
+#include <me/sculpter/IShapeCreator.h>
+#include <me/debug/IDebug.h>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace shapes
+{
+	/// <summary>
+	/// Running totals for one shape type. Updated with relaxed atomics only, so they are cheap enough to leave on.
+	/// </summary>
+	struct ShapeCounters
+	{
+		// Counters current while a creator runs count the buffers it adds against its shape type.
+		typedef CurrentScope< ShapeCounters > Scope;
+
+		ShapeCounters();
+
+		void AddCall( uint64_t nanoseconds, bool failed );
+		void AddVertices( uint64_t count, uint64_t bytes );
+		void AddIndices( uint64_t count, uint64_t bytes );
+
+		/// <summary>
+		/// Returns the counters current for the calling thread, or nullptr.
+		/// </summary>
+		static ShapeCounters * Current();
+
+		std::atomic< uint64_t > calls;
+		std::atomic< uint64_t > failures;
+		std::atomic< uint64_t > totalNanoseconds;
+		std::atomic< uint64_t > maxNanoseconds;
+		std::atomic< uint64_t > vertices;
+		std::atomic< uint64_t > indices;
+		std::atomic< uint64_t > bytes;
+	};
+
+	/// <summary>
+	/// A copy of the counters for one shape type, taken at a point in time.
+	/// </summary>
+	struct ShapeStatsEntry
+	{
+		std::string type;
+		uint64_t calls;
+		uint64_t failures;
+		uint64_t totalNanoseconds;
+		uint64_t maxNanoseconds;
+		uint64_t vertices;
+		uint64_t indices;
+		uint64_t bytes;
+	};
+
+	/// <summary>
+	/// Counters for every registered shape type. Types are only added while creators are registered, the counters
+	/// themselves never take a lock. Whoever owns the stats writes them to the log with Log, while the log is
+	/// still alive; MEShapes does so from MEShapesUnload.
+	/// </summary>
+	class ShapeStats
+	{
+	public:
+		typedef std::shared_ptr< ShapeStats > ptr;
+
+		ShapeStats();
+		~ShapeStats();
+
+		ShapeCounters & Add( const std::string & type );
+
+		std::vector< ShapeStatsEntry > GetEntries() const;
+
+		void Log( me::debug::IDebug * debug ) const;
+
+	private:
+		mutable std::mutex m_lock;
+		std::deque< std::pair< std::string, ShapeCounters > > m_counters;
+	};
+
+	/// <summary>
+	/// Times and counts the output of the wrapped creator.
+	/// </summary>
+	class StatsShapeCreator : public me::sculpter::IShapeCreator
+	{
+	public:
+		StatsShapeCreator( ShapeStats::ptr stats, const std::string & type, me::sculpter::IShapeCreator::ptr creator );
+		~StatsShapeCreator() override;
+
+		void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+
+	private:
+		ShapeStats::ptr m_stats;
+		ShapeCounters & m_counters;
+		me::sculpter::IShapeCreator::ptr m_creator;
+	};
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <shapes/ShapeTransform.h>
+#include <me/exception/FailedToCreate.h>
+
+using namespace shapes;
+
+namespace
+{
+	float InverseScale( float scale )
+	{
+		return scale == 0.0f ? 1.0f : 1.0f / scale;
+	}
+}
+
+ShapeTransform::ShapeTransform()
+	: scale{ 1, 1, 1 }
+	, offset{ 0, 0, 0 }
+{
+}
+
+ShapeTransform::ShapeTransform( const unify::V3< float > & scale, const unify::V3< float > & offset )
+	: scale{ scale }
+	, offset{ offset }
+{
+}
+
+bool ShapeTransform::IsIdentity() const
+{
+	return scale.x == 1.0f && scale.y == 1.0f && scale.z == 1.0f && offset.x == 0.0f && offset.y == 0.0f && offset.z == 0.0f;
+}
+
+unify::Matrix ShapeTransform::GetMatrix() const
+{
+	return unify::MatrixScale( scale ) * unify::MatrixTranslate( offset );
+}
+
+unify::Matrix ShapeTransform::GetNormalMatrix() const
+{
+	// The scale is diagonal, so its inverse transpose is the reciprocal of each axis.
+	return unify::MatrixScale( unify::V3< float >( InverseScale( scale.x ), InverseScale( scale.y ), InverseScale( scale.z ) ) );
+}
+
+unify::V3< float > ShapeTransform::TransformPosition( const unify::V3< float > & position ) const
+{
+	return unify::V3< float >( position.x * scale.x + offset.x, position.y * scale.y + offset.y, position.z * scale.z + offset.z );
+}
+
+unify::V3< float > ShapeTransform::TransformNormal( const unify::V3< float > & normal ) const
+{
+	unify::V3< float > result( normal.x * InverseScale( scale.x ), normal.y * InverseScale( scale.y ), normal.z * InverseScale( scale.z ) );
+	result.Normalize();
+	return result;
+}
+
+unify::BBox< float > ShapeTransform::TransformBBox( const unify::BBox< float > & bbox ) const
+{
+	// A negative scale swaps the ends of an axis, so both corners are added.
+	unify::BBox< float > result;
+	result += TransformPosition( bbox.inf );
+	result += TransformPosition( bbox.sup );
+	return result;
+}
+
+ShapeTransform * ShapeTransform::Current()
+{
+	return CurrentScope< ShapeTransform >::Get();
+}
+
+void ShapeTransform::Report( const unify::V3< float > & scale, const unify::V3< float > & offset )
+{
+	ShapeTransform * current = Current();
+	if( !current )
+	{
+		throw me::exception::FailedToCreate( "A canonical shape requires a current ShapeTransform to receive its size and center!" );
+	}
+	*current = ShapeTransform( scale, offset );
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <shapes/CurrentScope.h>
+#include <unify/V3.h>
+#include <unify/BBox.h>
+#include <unify/Matrix.h>
+
+namespace shapes
+{
+	/// <summary>
+	/// The draw time transform of a shape created with ShapeDesc::canonical. A canonical shape is built unit sized
+	/// and centered on the origin, so only its topology decides its vertices; a caller can create it once and draw
+	/// it for every shape that differs only in size and center. The size and center asked for come back here as a
+	/// scale and an offset.
+	/// </summary>
+	struct ShapeTransform
+	{
+		// A canonical shape created while a transform is current overwrites it, so read it after each Create.
+		typedef CurrentScope< ShapeTransform > Scope;
+
+		ShapeTransform();
+		ShapeTransform( const unify::V3< float > & scale, const unify::V3< float > & offset );
+
+		unify::V3< float > scale;
+		unify::V3< float > offset;
+
+		bool IsIdentity() const;
+
+		/// <summary>
+		/// Scales, then translates by offset.
+		/// </summary>
+		unify::Matrix GetMatrix() const;
+
+		/// <summary>
+		/// The inverse transpose of GetMatrix without the translation, which keeps normals perpendicular to
+		/// surfaces under a non-uniform scale. Transformed normals need normalizing. An axis with no scale is
+		/// left as is.
+		/// </summary>
+		unify::Matrix GetNormalMatrix() const;
+
+		unify::V3< float > TransformPosition( const unify::V3< float > & position ) const;
+		unify::V3< float > TransformNormal( const unify::V3< float > & normal ) const;
+		unify::BBox< float > TransformBBox( const unify::BBox< float > & bbox ) const;
+
+		/// <summary>
+		/// Returns the transform current for the calling thread, or nullptr.
+		/// </summary>
+		static ShapeTransform * Current();
+
+		/// <summary>
+		/// Called by creators in canonical mode. Throws when no transform is current, as the shape's size and
+		/// center would otherwise be lost.
+		/// </summary>
+		static void Report( const unify::V3< float > & scale, const unify::V3< float > & offset );
+	};
+}
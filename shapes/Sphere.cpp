@@ -2,6 +2,10 @@
 // All Rights Reserved
 
 #include <shapes/Sphere.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapeTransform.h>
+#include <shapes/CollisionProxy.h>
+#include <shapes/ShapeKernels.h>
 #include <me/render/VertexUtil.h>
 #include <me/exception/FailedToCreate.h>
 #include <unify/String.h>
@@ -15,7 +19,21 @@ using namespace shapes;
 
 const float PI = 3.14159265358979f;
 const float PI2 = 6.28318530717959f;
-const std::string DefaultBufferUsage = "Default";
+
+SphereDesc::SphereDesc()
+	: radius{ 1.0f }
+	, segments{ 12 }
+{
+}
+
+SphereDesc::SphereDesc( const unify::Parameters & parameters )
+	: ShapeDesc( parameters )
+	, radius{ parameters.Get( "radius", 1.0f ) }
+	, segments{ parameters.Get< unsigned int >( "segments", 12 ) }
+	, autoSegments{ parameters }
+	, meshlets{ parameters }
+{
+}
 
 Sphere::Sphere()
 {
@@ -26,114 +44,131 @@ Sphere::~Sphere()
 }
 
 void Sphere::Create(PrimitiveList & primitiveList, const unify::Parameters & parameters ) const
+{
+	try
+	{
+		Create( primitiveList, SphereDesc( parameters ) );
+	}
+	catch( std::exception & ex )
+	{
+		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+	}
+}
+
+void Sphere::Create(PrimitiveList & primitiveList, const SphereDesc & desc ) const
 {
 	using namespace unify;
 
-	try
+	if( desc.canonical )
+	{
+		SphereDesc unit = desc;
+		unit.canonical = false;
+		unit.center = V3< float >( 0, 0, 0 );
+		unit.radius = 1.0f;
+		unit.segments = desc.autoSegments.Resolve( desc.radius, desc.segments );
+		unit.autoSegments.enabled = false;
+		ShapeTransform::Report( V3< float >( desc.radius, desc.radius, desc.radius ), desc.center );
+		Create( primitiveList, unit );
+		return;
+	}
+
+	if( desc.collision )
 	{
-		float radius = parameters.Get( "radius", 1.0f );
-		unsigned int segments = parameters.Get< unsigned int >( "segments", 12 );
-		Color diffuse = parameters.Get( "diffuse", unify::ColorWhite() );
-		Color specular = parameters.Get( "specular", unify::ColorWhite() );
-		V3< float > center = parameters.Get( "center", unify::V3< float >( 0, 0, 0 ) );
-		Effect::ptr effect = parameters.Get< Effect::ptr >( "effect" );
-		VertexDeclaration::ptr vd = effect->GetVertexShader()->GetVertexDeclaration();
-		BufferUsage::TYPE bufferUsage = BufferUsage::FromString( parameters.Get( "bufferusage", DefaultBufferUsage ) );
+		AddCollisionProxy( CollisionProxy::MakeSphere( desc.center, desc.radius ) );
+	}
 
-		if( segments < 4 ) segments = 4;
+	float radius = desc.radius;
+	unsigned int segments = desc.autoSegments.Resolve( desc.radius, desc.segments );
+	Color diffuse = desc.diffuse;
+	Color specular = desc.specular;
+	V3< float > center = desc.center;
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
 
-		bool bStrip = true;
+	if( segments < 4 ) segments = 4;
 
-		// TRIANGLE LIST version:
-		if( !bStrip )
-		{	// LIST VERSION
+	// Meshlets need a triangle list.
+	bool bStrip = !desc.meshlets.enabled;
 
-			int iFacesH = (int)segments;
-			int iFacesV = (int)iFacesH / 2;
+	// TRIANGLE LIST version:
+	if( !bStrip )
+	{	// LIST VERSION
 
-			size_t vertexCount = (iFacesH + 1) * (iFacesV + 1);
+		int iFacesH = (int)segments;
+		int iFacesV = (int)iFacesH / 2;
 
-			int iNumFaces = iFacesH * iFacesV * 2;	// Twice as many to count for triangles
-			unsigned int indexCount = iNumFaces * 3;			// Three indices to a triangle
+		size_t vertexCount = (iFacesH + 1) * (iFacesV + 1);
 
-			BufferSet & set = primitiveList.AddBufferSet();
-			set.SetEffect( effect );
+		int iNumFaces = iFacesH * iFacesV * 2;	// Twice as many to count for triangles
+		unsigned int indexCount = iNumFaces * 3;			// Three indices to a triangle
 
-			// Method 1 - Triangle List...
-			set.AddMethod( RenderMethod::CreateTriangleListIndexed( vertexCount, indexCount, 0, 0 ) );
+		BufferSet & set = primitiveList.AddBufferSet();
+		set.SetEffect( effect );
 
-			std::shared_ptr< unsigned char > vertices( new unsigned char[vd->GetSizeInBytes( 0 ) * vertexCount] );
-			DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
+		std::shared_ptr< unsigned char > vertices( new unsigned char[vd->GetSizeInBytes( 0 ) * vertexCount] );
+		DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
 
-			VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
+		VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
 
-			unsigned short stream = 0;
+		unsigned short stream = 0;
 
-			VertexElement positionE = CommonVertexElement::Position( stream );
-			VertexElement normalE = CommonVertexElement::Normal( stream );
-			VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
-			VertexElement specularE = CommonVertexElement::Specular( stream );
-			VertexElement texE = CommonVertexElement::TexCoords( stream );
+		VertexElement positionE = CommonVertexElement::Position( stream );
+		VertexElement normalE = CommonVertexElement::Normal( stream );
+		VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+		VertexElement specularE = CommonVertexElement::Specular( stream );
+		VertexElement texE = CommonVertexElement::TexCoords( stream );
 
-			class V
+		// Set the vertices...
+		std::vector< float > sinH( iFacesH + 1 ), cosH( iFacesH + 1 );
+		std::vector< float > sinV( iFacesV + 1 ), cosV( iFacesV + 1 );
+		kernels::SinCos( 0.0f, PI2 / iFacesH, iFacesH + 1, sinH.data(), cosH.data() );
+		kernels::SinCos( 0.0f, PI / iFacesV, iFacesV + 1, sinV.data(), cosV.data() );
+
+		std::vector< unify::V3< float > > positions( vertexCount );
+		std::vector< unify::V3< float > > normals( vertexCount );
+		int iVert = 0;
+		int v, h;
+		for( v = 0; v < (iFacesV + 1); v++ )
+		{
+			for( h = 0; h < (iFacesH + 1); h++ )
 			{
-			public:
-				unify::V3< float > pos;
-				unify::V3< float > normal;
-				unify::Color diffuse;
-				unify::Color specular;
-				unify::TexCoords coords;
-			};
-			qjson::Object jsonFormat;
-			jsonFormat.Add( { "Position", "Float3" } );
-			jsonFormat.Add( { "Normal", "Float3" } );
-			jsonFormat.Add( { "Diffuse", "Color" } );
-			jsonFormat.Add( { "Specular", "Color" } );
-			jsonFormat.Add( { "TexCoord", "TexCoord" } );
-			VertexDeclaration::ptr vFormat( new VertexDeclaration( jsonFormat ) );
-
-			unify::V3< float > vec, norm;
-
-			// Set the vertices...
-			float fRadH, fRadV;
-			int iVert = 0;
-			int v, h;
-			for( v = 0; v < (iFacesV + 1); v++ )
+				positions[iVert++] = unify::V3< float >(
+					(cosH[h] * sinV[v] * radius),
+					(1 * cosV[v] * radius),
+					(sinH[h] * sinV[v] * radius)
+					);
+			}
+		}
+		kernels::Normalize( positions.data(), normals.data(), vertexCount );
+		kernels::Transform( kernels::Affine::Translation( center ), positions.data(), positions.data(), vertexCount );
+		kernels::Bounds( positions.data(), vertexCount, vbParameters.bbox );
+
+		iVert = 0;
+		for( v = 0; v < (iFacesV + 1); v++ )
+		{
+			for( h = 0; h < (iFacesH + 1); h++ )
 			{
-				fRadV = (PI / iFacesV) * v;
-
-				for( h = 0; h < (iFacesH + 1); h++ )
-				{
-					fRadH = (PI2 / iFacesH) * h;
-
-					vec = unify::V3< float >(
-						(cosf( fRadH )	* sinf( fRadV )	* radius),
-						(1 * cosf( fRadV )	* radius),
-						(sinf( fRadH )	* sinf( fRadV )	* radius)
-						);
-
-					norm = vec;
-					norm.Normalize();
-
-					vec += center;
-					WriteVertex( *vd, lock, iVert, positionE, vec );
-					WriteVertex( *vd, lock, iVert, normalE, norm );
-					WriteVertex( *vd, lock, iVert, diffuseE, diffuse );
-					WriteVertex( *vd, lock, iVert, specularE, specular );
-					WriteVertex( *vd, lock, iVert, texE, unify::TexCoords( h * (1.0f / iFacesH), v * (1.0f / iFacesV) ) );
-					vbParameters.bbox += vec;
-					iVert++;
-				}
+				WriteVertex( *vd, lock, iVert, positionE, positions[iVert] );
+				WriteVertex( *vd, lock, iVert, normalE, normals[iVert] );
+				WriteVertex( *vd, lock, iVert, diffuseE, diffuse );
+				WriteVertex( *vd, lock, iVert, specularE, specular );
+				WriteVertex( *vd, lock, iVert, texE, unify::TexCoords( h * (1.0f / iFacesH), v * (1.0f / iFacesV) ) );
+				iVert++;
 			}
+		}
 
-			set.AddVertexBuffer( vbParameters );
+		AddVertexBuffer( set, vbParameters );
 
-			// Indices...
-			std::vector< Index32 > indices( indexCount );
+		// Indices...
+		IndexCache::Key key{ "SphereList", { segments } };
+		IndexCache::Generator generate = [&]( std::vector< Index32 > & indices )
+		{
+			indices.resize( indexCount );
 			Index32 io = 0;
-			for( v = 0; v < iFacesV; v++ )
+			for( int v = 0; v < iFacesV; v++ )
 			{
-				for( h = 0; h < iFacesH; h++ )
+				for( int h = 0; h < iFacesH; h++ )
 				{
 					//						V							H
 					indices[io++] = (Index32)((v * (iFacesH + 1)) + h);
@@ -145,85 +180,109 @@ void Sphere::Create(PrimitiveList & primitiveList, const unify::Parameters & par
 					indices[io++] = (Index32)(((v + 1) * (iFacesH + 1)) + h);
 				}
 			}
+		};
 
-			set.AddIndexBuffer( { { { indexCount, (Index32*)&indices[0] } }, bufferUsage } );
+		if( desc.meshlets.enabled )
+		{
+			// Meshlet order is topology too, so the reordered indices are cached alongside the plain ones.
+			key = IndexCache::Key{ "SphereListMeshlets", { segments, desc.meshlets.maxVertices, desc.meshlets.maxTriangles } };
+			generate = [plain = generate, &desc]( std::vector< Index32 > & indices )
+			{
+				plain( indices );
+				OrderForMeshlets( indices, desc.meshlets.maxVertices, desc.meshlets.maxTriangles );
+			};
+			IndexCache::Indices indices = IndexCache::Instance().GetIndices( key, generate );
+			std::vector< Meshlet > meshlets = BuildMeshlets( positions.data(), normals.data(), indices->data(), indices->size(), desc.meshlets.maxVertices, desc.meshlets.maxTriangles );
+			AddMeshletMethods( set, meshlets, (unsigned int)vertexCount );
 		}
 		else
-		{	// STRIP VERSION
-			int iRows = (int)segments;
-			int iColumns = (int)iRows / 2;
-			size_t vertexCount = (iRows + 1) * (iColumns + 1);
-			unsigned int indexCount = (iColumns * (2 * (iRows + 1))) + (((iColumns - 1) * 2));
-
-			BufferSet & set = primitiveList.AddBufferSet();
-			set.SetEffect( effect );
-
-			// Method 1 - Triangle Strip...
-			RenderMethod renderMethod( RenderMethod::CreateTriangleStripIndexed( vertexCount, indexCount, 0, 0 ) );
-			set.AddMethod( renderMethod );
-
-			std::shared_ptr< unsigned char > vertices( new unsigned char[vd->GetSizeInBytes( 0 ) * vertexCount] );
-
-			unsigned short stream = 0;
-
-			VertexElement positionE = CommonVertexElement::Position( stream );
-			VertexElement normalE = CommonVertexElement::Normal( stream );
-			VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
-			VertexElement specularE = CommonVertexElement::Specular( stream );
-			VertexElement texE = CommonVertexElement::TexCoords( stream );
-								
-			V3< float > vec, norm;
-			TexCoords coords;
-
-			// Set the vertices...
-			DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
-
-			VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
+		{
+			// Method 1 - Triangle List...
+			AddMethod( set, RenderMethod::CreateTriangleListIndexed( vertexCount, indexCount, 0, 0 ) );
+		}
 
-			float fRadH, fRadV;
-			int iVert = 0;
-			int v, h;
-			for( v = 0; v < (iColumns + 1); v++ )
+		AddSharedIndexBuffer( set, key, bufferUsage, generate );
+	}
+	else
+	{	// STRIP VERSION
+		int iRows = (int)segments;
+		int iColumns = (int)iRows / 2;
+		size_t vertexCount = (iRows + 1) * (iColumns + 1);
+		unsigned int indexCount = (iColumns * (2 * (iRows + 1))) + (((iColumns - 1) * 2));
+
+		BufferSet & set = primitiveList.AddBufferSet();
+		set.SetEffect( effect );
+
+		// Method 1 - Triangle Strip...
+		RenderMethod renderMethod( RenderMethod::CreateTriangleStripIndexed( vertexCount, indexCount, 0, 0 ) );
+		AddMethod( set, renderMethod );
+
+		std::shared_ptr< unsigned char > vertices( new unsigned char[vd->GetSizeInBytes( 0 ) * vertexCount] );
+
+		unsigned short stream = 0;
+
+		VertexElement positionE = CommonVertexElement::Position( stream );
+		VertexElement normalE = CommonVertexElement::Normal( stream );
+		VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+		VertexElement specularE = CommonVertexElement::Specular( stream );
+		VertexElement texE = CommonVertexElement::TexCoords( stream );
+							
+		// Set the vertices...
+		DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
+
+		VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
+
+		std::vector< float > sinH( iRows + 1 ), cosH( iRows + 1 );
+		std::vector< float > sinV( iColumns + 1 ), cosV( iColumns + 1 );
+		kernels::SinCos( 0.0f, PI2 / iRows, iRows + 1, sinH.data(), cosH.data() );
+		kernels::SinCos( 0.0f, PI / iColumns, iColumns + 1, sinV.data(), cosV.data() );
+
+		std::vector< V3< float > > positions( vertexCount );
+		std::vector< V3< float > > normals( vertexCount );
+		int iVert = 0;
+		int v, h;
+		for( v = 0; v < (iColumns + 1); v++ )
+		{
+			for( h = 0; h < (iRows + 1); h++ )
 			{
-				fRadV = (PI / (iColumns)) * v;
-
-				for( h = 0; h < (iRows + 1); h++ )
-				{
-					fRadH = (PI2 / iRows) * h;
-
-					vec = unify::V3< float >(
-						cosf( fRadH )	* sinf( fRadV )	* radius,	// X
-						-1 * cosf( fRadV )	* radius,	// Y
-						sinf( fRadH )	* sinf( fRadV )	* radius	// Z
-						);
-
-					norm = vec;
-					norm.Normalize();
-
-					vec += center;
-
-					coords = unify::TexCoords( h * (1.0f / iRows), 1 - v * (1.0f / iColumns) );
-
-					WriteVertex( *vd, lock, iVert, positionE, vec );
-					WriteVertex( *vd, lock, iVert, normalE, norm );
-					WriteVertex( *vd, lock, iVert, diffuseE, diffuse );
-					WriteVertex( *vd, lock, iVert, specularE, specular );
-					WriteVertex( *vd, lock, iVert, texE, coords );
-					vbParameters.bbox += vec;
-					iVert++;
-				}
+				positions[iVert++] = unify::V3< float >(
+					cosH[h] * sinV[v] * radius,	// X
+					-1 * cosV[v] * radius,	// Y
+					sinH[h] * sinV[v] * radius	// Z
+					);
 			}
-		
-			set.AddVertexBuffer( vbParameters );
-
-			std::vector< Index32 > indices( indexCount );
+		}
+		kernels::Normalize( positions.data(), normals.data(), vertexCount );
+		kernels::Transform( kernels::Affine::Translation( center ), positions.data(), positions.data(), vertexCount );
+		kernels::Bounds( positions.data(), vertexCount, vbParameters.bbox );
+
+		iVert = 0;
+		for( v = 0; v < (iColumns + 1); v++ )
+		{
+			for( h = 0; h < (iRows + 1); h++ )
+			{
+				TexCoords coords = unify::TexCoords( h * (1.0f / iRows), 1 - v * (1.0f / iColumns) );
+
+				WriteVertex( *vd, lock, iVert, positionE, positions[iVert] );
+				WriteVertex( *vd, lock, iVert, normalE, normals[iVert] );
+				WriteVertex( *vd, lock, iVert, diffuseE, diffuse );
+				WriteVertex( *vd, lock, iVert, specularE, specular );
+				WriteVertex( *vd, lock, iVert, texE, coords );
+				iVert++;
+			}
+		}
+	
+		AddVertexBuffer( set, vbParameters );
 
-			// Indices...
+		// Indices...
+		AddSharedIndexBuffer( set, { "SphereStrip", { segments } }, bufferUsage, [&]( std::vector< Index32 > & indices )
+		{
+			indices.resize( indexCount );
 			Index32 io = 0;
 			int segmentmentsH = iRows + 1;	// Number of segments
-			for( v = 0; v < iColumns; v++ )
+			for( int v = 0; v < iColumns; v++ )
 			{
-				for( h = 0; h < segmentmentsH; h++ )
+				for( int h = 0; h < segmentmentsH; h++ )
 				{
 					indices[io++] = (Index32)((segmentmentsH * v) + h);
 					indices[io++] = (Index32)((segmentmentsH * (v + 1)) + h);
@@ -234,12 +293,11 @@ void Sphere::Create(PrimitiveList & primitiveList, const unify::Parameters & par
 					indices[io++] = (Index32)(segmentmentsH * (v + 1));
 				}
 			}
-
-			set.AddIndexBuffer( { { { indexCount, &indices[0] } }, bufferUsage } );
-		}
-	}
-	catch( std::exception & ex )
-	{
-		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+		} );
 	}
 }
+
+IShapeQuery::ptr Sphere::CreateQuery( const SphereDesc & desc ) const
+{
+	return IShapeQuery::ptr( new SphereQuery( desc.center, desc.radius ) );
+}
@@ -3,9 +3,26 @@
 #pragma once
 
 #include <me/sculpter/IShapeCreator.h>
+#include <shapes/ShapeDesc.h>
+#include <shapes/ShapeQuery.h>
+#include <shapes/Meshlets.h>
+#include <shapes/AutoSegments.h>
 
 namespace shapes
 {
+	struct SphereDesc : public ShapeDesc
+	{
+		SphereDesc();
+		SphereDesc( const unify::Parameters & parameters );
+
+		float radius;
+		unsigned int segments;
+		AutoSegments autoSegments;
+
+		// Draw as meshlets, one method each, with their bounds and cones in the current MeshletTable.
+		MeshletOptions meshlets;
+	};
+
 	class Sphere : public me::sculpter::IShapeCreator
 	{
 	public:
@@ -13,5 +30,11 @@ namespace shapes
 		~Sphere() override;
 
 		void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+		void Create( me::render::PrimitiveList & primitiveList, const SphereDesc & desc ) const;
+
+		/// <summary>
+		/// The exact shape desc describes, for picking and containment without its triangles.
+		/// </summary>
+		IShapeQuery::ptr CreateQuery( const SphereDesc & desc ) const;
 	};
 }
\ No newline at end of file
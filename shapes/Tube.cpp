@@ -2,12 +2,17 @@
 // All Rights Reserved
 
 #include <shapes/Tube.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapeTransform.h>
+#include <shapes/CollisionProxy.h>
+#include <shapes/ShapeKernels.h>
 #include <me/exception/NotImplemented.h>
 #include <me/exception/FailedToCreate.h>
 #include <me/render/VertexUtil.h>
 #include <unify/String.h>
 #include <unify/Size3.h>
 #include <unify/TexArea.h>
+#include <algorithm>
 #include <unify/Angle.h>
 
 using namespace me;
@@ -16,7 +21,70 @@ using namespace shapes;
 
 const float PI = 3.14159265358979f;
 const float PI2 = 6.28318530717959f;
-const std::string DefaultBufferUsage = "Default";
+
+namespace
+{
+	// A hollow tube is not convex, so its proxy is a ring of convex wedges; a solid one is a single prism.
+	void AddCollisionWedges( const TubeDesc & desc )
+	{
+		using namespace unify;
+
+		unsigned int segments = std::max( 3u, desc.collisionSegments );
+		float half = desc.height * 0.5f;
+		std::vector< V3< float > > outer( segments );
+		for( unsigned int s = 0; s < segments; ++s )
+		{
+			float angle = PI2 * s / segments;
+			outer[s] = desc.center + V3< float >( sinf( angle ) * desc.majorRadius, 0, cosf( angle ) * desc.majorRadius );
+		}
+
+		if( desc.minorRadius <= 0.0f )
+		{
+			AddCollisionPrism( outer.data(), segments, desc.center.y - half, desc.center.y + half );
+			return;
+		}
+
+		float ratio = desc.minorRadius / desc.majorRadius;
+		for( unsigned int s = 0; s < segments; ++s )
+		{
+			const V3< float > & outer0 = outer[s];
+			const V3< float > & outer1 = outer[( s + 1 ) % segments];
+			V3< float > wedge[4] =
+			{
+				desc.center + ( outer0 - desc.center ) * ratio,
+				outer0,
+				outer1,
+				desc.center + ( outer1 - desc.center ) * ratio
+			};
+			AddCollisionPrism( wedge, 4, desc.center.y - half, desc.center.y + half );
+		}
+	}
+}
+
+TubeDesc::TubeDesc()
+	: majorRadius{ 0.5f }
+	, minorRadius{ 0.3f }
+	, height{ 1.0f }
+	, segments{ 12 }
+	, merged{ false }
+	, indexed{ false }
+	, collisionSegments{ 8 }
+{
+}
+
+TubeDesc::TubeDesc( const unify::Parameters & parameters )
+	: ShapeDesc( parameters )
+	, majorRadius{ parameters.Get( "majorradius", 0.5f ) }
+	, minorRadius{ parameters.Get( "minorradius", 0.3f ) }
+	, height{ parameters.Get( "height", 1.0f ) }
+	, segments{ parameters.Get< unsigned int >( "segments", 12 ) }
+	, merged{ parameters.Get( "merged", false ) }
+	, indexed{ parameters.Get( "indexed", false ) }
+	, autoSegments{ parameters }
+	, meshlets{ parameters }
+	, collisionSegments{ parameters.Get< unsigned int >( "collisionsegments", 8 ) }
+{
+}
 
 Tube::Tube()
 {
@@ -28,176 +96,387 @@ Tube::~Tube()
 
 void Tube::Create(PrimitiveList & primitiveList, const unify::Parameters & parameters ) const
 {
-	using namespace unify;
-	
 	try
 	{
-		float outer = parameters.Get( "majorradius", 0.5f );
-		float inner = parameters.Get( "minorradius", 0.3f );
-		unsigned int segments = parameters.Get< unsigned int >( "segments", 12 );
-		float height = parameters.Get( "height", 1.0f );
-		Color diffuse = parameters.Get( "diffuse", unify::ColorWhite() );
-		Color specular = parameters.Get( "specular", unify::ColorWhite() );
-		V3< float > center = parameters.Get( "center", unify::V3< float >( 0, 0, 0 ) );
-		Effect::ptr effect = parameters.Get< Effect::ptr >( "effect" );
-		VertexDeclaration::ptr vd = effect->GetVertexShader()->GetVertexDeclaration();
-		BufferUsage::TYPE bufferUsage = BufferUsage::FromString( parameters.Get( "bufferusage", DefaultBufferUsage ) );
+		Create( primitiveList, TubeDesc( parameters ) );
+	}
+	catch( std::exception & ex )
+	{
+		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+	}
+}
 
-		if( segments < 3 ) segments = 3;
+void Tube::Create(PrimitiveList & primitiveList, const TubeDesc & desc ) const
+{
+	using namespace unify;
 
-		size_t vertexCount = RenderMethod::VertexCountInATriangleStrip( segments * 2 ) * 4;
+	if( desc.canonical )
+	{
+		// The unit shape is the real one divided by its outer radius.
+		if( !( desc.majorRadius > 0.0f ) )
+		{
+			throw me::exception::FailedToCreate( "Canonical Tube needs a positive majorradius!" );
+		}
 
-		// Height is distance from origin/center.
-		height *= 0.5f;
+		TubeDesc unit = desc;
+		unit.canonical = false;
+		unit.center = V3< float >( 0, 0, 0 );
+		// The ratio of the radii is topology, so only the outer radius is scaled out.
+		unit.majorRadius = 1.0f;
+		unit.minorRadius = desc.minorRadius / desc.majorRadius;
+		unit.height = 1.0f;
+		unit.segments = desc.autoSegments.Resolve( desc.majorRadius, desc.segments );
+		unit.autoSegments.enabled = false;
+		ShapeTransform::Report( V3< float >( desc.majorRadius, desc.height, desc.majorRadius ), desc.center );
+		Create( primitiveList, unit );
+		return;
+	}
 
-		// a segment is made up of two triangles... segments * 2 = NumTriangles
-		BufferSet & set = primitiveList.AddBufferSet();
-		set.SetEffect( effect );
+	if( desc.collision )
+	{
+		AddCollisionWedges( desc );
+	}
 
-		std::shared_ptr< unsigned char > vertices( new unsigned char[vd->GetSizeInBytes( 0 ) * vertexCount] );
-		DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
+	if( desc.indexed || desc.meshlets.enabled )
+	{
+		CreateIndexed( primitiveList, desc );
+		return;
+	}
+
+	float outer = desc.majorRadius;
+	float inner = desc.minorRadius;
+	unsigned int segments = desc.autoSegments.Resolve( desc.majorRadius, desc.segments );
+	float height = desc.height;
+	Color diffuse = desc.diffuse;
+	Color specular = desc.specular;
+	V3< float > center = desc.center;
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
+	bool merged = desc.merged;
+
+	if( segments < 3 ) segments = 3;
+
+	size_t vertexCount = RenderMethod::VertexCountInATriangleStrip( segments * 2 ) * 4;
+
+	// Height is distance from origin/center.
+	height *= 0.5f;
+
+	// a segment is made up of two triangles... segments * 2 = NumTriangles
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
 
-		VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
+	std::shared_ptr< unsigned char > vertices( new unsigned char[vd->GetSizeInBytes( 0 ) * vertexCount] );
+	DataLock lock( vertices.get(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
 
-		unsigned short stream = 0;
+	VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.get() } }, bufferUsage };
 
-		VertexElement positionE = CommonVertexElement::Position( stream );
-		VertexElement normalE = CommonVertexElement::Normal( stream );
-		VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
-		VertexElement specularE = CommonVertexElement::Specular( stream );
-		VertexElement texE = CommonVertexElement::TexCoords( stream );
+	unsigned short stream = 0;
 
-		class V
+	VertexElement positionE = CommonVertexElement::Position( stream );
+	VertexElement normalE = CommonVertexElement::Normal( stream );
+	VertexElement diffuseE = CommonVertexElement::Diffuse( stream );
+	VertexElement specularE = CommonVertexElement::Specular( stream );
+	VertexElement texE = CommonVertexElement::TexCoords( stream );
+
+	class V
+	{
+	public:
+		unify::V3< float > pos;
+		unify::V3< float > normal;
+		unify::Color diffuse;
+		unify::Color specular;
+		unify::TexCoords coords;
+	};
+	qjson::Object jsonFormat;
+	jsonFormat.Add( { "Position", "Float3" } );
+	jsonFormat.Add( { "Normal", "Float3" } );
+	jsonFormat.Add( { "Diffuse", "Color" } );
+	jsonFormat.Add( { "Specular", "Color" } );
+	jsonFormat.Add( { "TexCoord", "TexCoord" } );
+	VertexDeclaration::ptr vFormat( new VertexDeclaration( jsonFormat ) );
+
+	unsigned int trianglesPerSide = segments * 2;
+	unsigned int verticesPerSide = segments * 2 + 2;
+
+	std::vector< Index32 > indices;
+	if( merged )
+	{
+		// All four strips as one list.
+		for( unsigned int side = 0; side < 4; ++side )
 		{
-		public:
-			unify::V3< float > pos;
-			unify::V3< float > normal;
-			unify::Color diffuse;
-			unify::Color specular;
-			unify::TexCoords coords;
-		};
-		qjson::Object jsonFormat;
-		jsonFormat.Add( { "Position", "Float3" } );
-		jsonFormat.Add( { "Normal", "Float3" } );
-		jsonFormat.Add( { "Diffuse", "Color" } );
-		jsonFormat.Add( { "Specular", "Color" } );
-		jsonFormat.Add( { "TexCoord", "TexCoord" } );
-		VertexDeclaration::ptr vFormat( new VertexDeclaration( jsonFormat ) );
-
-		unsigned int trianglesPerSide = segments * 2;
-		unsigned int verticesPerSide = segments * 2 + 2;
+			AppendTriangleStrip( indices, side * verticesPerSide, trianglesPerSide );
+		}
+		AddMethod( set, RenderMethod::CreateTriangleListIndexed( (unsigned int)vertexCount, (unsigned int)indices.size(), 0, 0 ) );
+	}
+	else
+	{
+		// Method 1 - Triangle Strip (Top)
+		AddMethod( set, RenderMethod::CreateTriangleStrip( 0 * verticesPerSide, trianglesPerSide ) );
+
+		// Method 2 - Triangle Strip (Bottom)
+		AddMethod( set, RenderMethod::CreateTriangleStrip( 1 * verticesPerSide, trianglesPerSide ) );
+
+		// Method 3 - Triangle Strip (Outside)
+		AddMethod( set, RenderMethod::CreateTriangleStrip( 2 * verticesPerSide, trianglesPerSide ) );
+
+		// Method 4 - Triangle Strip (Inside)
+		AddMethod( set, RenderMethod::CreateTriangleStrip( 3 * verticesPerSide, trianglesPerSide ) );
+	}
+
+	// Vertices are staged around the origin, then moved to center and bounded in bulk.
+	std::vector< V > staged( vertexCount );
+	std::vector< V3< float > > positions( vertexCount );
+	auto stage = [&]( size_t index, const V & vertex )
+	{
+		staged[index] = vertex;
+		positions[index] = vertex.pos;
+	};
+
+	std::vector< float > sines( segments + 1 );
+	std::vector< float > cosines( segments + 1 );
+	kernels::SinCos( 0.0f, PI2 / segments, segments + 1, sines.data(), cosines.data() );
+
+	V vertex;
+	float ratioT = inner / outer;
+	for( unsigned int v = 0; v < (segments + 1); v++ )
+	{
+		unify::V2< float > coord( sines[v], cosines[v] );
 
 		// Method 1 - Triangle Strip (Top)
-		set.AddMethod( RenderMethod::CreateTriangleStrip( 0 * verticesPerSide, trianglesPerSide ) );
+		// Outside edge
+		vertex.pos = unify::V3< float >( coord.x * outer, height, coord.y * outer );
+		vertex.normal = unify::V3< float >( 0, 1, 0 );
+		vertex.coords = unify::TexCoords( 0.5f + (coord.x * 0.5f), 0.5f + (coord.y * -0.5f) );
+		vertex.diffuse = diffuse;
+		vertex.specular = specular;
+		stage( (0 * verticesPerSide) + (v * 2), vertex );
+
+
+		// Inside edge
+		vertex.pos = unify::V3< float >( coord.x * inner, height, coord.y * inner );
+		vertex.normal = unify::V3< float >( 0, 1, 0 );
+		vertex.coords = unify::TexCoords( 0.5f + (coord.x * 0.5f * ratioT), 0.5f + (coord.y * -0.5f * ratioT) );
+		vertex.diffuse = diffuse;
+		vertex.specular = specular;
+		stage( (0 * verticesPerSide) + (v * 2) + 1, vertex );
 
 		// Method 2 - Triangle Strip (Bottom)
-		set.AddMethod( RenderMethod::CreateTriangleStrip( 1 * verticesPerSide, trianglesPerSide ) );
+		// Outside edge
+		vertex.pos = unify::V3< float >( coord.x * outer, -height, coord.y * outer );
+		vertex.normal = unify::V3< float >( 0, -1, 0 );
+		vertex.coords = unify::TexCoords( 0.5f + (coord.x * 0.5f), 0.5f + (coord.y * -0.5f) );
+		vertex.diffuse = diffuse;
+		vertex.specular = specular;
+		stage( (1 * verticesPerSide) + (v * 2), vertex );
+
+		// Inside edge
+		vertex.pos = unify::V3< float >( coord.x * inner, -height, coord.y * inner );
+		vertex.normal = unify::V3< float >( 0, -1, 0 );
+		vertex.coords = unify::TexCoords( 0.5f + (coord.x * 0.5f * ratioT), 0.5f + (coord.y * -0.5f * ratioT) );
+		vertex.diffuse = diffuse;
+		vertex.specular = specular;
+		stage( (1 * verticesPerSide) + (v * 2) + 1, vertex );
 
 		// Method 3 - Triangle Strip (Outside)
-		set.AddMethod( RenderMethod::CreateTriangleStrip( 2 * verticesPerSide, trianglesPerSide ) );
+		// Top
+		vertex.pos = unify::V3< float >( coord.x * outer, height, coord.y * outer );
+		vertex.normal = unify::V3< float >( coord.x, 0, coord.y );
+		vertex.coords = unify::TexCoords( (1.0f / segments) * v, 0 );
+		vertex.diffuse = diffuse;
+		vertex.specular = specular;
+		stage( (2 * verticesPerSide) + (v * 2), vertex );
+
+		// Bottom
+		vertex.pos = unify::V3< float >( coord.x * outer, -height, coord.y * outer );
+		vertex.normal = unify::V3< float >( coord.x, 0, coord.y );
+		vertex.coords = unify::TexCoords( (1.0f / segments) * v, 1 );
+		vertex.diffuse = diffuse;
+		vertex.specular = specular;
+		stage( (2 * verticesPerSide) + (v * 2) + 1, vertex );
 
 		// Method 4 - Triangle Strip (Inside)
-		set.AddMethod( RenderMethod::CreateTriangleStrip( 3 * verticesPerSide, trianglesPerSide ) );
+		// Top
+		vertex.pos = unify::V3< float >( coord.x * inner, height, coord.y * inner );
+		vertex.normal = unify::V3< float >( coord.x, 0, coord.y );
+		vertex.coords = unify::TexCoords( (1.0f / segments) * v, 0 );
+		vertex.diffuse = diffuse;
+		vertex.specular = specular;
+		stage( (3 * verticesPerSide) + (v * 2), vertex );
+
+		// Bottom
+		vertex.pos = unify::V3< float >( coord.x * inner, -height, coord.y * inner );
+		vertex.normal = unify::V3< float >( coord.x, 0, coord.y );
+		vertex.coords = unify::TexCoords( (1.0f / segments) * v, 1 );
+		vertex.diffuse = diffuse;
+		vertex.specular = specular;
+		stage( (3 * verticesPerSide) + (v * 2) + 1, vertex );
+	}
+
+	kernels::Transform( kernels::Affine::Translation( center ), positions.data(), positions.data(), vertexCount );
+	kernels::Bounds( positions.data(), vertexCount, vbParameters.bbox );
+	for( size_t index = 0; index < vertexCount; ++index )
+	{
+		staged[index].pos = positions[index];
+		WriteVertex( *vd, lock, index, *vFormat, &staged[index] );
+	}
+
+	AddVertexBuffer( set, vbParameters );
+
+	if( !indices.empty() )
+	{
+		AddIndexBuffer( set, { { { indices.size(), &indices[0] } }, bufferUsage } );
+	}
+}
 
-		V vertex;
-		float radiansChange = PI2 / segments;
-		float ratioT = inner / outer;
-		for( unsigned int v = 0; v < (segments + 1); v++ )
+void Tube::CreateIndexed( PrimitiveList & primitiveList, const TubeDesc & desc ) const
+{
+	using namespace unify;
+
+	float outer = desc.majorRadius;
+	float inner = desc.minorRadius;
+	unsigned int segments = desc.autoSegments.Resolve( desc.majorRadius, desc.segments );
+	float height = desc.height;
+	V3< float > center = desc.center;
+	Effect::ptr effect = desc.effect;
+	VertexDeclaration::ptr vd = desc.GetVertexDeclaration();
+	BufferUsage::TYPE bufferUsage = desc.bufferUsage;
+
+	if( segments < 3 ) segments = 3;
+
+	// Height is distance from origin/center.
+	height *= 0.5f;
+
+	// No two parts share a normal, so each part keeps its own rings. The caps' texture coordinates are planar,
+	// so only the side rings need a seam vertex.
+	const unsigned int capRing = segments;
+	const unsigned int sideRing = segments + 1;
+	const unsigned int topOuter = 0;
+	const unsigned int topInner = topOuter + capRing;
+	const unsigned int bottomOuter = topInner + capRing;
+	const unsigned int bottomInner = bottomOuter + capRing;
+	const unsigned int outsideTop = bottomInner + capRing;
+	const unsigned int outsideBottom = outsideTop + sideRing;
+	const unsigned int insideTop = outsideBottom + sideRing;
+	const unsigned int insideBottom = insideTop + sideRing;
+	size_t vertexCount = insideBottom + sideRing;
+
+	BufferSet & set = primitiveList.AddBufferSet();
+	set.SetEffect( effect );
+
+	std::vector< unsigned char > vertices( vd->GetSizeInBytes( 0 ) * vertexCount );
+	DataLock lock( vertices.data(), vd->GetSizeInBytes( 0 ), vertexCount, DataLockAccess::ReadWrite, 0 );
+
+	VertexBufferParameters vbParameters{ vd, { { vertexCount, vertices.data() } }, bufferUsage };
+
+	class V
+	{
+	public:
+		unify::V3< float > pos;
+		unify::V3< float > normal;
+		unify::Color diffuse;
+		unify::Color specular;
+		unify::TexCoords coords;
+	};
+	qjson::Object jsonFormat;
+	jsonFormat.Add( { "Position", "Float3" } );
+	jsonFormat.Add( { "Normal", "Float3" } );
+	jsonFormat.Add( { "Diffuse", "Color" } );
+	jsonFormat.Add( { "Specular", "Color" } );
+	jsonFormat.Add( { "TexCoord", "TexCoord" } );
+	VertexDeclaration::ptr vFormat( new VertexDeclaration( jsonFormat ) );
+
+	// Vertices are staged around the origin, then moved to center and bounded in bulk.
+	std::vector< V > staged( vertexCount );
+	std::vector< V3< float > > positions( vertexCount );
+	auto place = [&]( size_t index, V3< float > pos, V3< float > normal, TexCoords coords )
+	{
+		V & vertex = staged[index];
+		vertex.pos = pos;
+		vertex.normal = normal;
+		vertex.coords = coords;
+		vertex.diffuse = desc.diffuse;
+		vertex.specular = desc.specular;
+		positions[index] = pos;
+	};
+
+	std::vector< float > sines( sideRing );
+	std::vector< float > cosines( sideRing );
+	kernels::SinCos( 0.0f, PI2 / segments, sideRing, sines.data(), cosines.data() );
+
+	float ratioT = inner / outer;
+	for( unsigned int v = 0; v < sideRing; v++ )
+	{
+		unify::V2< float > coord( sines[v], cosines[v] );
+
+		if( v < capRing )
 		{
-			float radians = radiansChange * v;
-
-			unify::V2< float > coord( sin( radians ), cos( radians ) );
-
-			// Method 1 - Triangle Strip (Top)
-			// Outside edge
-			vertex.pos = unify::V3< float >( coord.x * outer, height, coord.y * outer );
-			vertex.pos += center;
-			vertex.normal = unify::V3< float >( 0, 1, 0 );
-			vertex.coords = unify::TexCoords( 0.5f + (coord.x * 0.5f), 0.5f + (coord.y * -0.5f) );
-			vertex.diffuse = diffuse;
-			vertex.specular = specular;
-			WriteVertex( *vd, lock, (0 * verticesPerSide) + (v * 2), *vFormat, &vertex );
-			vbParameters.bbox += vertex.pos;
-
-
-			// Inside edge
-			vertex.pos = unify::V3< float >( coord.x * inner, height, coord.y * inner );
-			vertex.pos += center;
-			vertex.normal = unify::V3< float >( 0, 1, 0 );
-			vertex.coords = unify::TexCoords( 0.5f + (coord.x * 0.5f * ratioT), 0.5f + (coord.y * -0.5f * ratioT) );
-			vertex.diffuse = diffuse;
-			vertex.specular = specular;
-			WriteVertex( *vd, lock, (0 * verticesPerSide) + (v * 2) + 1, *vFormat, &vertex );
-			vbParameters.bbox += vertex.pos;
-
-			// Method 2 - Triangle Strip (Bottom)
-			// Outside edge
-			vertex.pos = unify::V3< float >( coord.x * outer, -height, coord.y * outer );
-			vertex.pos += center;
-			vertex.normal = unify::V3< float >( 0, -1, 0 );
-			vertex.coords = unify::TexCoords( 0.5f + (coord.x * 0.5f), 0.5f + (coord.y * -0.5f) );
-			vertex.diffuse = diffuse;
-			vertex.specular = specular;
-			WriteVertex( *vd, lock, (1 * verticesPerSide) + (v * 2), *vFormat, &vertex );
-			vbParameters.bbox += vertex.pos;
-
-			// Inside edge
-			vertex.pos = unify::V3< float >( coord.x * inner, -height, coord.y * inner );
-			vertex.pos += center;
-			vertex.normal = unify::V3< float >( 0, -1, 0 );
-			vertex.coords = unify::TexCoords( 0.5f + (coord.x * 0.5f * ratioT), 0.5f + (coord.y * -0.5f * ratioT) );
-			vertex.diffuse = diffuse;
-			vertex.specular = specular;
-			WriteVertex( *vd, lock, (1 * verticesPerSide) + (v * 2) + 1, *vFormat, &vertex );
-			vbParameters.bbox += vertex.pos;
-
-			// Method 3 - Triangle Strip (Outside)
-			// Top
-			vertex.pos = unify::V3< float >( coord.x * outer, height, coord.y * outer );
-			vertex.pos += center;
-			vertex.normal = unify::V3< float >( coord.x, 0, coord.y );
-			vertex.coords = unify::TexCoords( (1.0f / segments) * v, 0 );
-			vertex.diffuse = diffuse;
-			vertex.specular = specular;
-			WriteVertex( *vd, lock, (2 * verticesPerSide) + (v * 2), *vFormat, &vertex );
-			vbParameters.bbox += vertex.pos;
-
-			// Bottom
-			vertex.pos = unify::V3< float >( coord.x * outer, -height, coord.y * outer );
-			vertex.pos += center;
-			vertex.normal = unify::V3< float >( coord.x, 0, coord.y );
-			vertex.coords = unify::TexCoords( (1.0f / segments) * v, 1 );
-			vertex.diffuse = diffuse;
-			vertex.specular = specular;
-			WriteVertex( *vd, lock, (2 * verticesPerSide) + (v * 2) + 1, *vFormat, &vertex );
-			vbParameters.bbox += vertex.pos;
-
-			// Method 4 - Triangle Strip (Inside)
-			// Top
-			vertex.pos = unify::V3< float >( coord.x * inner, height, coord.y * inner );
-			vertex.pos += center;
-			vertex.normal = unify::V3< float >( coord.x, 0, coord.y );
-			vertex.coords = unify::TexCoords( (1.0f / segments) * v, 0 );
-			vertex.diffuse = diffuse;
-			vertex.specular = specular;
-			WriteVertex( *vd, lock, (3 * verticesPerSide) + (v * 2), *vFormat, &vertex );
-			vbParameters.bbox += vertex.pos;
-
-			// Bottom
-			vertex.pos = unify::V3< float >( coord.x * inner, -height, coord.y * inner );
-			vertex.pos += center;
-			vertex.normal = unify::V3< float >( coord.x, 0, coord.y );
-			vertex.coords = unify::TexCoords( (1.0f / segments) * v, 1 );
-			vertex.diffuse = diffuse;
-			vertex.specular = specular;
-			WriteVertex( *vd, lock, (3 * verticesPerSide) + (v * 2) + 1, *vFormat, &vertex );
-			vbParameters.bbox += vertex.pos;
+			TexCoords outerCoords( 0.5f + (coord.x * 0.5f), 0.5f + (coord.y * -0.5f) );
+			TexCoords innerCoords( 0.5f + (coord.x * 0.5f * ratioT), 0.5f + (coord.y * -0.5f * ratioT) );
+			place( topOuter + v, V3< float >( coord.x * outer, height, coord.y * outer ), V3< float >( 0, 1, 0 ), outerCoords );
+			place( topInner + v, V3< float >( coord.x * inner, height, coord.y * inner ), V3< float >( 0, 1, 0 ), innerCoords );
+			place( bottomOuter + v, V3< float >( coord.x * outer, -height, coord.y * outer ), V3< float >( 0, -1, 0 ), outerCoords );
+			place( bottomInner + v, V3< float >( coord.x * inner, -height, coord.y * inner ), V3< float >( 0, -1, 0 ), innerCoords );
 		}
 
-		set.AddVertexBuffer( vbParameters );
+		V3< float > sideNormal( coord.x, 0, coord.y );
+		float u = (1.0f / segments) * v;
+		place( outsideTop + v, V3< float >( coord.x * outer, height, coord.y * outer ), sideNormal, TexCoords( u, 0 ) );
+		place( outsideBottom + v, V3< float >( coord.x * outer, -height, coord.y * outer ), sideNormal, TexCoords( u, 1 ) );
+		place( insideTop + v, V3< float >( coord.x * inner, height, coord.y * inner ), sideNormal, TexCoords( u, 0 ) );
+		place( insideBottom + v, V3< float >( coord.x * inner, -height, coord.y * inner ), sideNormal, TexCoords( u, 1 ) );
 	}
-	catch( std::exception & ex )
+
+	// Two rings stitched with the same triangles, and winding, as the strips of the unindexed tube.
+	std::vector< Index32 > indices;
+	indices.reserve( segments * 6 * 4 );
+	auto stitch = [&]( unsigned int a, unsigned int b, unsigned int ring )
 	{
-		throw me::exception::FailedToCreate( "Failed to create create shape " + parameters.Get< std::string >( "type" ) + ",  \"" + ex.what() + "\"" );
+		for( unsigned int v = 0; v < segments; ++v )
+		{
+			unsigned int next = (v + 1) % ring;
+			indices.push_back( a + v );
+			indices.push_back( b + v );
+			indices.push_back( a + next );
+
+			indices.push_back( b + v );
+			indices.push_back( b + next );
+			indices.push_back( a + next );
+		}
+	};
+	stitch( topOuter, topInner, capRing );
+	stitch( bottomOuter, bottomInner, capRing );
+	stitch( outsideTop, outsideBottom, sideRing );
+	stitch( insideTop, insideBottom, sideRing );
+
+	kernels::Transform( kernels::Affine::Translation( center ), positions.data(), positions.data(), vertexCount );
+	kernels::Bounds( positions.data(), vertexCount, vbParameters.bbox );
+	for( size_t index = 0; index < vertexCount; ++index )
+	{
+		staged[index].pos = positions[index];
+		WriteVertex( *vd, lock, index, *vFormat, &staged[index] );
+	}
+
+	if( desc.meshlets.enabled )
+	{
+		std::vector< V3< float > > normals( vertexCount );
+		for( size_t index = 0; index < vertexCount; ++index )
+		{
+			normals[index] = staged[index].normal;
+		}
+		OrderForMeshlets( indices, desc.meshlets.maxVertices, desc.meshlets.maxTriangles );
+		std::vector< Meshlet > meshlets = BuildMeshlets( positions.data(), normals.data(), indices.data(), indices.size(), desc.meshlets.maxVertices, desc.meshlets.maxTriangles );
+		AddMeshletMethods( set, meshlets, (unsigned int)vertexCount );
 	}
+	else
+	{
+		AddMethod( set, RenderMethod::CreateTriangleListIndexed( (unsigned int)vertexCount, (unsigned int)indices.size(), 0, 0 ) );
+	}
+	AddVertexBuffer( set, vbParameters );
+	AddIndexBuffer( set, { { { indices.size(), &indices[0] } }, bufferUsage } );
+}
+
+IShapeQuery::ptr Tube::CreateQuery( const TubeDesc & desc ) const
+{
+	return RevolvedQuery::CreateTube( desc.center, desc.minorRadius, desc.majorRadius, desc.height );
 }
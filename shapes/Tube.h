@@ -3,9 +3,37 @@
 #pragma once
 
 #include <me/sculpter/IShapeCreator.h>
+#include <shapes/ShapeDesc.h>
+#include <shapes/ShapeQuery.h>
+#include <shapes/Meshlets.h>
+#include <shapes/AutoSegments.h>
 
 namespace shapes
 {
+	struct TubeDesc : public ShapeDesc
+	{
+		TubeDesc();
+		TubeDesc( const unify::Parameters & parameters );
+
+		float majorRadius;
+		float minorRadius;
+		float height;
+		unsigned int segments;
+
+		// Every part shares one index buffer and draws as a single indexed triangle list.
+		bool merged;
+
+		// Each ring position is written once per distinct normal and the cap rings drop their seam vertex. Implies merged.
+		bool indexed;
+		AutoSegments autoSegments;
+
+		// Draw as meshlets, one method each, with their bounds and cones in the current MeshletTable. Implies indexed.
+		MeshletOptions meshlets;
+
+		// With collision, the tube is split into this many convex wedges.
+		unsigned int collisionSegments;
+	};
+
 	class Tube : public me::sculpter::IShapeCreator
 	{
 	public:
@@ -13,5 +41,14 @@ namespace shapes
 		~Tube() override;
 
 		void Create( me::render::PrimitiveList & primitiveList, const unify::Parameters & parameters ) const override;
+		void Create( me::render::PrimitiveList & primitiveList, const TubeDesc & desc ) const;
+
+		/// <summary>
+		/// The exact shape desc describes, for picking and containment without its triangles.
+		/// </summary>
+		IShapeQuery::ptr CreateQuery( const TubeDesc & desc ) const;
+
+	private:
+		void CreateIndexed( me::render::PrimitiveList & primitiveList, const TubeDesc & desc ) const;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,24 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+#pragma once
+
+#include <unify/V3.h>
+
+namespace shapes
+{
+	/// <summary>
+	/// The vector products the shapes' geometry code uses, as free functions on unify::V3.
+	/// </summary>
+	namespace vectormath
+	{
+		inline float Dot( const unify::V3< float > & a, const unify::V3< float > & b )
+		{
+			return a.x * b.x + a.y * b.y + a.z * b.z;
+		}
+
+		inline unify::V3< float > Cross( const unify::V3< float > & a, const unify::V3< float > & b )
+		{
+			return unify::V3< float >( a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x );
+		}
+	}
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include "AllShapes.h"
+#include <unify/Color.h>
+#include <unify/Size.h>
+#include <unify/Size3.h>
+#include <string>
+
+std::vector< TestShape > GetAllShapes()
+{
+	using namespace unify;
+
+	return {
+		{ Parameters{
+			{ "type", (std::string)"box" },
+			{ "size3", Size3< float >( 1.0f, 1.0f, 1.0f ) },
+			{ "diffuses", std::vector< Color >{
+					ColorRed(), ColorGreen(), ColorBlue(), ColorYellow(), ColorCyan(), ColorMagenta()
+				}
+			} }, true },
+		{ Parameters{
+			{ "type", (std::string)"pointfield" },
+			{ "majorradius", 0.5f },
+			{ "minorradius", 0.5f },
+			{ "count", 1000 },
+			{ "diffuse", ColorRed() } }, true },
+		{ Parameters{
+			{ "type", (std::string)"pointring" },
+			{ "majorradius", 0.5f },
+			{ "minorradius", 0.25f },
+			{ "count", 1000 },
+			{ "diffuse", ColorGreen() } }, true },
+		{ Parameters{
+			{ "type", (std::string)"dashring" },
+			{ "majorradius", 1.0f },
+			{ "minorradius", 0.9f },
+			{ "size1", 0.5f },
+			{ "count", (size_t)12 },
+			{ "diffuse", ColorBlue() } }, true },
+		{ Parameters{
+			{ "type", (std::string)"pyramid" },
+			{ "size3", Size3< float >{ 1.0f, 1.0f, 1.0f } },
+			{ "diffuse", ColorRed( 255 / 2 ) } }, false },
+		{ Parameters{
+			{ "type", (std::string)"circle" },
+			{ "radius", 1.0f },
+			{ "diffuse", ColorGreen( 255 / 2 ) } }, true },
+		{ Parameters{
+			{ "type", (std::string)"sphere" },
+			{ "radius", 0.5f },
+			{ "diffuse", ColorBlue( 255 / 2 ) } }, true },
+		{ Parameters{
+			{ "type", (std::string)"cylinder" },
+			{ "radius", 0.25f },
+			{ "height", 1.0f },
+			{ "diffuse", ColorCyan( 255 / 2 ) } }, true },
+		{ Parameters{
+			{ "type", (std::string)"tube" },
+			{ "majorradius", 0.5f },
+			{ "minorradius", 0.25f },
+			{ "height", 1.0f },
+			{ "diffuse", ColorMagenta( 255 / 2 ) } }, true },
+		{ Parameters{
+			{ "type", (std::string)"plane" },
+			{ "size2", Size< float >{ 1.0f, 1.0f } },
+			{ "diffuse", ColorRed( 255 ) } }, true },
+		{ Parameters{
+			{ "type", (std::string)"cone" },
+			{ "radius", 0.25f },
+			{ "height", 1.0f },
+			{ "diffuse", ColorGreen( 255 ) } }, true }
+	};
+}
@@ -0,0 +1,22 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#pragma once
+
+#include <unify/Parameters.h>
+#include <vector>
+
+/// <summary>
+/// A shape of MEShapes_Test02, without its effect. The test draws each shape twice, once per depth; shapes that
+/// are not layered use the first depth's effect at both.
+/// </summary>
+struct TestShape
+{
+	unify::Parameters parameters;
+	bool layered;
+};
+
+/// <summary>
+/// The shapes, and parameters, of MEShapes_Test02 - All Shapes, shared with the tests that time or bake them.
+/// </summary>
+std::vector< TestShape > GetAllShapes();
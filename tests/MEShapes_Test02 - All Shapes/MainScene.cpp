@@ -2,6 +2,7 @@
 // All Rights Reserved
 
 #include <MainScene.h>
+#include "AllShapes.h"
 #include <me/scene/SceneManager.h>
 #include <me/object/Object.h>
 #include <me/render/Mesh.h>
@@ -79,131 +80,13 @@ void MainScene::OnStart()
 
 	for( int depth = 0; depth < 2; depth++ )
 	{
-		using namespace unify;
 		auto & effect = depth == 0 ? colorEffect : fourColorsEffect;
 
+		for( auto & shape : GetAllShapes() )
 		{
-			Parameters parameters{
-				{ "type", (std::string)"box" },
-				{ "effect", effect },
-				{ "size3", Size3< float >( 1.0f, 1.0f, 1.0f ) },
-				{ "diffuses", std::vector< Color >{
-						ColorRed(), ColorGreen(), ColorBlue(), ColorYellow(), ColorCyan(), ColorMagenta() 
-					}
-				}
-			};
-
-			auto object = createObject( parameters, depth );
-		}
-		{
-			Parameters parameters {
-				{ "type", (std::string)"pointfield" },
-				{ "effect", effect },
-				{ "majorradius", 0.5f },
-				{ "minorradius", 0.5f },
-				{ "count", 1000 },
-				{ "diffuse", ColorRed() }
-			};
-			auto object = createObject( parameters, depth );
-		}
-
-		{
-			Parameters parameters {
-				{ "type", (std::string)"pointring" },
-				{ "effect", effect },
-				{ "majorradius", 0.5f },
-				{ "minorradius", 0.25f },
-				{ "count", 1000 },
-				{ "diffuse", ColorGreen() }
-			};
-			auto object = createObject( parameters, depth );
-		}
-
-		{
-			Parameters parameters {
-				{ "type", (std::string)"dashring" },
-				{ "effect", effect },
-				{ "majorradius", 1.0f },
-				{ "minorradius", 0.9f },
-				{ "size1", 0.5f },
-				{ "count", (size_t)12 },
-				{ "diffuse", ColorBlue() } 
-			};
-			auto object = createObject( parameters, depth );
-		}
-
-		{
-			Parameters parameters {
-				{ "type", (std::string)"pyramid" },
-				{ "effect", colorEffect },
-				{ "size3", Size3< float >{ 1.0f, 1.0f, 1.0f } },
-				{ "diffuse", ColorRed( 255 / 2 ) }
-			};
-			auto object = createObject( parameters, depth );
-		}
-
-		{
-			Parameters parameters {
-				{ "type", (std::string)"circle" },
-				{ "effect", effect },
-				{ "radius", 1.0f },
-				{ "diffuse", ColorGreen( 255 / 2 ) }
-			};
-			auto object = createObject( parameters, depth );
-		}
-
-		{
-			Parameters parameters {
-				{ "type", (std::string)"sphere" },
-				{ "effect", effect },
-				{ "radius", 0.5f },
-				{ "diffuse", ColorBlue( 255 / 2 ) }
-			};
-			auto object = createObject( parameters, depth );
-		}
-
-		{
-			Parameters parameters {
-				{ "type", (std::string)"cylinder" },
-				{ "effect", effect },
-				{ "radius", 0.25f },
-				{ "height", 1.0f },
-				{ "diffuse", ColorCyan( 255 / 2 ) }
-			};
-			auto object = createObject( parameters, depth );
-		}
-
-		{
-			Parameters parameters {
-				{ "type", (std::string)"tube" },
-				{ "effect", effect },
-				{ "majorradius", 0.5f },
-				{ "minorradius", 0.25f },
-				{ "height", 1.0f },
-				{ "diffuse", ColorMagenta( 255 / 2 ) }
-			};
-			auto object = createObject( parameters, depth );
-		}
-
-		{
-			Parameters parameters {
-				{ "type", (std::string)"plane" },
-				{ "effect", effect },
-				{ "size2", Size< float >{ 1.0f, 1.0f } },
-				{ "diffuse", ColorRed( 255 ) }
-			};
-			auto object = createObject( parameters, depth );
-		}
-
-		{
-			Parameters parameters {
-				{ "type", (std::string)"cone" },
-				{ "effect", effect },
-				{ "radius", 0.25f },
-				{ "height", 1.0f },
-				{ "diffuse", ColorGreen( 255 ) }
-			};
-			auto object = createObject( parameters, depth );
+			unify::Parameters parameters = shape.parameters;
+			parameters.Set< Effect::ptr >( "effect", shape.layered ? effect : colorEffect );
+			createObject( parameters, depth );
 		}
 	}
 }
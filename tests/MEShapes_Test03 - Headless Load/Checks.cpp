@@ -0,0 +1,201 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <Checks.h>
+#include <shapes/AutoSegments.h>
+#include <shapes/ShapeQuery.h>
+#include <shapes/ShapeBVH.h>
+#include <stdexcept>
+#include <limits>
+#include <cmath>
+
+namespace
+{
+	bool Near( float a, float b )
+	{
+		return std::abs( a - b ) < 1e-4f;
+	}
+
+	bool Near( const unify::V3< float > & a, const unify::V3< float > & b )
+	{
+		return Near( a.x, b.x ) && Near( a.y, b.y ) && Near( a.z, b.z );
+	}
+}
+
+void Check( bool condition, const std::string & what )
+{
+	if( !condition )
+	{
+		throw std::runtime_error( "Check failed: " + what );
+	}
+}
+
+void CheckRecorded( const shapes::ShapeRecorder & recorder, const std::string & shape )
+{
+	Check( !recorder.GetSets().empty(), shape + " recorded no buffer sets" );
+	for( const auto & set : recorder.GetSets() )
+	{
+		Check( set.vertexCount > 0, shape + " recorded a buffer set without vertices" );
+		Check( set.vertices.size() == (size_t)set.vertexStride * set.vertexCount, shape + " recorded fewer vertex bytes than its count" );
+		Check( !set.methods.empty(), shape + " recorded a buffer set without a draw" );
+		for( auto index : set.indices )
+		{
+			Check( index < set.vertexCount, shape + " recorded an index past its vertices" );
+		}
+	}
+}
+
+void CheckAutoSegments()
+{
+	shapes::AutoSegments segments;
+	segments.enabled = true;
+	segments.minSegments = 3;
+	segments.maxSegments = 256;
+
+	// Too fine to tell from the arc in a float, on any radius.
+	segments.chordError = 1e-9f;
+	Check( segments.Resolve( 1e6f, 8 ) == 256, "AutoSegments gives the most segments for a tiny error on a huge radius" );
+	Check( segments.Resolve( 1.0f, 8 ) == 256, "AutoSegments gives the most segments for a tiny error" );
+
+	// Half angle acos(0.99), about 8.1 degrees, so 23 chords around.
+	segments.chordError = 0.01f;
+	Check( segments.Resolve( 1.0f, 8 ) == 23, "AutoSegments gives 23 segments for a 1% chord error" );
+	Check( segments.Resolve( 1.0f, 8, 3.14159265f ) == 12, "AutoSegments gives half as many segments for half the arc" );
+
+	// An error as large as the radius needs the fewest; disabled, segments are returned unchanged.
+	segments.chordError = 2.0f;
+	Check( segments.Resolve( 1.0f, 8 ) == 3, "AutoSegments gives the fewest segments for an error beyond the radius" );
+	segments.enabled = false;
+	Check( segments.Resolve( 1.0f, 8 ) == 8, "AutoSegments leaves segments alone when disabled" );
+}
+
+void CheckQueries()
+{
+	using namespace shapes;
+	using V = unify::V3< float >;
+
+	RayHit hit;
+	const V none( 0, 0, 0 );
+	const V nan( std::numeric_limits< float >::quiet_NaN(), 0, 0 );
+
+	BoxQuery box( V( -1, -1, -1 ), V( 1, 1, 1 ) );
+	Check( box.Intersect( V( -5, 0, 0 ), V( 1, 0, 0 ), hit ) && Near( hit.distance, 4 ) && Near( hit.normal, V( -1, 0, 0 ) ), "BoxQuery hits its near face" );
+	Check( box.Intersect( V( 0, 0, 0 ), V( 0, 1, 0 ), hit ) && Near( hit.distance, 1 ) && Near( hit.normal, V( 0, 1, 0 ) ), "BoxQuery hits its way out from inside" );
+	Check( !box.Intersect( V( -5, 2, 0 ), V( 1, 0, 0 ), hit ), "BoxQuery misses a ray passing above" );
+	Check( !box.Intersect( V( 0, 0, 0 ), none, hit ) && !box.Intersect( V( 0, 0, 0 ), nan, hit ), "BoxQuery hits nothing without a direction" );
+
+	SphereQuery sphere( V( 0, 0, 0 ), 1 );
+	Check( sphere.Intersect( V( 0, 0, -5 ), V( 0, 0, 1 ), hit ) && Near( hit.distance, 4 ) && Near( hit.normal, V( 0, 0, -1 ) ), "SphereQuery hits its near side" );
+	Check( !sphere.Intersect( V( 0, 2, -5 ), V( 0, 0, 1 ), hit ), "SphereQuery misses a ray passing above" );
+	Check( !sphere.Intersect( V( 0, 0, 0 ), none, hit ) && !sphere.Intersect( V( 0, 0, 0 ), nan, hit ), "SphereQuery hits nothing without a direction" );
+
+	// Apex at y = 1, base at y = -1; at y = 0.9 it is 0.1 across.
+	IShapeQuery::ptr pyramid = ConvexQuery::CreatePyramid( V( 0, 0, 0 ), unify::Size3< float >( 2, 2, 2 ) );
+	Check( pyramid->Intersect( V( 0, -5, 0 ), V( 0, 1, 0 ), hit ) && Near( hit.distance, 4 ) && Near( hit.normal, V( 0, -1, 0 ) ), "Pyramid query hits its base" );
+	Check( !pyramid->Intersect( V( 0.9f, 0.9f, -5 ), V( 0, 0, 1 ), hit ), "Pyramid query misses beside its apex" );
+	Check( pyramid->Contains( V( 0, 0, 0 ) ) && !pyramid->Contains( V( 0.9f, 0.9f, 0 ) ), "Pyramid query contains its middle only" );
+	Check( Near( pyramid->SignedDistance( V( 0, -3, 0 ) ), 2 ), "Pyramid query distance below its base" );
+	Check( !pyramid->Intersect( V( 0, 0, 0 ), none, hit ), "Pyramid query hits nothing without a direction" );
+
+	// Four dashes of an eighth of a turn each, from +x toward +z, between radius 0.5 and 1.
+	const float quarter = 1.57079633f;
+	auto onRing = [&]( float angle, float y ) { return V( 0.75f * std::cos( angle ), y, 0.75f * std::sin( angle ) ); };
+	IShapeQuery::ptr dashes = RevolvedQuery::CreateDashRing( V( 0, 0, 0 ), 0.5f, 1.0f, RevolvedQuery::ArcMask( 4, 0.5f, 4 ) );
+	Check( dashes->Intersect( onRing( quarter * 0.25f, 1 ), V( 0, -1, 0 ), hit ) && Near( hit.distance, 1 ), "Dash ring query hits a dash" );
+	Check( !dashes->Intersect( onRing( quarter * 0.75f, 1 ), V( 0, -1, 0 ), hit ), "Dash ring query misses between dashes" );
+	Check( Near( dashes->SignedDistance( onRing( quarter * 0.75f, 0 ) ), 0.75f * std::sin( quarter * 0.25f ) ), "Dash ring query distance to the nearest dash's edge" );
+	Check( !dashes->Intersect( onRing( quarter * 0.25f, 0 ), none, hit ), "Dash ring query hits nothing without a direction" );
+
+	IShapeQuery::ptr oneDash = RevolvedQuery::CreateDashRing( V( 0, 0, 0 ), 0.5f, 1.0f, RevolvedQuery::ArcMask( 4, 0.5f, 1 ) );
+	Check( !oneDash->Intersect( onRing( quarter * 1.25f, 1 ), V( 0, -1, 0 ), hit ), "Dash ring query misses dashes past visible" );
+}
+
+void CheckBVH()
+{
+	using namespace shapes;
+	using V = unify::V3< float >;
+
+	// Unit boxes and spheres on a grid with gaps between, so rays along the grid lines start on their faces.
+	ShapeBVH bvh;
+	std::vector< IShapeQuery::ptr > shapes;
+	for( int x = 0; x < 6; ++x )
+	{
+		for( int y = 0; y < 6; ++y )
+		{
+			for( int z = 0; z < 6; ++z )
+			{
+				const V corner( x * 2.0f, y * 2.0f, z * 2.0f );
+				IShapeQuery::ptr shape;
+				if( ( x + y + z ) % 3 )
+				{
+					shape.reset( new BoxQuery( corner, corner + V( 1, 1, 1 ) ) );
+				}
+				else
+				{
+					shape.reset( new SphereQuery( corner + V( 0.5f, 0.5f, 0.5f ), 0.5f ) );
+				}
+				shapes.push_back( shape );
+				bvh.AddShape( shape );
+			}
+		}
+	}
+	bvh.Build();
+
+	auto cast = [&]( const V & origin, const V & direction )
+	{
+		RayHit nearest;
+		bool expected = false;
+		for( const auto & shape : shapes )
+		{
+			RayHit hit;
+			if( shape->Intersect( origin, direction, hit ) && ( !expected || hit.distance < nearest.distance ) )
+			{
+				nearest = hit;
+				expected = true;
+			}
+		}
+
+		ShapeBVH::Hit hit;
+		const bool found = bvh.Intersect( origin, direction, hit );
+		Check( found == expected, "ShapeBVH finds a hit exactly when testing every shape does" );
+		Check( !found || Near( hit.hit.distance, nearest.distance ), "ShapeBVH finds the nearest hit" );
+	};
+
+	const V axes[] = { V( 1, 0, 0 ), V( -1, 0, 0 ), V( 0, 1, 0 ), V( 0, -1, 0 ), V( 0, 0, 1 ), V( 0, 0, -1 ) };
+	for( int a = -1; a <= 12; ++a )
+	{
+		for( int b = -1; b <= 12; ++b )
+		{
+			const float u = a * 0.5f;
+			const float v = b * 0.5f;
+			cast( V( -1, u, v ), axes[0] );
+			cast( V( 13, u, v ), axes[1] );
+			cast( V( u, -1, v ), axes[2] );
+			cast( V( u, 13, v ), axes[3] );
+			cast( V( u, v, -1 ), axes[4] );
+			cast( V( u, v, 13 ), axes[5] );
+		}
+	}
+
+	// Diagonal rays from a fixed sequence, some starting inside the grid.
+	unsigned int seed = 12345;
+	auto next = [&]() { seed = seed * 1664525u + 1013904223u; return ( seed >> 8 ) / 16777216.0f; };
+	for( int ray = 0; ray < 500; ++ray )
+	{
+		const V origin( next() * 16 - 2, next() * 16 - 2, next() * 16 - 2 );
+		const V direction( next() * 2 - 1, next() * 2 - 1, next() * 2 - 1 );
+		cast( origin, direction );
+	}
+
+	ShapeBVH::Hit hit;
+	Check( !bvh.Intersect( V( 0.5f, 0.5f, 0.5f ), V( 0, 0, 0 ), hit ), "ShapeBVH hits nothing without a direction" );
+
+	// Two triangles over the unit square at z = 0, hit along the diagonal they share.
+	const V square[] = { V( 0, 0, 0 ), V( 1, 0, 0 ), V( 1, 1, 0 ), V( 0, 1, 0 ) };
+	const me::render::Index32 indices[] = { 0, 1, 2, 0, 2, 3 };
+	ShapeBVH mesh;
+	mesh.AddMesh( square, indices, 6 );
+	mesh.Build();
+	Check( mesh.Intersect( V( 0.5f, 0.5f, -1 ), V( 0, 0, 1 ), hit ) && Near( hit.hit.distance, 1 ) && hit.triangle != ShapeBVH::NoTriangle, "ShapeBVH hits a mesh triangle" );
+	Check( !mesh.Intersect( V( 1.5f, 0.5f, -1 ), V( 0, 0, 1 ), hit ), "ShapeBVH misses beside a mesh" );
+}
@@ -0,0 +1,37 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#pragma once
+
+#include <shapes/ShapeOutput.h>
+#include <string>
+
+/// <summary>
+/// Throws, naming what failed, unless condition holds. The headless setup treats failures as critical, so a
+/// failed check fails the run.
+/// </summary>
+void Check( bool condition, const std::string & what );
+
+/// <summary>
+/// Checks a creator's captured output is complete: at least one BufferSet, each with vertices filling its
+/// count, a draw, and only indices within its vertices.
+/// </summary>
+void CheckRecorded( const shapes::ShapeRecorder & recorder, const std::string & shape );
+
+/// <summary>
+/// Checks AutoSegments resolves tolerances too fine for a float to the most segments, and an ordinary
+/// tolerance to the chord count it implies.
+/// </summary>
+void CheckAutoSegments();
+
+/// <summary>
+/// Checks shape queries against hits, misses and distances worked out by hand, and that rays without a
+/// direction hit nothing.
+/// </summary>
+void CheckQueries();
+
+/// <summary>
+/// Checks ShapeBVH ray casts against testing every shape, including rays along an axis that start on the
+/// faces of the bounds they pass.
+/// </summary>
+void CheckBVH();
@@ -0,0 +1,160 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <MainScene.h>
+#include <Checks.h>
+#include "../MEShapes_Test02 - All Shapes/AllShapes.h"
+#include <me/scene/SceneManager.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/Box.h>
+#include <shapes/Circle.h>
+#include <shapes/Cone.h>
+#include <shapes/Cylinder.h>
+#include <shapes/DashRing.h>
+#include <shapes/Plane.h>
+#include <shapes/PointField.h>
+#include <shapes/PointRing.h>
+#include <shapes/Pyramid.h>
+#include <shapes/Sphere.h>
+#include <shapes/Tube.h>
+#include <me/render/VertexDeclaration.h>
+#include <me/exception/FailedToCreate.h>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+
+using namespace me;
+using namespace render;
+
+namespace
+{
+	struct Shape
+	{
+		me::sculpter::IShapeCreator::ptr creator;
+		unify::Parameters parameters;
+	};
+
+	// Creations per shape, enough to be well above the clock's resolution.
+	const size_t Passes = 100;
+
+	void Deleter( me::sculpter::IShapeCreator * creator )
+	{
+		delete creator;
+	}
+
+	me::sculpter::IShapeCreator::ptr CreatorFor( const std::string & type )
+	{
+		if( type == "box" ) return me::sculpter::IShapeCreator::ptr( new shapes::Box(), Deleter );
+		if( type == "pointfield" ) return me::sculpter::IShapeCreator::ptr( new shapes::PointField(), Deleter );
+		if( type == "pointring" ) return me::sculpter::IShapeCreator::ptr( new shapes::PointRing(), Deleter );
+		if( type == "dashring" ) return me::sculpter::IShapeCreator::ptr( new shapes::DashRing(), Deleter );
+		if( type == "pyramid" ) return me::sculpter::IShapeCreator::ptr( new shapes::Pyramid(), Deleter );
+		if( type == "circle" ) return me::sculpter::IShapeCreator::ptr( new shapes::Circle(), Deleter );
+		if( type == "sphere" ) return me::sculpter::IShapeCreator::ptr( new shapes::Sphere(), Deleter );
+		if( type == "cylinder" ) return me::sculpter::IShapeCreator::ptr( new shapes::Cylinder(), Deleter );
+		if( type == "tube" ) return me::sculpter::IShapeCreator::ptr( new shapes::Tube(), Deleter );
+		if( type == "plane" ) return me::sculpter::IShapeCreator::ptr( new shapes::Plane(), Deleter );
+		if( type == "cone" ) return me::sculpter::IShapeCreator::ptr( new shapes::Cone(), Deleter );
+		throw me::exception::FailedToCreate( "No creator for shape \"" + type + "\"!" );
+	}
+}
+
+MainScene::MainScene( me::game::Game * gameInstance )
+	:Scene( gameInstance, "Main" )
+{
+}
+
+void MainScene::OnStart()
+{
+	CheckAutoSegments();
+	CheckQueries();
+	CheckBVH();
+
+	// No renderer is loaded, so there are no effects; shapes are written in the layouts of the vertex shaders
+	// MEShapes_Test02 draws them with, ColorSimple and TextureSimple.
+	qjson::Object colorFormat;
+	colorFormat.Add( { "Position", "Float3" } );
+	colorFormat.Add( { "Diffuse", "Color" } );
+	VertexDeclaration::ptr colorLayout( new VertexDeclaration( colorFormat ) );
+
+	qjson::Object textureFormat;
+	textureFormat.Add( { "Position", "Float3" } );
+	textureFormat.Add( { "TexCoord", "TexCoord" } );
+	VertexDeclaration::ptr textureLayout( new VertexDeclaration( textureFormat ) );
+
+	std::vector< Shape > shapeList;
+	for( int depth = 0; depth < 2; depth++ )
+	{
+		auto & layout = depth == 0 ? colorLayout : textureLayout;
+
+		for( auto & shape : GetAllShapes() )
+		{
+			unify::Parameters parameters = shape.parameters;
+			parameters.Set< VertexDeclaration::ptr >( "vertexdeclaration", shape.layered ? layout : colorLayout );
+			shapeList.push_back( { CreatorFor( parameters.Get< std::string >( "type" ) ), parameters } );
+		}
+	}
+
+	using clock = std::chrono::steady_clock;
+
+	shapes::ShapeRecorder recorder( shapes::ShapeRecorder::Mode::Capture );
+	shapes::ShapeRecorder::Scope scope( recorder );
+
+	double totalMilliseconds = 0.0;
+	size_t totalBytes = 0;
+	size_t totalDraws = 0;
+	for( auto & shape : shapeList )
+	{
+		const std::string type = shape.parameters.Get< std::string >( "type" );
+
+		// One checked pass first, so the checks stay out of the timing.
+		{
+			PrimitiveList primitiveList( nullptr );
+			shape.creator->Create( primitiveList, shape.parameters );
+			CheckRecorded( recorder, type );
+		}
+		const size_t expectedVertexBytes = recorder.GetVertexBytes();
+		const size_t expectedIndexBytes = recorder.GetIndexBytes();
+		const size_t expectedDraws = recorder.GetDrawCount();
+		recorder.Clear();
+
+		size_t vertexBytes = 0;
+		size_t indexBytes = 0;
+		size_t draws = 0;
+
+		auto start = clock::now();
+		for( size_t pass = 0; pass < Passes; pass++ )
+		{
+			PrimitiveList primitiveList( nullptr );
+			shape.creator->Create( primitiveList, shape.parameters );
+
+			vertexBytes += recorder.GetVertexBytes();
+			indexBytes += recorder.GetIndexBytes();
+			draws += recorder.GetDrawCount();
+			recorder.Clear();
+		}
+		double milliseconds = std::chrono::duration< double, std::milli >( clock::now() - start ).count();
+
+		// A creator makes the same output from the same parameters every time.
+		Check( vertexBytes == expectedVertexBytes * Passes, type + " recorded different vertices between passes" );
+		Check( indexBytes == expectedIndexBytes * Passes, type + " recorded different indices between passes" );
+		Check( draws == expectedDraws * Passes, type + " recorded different draws between passes" );
+
+		std::stringstream line;
+		line << std::fixed << std::setprecision( 4 )
+			<< type << ": " << milliseconds / Passes << "ms, "
+			<< vertexBytes / Passes << " vertex bytes, " << indexBytes / Passes << " index bytes, " << draws / Passes << " draws";
+		GetGame()->Debug()->LogLine( "Headless Load", line.str() );
+
+		totalMilliseconds += milliseconds / Passes;
+		totalBytes += ( vertexBytes + indexBytes ) / Passes;
+		totalDraws += draws / Passes;
+	}
+
+	std::stringstream line;
+	line << std::fixed << std::setprecision( 4 )
+		<< "All shapes: " << totalMilliseconds << "ms, " << totalBytes << " bytes, " << totalDraws << " draws";
+	GetGame()->Debug()->LogLine( "Headless Load", line.str() );
+
+	GetGame()->Quit();
+}
@@ -0,0 +1,20 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#pragma once
+
+#include <me/scene/Scene.h>
+
+/// <summary>
+/// Creates the shapes from MEShapes_Test02 repeatedly with the shape output captured on the CPU, so no buffer is
+/// created and nothing is drawn, then logs the time, bytes and draw calls per shape and quits. Each shape's
+/// output is checked first, and every pass must match it, after the behaviour checks in Checks.h; a failed
+/// check fails the run.
+/// </summary>
+class MainScene : public me::scene::Scene
+{
+public:
+	MainScene( me::game::Game * gameInstance );
+
+	void OnStart() override;
+};
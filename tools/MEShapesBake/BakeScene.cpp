@@ -0,0 +1,237 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#include <BakeScene.h>
+#include <shapes/ShapeCreators.h>
+#include <shapes/ShapeOutput.h>
+#include <shapes/ShapePack.h>
+#include <me/scene/SceneManager.h>
+#include <me/render/TextureMode.h>
+#include <me/exception/FailedToCreate.h>
+#include <unify/Color.h>
+#include <unify/Size3.h>
+#include <unify/TexArea.h>
+#include <unify/V3.h>
+#include <fstream>
+#include <sstream>
+
+using namespace me;
+using namespace render;
+
+namespace
+{
+	std::vector< float > SplitFloats( const std::string & value, size_t count )
+	{
+		std::vector< float > floats;
+		std::stringstream stream( value );
+		std::string item;
+		while( std::getline( stream, item, ',' ) )
+		{
+			floats.push_back( std::stof( item ) );
+		}
+		if( floats.size() != count )
+		{
+			throw me::exception::FailedToCreate( "Expected " + std::to_string( count ) + " values, found \"" + value + "\"!" );
+		}
+		return floats;
+	}
+
+	unify::Color ParseColor( const std::string & value )
+	{
+		auto c = SplitFloats( value, 4 );
+		return unify::Color::ColorRGBA( (unify::Color::Component)c[0], (unify::Color::Component)c[1], (unify::Color::Component)c[2], (unify::Color::Component)c[3] );
+	}
+
+	/// <summary>
+	/// Sets a value as the type named after its key, "key:type=value", or as a float without one. The creators
+	/// read each parameter as one exact type, so the bake file says which, rather than the baker keeping a list
+	/// of every creator's parameters.
+	/// </summary>
+	void SetParameter( unify::Parameters & parameters, const std::string & typedKey, const std::string & value )
+	{
+		size_t colon = typedKey.find( ':' );
+		std::string key = typedKey.substr( 0, colon );
+		std::string type = colon == std::string::npos ? "float" : typedKey.substr( colon + 1 );
+
+		if( type == "float" )
+		{
+			parameters.Set< float >( key, std::stof( value ) );
+		}
+		else if( type == "int" )
+		{
+			parameters.Set< int >( key, std::stoi( value ) );
+		}
+		else if( type == "uint" )
+		{
+			parameters.Set< unsigned int >( key, (unsigned int)std::stoul( value ) );
+		}
+		else if( type == "bool" )
+		{
+			parameters.Set< bool >( key, value == "true" || value == "1" );
+		}
+		else if( type == "string" )
+		{
+			parameters.Set< std::string >( key, value );
+		}
+		else if( type == "v3" )
+		{
+			auto v = SplitFloats( value, 3 );
+			parameters.Set< unify::V3< float > >( key, unify::V3< float >( v[0], v[1], v[2] ) );
+		}
+		else if( type == "size2" )
+		{
+			auto v = SplitFloats( value, 2 );
+			parameters.Set< unify::Size< float > >( key, unify::Size< float >( v[0], v[1] ) );
+		}
+		else if( type == "size3" )
+		{
+			auto v = SplitFloats( value, 3 );
+			parameters.Set< unify::Size3< float > >( key, unify::Size3< float >( v[0], v[1], v[2] ) );
+		}
+		else if( type == "texarea" )
+		{
+			auto v = SplitFloats( value, 4 );
+			parameters.Set< unify::TexArea >( key, unify::TexArea( unify::TexCoords( v[0], v[1] ), unify::TexCoords( v[2], v[3] ) ) );
+		}
+		else if( type == "color" )
+		{
+			parameters.Set< unify::Color >( key, ParseColor( value ) );
+		}
+		else if( type == "colors" )
+		{
+			std::vector< unify::Color > colors;
+			std::stringstream stream( value );
+			std::string item;
+			while( std::getline( stream, item, ';' ) )
+			{
+				colors.push_back( ParseColor( item ) );
+			}
+			parameters.Set< std::vector< unify::Color > >( key, colors );
+		}
+		else if( type == "texturemode" )
+		{
+			parameters.Set< TextureMode::TYPE >( key, value == "wrapped" ? TextureMode::Wrapped : TextureMode::Correct );
+		}
+		else
+		{
+			throw me::exception::FailedToCreate( "Unknown type \"" + type + "\" for shape parameter \"" + key + "\"!" );
+		}
+	}
+}
+
+BakeScene::BakeScene( me::game::Game * gameInstance )
+	:Scene( gameInstance, "Main" )
+	, m_output{ "shapes.me_pack" }
+{
+}
+
+void BakeScene::Load( const unify::Path & path )
+{
+	std::ifstream file( path.ToString() );
+	if( !file )
+	{
+		throw me::exception::FailedToCreate( "Failed to open bake file \"" + path.ToString() + "\"!" );
+	}
+
+	std::string line;
+	while( std::getline( file, line ) )
+	{
+		std::stringstream stream( line );
+		std::string name;
+		std::string type;
+		if( !( stream >> name ) || name[0] == '#' )
+		{
+			continue;
+		}
+
+		if( name == "output" )
+		{
+			std::string output;
+			stream >> output;
+			m_output = unify::Path( output );
+			continue;
+		}
+
+		if( !( stream >> type ) )
+		{
+			throw me::exception::FailedToCreate( "Shape \"" + name + "\" has no type!" );
+		}
+
+		ShapeDeclaration declaration;
+		declaration.name = name;
+		declaration.parameters.Set< std::string >( "type", type );
+
+		std::string pair;
+		while( stream >> pair )
+		{
+			size_t equals = pair.find( '=' );
+			if( equals == std::string::npos )
+			{
+				throw me::exception::FailedToCreate( "Shape \"" + name + "\" has a parameter without a value, \"" + pair + "\"!" );
+			}
+
+			std::string key = pair.substr( 0, equals );
+			std::string value = pair.substr( equals + 1 );
+			if( key == "effect" )
+			{
+				declaration.effect = value;
+			}
+			else
+			{
+				try
+				{
+					SetParameter( declaration.parameters, key, value );
+				}
+				catch( const std::logic_error & )
+				{
+					// std::stof and the like throw invalid_argument or out_of_range, both logic_errors.
+					throw me::exception::FailedToCreate( "Shape \"" + name + "\" has an unreadable value, \"" + pair + "\"!" );
+				}
+			}
+		}
+
+		if( declaration.effect.empty() )
+		{
+			throw me::exception::FailedToCreate( "Shape \"" + name + "\" has no effect!" );
+		}
+
+		// A pack holds per-vertex data; an instance slot has nowhere to go.
+		if( declaration.parameters.Get( "instanced", false ) )
+		{
+			throw me::exception::FailedToCreate( "Shape \"" + name + "\" is instanced, and instanced shapes can't be baked!" );
+		}
+
+		m_declarations.push_back( declaration );
+	}
+}
+
+void BakeScene::OnStart()
+{
+	AddResources( unify::Path( "resources/Standard.me_res" ) );
+
+	Load( unify::Path( "shapes.me_bake" ) );
+
+	auto geometryManager = unify::polymorphic_downcast< rm::ResourceManager< Geometry > * >( GetManager< Geometry >() );
+	auto shapeFactory = dynamic_cast< me::sculpter::SculpterFactory * >( geometryManager->GetFactory( "me_shape" ) );
+	shapes::AddShapeCreators( *shapeFactory, shapes::ShapePack::ptr(), shapes::ShapeStats::ptr() );
+
+	shapes::ShapePackWriter writer;
+	for( auto & declaration : m_declarations )
+	{
+		declaration.parameters.Set< Effect::ptr >( "effect", GetAsset< Effect >( declaration.effect ) );
+
+		shapes::ShapeRecorder recorder;
+		{
+			shapes::ShapeRecorder::Scope scope( recorder );
+			shapeFactory->Produce( declaration.parameters );
+		}
+		writer.Add( declaration.name, recorder.GetSets() );
+
+		GetGame()->Debug()->LogLine( "BakeScene", "Baked \"" + declaration.name + "\" (" + std::to_string( recorder.GetSets().size() ) + " buffer sets)." );
+	}
+
+	writer.Save( m_output );
+	GetGame()->Debug()->LogLine( "BakeScene", "Wrote " + std::to_string( writer.GetCount() ) + " shapes to \"" + m_output.ToString() + "\"." );
+
+	GetGame()->Quit();
+}
@@ -0,0 +1,43 @@
+// Copyright (c) 2002 - 2018, Kit10 Studios LLC
+// All Rights Reserved
+
+#pragma once
+
+#include <me/scene/Scene.h>
+#include <unify/Parameters.h>
+#include <unify/Path.h>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// A shape to bake, the name it is baked under, and the same parameters that would be given to "me_shape".
+/// </summary>
+struct ShapeDeclaration
+{
+	std::string name;
+	std::string effect;
+	unify::Parameters parameters;
+};
+
+/// <summary>
+/// Runs every declaration in a bake file through the shape creators and writes the results into a shape pack.
+///
+/// A bake file has one shape per line, "name type key:type=value ...", for example:
+///		output shapes.me_pack
+///		redbox box effect=ColorSimple size3:size3=1,1,1 diffuse:color=255,0,0,255 segments:uint=8 radius=0.5
+/// A key without a type is a float. The types are float, int, uint, bool, string, v3, size2, size3, texarea,
+/// color, colors and texturemode; "colors" are separated with ';'. Lines starting with '#' are ignored.
+/// </summary>
+class BakeScene : public me::scene::Scene
+{
+public:
+	BakeScene( me::game::Game * gameInstance );
+
+	void OnStart() override;
+
+private:
+	void Load( const unify::Path & path );
+
+	unify::Path m_output;
+	std::vector< ShapeDeclaration > m_declarations;
+};